@@ -1,4 +1,5 @@
 #include <cmon/cmon_argparse.h>
+#include <cmon/cmon_builder_mt.h>
 #include <cmon/cmon_builder_st.h>
 #include <cmon/cmon_codegen_c.h>
 #include <cmon/cmon_dir_parse.h>
@@ -22,7 +23,11 @@ int main(int _argc, const char * _args[])
     cmon_src * src = cmon_src_create(&alloc);
     cmon_modules * mods = cmon_modules_create(&alloc, src);
     cmon_log * log = NULL;
+    // only one of the two builders is created, depending on the job count (see -j)
     cmon_builder_st * builder = NULL;
+    cmon_builder_mt * builder_mt = NULL;
+    cmon_trace * trace = NULL;
+    cmon_mem_stats * mem_stats = NULL;
     // cmon_src_dir * sd = NULL;
     // // cmon_src_dir * dep_dir = NULL;
     // cmon_dyn_arr(cmon_src_dir *) dep_dirs;
@@ -52,6 +57,42 @@ int main(int _argc, const char * _args[])
     cmon_argparse_add_possible_val(ap, arg, "cwd", cmon_true);
     cmon_argparse_add_possible_val(ap, arg, "?", cmon_false);
 
+    cmon_idx jobs_arg =
+        cmon_argparse_add_arg(ap,
+                              build_cmd_idx,
+                              "-j",
+                              "--jobs",
+                              "number of parallel jobs (0 = one per hardware thread, 1 = single threaded build)",
+                              cmon_true,
+                              cmon_false);
+    cmon_argparse_add_possible_val(ap, jobs_arg, "0", cmon_true);
+    cmon_argparse_add_possible_val(ap, jobs_arg, "?", cmon_false);
+
+    cmon_idx trace_arg = cmon_argparse_add_arg(ap,
+                                               build_cmd_idx,
+                                               "-t",
+                                               "--trace",
+                                               "save a chrome trace of the build to the given path",
+                                               cmon_true,
+                                               cmon_false);
+    cmon_argparse_add_possible_val(ap, trace_arg, "?", cmon_false);
+
+    CMON_UNUSED(cmon_argparse_add_arg(ap,
+                                      build_cmd_idx,
+                                      "-m",
+                                      "--mem-stats",
+                                      "print the memory used by each part of the compiler",
+                                      cmon_false,
+                                      cmon_false));
+
+    CMON_UNUSED(cmon_argparse_add_arg(ap,
+                                      build_cmd_idx,
+                                      "-r",
+                                      "--release-src",
+                                      "release the src of modules once they are compiled",
+                                      cmon_false,
+                                      cmon_false));
+
     cmon_idx clean_cmd_idx = cmon_argparse_add_cmd(ap, "clean", "clean build directory");
     cmon_argparse_cmd_add_arg(ap, clean_cmd_idx, arg);
 
@@ -172,7 +213,26 @@ int main(int _argc, const char * _args[])
             }
         }
 
-        builder = cmon_builder_st_create(&alloc, atoi(cmon_argparse_value(ap, "-e")), src, mods);
+        int job_count = atoi(cmon_argparse_value(ap, "-j"));
+        if (job_count < 0)
+        {
+            _panic(end, "invalid job count %i", job_count);
+        }
+
+        //@NOTE: the multi threaded builder does not support releasing the src (yet), so -r always
+        // builds single threaded.
+        size_t max_errs = atoi(cmon_argparse_value(ap, "-e"));
+        if (job_count == 1 || cmon_argparse_is_arg_set(ap, "-r"))
+        {
+            builder = cmon_builder_st_create(&alloc, max_errs, src, mods);
+            cmon_builder_st_set_release_src(builder, cmon_argparse_is_arg_set(ap, "-r"));
+        }
+        else
+        {
+            builder_mt = cmon_builder_mt_create(&alloc, max_errs, src, mods);
+            cmon_builder_mt_set_thread_count(builder_mt, (size_t)job_count);
+        }
+
         log = cmon_log_create(&alloc,
                               "cmon_build.log",
                               build_path,
@@ -199,13 +259,38 @@ int main(int _argc, const char * _args[])
             cmon_log_write(log, cmon_log_level_info, "\n");
         }
 
-        cmon_codegen cgen = cmon_codegen_c_make(&alloc);
+        cmon_allocator cgen_alloc = alloc;
+        if (cmon_argparse_is_arg_set(ap, "-m"))
+        {
+            mem_stats = cmon_mem_stats_create(&alloc);
+            if (builder)
+                cmon_builder_st_set_mem_stats(builder, mem_stats);
+            else
+                cmon_builder_mt_set_mem_stats(builder_mt, mem_stats);
+            cgen_alloc = cmon_mem_stats_allocator(mem_stats, &alloc, "codegen");
+        }
+
+        cmon_codegen cgen = cmon_codegen_c_make_with_jobs(&cgen_alloc, (size_t)job_count);
 
-        if (cmon_builder_st_build(builder, &cgen, build_path, log))
+        if (cmon_argparse_is_arg_set(ap, "-t"))
+        {
+            trace = cmon_trace_create(&alloc);
+            if (builder)
+                cmon_builder_st_set_trace(builder, trace);
+            else
+                cmon_builder_mt_set_trace(builder_mt, trace);
+            cmon_codegen_c_set_trace(&cgen, trace);
+        }
+
+        if (builder ? cmon_builder_st_build(builder, &cgen, build_path, log)
+                    : cmon_builder_mt_build(builder_mt, &cgen, build_path, log))
         {
             cmon_err_report * errs;
             size_t count;
-            cmon_builder_st_errors(builder, &errs, &count);
+            if (builder)
+                cmon_builder_st_errors(builder, &errs, &count);
+            else
+                cmon_builder_mt_errors(builder_mt, &errs, &count);
             for (size_t i = 0; i < count; ++i)
             {
                 cmon_log_write_err_report(log, &errs[i], src);
@@ -213,10 +298,29 @@ int main(int _argc, const char * _args[])
         }
 
         cmon_codegen_dealloc(&cgen);
+
+        if (mem_stats)
+        {
+            cmon_str_builder_clear(tmp_strb);
+            cmon_mem_stats_report(mem_stats, tmp_strb);
+            // the report is the requested output rather than a log message, so it bypasses the log
+            // and its verbosity filtering.
+            fputs(cmon_str_builder_c_str(tmp_strb), stdout);
+        }
+
+        //@NOTE: saved after the codegen is gone, so all c compiler invocations are done.
+        if (trace && cmon_trace_save(trace, cmon_argparse_value(ap, "-t")))
+        {
+            _panic(end, "failed to save trace to %s", cmon_argparse_value(ap, "-t"));
+        }
     }
 
 end:
+    cmon_trace_destroy(trace);
     cmon_builder_st_destroy(builder);
+    cmon_builder_mt_destroy(builder_mt);
+    // the builder still allocates through the mem stats
+    cmon_mem_stats_destroy(mem_stats);
     cmon_str_builder_destroy(tmp_strb);
     cmon_log_destroy(log);
     cmon_modules_destroy(mods);
@@ -69,3 +69,175 @@ cmon_allocator cmon_mallocator_make()
     ret.shutdown_fn = NULL;
     return ret;
 }
+
+// all arena allocations are aligned to this
+#define _ARENA_ALIGN 16
+#define _arena_align(_v) (((_v) + (_ARENA_ALIGN - 1)) & ~(size_t)(_ARENA_ALIGN - 1))
+
+typedef struct _arena_chunk
+{
+    struct _arena_chunk * prev;
+    size_t size;
+    size_t used;
+} _arena_chunk;
+
+// the chunk header is padded so the data following it is aligned
+#define _ARENA_CHUNK_HEADER _arena_align(sizeof(_arena_chunk))
+
+typedef struct
+{
+    cmon_allocator * parent;
+    size_t chunk_size;
+    _arena_chunk * head;
+    // the most recent allocation, which can be grown, shrunk and freed in place
+    void * last;
+    size_t byte_count;
+} _arena_state;
+
+static inline char * _arena_chunk_data(_arena_chunk * _c)
+{
+    return (char *)_c + _ARENA_CHUNK_HEADER;
+}
+
+static inline void _arena_free_chunk(_arena_state * _a, _arena_chunk * _c)
+{
+    cmon_allocator_free(_a->parent, (cmon_mem_blk){ _c, _ARENA_CHUNK_HEADER + _c->size });
+}
+
+// true if _blk is the most recent allocation and ends where the free space of the current chunk
+// starts, in which case it can be resized and freed in place.
+static inline cmon_bool _arena_is_last(_arena_state * _a, cmon_mem_blk _blk)
+{
+    return _blk.ptr && _blk.ptr == _a->last &&
+           (char *)_blk.ptr + _arena_align(_blk.byte_count) ==
+               _arena_chunk_data(_a->head) + _a->head->used;
+}
+
+static inline cmon_mem_blk arena_alloc(size_t _s, void * _user_data)
+{
+    _arena_state * a = (_arena_state *)_user_data;
+    size_t s = _arena_align(_s);
+    char * ret;
+
+    if (!a->head || a->head->size - a->head->used < s)
+    {
+        //@NOTE: allocations bigger than the chunk size get their own chunk. The rest of the current
+        // chunk is wasted, which is fine as long as those are rare.
+        size_t size = s > a->chunk_size ? s : a->chunk_size;
+        _arena_chunk * c = cmon_allocator_alloc(a->parent, _ARENA_CHUNK_HEADER + size).ptr;
+        if (!c)
+            return (cmon_mem_blk){ NULL, 0 };
+
+        c->prev = a->head;
+        c->size = size;
+        c->used = 0;
+        a->head = c;
+    }
+
+    ret = _arena_chunk_data(a->head) + a->head->used;
+    a->head->used += s;
+    a->byte_count += s;
+    a->last = ret;
+    return (cmon_mem_blk){ ret, _s };
+}
+
+static inline cmon_mem_blk arena_realloc(cmon_mem_blk _blk, size_t _s, void * _user_data)
+{
+    _arena_state * a = (_arena_state *)_user_data;
+    cmon_mem_blk ret;
+
+    if (!_blk.ptr)
+        return arena_alloc(_s, _user_data);
+
+    if (_arena_is_last(a, _blk))
+    {
+        size_t old_s = _arena_align(_blk.byte_count);
+        size_t new_s = _arena_align(_s);
+        if (a->head->used - old_s + new_s <= a->head->size)
+        {
+            a->head->used = a->head->used - old_s + new_s;
+            a->byte_count = a->byte_count - old_s + new_s;
+            return (cmon_mem_blk){ _blk.ptr, _s };
+        }
+    }
+
+    ret = arena_alloc(_s, _user_data);
+    if (ret.ptr)
+        memcpy(ret.ptr, _blk.ptr, _blk.byte_count < _s ? _blk.byte_count : _s);
+    return ret;
+}
+
+static inline void arena_free(cmon_mem_blk _blk, void * _user_data)
+{
+    _arena_state * a = (_arena_state *)_user_data;
+    if (_arena_is_last(a, _blk))
+    {
+        size_t s = _arena_align(_blk.byte_count);
+        a->head->used -= s;
+        a->byte_count -= s;
+        a->last = NULL;
+    }
+}
+
+static inline void arena_shutdown(void * _user_data)
+{
+    _arena_state * a = (_arena_state *)_user_data;
+    while (a->head)
+    {
+        _arena_chunk * prev = a->head->prev;
+        _arena_free_chunk(a, a->head);
+        a->head = prev;
+    }
+    CMON_DESTROY(a->parent, a);
+}
+
+cmon_allocator cmon_arena_allocator_make(cmon_allocator * _parent, size_t _chunk_size)
+{
+    cmon_allocator ret;
+    _arena_state * a = CMON_CREATE(_parent, _arena_state);
+    a->parent = _parent;
+    a->chunk_size = _arena_align(_chunk_size);
+    a->head = NULL;
+    a->last = NULL;
+    a->byte_count = 0;
+
+    ret.user_data = a;
+    ret.alloc_fn = arena_alloc;
+    ret.realloc_fn = arena_realloc;
+    ret.free_fn = arena_free;
+    ret.shutdown_fn = arena_shutdown;
+    return ret;
+}
+
+cmon_arena_mark cmon_arena_allocator_mark(cmon_allocator * _arena)
+{
+    _arena_state * a = (_arena_state *)_arena->user_data;
+    return (cmon_arena_mark){ a->head, a->head ? a->head->used : 0 };
+}
+
+void cmon_arena_allocator_reset(cmon_allocator * _arena, cmon_arena_mark _mark)
+{
+    _arena_state * a = (_arena_state *)_arena->user_data;
+    while (a->head != _mark.chunk)
+    {
+        _arena_chunk * prev;
+        assert(a->head);
+        prev = a->head->prev;
+        a->byte_count -= a->head->used;
+        _arena_free_chunk(a, a->head);
+        a->head = prev;
+    }
+
+    if (a->head)
+    {
+        assert(_mark.used <= a->head->used);
+        a->byte_count -= a->head->used - _mark.used;
+        a->head->used = _mark.used;
+    }
+    a->last = NULL;
+}
+
+size_t cmon_arena_allocator_byte_count(cmon_allocator * _arena)
+{
+    return ((_arena_state *)_arena->user_data)->byte_count;
+}
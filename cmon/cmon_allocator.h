@@ -39,4 +39,22 @@ CMON_API void cmon_allocator_free(cmon_allocator * _alloc, cmon_mem_blk _blk);
 // creates an allocator that simply uses malloc and free
 CMON_API cmon_allocator cmon_mallocator_make();
 
+// position in an arena allocator to roll back to via cmon_arena_allocator_reset
+typedef struct
+{
+    void * chunk;
+    size_t used;
+} cmon_arena_mark;
+
+// creates an arena allocator that bumps allocations out of chunks of at least _chunk_size bytes,
+// which are allocated from _parent. Freeing is a noop unless the block is the most recent
+// allocation (the same goes for growing a block in place). All memory is released at once via
+// cmon_allocator_dealloc. Arena allocators are not thread safe.
+CMON_API cmon_allocator cmon_arena_allocator_make(cmon_allocator * _parent, size_t _chunk_size);
+CMON_API cmon_arena_mark cmon_arena_allocator_mark(cmon_allocator * _arena);
+// releases everything that was allocated after _mark was taken
+CMON_API void cmon_arena_allocator_reset(cmon_allocator * _arena, cmon_arena_mark _mark);
+// the number of bytes handed out by the arena (including alignment padding)
+CMON_API size_t cmon_arena_allocator_byte_count(cmon_allocator * _arena);
+
 #endif // CMON_CMON_ALLOCATOR2_H
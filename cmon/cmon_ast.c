@@ -3,33 +3,41 @@
 #include <cmon/cmon_util.h>
 #include <stdarg.h>
 
+//@NOTE: The ast is kept alive until codegen is done, so it is stored as compact as possible: Node
+// and extra data indices are 32 bit and every node only stores its main token. The first and last
+// token of a node are reconstructed from its children in cmon_ast_token_first and
+// cmon_ast_token_last. CMON_INVALID_IDX is stored as UINT32_MAX.
+typedef uint32_t _ast_idx;
+
 typedef struct
 {
-    cmon_idx left;
-    cmon_idx right;
+    _ast_idx left;
+    _ast_idx right;
 } _left_right;
 
-//@NOTE: For simplycity and nice error messages, we save three tokens for each node for now (which
-// is raher wasteful). As a future optimization we can only save the main token and algorithmically
-// reconstruct first and last in cmon_ast_token_first and cmon_ast_token_last.
-typedef struct
+static inline _ast_idx _to_ast_idx(cmon_idx _idx)
+{
+    if (!cmon_is_valid_idx(_idx))
+        return UINT32_MAX;
+    assert(_idx < UINT32_MAX);
+    return (_ast_idx)_idx;
+}
+
+static inline cmon_idx _from_ast_idx(_ast_idx _idx)
 {
-    cmon_idx main; // the token of interest, for most nodes this is equivalent to first. For binary
-                   // expressions it will be the op token for example.
-    cmon_idx first;
-    cmon_idx last;
-} _tok_range;
+    return _idx == UINT32_MAX ? CMON_INVALID_IDX : (cmon_idx)_idx;
+}
 
 typedef struct cmon_ast
 {
     cmon_allocator * alloc;
     cmon_tokens * tokens;
-    cmon_astk * kinds;
-    cmon_idx * main_tokens;
+    uint8_t * kinds; // cmon_astk
+    _ast_idx * main_tokens;
     _left_right * left_right;
     size_t count;
     cmon_idx root_block_idx;
-    cmon_idx * extra_data;
+    _ast_idx * extra_data;
     size_t extra_data_count;
 } cmon_ast;
 
@@ -37,10 +45,10 @@ typedef struct cmon_astb
 {
     cmon_allocator * alloc;
     cmon_tokens * tokens;
-    cmon_dyn_arr(cmon_astk) kinds;
-    cmon_dyn_arr(cmon_idx) main_tokens;
+    cmon_dyn_arr(uint8_t) kinds; // cmon_astk
+    cmon_dyn_arr(_ast_idx) main_tokens;
     cmon_dyn_arr(_left_right) left_right;
-    cmon_dyn_arr(cmon_idx) extra_data;
+    cmon_dyn_arr(_ast_idx) extra_data;
     cmon_dyn_arr(cmon_idx) imports; // we put all imports in one additional list for easy dependency
                                     // tree building later on
     cmon_idx root_block_idx;
@@ -49,13 +57,16 @@ typedef struct cmon_astb
 
 cmon_astb * cmon_astb_create(cmon_allocator * _alloc, cmon_tokens * _tokens)
 {
+    //@NOTE: A file has roughly 1.5 tokens per node and a little less than one extra data entry per
+    // node, so reserving 3/4 of the token count usually avoids growing the arrays while parsing.
+    size_t cap = CMON_MAX(256, cmon_tokens_count(_tokens) * 3 / 4);
     cmon_astb * ret = CMON_CREATE(_alloc, cmon_astb);
     ret->alloc = _alloc;
     ret->tokens = _tokens;
-    cmon_dyn_arr_init(&ret->kinds, _alloc, 256);
-    cmon_dyn_arr_init(&ret->main_tokens, _alloc, 256);
-    cmon_dyn_arr_init(&ret->left_right, _alloc, 256);
-    cmon_dyn_arr_init(&ret->extra_data, _alloc, 256);
+    cmon_dyn_arr_init(&ret->kinds, _alloc, cap);
+    cmon_dyn_arr_init(&ret->main_tokens, _alloc, cap);
+    cmon_dyn_arr_init(&ret->left_right, _alloc, cap);
+    cmon_dyn_arr_init(&ret->extra_data, _alloc, cap);
     cmon_dyn_arr_init(&ret->imports, _alloc, 8);
     ret->root_block_idx = CMON_INVALID_IDX;
     return ret;
@@ -76,7 +87,7 @@ void cmon_astb_destroy(cmon_astb * _b)
 
 static inline cmon_idx _add_extra_data(cmon_astb * _b, cmon_idx _data)
 {
-    cmon_dyn_arr_append(&_b->extra_data, _data);
+    cmon_dyn_arr_append(&_b->extra_data, _to_ast_idx(_data));
     return cmon_dyn_arr_count(&_b->extra_data) - 1;
 }
 
@@ -86,7 +97,7 @@ static inline cmon_idx _add_extra_data_arr(cmon_astb * _b, cmon_idx * _data, siz
     size_t i;
     for (i = 0; i < _count; ++i)
     {
-        cmon_dyn_arr_append(&_b->extra_data, _data[i]);
+        cmon_dyn_arr_append(&_b->extra_data, _to_ast_idx(_data[i]));
     }
 
     return begin;
@@ -125,9 +136,11 @@ static inline cmon_idx _add_extra_data_arr(cmon_astb * _b, cmon_idx * _data, siz
 static inline cmon_idx _add_node(
     cmon_astb * _b, cmon_astk _kind, cmon_idx _main_tok, cmon_idx _left, cmon_idx _right)
 {
-    cmon_dyn_arr_append(&_b->kinds, _kind);
-    cmon_dyn_arr_append(&_b->main_tokens, _main_tok);
-    cmon_dyn_arr_append(&_b->left_right, ((_left_right){ _left, _right }));
+    assert(_kind <= UINT8_MAX);
+    cmon_dyn_arr_append(&_b->kinds, (uint8_t)_kind);
+    cmon_dyn_arr_append(&_b->main_tokens, _to_ast_idx(_main_tok));
+    cmon_dyn_arr_append(&_b->left_right,
+                        ((_left_right){ _to_ast_idx(_left), _to_ast_idx(_right) }));
     return cmon_dyn_arr_count(&_b->kinds) - 1;
 }
 
@@ -251,7 +264,7 @@ cmon_idx cmon_astb_add_struct_init(cmon_astb * _b,
     _add_extra_data_arr(_b, _fields, _count);
     return _add_node(_b,
                      cmon_astk_struct_init,
-                     _b->main_tokens[_parsed_type_idx],
+                     _from_ast_idx(_b->main_tokens[_parsed_type_idx]),
                      left,
                      cmon_dyn_arr_count(&_b->extra_data));
 }
@@ -374,6 +387,67 @@ void cmon_astb_set_root_block(cmon_astb * _b, cmon_idx _idx)
     _b->root_block_idx = _idx;
 }
 
+size_t cmon_astb_count(cmon_astb * _b)
+{
+    return cmon_dyn_arr_count(&_b->kinds);
+}
+
+static inline void _shift_tok(_ast_idx * _tok, cmon_idx _from_tok, long _delta)
+{
+    if (*_tok != UINT32_MAX && *_tok >= _from_tok)
+        *_tok += _delta;
+}
+
+void cmon_astb_shift_tokens(
+    cmon_astb * _b, cmon_idx _node_begin, cmon_idx _node_end, cmon_idx _from_tok, long _delta)
+{
+    cmon_idx i, j;
+    _left_right * lr;
+
+    for (i = _node_begin; i < _node_end; ++i)
+    {
+        lr = &_b->left_right[i];
+        _shift_tok(&_b->main_tokens[i], _from_tok, _delta);
+
+        // all other places that store token indices, see the cmon_astb_add_* functions
+        switch (_b->kinds[i])
+        {
+        case cmon_astk_paran_expr:
+            _shift_tok(&lr->right, _from_tok, _delta);
+            break;
+        case cmon_astk_module:
+        case cmon_astk_struct_init_field:
+            _shift_tok(&lr->left, _from_tok, _delta);
+            break;
+        case cmon_astk_type_named:
+            _shift_tok(&lr->left, _from_tok, _delta);
+            _shift_tok(&lr->right, _from_tok, _delta);
+            break;
+        case cmon_astk_selector:
+            _shift_tok(&_b->extra_data[lr->right], _from_tok, _delta);
+            break;
+        case cmon_astk_call:
+        case cmon_astk_array_init:
+        case cmon_astk_index:
+        case cmon_astk_block:
+        case cmon_astk_struct_init:
+        case cmon_astk_struct_decl:
+        case cmon_astk_type_fn:
+        case cmon_astk_alias:
+        case cmon_astk_typedef:
+            _shift_tok(&_b->extra_data[lr->left], _from_tok, _delta);
+            break;
+        case cmon_astk_import_pair:
+            // alias followed by the path tokens
+            for (j = lr->left; j < lr->right; ++j)
+                _shift_tok(&_b->extra_data[j], _from_tok, _delta);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
 // adding parsed types
 cmon_idx cmon_astb_add_type_named(cmon_astb * _b, cmon_idx _mod_tok_idx, cmon_idx _tok_idx)
 {
@@ -402,10 +476,10 @@ cmon_idx cmon_astb_add_type_view(cmon_astb * _b,
 
 cmon_idx cmon_astb_add_type_array(cmon_astb * _b,
                                   cmon_idx _tok_idx,
-                                  size_t _count,
+                                  cmon_idx _count_expr,
                                   cmon_idx _type_idx)
 {
-    return _add_node(_b, cmon_astk_type_array, _tok_idx, _count, _type_idx);
+    return _add_node(_b, cmon_astk_type_array, _tok_idx, _count_expr, _type_idx);
 }
 
 cmon_idx cmon_astb_add_type_fn(cmon_astb * _b,
@@ -486,21 +560,30 @@ static inline cmon_astk _get_kind(cmon_ast * _ast, cmon_idx _idx)
 static inline cmon_idx _get_extra_data(cmon_ast * _ast, cmon_idx _idx)
 {
     assert(_idx < _ast->extra_data_count);
-    return _ast->extra_data[_idx];
+    return _from_ast_idx(_ast->extra_data[_idx]);
+}
+
+static inline void _set_extra_data(cmon_ast * _ast, cmon_idx _idx, cmon_idx _data)
+{
+    assert(_idx < _ast->extra_data_count);
+    _ast->extra_data[_idx] = _to_ast_idx(_data);
 }
 
+#define _node_left(_ast, _idx) _from_ast_idx((_ast)->left_right[_idx].left)
+#define _node_right(_ast, _idx) _from_ast_idx((_ast)->left_right[_idx].right)
+
 #define _extra_data_count_def(_name, _kind, _off)                                                  \
     size_t _name(cmon_ast * _ast, cmon_idx _idx)                                                   \
     {                                                                                              \
         assert(_get_kind(_ast, _idx) == _kind);                                                    \
-        return _ast->left_right[_idx].right - (_ast->left_right[_idx].left + _off);                \
+        return _node_right(_ast, _idx) - (_node_left(_ast, _idx) + _off);                          \
     }
 
 #define _extra_data_getter_def(_name, _count_fn_name, _off)                                        \
     cmon_idx _name(cmon_ast * _ast, cmon_idx _idx, size_t _gidx)                                   \
     {                                                                                              \
         assert(_gidx < _count_fn_name(_ast, _idx));                                                \
-        return _get_extra_data(_ast, _ast->left_right[_idx].left + _gidx + _off);                  \
+        return _get_extra_data(_ast, _node_left(_ast, _idx) + _gidx + _off);                       \
     }
 
 cmon_idx cmon_ast_root_block(cmon_ast * _ast)
@@ -513,6 +596,13 @@ size_t cmon_ast_count(cmon_ast * _ast)
     return _ast->count;
 }
 
+size_t cmon_ast_byte_count(cmon_ast * _ast)
+{
+    return _ast->count *
+               (sizeof(*_ast->kinds) + sizeof(*_ast->main_tokens) + sizeof(*_ast->left_right)) +
+           _ast->extra_data_count * sizeof(*_ast->extra_data);
+}
+
 cmon_astk cmon_ast_kind(cmon_ast * _ast, cmon_idx _idx)
 {
     return _get_kind(_ast, _idx);
@@ -521,7 +611,7 @@ cmon_astk cmon_ast_kind(cmon_ast * _ast, cmon_idx _idx)
 cmon_idx cmon_ast_token(cmon_ast * _ast, cmon_idx _idx)
 {
     assert(_idx < _ast->count);
-    return _ast->main_tokens[_idx];
+    return _from_ast_idx(_ast->main_tokens[_idx]);
 }
 
 cmon_idx cmon_ast_token_first(cmon_ast * _ast, cmon_idx _idx)
@@ -614,7 +704,7 @@ cmon_idx cmon_ast_token_last(cmon_ast * _ast, cmon_idx _idx)
              kind == cmon_astk_struct_decl || kind == cmon_astk_type_fn ||
              kind == cmon_astk_alias || kind == cmon_astk_typedef || kind == cmon_astk_block)
     {
-        return _get_extra_data(_ast, _ast->left_right[_idx].left);
+        return _get_extra_data(_ast, _node_left(_ast, _idx));
     }
     else if (kind == cmon_astk_ident || kind == cmon_astk_int_literal ||
              kind == cmon_astk_float_literal || kind == cmon_astk_bool_literal ||
@@ -630,25 +720,25 @@ cmon_idx cmon_ast_token_last(cmon_ast * _ast, cmon_idx _idx)
 cmon_idx cmon_ast_left(cmon_ast * _ast, cmon_idx _idx)
 {
     assert(_idx < _ast->count);
-    return _ast->left_right[_idx].left;
+    return _node_left(_ast, _idx);
 }
 
 cmon_idx cmon_ast_right(cmon_ast * _ast, cmon_idx _idx)
 {
     assert(_idx < _ast->count);
-    return _ast->left_right[_idx].right;
+    return _node_right(_ast, _idx);
 }
 
 cmon_idx cmon_ast_extra_data(cmon_ast * _ast, cmon_idx _extra_idx)
 {
     assert(_extra_idx < _ast->extra_data_count);
-    return _ast->extra_data[_extra_idx];
+    return _get_extra_data(_ast, _extra_idx);
 }
 
 cmon_idx cmon_ast_module_name_tok(cmon_ast * _ast, cmon_idx _mod_idx)
 {
     assert(_get_kind(_ast, _mod_idx) == cmon_astk_module);
-    return _ast->left_right[_mod_idx].left;
+    return _node_left(_ast, _mod_idx);
 }
 
 _extra_data_count_def(cmon_ast_import_pairs_count, cmon_astk_import, 0);
@@ -678,7 +768,7 @@ _extra_data_getter_def(cmon_ast_import_pair_path_token, cmon_ast_import_pair_pat
 cmon_idx cmon_ast_import_pair_alias(cmon_ast * _ast, cmon_idx _importp_idx)
 {
     assert(_get_kind(_ast, _importp_idx) == cmon_astk_import_pair);
-    return _get_extra_data(_ast, _ast->left_right[_importp_idx].left);
+    return _get_extra_data(_ast, _node_left(_ast, _importp_idx));
 }
 
 cmon_idx cmon_ast_import_pair_ident(cmon_ast * _ast, cmon_idx _importp_idx)
@@ -699,67 +789,67 @@ cmon_str_view cmon_ast_ident_name(cmon_ast * _ast, cmon_idx _tidx)
 void cmon_ast_ident_set_sym(cmon_ast * _ast, cmon_idx _tidx, cmon_idx _sym)
 {
     assert(_get_kind(_ast, _tidx) == cmon_astk_ident);
-    _ast->left_right[_tidx].left = _sym;
+    _ast->left_right[_tidx].left = _to_ast_idx(_sym);
 }
 
 cmon_idx cmon_ast_ident_sym(cmon_ast * _ast, cmon_idx _tidx)
 {
     assert(_get_kind(_ast, _tidx) == cmon_astk_ident);
-    return _ast->left_right[_tidx].left;
+    return _node_left(_ast, _tidx);
 }
 
 cmon_idx cmon_ast_type_named_module_tok(cmon_ast * _ast, cmon_idx _tidx)
 {
     assert(_get_kind(_ast, _tidx) == cmon_astk_type_named);
-    return _ast->left_right[_tidx].left;
+    return _node_left(_ast, _tidx);
 }
 
 cmon_idx cmon_ast_type_named_name_tok(cmon_ast * _ast, cmon_idx _tidx)
 {
     assert(_get_kind(_ast, _tidx) == cmon_astk_type_named);
-    return _ast->left_right[_tidx].right;
+    return _node_right(_ast, _tidx);
 }
 
 cmon_idx cmon_ast_type_ptr_type(cmon_ast * _ast, cmon_idx _tidx)
 {
     assert(_get_kind(_ast, _tidx) == cmon_astk_type_ptr);
-    return _ast->left_right[_tidx].right;
+    return _node_right(_ast, _tidx);
 }
 
 cmon_bool cmon_ast_type_ptr_is_mut(cmon_ast * _ast, cmon_idx _tidx)
 {
     assert(_get_kind(_ast, _tidx) == cmon_astk_type_ptr);
-    return (cmon_bool)_ast->left_right[_tidx].left;
+    return (cmon_bool)_node_left(_ast, _tidx);
 }
 
 cmon_idx cmon_ast_type_view_type(cmon_ast * _ast, cmon_idx _tidx)
 {
     assert(_get_kind(_ast, _tidx) == cmon_astk_type_view);
-    return _ast->left_right[_tidx].right;
+    return _node_right(_ast, _tidx);
 }
 
 cmon_bool cmon_ast_type_view_is_mut(cmon_ast * _ast, cmon_idx _tidx)
 {
     assert(_get_kind(_ast, _tidx) == cmon_astk_type_view);
-    return (cmon_bool)_ast->left_right[_tidx].left;
+    return (cmon_bool)_node_left(_ast, _tidx);
 }
 
 cmon_idx cmon_ast_type_array_type(cmon_ast * _ast, cmon_idx _tidx)
 {
     assert(_get_kind(_ast, _tidx) == cmon_astk_type_array);
-    return _ast->left_right[_tidx].right;
+    return _node_right(_ast, _tidx);
 }
 
-size_t cmon_ast_type_array_count(cmon_ast * _ast, cmon_idx _tidx)
+cmon_idx cmon_ast_type_array_count_expr(cmon_ast * _ast, cmon_idx _tidx)
 {
     assert(_get_kind(_ast, _tidx) == cmon_astk_type_array);
-    return (size_t)_ast->left_right[_tidx].left;
+    return _node_left(_ast, _tidx);
 }
 
 cmon_idx cmon_ast_type_fn_return_type(cmon_ast * _ast, cmon_idx _tidx)
 {
     assert(_get_kind(_ast, _tidx) == cmon_astk_type_fn);
-    return _get_extra_data(_ast, _ast->left_right[_tidx].left + 1);
+    return _get_extra_data(_ast, _node_left(_ast, _tidx) + 1);
 }
 
 _extra_data_count_def(cmon_ast_type_fn_params_count, cmon_astk_type_fn, 2);
@@ -774,38 +864,37 @@ cmon_idx cmon_ast_var_decl_name_tok(cmon_ast * _ast, cmon_idx _vidx)
 cmon_bool cmon_ast_var_decl_is_pub(cmon_ast * _ast, cmon_idx _vidx)
 {
     assert(_get_kind(_ast, _vidx) == cmon_astk_var_decl);
-    return _get_extra_data(_ast, _ast->left_right[_vidx].left);
+    return _get_extra_data(_ast, _node_left(_ast, _vidx));
 }
 
 cmon_bool cmon_ast_var_decl_is_mut(cmon_ast * _ast, cmon_idx _vidx)
 {
     assert(_get_kind(_ast, _vidx) == cmon_astk_var_decl);
-    return _get_extra_data(_ast, _ast->left_right[_vidx].left + 1);
+    return _get_extra_data(_ast, _node_left(_ast, _vidx) + 1);
 }
 
 cmon_idx cmon_ast_var_decl_type(cmon_ast * _ast, cmon_idx _vidx)
 {
     assert(_get_kind(_ast, _vidx) == cmon_astk_var_decl);
-    return _get_extra_data(_ast, _ast->left_right[_vidx].left + 2);
+    return _get_extra_data(_ast, _node_left(_ast, _vidx) + 2);
 }
 
 cmon_idx cmon_ast_var_decl_expr(cmon_ast * _ast, cmon_idx _vidx)
 {
     assert(_get_kind(_ast, _vidx) == cmon_astk_var_decl);
-    return _ast->left_right[_vidx].right;
+    return _node_right(_ast, _vidx);
 }
 
 void cmon_ast_var_decl_set_sym(cmon_ast * _ast, cmon_idx _vidx, cmon_idx _sym)
 {
     assert(_get_kind(_ast, _vidx) == cmon_astk_var_decl);
-    cmon_idx sym_ed_idx = _ast->left_right[_vidx].left + 3;
-    return _ast->extra_data[sym_ed_idx] = _sym;
+    _set_extra_data(_ast, _node_left(_ast, _vidx) + 3, _sym);
 }
 
 cmon_idx cmon_ast_var_decl_sym(cmon_ast * _ast, cmon_idx _vidx)
 {
     assert(_get_kind(_ast, _vidx) == cmon_astk_var_decl);
-    return _get_extra_data(_ast, _ast->left_right[_vidx].left + 3);
+    return _get_extra_data(_ast, _node_left(_ast, _vidx) + 3);
 }
 
 _extra_data_count_def(cmon_ast_block_child_count, cmon_astk_block, 1);
@@ -816,13 +905,13 @@ _extra_data_getter_def(cmon_ast_fn_param, cmon_ast_fn_params_count, 2);
 cmon_idx cmon_ast_fn_ret_type(cmon_ast * _ast, cmon_idx _fn_idx)
 {
     assert(_get_kind(_ast, _fn_idx) == cmon_astk_fn_decl);
-    return _get_extra_data(_ast, _ast->left_right[_fn_idx].left);
+    return _get_extra_data(_ast, _node_left(_ast, _fn_idx));
 }
 
 cmon_idx cmon_ast_fn_block(cmon_ast * _ast, cmon_idx _fn_idx)
 {
     assert(_get_kind(_ast, _fn_idx) == cmon_astk_fn_decl);
-    return _get_extra_data(_ast, _ast->left_right[_fn_idx].left + 1);
+    return _get_extra_data(_ast, _node_left(_ast, _fn_idx) + 1);
 }
 
 _extra_data_count_def(cmon_ast_struct_fields_count, cmon_astk_struct_decl, 3);
@@ -831,7 +920,7 @@ _extra_data_getter_def(cmon_ast_struct_field, cmon_ast_struct_fields_count, 3);
 cmon_bool cmon_ast_struct_is_pub(cmon_ast * _ast, cmon_idx _struct_idx)
 {
     assert(_get_kind(_ast, _struct_idx) == cmon_astk_struct_decl);
-    return _get_extra_data(_ast, _ast->left_right[_struct_idx].left + 1);
+    return _get_extra_data(_ast, _node_left(_ast, _struct_idx) + 1);
 }
 
 cmon_idx cmon_ast_struct_name(cmon_ast * _ast, cmon_idx _struct_idx)
@@ -843,25 +932,25 @@ cmon_idx cmon_ast_struct_name(cmon_ast * _ast, cmon_idx _struct_idx)
 void cmon_ast_struct_set_type(cmon_ast * _ast, cmon_idx _struct_idx, cmon_idx _type_idx)
 {
     assert(_get_kind(_ast, _struct_idx) == cmon_astk_struct_decl);
-    _ast->extra_data[_ast->left_right[_struct_idx].left + 1] = _type_idx;
+    _set_extra_data(_ast, _node_left(_ast, _struct_idx) + 1, _type_idx);
 }
 
 cmon_idx cmon_ast_struct_type(cmon_ast * _ast, cmon_idx _struct_idx)
 {
     assert(_get_kind(_ast, _struct_idx) == cmon_astk_struct_decl);
-    return _get_extra_data(_ast, _ast->left_right[_struct_idx].left + 1);
+    return _get_extra_data(_ast, _node_left(_ast, _struct_idx) + 1);
 }
 
 cmon_idx cmon_ast_addr_expr(cmon_ast * _ast, cmon_idx _addr_idx)
 {
     assert(_get_kind(_ast, _addr_idx) == cmon_astk_addr);
-    return _ast->left_right[_addr_idx].right;
+    return _node_right(_ast, _addr_idx);
 }
 
 cmon_idx cmon_ast_deref_expr(cmon_ast * _ast, cmon_idx _deref_idx)
 {
     assert(_get_kind(_ast, _deref_idx) == cmon_astk_deref);
-    return _ast->left_right[_deref_idx].right;
+    return _node_right(_ast, _deref_idx);
 }
 
 cmon_idx cmon_ast_prefix_op_tok(cmon_ast * _ast, cmon_idx _pref_idx)
@@ -873,7 +962,7 @@ cmon_idx cmon_ast_prefix_op_tok(cmon_ast * _ast, cmon_idx _pref_idx)
 cmon_idx cmon_ast_prefix_expr(cmon_ast * _ast, cmon_idx _pref_idx)
 {
     assert(_get_kind(_ast, _pref_idx) == cmon_astk_prefix);
-    return _ast->left_right[_pref_idx].right;
+    return _node_right(_ast, _pref_idx);
 }
 
 cmon_idx cmon_ast_binary_op_tok(cmon_ast * _ast, cmon_idx _bin_idx)
@@ -885,13 +974,13 @@ cmon_idx cmon_ast_binary_op_tok(cmon_ast * _ast, cmon_idx _bin_idx)
 cmon_idx cmon_ast_binary_left(cmon_ast * _ast, cmon_idx _bin_idx)
 {
     assert(_get_kind(_ast, _bin_idx) == cmon_astk_binary);
-    return _ast->left_right[_bin_idx].left;
+    return _node_left(_ast, _bin_idx);
 }
 
 cmon_idx cmon_ast_binary_right(cmon_ast * _ast, cmon_idx _bin_idx)
 {
     assert(_get_kind(_ast, _bin_idx) == cmon_astk_binary);
-    return _ast->left_right[_bin_idx].right;
+    return _node_right(_ast, _bin_idx);
 }
 
 cmon_bool cmon_ast_binary_is_assignment(cmon_ast * _ast, cmon_idx _bin_idx)
@@ -903,35 +992,35 @@ cmon_bool cmon_ast_binary_is_assignment(cmon_ast * _ast, cmon_idx _bin_idx)
 cmon_idx cmon_ast_paran_expr(cmon_ast * _ast, cmon_idx _paran_idx)
 {
     assert(_get_kind(_ast, _paran_idx) == cmon_astk_paran_expr);
-    return _ast->left_right[_paran_idx].left;
+    return _node_left(_ast, _paran_idx);
 }
 
 cmon_idx cmon_ast_selector_left(cmon_ast * _ast, cmon_idx _sel_idx)
 {
     assert(_get_kind(_ast, _sel_idx) == cmon_astk_selector);
-    return _ast->left_right[_sel_idx].left;
+    return _node_left(_ast, _sel_idx);
 }
 
 cmon_idx cmon_ast_selector_name_tok(cmon_ast * _ast, cmon_idx _sel_idx)
 {
     assert(_get_kind(_ast, _sel_idx) == cmon_astk_selector);
-    return _get_extra_data(_ast, _ast->left_right[_sel_idx].right);
+    return _get_extra_data(_ast, _node_right(_ast, _sel_idx));
 }
 
 void cmon_ast_selector_set_sym(cmon_ast * _ast, cmon_idx _sel_idx, cmon_idx _sym)
 {
-    _ast->extra_data[_ast->left_right[_sel_idx].right + 1] = _sym;
+    _set_extra_data(_ast, _node_right(_ast, _sel_idx) + 1, _sym);
 }
 
 cmon_idx cmon_ast_selector_sym(cmon_ast * _ast, cmon_idx _sel_idx)
 {
-    return _get_extra_data(_ast, _ast->left_right[_sel_idx].right + 1);
+    return _get_extra_data(_ast, _node_right(_ast, _sel_idx) + 1);
 }
 
 cmon_idx cmon_ast_call_left(cmon_ast * _ast, cmon_idx _idx)
 {
     assert(_get_kind(_ast, _idx) == cmon_astk_call);
-    return _get_extra_data(_ast, _ast->left_right[_idx].left + 1);
+    return _get_extra_data(_ast, _node_left(_ast, _idx) + 1);
 }
 
 _extra_data_count_def(cmon_ast_call_args_count, cmon_astk_call, 2);
@@ -942,31 +1031,31 @@ _extra_data_getter_def(cmon_ast_array_init_expr, cmon_ast_array_init_exprs_count
 cmon_idx cmon_ast_index_left(cmon_ast * _ast, cmon_idx _idx)
 {
     assert(_get_kind(_ast, _idx) == cmon_astk_index);
-    return _ast->left_right[_idx].right;
+    return _node_right(_ast, _idx);
 }
 
 cmon_idx cmon_ast_index_expr(cmon_ast * _ast, cmon_idx _idx)
 {
     assert(_get_kind(_ast, _idx) == cmon_astk_index);
-    return _get_extra_data(_ast, _ast->left_right[_idx].left + 1);
+    return _get_extra_data(_ast, _node_left(_ast, _idx) + 1);
 }
 
 cmon_idx cmon_ast_struct_init_field_name_tok(cmon_ast * _ast, cmon_idx _idx)
 {
     assert(_get_kind(_ast, _idx) == cmon_astk_struct_init_field);
-    return _ast->left_right[_idx].left;
+    return _node_left(_ast, _idx);
 }
 
 cmon_idx cmon_ast_struct_init_field_expr(cmon_ast * _ast, cmon_idx _idx)
 {
     assert(_get_kind(_ast, _idx) == cmon_astk_struct_init_field);
-    return _ast->left_right[_idx].right;
+    return _node_right(_ast, _idx);
 }
 
 cmon_idx cmon_ast_struct_init_parsed_type(cmon_ast * _ast, cmon_idx _idx)
 {
     assert(_get_kind(_ast, _idx) == cmon_astk_struct_init);
-    return _get_extra_data(_ast, _ast->left_right[_idx].left + 1);
+    return _get_extra_data(_ast, _node_left(_ast, _idx) + 1);
 }
 
 cmon_idx cmon_ast_struct_field_name(cmon_ast * _ast, cmon_idx _idx)
@@ -978,13 +1067,13 @@ cmon_idx cmon_ast_struct_field_name(cmon_ast * _ast, cmon_idx _idx)
 cmon_idx cmon_ast_struct_field_type(cmon_ast * _ast, cmon_idx _idx)
 {
     assert(_get_kind(_ast, _idx) == cmon_astk_struct_field);
-    return _ast->left_right[_idx].left;
+    return _node_left(_ast, _idx);
 }
 
 cmon_idx cmon_ast_struct_field_expr(cmon_ast * _ast, cmon_idx _idx)
 {
     assert(_get_kind(_ast, _idx) == cmon_astk_struct_field);
-    return _ast->left_right[_idx].right;
+    return _node_right(_ast, _idx);
 }
 
 _extra_data_count_def(cmon_ast_struct_init_fields_count, cmon_astk_struct_init, 3);
@@ -995,41 +1084,41 @@ void cmon_ast_struct_init_set_resolved_field_idx_buf(cmon_ast * _ast,
                                                      cmon_idx _idx_buf)
 {
     assert(_get_kind(_ast, _idx) == cmon_astk_struct_init);
-    _ast->extra_data[_ast->left_right[_idx].left + 1] = _idx_buf;
+    _set_extra_data(_ast, _node_left(_ast, _idx) + 1, _idx_buf);
 }
 
 cmon_idx cmon_ast_struct_init_resolved_field_idx_buf(cmon_ast * _ast, cmon_idx _idx)
 {
     assert(_get_kind(_ast, _idx) == cmon_astk_struct_init);
-    return _get_extra_data(_ast, _ast->left_right[_idx].left + 1);
+    return _get_extra_data(_ast, _node_left(_ast, _idx) + 1);
 }
 
 cmon_idx cmon_ast_alias_name_tok(cmon_ast * _ast, cmon_idx _idx)
 {
     assert(_get_kind(_ast, _idx) == cmon_astk_alias);
-    return _get_extra_data(_ast, _ast->left_right[_idx].left);
+    return _get_extra_data(_ast, _node_left(_ast, _idx));
 }
 
 cmon_bool cmon_ast_alias_is_pub(cmon_ast * _ast, cmon_idx _idx)
 {
     assert(_get_kind(_ast, _idx) == cmon_astk_alias);
-    return (cmon_bool)_get_extra_data(_ast, _ast->left_right[_idx].left + 1);
+    return (cmon_bool)_get_extra_data(_ast, _node_left(_ast, _idx) + 1);
 }
 
 cmon_idx cmon_ast_alias_parsed_type(cmon_ast * _ast, cmon_idx _idx)
 {
     assert(_get_kind(_ast, _idx) == cmon_astk_alias);
-    return _ast->left_right[_idx].right;
+    return _node_right(_ast, _idx);
 }
 
 void cmon_ast_alias_set_sym(cmon_ast * _ast, cmon_idx _idx, cmon_idx _sym)
 {
     assert(_get_kind(_ast, _idx) == cmon_astk_alias);
-    return _ast->extra_data[_ast->left_right[_idx].left + 2] = _sym;
+    _set_extra_data(_ast, _node_left(_ast, _idx) + 2, _sym);
 }
 
 cmon_idx cmon_ast_alias_sym(cmon_ast * _ast, cmon_idx _idx)
 {
     assert(_get_kind(_ast, _idx) == cmon_astk_alias);
-    return _get_extra_data(_ast, _ast->left_right[_idx].left + 2);
+    return _get_extra_data(_ast, _node_left(_ast, _idx) + 2);
 }
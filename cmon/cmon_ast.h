@@ -151,6 +151,11 @@ CMON_API cmon_idx cmon_astb_add_typedef(cmon_astb * _b,
 
 // helpers
 CMON_API void cmon_astb_set_root_block(cmon_astb * _b, cmon_idx _idx);
+CMON_API size_t cmon_astb_count(cmon_astb * _b);
+// adds _delta to all token indices >= _from_tok that are stored in the nodes [_node_begin,
+// _node_end). Used to reuse nodes after tokens in front of them were inserted or removed.
+CMON_API void cmon_astb_shift_tokens(
+    cmon_astb * _b, cmon_idx _node_begin, cmon_idx _node_end, cmon_idx _from_tok, long _delta);
 
 // adding parsed types
 CMON_API cmon_idx cmon_astb_add_type_named(cmon_astb * _b,
@@ -166,7 +171,7 @@ CMON_API cmon_idx cmon_astb_add_type_view(cmon_astb * _b,
                                           cmon_idx _type_idx);
 CMON_API cmon_idx cmon_astb_add_type_array(cmon_astb * _b,
                                            cmon_idx _tok_idx,
-                                           size_t _count,
+                                           cmon_idx _count_expr,
                                            cmon_idx _type_idx);
 CMON_API cmon_idx cmon_astb_add_type_fn(
     cmon_astb * _b, cmon_idx _tok_idx, cmon_idx _last_tok, cmon_idx _ret_type, cmon_idx * _params, size_t _count);
@@ -190,6 +195,8 @@ CMON_API void cmon_ast_destroy(cmon_ast * _ast);
 // ast getters
 CMON_API cmon_idx cmon_ast_root_block(cmon_ast * _ast);
 CMON_API size_t cmon_ast_count(cmon_ast * _ast);
+// number of bytes used by the nodes and extra data of the ast
+CMON_API size_t cmon_ast_byte_count(cmon_ast * _ast);
 CMON_API cmon_astk cmon_ast_kind(cmon_ast * _ast, cmon_idx _idx);
 CMON_API cmon_idx cmon_ast_token(cmon_ast * _ast, cmon_idx _idx);
 CMON_API cmon_idx cmon_ast_token_first(cmon_ast * _ast, cmon_idx _idx);
@@ -224,7 +231,7 @@ CMON_API cmon_bool cmon_ast_type_ptr_is_mut(cmon_ast * _ast, cmon_idx _tidx);
 CMON_API cmon_idx cmon_ast_type_view_type(cmon_ast * _ast, cmon_idx _tidx);
 CMON_API cmon_bool cmon_ast_type_view_is_mut(cmon_ast * _ast, cmon_idx _tidx);
 CMON_API cmon_idx cmon_ast_type_array_type(cmon_ast * _ast, cmon_idx _tidx);
-CMON_API size_t cmon_ast_type_array_count(cmon_ast * _ast, cmon_idx _tidx);
+CMON_API cmon_idx cmon_ast_type_array_count_expr(cmon_ast * _ast, cmon_idx _tidx);
 CMON_API cmon_idx cmon_ast_type_fn_return_type(cmon_ast * _ast, cmon_idx _tidx);
 CMON_API size_t cmon_ast_type_fn_params_count(cmon_ast * _ast, cmon_idx _idx);
 CMON_API cmon_idx cmon_ast_type_fn_param(cmon_ast * _ast, cmon_idx _idx, size_t _pidx);
@@ -0,0 +1,68 @@
+#ifndef CMON_CMON_BLK_ARR_H
+#define CMON_CMON_BLK_ARR_H
+
+#include <cmon/cmon_allocator.h>
+#include <string.h>
+
+// array that stores its elements in blocks that never move. Block b holds
+// (1 << (b + CMON_BLK_ARR_BLOCK_SHIFT)) elements, so appending never reallocates existing elements
+// and pointers to them (or reads of them from other threads) stay valid while the array grows.
+//@NOTE: appends still need to be synchronized with each other.
+#define CMON_BLK_ARR_BLOCK_SHIFT 4
+#define CMON_BLK_ARR_MAX_BLOCKS 48
+
+#define cmon_blk_arr(_type)                                                                        \
+    struct                                                                                         \
+    {                                                                                              \
+        cmon_allocator * alloc;                                                                    \
+        size_t count;                                                                              \
+        _type * blocks[CMON_BLK_ARR_MAX_BLOCKS];                                                   \
+    }
+
+#define _cmon_blk_arr_block(_i)                                                                    \
+    ((size_t)(63 - __builtin_clzll(((uint64_t)(_i) >> CMON_BLK_ARR_BLOCK_SHIFT) + 1)))
+#define _cmon_blk_arr_block_size(_b) ((size_t)1 << ((_b) + CMON_BLK_ARR_BLOCK_SHIFT))
+// index of the first element in block _b
+#define _cmon_blk_arr_block_begin(_b) (_cmon_blk_arr_block_size(_b) - _cmon_blk_arr_block_size(0))
+
+#define cmon_blk_arr_init(_arr, _alloc)                                                            \
+    do                                                                                             \
+    {                                                                                              \
+        (_arr)->alloc = (_alloc);                                                                  \
+        (_arr)->count = 0;                                                                         \
+        memset((_arr)->blocks, 0, sizeof((_arr)->blocks));                                         \
+    } while (0)
+#define cmon_blk_arr_count(_arr) ((_arr)->count)
+#define cmon_blk_arr_get(_arr, _idx)                                                               \
+    ((_arr)->blocks[_cmon_blk_arr_block(_idx)]                                                     \
+                   [(_idx)-_cmon_blk_arr_block_begin(_cmon_blk_arr_block(_idx))])
+#define cmon_blk_arr_last(_arr) cmon_blk_arr_get((_arr), (_arr)->count - 1)
+#define cmon_blk_arr_append(_arr, _val)                                                            \
+    do                                                                                             \
+    {                                                                                              \
+        size_t _b = _cmon_blk_arr_block((_arr)->count);                                            \
+        assert(_b < CMON_BLK_ARR_MAX_BLOCKS);                                                      \
+        if (!(_arr)->blocks[_b])                                                                   \
+        {                                                                                          \
+            (_arr)->blocks[_b] =                                                                   \
+                cmon_allocator_alloc((_arr)->alloc,                                                \
+                                     sizeof(*(_arr)->blocks[_b]) * _cmon_blk_arr_block_size(_b))   \
+                    .ptr;                                                                          \
+        }                                                                                          \
+        (_arr)->blocks[_b][(_arr)->count - _cmon_blk_arr_block_begin(_b)] = (_val);                \
+        ++(_arr)->count;                                                                           \
+    } while (0)
+#define cmon_blk_arr_dealloc(_arr)                                                                 \
+    do                                                                                             \
+    {                                                                                              \
+        size_t _b;                                                                                 \
+        for (_b = 0; _b < CMON_BLK_ARR_MAX_BLOCKS && (_arr)->blocks[_b]; ++_b)                     \
+        {                                                                                          \
+            cmon_allocator_free(                                                                   \
+                (_arr)->alloc,                                                                     \
+                (cmon_mem_blk){ (_arr)->blocks[_b],                                                \
+                                sizeof(*(_arr)->blocks[_b]) * _cmon_blk_arr_block_size(_b) });     \
+        }                                                                                          \
+    } while (0)
+
+#endif // CMON_CMON_BLK_ARR_H
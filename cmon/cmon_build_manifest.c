@@ -0,0 +1,389 @@
+#include <cmon/cmon_ast.h>
+#include <cmon/cmon_build_manifest.h>
+#include <cmon/cmon_dyn_arr.h>
+#include <cmon/cmon_fs.h>
+#include <cmon/cmon_hashmap.h>
+#include <cmon/cmon_str_builder.h>
+#include <cmon/cmon_tini.h>
+#include <cmon/cmon_tokens.h>
+#include <cmon/cmon_util.h>
+
+// bump this whenever the way hashes are computed changes so old manifests get ignored
+#define _MANIFEST_VERSION "1"
+
+// 64 bit FNV-1a
+#define _HASH_OFFSET 0xcbf29ce484222325ULL
+#define _HASH_PRIME 0x100000001b3ULL
+
+typedef struct
+{
+    char * path;
+    uint64_t src_hash;
+    uint64_t deps_hash;
+    uint64_t iface_hash;
+    uint64_t flags_hash;
+} _entry;
+
+typedef struct
+{
+    cmon_bool is_hashed;
+    uint64_t src_hash;
+    uint64_t deps_hash;
+    uint64_t iface_hash;
+} _mod_hashes;
+
+typedef struct cmon_build_manifest
+{
+    cmon_allocator * alloc;
+    cmon_modules * mods;
+    uint64_t flags_hash;
+    // entries loaded from the previous build
+    cmon_dyn_arr(_entry) prev_entries;
+    // maps the module path of each entry in prev_entries to its index
+    cmon_hashmap(const char *, cmon_idx) prev_entry_map;
+    // hashes of the current build, indexed by module
+    cmon_dyn_arr(_mod_hashes) mod_hashes;
+    cmon_str_builder * str_builder;
+} cmon_build_manifest;
+
+static inline uint64_t _hash_range(uint64_t _h, const char * _begin, const char * _end)
+{
+    while (_begin != _end)
+    {
+        _h ^= (uint64_t)(unsigned char)*_begin++;
+        _h *= _HASH_PRIME;
+    }
+    return _h;
+}
+
+static inline uint64_t _hash_str(uint64_t _h, const char * _str)
+{
+    //@NOTE: include the terminator so that i.e. "ab" + "c" and "a" + "bc" hash differently
+    return _hash_range(_h, _str, _str + strlen(_str) + 1);
+}
+
+static inline uint64_t _hash_u64(uint64_t _h, uint64_t _v)
+{
+    return _hash_range(_h, (const char *)&_v, (const char *)&_v + sizeof(_v));
+}
+
+static inline void _clear_prev_entries(cmon_build_manifest * _m)
+{
+    size_t i;
+    for (i = 0; i < cmon_dyn_arr_count(&_m->prev_entries); ++i)
+    {
+        cmon_c_str_free(_m->alloc, _m->prev_entries[i].path);
+    }
+    cmon_dyn_arr_clear(&_m->prev_entries);
+    //@NOTE: the keys are the paths owned by the entries, so the map has to go with them
+    cmon_hashmap_dealloc(&_m->prev_entry_map);
+    cmon_hashmap_str_key_init(&_m->prev_entry_map, _m->alloc);
+}
+
+static inline _entry * _find_prev_entry(cmon_build_manifest * _m, cmon_idx _mod_idx)
+{
+    const char * path = cmon_modules_path(_m->mods, _mod_idx);
+    cmon_idx * idx = cmon_hashmap_find(&_m->prev_entry_map, &path);
+    return idx ? &_m->prev_entries[*idx] : NULL;
+}
+
+cmon_build_manifest * cmon_build_manifest_create(cmon_allocator * _alloc, cmon_modules * _mods)
+{
+    cmon_build_manifest * ret = CMON_CREATE(_alloc, cmon_build_manifest);
+    ret->alloc = _alloc;
+    ret->mods = _mods;
+    ret->flags_hash = _hash_str(_HASH_OFFSET, "");
+    cmon_dyn_arr_init(&ret->prev_entries, _alloc, cmon_modules_count(_mods));
+    cmon_hashmap_str_key_init(&ret->prev_entry_map, _alloc);
+    cmon_dyn_arr_init(&ret->mod_hashes, _alloc, cmon_modules_count(_mods));
+    ret->str_builder = cmon_str_builder_create(_alloc, 512);
+    return ret;
+}
+
+void cmon_build_manifest_destroy(cmon_build_manifest * _m)
+{
+    if (!_m)
+        return;
+
+    cmon_str_builder_destroy(_m->str_builder);
+    cmon_dyn_arr_dealloc(&_m->mod_hashes);
+    _clear_prev_entries(_m);
+    cmon_hashmap_dealloc(&_m->prev_entry_map);
+    cmon_dyn_arr_dealloc(&_m->prev_entries);
+    CMON_DESTROY(_m->alloc, _m);
+}
+
+static inline cmon_bool _parse_hash(cmon_tini * _t, cmon_idx _obj, const char * _key, uint64_t * _out)
+{
+    char buf[32];
+    char * end;
+    cmon_idx val = cmon_tini_obj_find(_t, _obj, _key);
+    if (!cmon_is_valid_idx(val) || cmon_tini_kind(_t, val) != cmon_tinik_string)
+        return cmon_true;
+
+    cmon_str_view sv = cmon_tini_string(_t, val);
+    if (!cmon_str_view_len(sv) || cmon_str_view_len(sv) >= sizeof(buf))
+        return cmon_true;
+
+    memcpy(buf, sv.begin, cmon_str_view_len(sv));
+    buf[cmon_str_view_len(sv)] = '\0';
+    *_out = (uint64_t)strtoull(buf, &end, 16);
+    return *end != '\0';
+}
+
+void cmon_build_manifest_load(cmon_build_manifest * _m, const char * _path)
+{
+    cmon_tini_err err;
+    cmon_tini * tini;
+    cmon_idx root, version, mods_arr;
+    size_t i;
+
+    _clear_prev_entries(_m);
+
+    if (!cmon_fs_exists(_path))
+        return;
+
+    tini = cmon_tini_parse_file(_m->alloc, _path, &err);
+    if (!tini)
+        return;
+
+    root = cmon_tini_root_obj(tini);
+    version = cmon_tini_obj_find(tini, root, "version");
+    if (!cmon_is_valid_idx(version) || cmon_tini_kind(tini, version) != cmon_tinik_string ||
+        cmon_str_view_c_str_cmp(cmon_tini_string(tini, version), _MANIFEST_VERSION) != 0)
+    {
+        goto end;
+    }
+
+    mods_arr = cmon_tini_obj_find(tini, root, "modules");
+    if (!cmon_is_valid_idx(mods_arr) || cmon_tini_kind(tini, mods_arr) != cmon_tinik_array)
+        goto end;
+
+    for (i = 0; i < cmon_tini_child_count(tini, mods_arr); ++i)
+    {
+        _entry e;
+        cmon_idx child = cmon_tini_child(tini, mods_arr, i);
+        if (cmon_tini_kind(tini, child) != cmon_tinik_obj)
+            continue;
+
+        cmon_idx path = cmon_tini_obj_find(tini, child, "path");
+        if (!cmon_is_valid_idx(path) || cmon_tini_kind(tini, path) != cmon_tinik_string)
+            continue;
+
+        //@NOTE: entries we can't make sense of are simply dropped, which results in the module
+        // being rebuilt.
+        if (_parse_hash(tini, child, "src", &e.src_hash) ||
+            _parse_hash(tini, child, "deps", &e.deps_hash) ||
+            _parse_hash(tini, child, "iface", &e.iface_hash) ||
+            _parse_hash(tini, child, "flags", &e.flags_hash))
+        {
+            continue;
+        }
+
+        e.path = cmon_str_view_copy(_m->alloc, cmon_tini_string(tini, path));
+        cmon_dyn_arr_append(&_m->prev_entries, e);
+    }
+
+    // if a path is listed more than once, the first entry wins
+    for (i = 0; i < cmon_dyn_arr_count(&_m->prev_entries); ++i)
+    {
+        cmon_hashmap_get_or_insert(&_m->prev_entry_map, _m->prev_entries[i].path, (cmon_idx)i);
+    }
+
+end:
+    cmon_tini_destroy(tini);
+}
+
+cmon_bool cmon_build_manifest_save(cmon_build_manifest * _m, const char * _path)
+{
+    size_t i;
+
+    cmon_str_builder_clear(_m->str_builder);
+    cmon_str_builder_append_fmt(_m->str_builder, "version = %s,\n", _MANIFEST_VERSION);
+    cmon_str_builder_append(_m->str_builder, "modules = [");
+    for (i = 0; i < cmon_dyn_arr_count(&_m->mod_hashes); ++i)
+    {
+        _mod_hashes * mh = &_m->mod_hashes[i];
+        if (!mh->is_hashed)
+            continue;
+
+        cmon_str_builder_append_fmt(_m->str_builder,
+                                    "\n    {\n"
+                                    "        path = \"%s\",\n"
+                                    "        src = %016llx,\n"
+                                    "        deps = %016llx,\n"
+                                    "        iface = %016llx,\n"
+                                    "        flags = %016llx\n"
+                                    "    },",
+                                    cmon_modules_path(_m->mods, i),
+                                    (unsigned long long)mh->src_hash,
+                                    (unsigned long long)mh->deps_hash,
+                                    (unsigned long long)mh->iface_hash,
+                                    (unsigned long long)_m->flags_hash);
+    }
+    cmon_str_builder_append(_m->str_builder, "\n]\n");
+
+    return cmon_fs_write_txt_file(_path, cmon_str_builder_c_str(_m->str_builder)) != 0;
+}
+
+void cmon_build_manifest_set_flags(cmon_build_manifest * _m, const char * _flags)
+{
+    _m->flags_hash = _hash_str(_HASH_OFFSET, _flags);
+}
+
+static inline _mod_hashes * _get_mod_hashes(cmon_build_manifest * _m, cmon_idx _mod_idx)
+{
+    size_t old_count = cmon_dyn_arr_count(&_m->mod_hashes);
+    if (_mod_idx >= old_count)
+    {
+        cmon_dyn_arr_resize(&_m->mod_hashes, _mod_idx + 1);
+        memset(&_m->mod_hashes[old_count], 0, sizeof(_mod_hashes) * (_mod_idx + 1 - old_count));
+    }
+    return &_m->mod_hashes[_mod_idx];
+}
+
+static inline uint64_t _hash_type_name(uint64_t _h, cmon_types * _types, cmon_idx _type)
+{
+    return _hash_str(_h, cmon_is_valid_idx(_type) ? cmon_types_unique_name(_types, _type) : "");
+}
+
+static inline uint64_t _hash_ast_src(uint64_t _h, cmon_src * _src, cmon_idx _src_file_idx, cmon_idx _ast_idx)
+{
+    cmon_ast * ast = cmon_src_ast(_src, _src_file_idx);
+    cmon_tokens * toks = cmon_src_tokens(_src, _src_file_idx);
+    cmon_str_view first = cmon_tokens_str_view(toks, cmon_ast_token_first(ast, _ast_idx));
+    cmon_str_view last = cmon_tokens_str_view(toks, cmon_ast_token_last(ast, _ast_idx));
+    return _hash_range(_h, first.begin, last.end);
+}
+
+// hashes everything of a module that other modules can see.
+static inline uint64_t _hash_iface(cmon_build_manifest * _m,
+                                   cmon_src * _src,
+                                   cmon_symbols * _symbols,
+                                   cmon_types * _types,
+                                   cmon_idx _mod_idx)
+{
+    size_t i, j, type_count;
+    uint64_t h = _HASH_OFFSET;
+
+    //@NOTE: struct layouts (and field default expressions, which get copied into the code of the
+    // module initializing the struct) can leak to other modules even if the struct is not pub (i.e.
+    // as the return type of a pub fn), so all of them are part of the interface.
+    type_count = cmon_types_count(_types);
+    for (i = 0; i < type_count; ++i)
+    {
+        if (cmon_types_kind(_types, i) != cmon_typek_struct || cmon_types_module(_types, i) != _mod_idx)
+            continue;
+
+        h = _hash_str(h, cmon_types_unique_name(_types, i));
+        for (j = 0; j < cmon_types_struct_field_count(_types, i); ++j)
+        {
+            cmon_idx def_expr = cmon_types_struct_field_def_expr(_types, i, j);
+            h = _hash_str(h, cmon_types_struct_field_name(_types, i, j));
+            h = _hash_type_name(h, _types, cmon_types_struct_field_type(_types, i, j));
+            if (cmon_is_valid_idx(def_expr))
+            {
+                h = _hash_ast_src(h, _src, cmon_types_src_file(_types, i), def_expr);
+            }
+        }
+    }
+
+    cmon_idx scope = cmon_modules_global_scope(_m->mods, _mod_idx);
+    for (i = 0; i < cmon_symbols_scope_symbol_count(_symbols, scope); ++i)
+    {
+        cmon_idx sym = cmon_symbols_scope_symbol(_symbols, scope, i);
+        if (!cmon_symbols_is_pub(_symbols, sym))
+            continue;
+
+        cmon_symk kind = cmon_symbols_kind(_symbols, sym);
+        cmon_str_view name = cmon_symbols_name(_symbols, sym);
+        h = _hash_u64(h, (uint64_t)kind);
+        h = _hash_range(h, name.begin, name.end);
+        if (cmon_symbols_unique_name(_symbols, sym))
+            h = _hash_str(h, cmon_symbols_unique_name(_symbols, sym));
+
+        if (kind == cmon_symk_var)
+        {
+            h = _hash_type_name(h, _types, cmon_symbols_var_type(_symbols, sym));
+            h = _hash_u64(h, cmon_symbols_var_is_mut(_symbols, sym));
+        }
+        else if (kind == cmon_symk_type || kind == cmon_symk_alias)
+        {
+            h = _hash_type_name(h, _types, cmon_symbols_type(_symbols, sym));
+        }
+    }
+
+    return h;
+}
+
+uint64_t cmon_build_manifest_hash_src(cmon_build_manifest * _m, cmon_src * _src, cmon_idx _mod_idx)
+{
+    size_t i;
+    uint64_t ret = _HASH_OFFSET;
+
+    for (i = 0; i < cmon_modules_src_file_count(_m->mods, _mod_idx); ++i)
+    {
+        cmon_idx src_file = cmon_modules_src_file(_m->mods, _mod_idx, i);
+        ret = _hash_str(ret, cmon_src_filename(_src, src_file));
+        ret = _hash_str(ret, cmon_src_code(_src, src_file));
+    }
+    return ret;
+}
+
+void cmon_build_manifest_hash_module(cmon_build_manifest * _m,
+                                     cmon_src * _src,
+                                     cmon_symbols * _symbols,
+                                     cmon_types * _types,
+                                     cmon_idx _mod_idx)
+{
+    size_t i;
+    uint64_t src_hash = cmon_build_manifest_hash_src(_m, _src, _mod_idx);
+    uint64_t deps_hash = _HASH_OFFSET;
+
+    for (i = 0; i < cmon_modules_dep_count(_m->mods, _mod_idx); ++i)
+    {
+        _mod_hashes * dep = _get_mod_hashes(_m, cmon_modules_dep_mod_idx(_m->mods, _mod_idx, i));
+        assert(dep->is_hashed);
+        deps_hash = _hash_u64(deps_hash, dep->iface_hash);
+    }
+
+    _mod_hashes * mh = _get_mod_hashes(_m, _mod_idx);
+    mh->is_hashed = cmon_true;
+    mh->src_hash = src_hash;
+    mh->deps_hash = deps_hash;
+    //@NOTE: the interface of a module depends on the interfaces of its own dependencies, too (i.e. a
+    // pub struct embedding a struct of another module). Folding them in makes interface changes
+    // propagate to all modules that transitively depend on it.
+    mh->iface_hash = _hash_u64(_hash_iface(_m, _src, _symbols, _types, _mod_idx), deps_hash);
+}
+
+cmon_bool cmon_build_manifest_module_changed(cmon_build_manifest * _m, cmon_idx _mod_idx)
+{
+    _mod_hashes * mh = _get_mod_hashes(_m, _mod_idx);
+    _entry * e = _find_prev_entry(_m, _mod_idx);
+
+    assert(mh->is_hashed);
+    if (!e)
+        return cmon_true;
+
+    return e->src_hash != mh->src_hash || e->deps_hash != mh->deps_hash ||
+           e->iface_hash != mh->iface_hash || e->flags_hash != _m->flags_hash;
+}
+
+cmon_bool cmon_build_manifest_module_reusable(cmon_build_manifest * _m,
+                                              cmon_idx _mod_idx,
+                                              uint64_t _src_hash)
+{
+    _entry * e = _find_prev_entry(_m, _mod_idx);
+    return e && e->src_hash == _src_hash && e->flags_hash == _m->flags_hash;
+}
+
+uint64_t cmon_build_manifest_src_hash(cmon_build_manifest * _m, cmon_idx _mod_idx)
+{
+    return _get_mod_hashes(_m, _mod_idx)->src_hash;
+}
+
+uint64_t cmon_build_manifest_iface_hash(cmon_build_manifest * _m, cmon_idx _mod_idx)
+{
+    return _get_mod_hashes(_m, _mod_idx)->iface_hash;
+}
@@ -0,0 +1,46 @@
+#ifndef CMON_CMON_BUILD_MANIFEST_H
+#define CMON_CMON_BUILD_MANIFEST_H
+
+#include <cmon/cmon_modules.h>
+#include <cmon/cmon_src.h>
+#include <cmon/cmon_symbols.h>
+#include <cmon/cmon_types.h>
+
+// persistent record of the inputs each module was last compiled with. Per module it stores a hash
+// of its src files, a hash of the public interfaces of its dependencies and a hash of the codegen
+// flags. If none of them changed since the last build, the output of the previous build can be
+// reused for that module.
+typedef struct cmon_build_manifest cmon_build_manifest;
+
+CMON_API cmon_build_manifest * cmon_build_manifest_create(cmon_allocator * _alloc,
+                                                          cmon_modules * _mods);
+CMON_API void cmon_build_manifest_destroy(cmon_build_manifest * _m);
+// loads the manifest of a previous build. A missing or unreadable manifest is not an error, it only
+// means that all modules are considered changed.
+CMON_API void cmon_build_manifest_load(cmon_build_manifest * _m, const char * _path);
+// saves the hashes of the current build (see cmon_build_manifest_hash_module)
+CMON_API cmon_bool cmon_build_manifest_save(cmon_build_manifest * _m, const char * _path);
+// flags of the code generator (i.e. the c compiler command), part of the hash of every module.
+CMON_API void cmon_build_manifest_set_flags(cmon_build_manifest * _m, const char * _flags);
+// hashes the src files of a module, only needs their code to be loaded.
+CMON_API uint64_t cmon_build_manifest_hash_src(cmon_build_manifest * _m,
+                                               cmon_src * _src,
+                                               cmon_idx _mod_idx);
+// hashes the inputs of a resolved module for the current build. As this needs the interface hashes
+// of all its dependencies, modules have to be hashed in dependency order.
+CMON_API void cmon_build_manifest_hash_module(cmon_build_manifest * _m,
+                                              cmon_src * _src,
+                                              cmon_symbols * _symbols,
+                                              cmon_types * _types,
+                                              cmon_idx _mod_idx);
+// cmon_true if the inputs of the module differ from the ones in the loaded manifest.
+CMON_API cmon_bool cmon_build_manifest_module_changed(cmon_build_manifest * _m, cmon_idx _mod_idx);
+// cmon_true if the loaded manifest has an entry for the module with the same src hash and flags,
+// i.e. the output of the previous build can be used before resolving the module.
+CMON_API cmon_bool cmon_build_manifest_module_reusable(cmon_build_manifest * _m,
+                                                       cmon_idx _mod_idx,
+                                                       uint64_t _src_hash);
+CMON_API uint64_t cmon_build_manifest_src_hash(cmon_build_manifest * _m, cmon_idx _mod_idx);
+CMON_API uint64_t cmon_build_manifest_iface_hash(cmon_build_manifest * _m, cmon_idx _mod_idx);
+
+#endif // CMON_CMON_BUILD_MANIFEST_H
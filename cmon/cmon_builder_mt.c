@@ -0,0 +1,882 @@
+#include <cmon/cmon_build_manifest.h>
+#include <cmon/cmon_builder_mt.h>
+#include <cmon/cmon_dep_graph.h>
+#include <cmon/cmon_dyn_arr.h>
+#include <cmon/cmon_err_handler.h>
+#include <cmon/cmon_fs.h>
+#include <cmon/cmon_interner.h>
+#include <cmon/cmon_job_pool.h>
+#include <cmon/cmon_mod_iface.h>
+#include <cmon/cmon_parser.h>
+#include <cmon/cmon_resolver.h>
+#include <cmon/cmon_str_builder.h>
+#include <setjmp.h>
+
+// chunk sizes of the arenas holding everything that lives as long as a file (tokens, parser and
+// ast) or module (resolver and IR).
+#define _FILE_ARENA_CHUNK_SIZE (64 * 1024)
+#define _MODULE_ARENA_CHUNK_SIZE (256 * 1024)
+
+// the subsystems memory is accounted for if mem stats are set
+typedef enum
+{
+    _mem_tag_tokens,
+    _mem_tag_ast,
+    _mem_tag_symbols,
+    _mem_tag_types,
+    _mem_tag_ir,
+    _mem_tag_count
+} _mem_tag;
+
+static const char * _mem_tag_names[] = { "tokens", "ast", "symbols", "types", "ir" };
+
+typedef struct
+{
+    //@NOTE: arenas are not thread safe, but each file (and module) is only processed by one job at a
+    // time.
+    cmon_allocator tokens_arena;
+    cmon_allocator ast_arena;
+    cmon_src * src;
+    cmon_interner * interner;
+    cmon_trace * trace;
+    cmon_tokens * tokens;
+    cmon_parser * parser;
+    cmon_ast * ast;
+    cmon_idx src_file_idx;
+    // the resolver of the module and the index of the file in the module, used by the main pass job
+    cmon_resolver * resolver;
+    cmon_idx mod_file_idx;
+    // results of the file job. These are only touched by the worker thread processing the file
+    // and merged into the builders error handler after all jobs are done to keep the error order
+    // deterministic.
+    cmon_bool load_failed;
+    cmon_err_report tokenize_err;
+    cmon_err_report parse_err;
+    cmon_bool main_pass_failed;
+} _per_file_data;
+
+typedef enum
+{
+    _iface_state_unknown,
+    _iface_state_failed,
+    _iface_state_imported
+} _iface_state;
+
+typedef struct
+{
+    cmon_dyn_arr(_per_file_data) file_data;
+    cmon_allocator arena;
+    cmon_resolver * resolver;
+    cmon_trace * trace;
+    const char * path;
+    // set by the module jobs if any resolver pass failed
+    cmon_bool failed;
+    // set by the module jobs if all resolver passes succeeded
+    cmon_ir * ir;
+    _iface_state iface_state;
+    cmon_mod_iface * iface;
+} _per_module_data;
+
+typedef struct cmon_builder_mt
+{
+    cmon_allocator * alloc;
+    size_t max_errors;
+    size_t thread_count;
+    cmon_src * src;
+    cmon_modules * mods;
+    cmon_dyn_arr(_per_module_data) mod_data;
+    // shared by the tokenizer and symbols so identifier tokens can be looked up by id
+    cmon_interner * interner;
+    cmon_symbols * symbols;
+    cmon_types * types;
+    cmon_dyn_arr(cmon_idx) dep_buf;
+    cmon_dep_graph * dep_graph;
+    cmon_build_manifest * manifest;
+    cmon_job_pool * job_pool;
+    cmon_err_handler * err_handler;
+    cmon_trace * trace;
+    // allocators accounting into the mem stats, only used if has_mem_stats is set
+    cmon_bool has_mem_stats;
+    cmon_allocator tag_allocs[_mem_tag_count];
+    jmp_buf err_jmp;
+} cmon_builder_mt;
+
+cmon_builder_mt * cmon_builder_mt_create(cmon_allocator * _alloc,
+                                         size_t _max_errors,
+                                         cmon_src * _src,
+                                         cmon_modules * _mods)
+{
+    cmon_builder_mt * ret = CMON_CREATE(_alloc, cmon_builder_mt);
+    ret->alloc = _alloc;
+    ret->max_errors = _max_errors;
+    ret->thread_count = 0;
+    ret->src = _src;
+    ret->mods = _mods;
+    cmon_dyn_arr_init(&ret->mod_data, _alloc, cmon_modules_count(_mods));
+    ret->interner = cmon_interner_create(_alloc);
+    ret->symbols = cmon_symbols_create(_alloc, _src, _mods, ret->interner);
+    ret->types = cmon_types_create(_alloc, _mods);
+    cmon_dyn_arr_init(&ret->dep_buf, _alloc, 4);
+    ret->dep_graph = cmon_dep_graph_create(_alloc);
+    ret->manifest = cmon_build_manifest_create(_alloc, _mods);
+    ret->job_pool = NULL;
+    ret->err_handler = cmon_err_handler_create(_alloc, _src, _max_errors);
+    ret->trace = NULL;
+    ret->has_mem_stats = cmon_false;
+    return ret;
+}
+
+void cmon_builder_mt_destroy(cmon_builder_mt * _b)
+{
+    if (!_b)
+        return;
+
+    cmon_job_pool_destroy(_b->job_pool);
+    cmon_err_handler_destroy(_b->err_handler);
+    cmon_build_manifest_destroy(_b->manifest);
+    cmon_dep_graph_destroy(_b->dep_graph);
+    cmon_dyn_arr_dealloc(&_b->dep_buf);
+    cmon_types_destroy(_b->types);
+    cmon_symbols_destroy(_b->symbols);
+    cmon_interner_destroy(_b->interner);
+    size_t i, j;
+    for (i = 0; i < cmon_dyn_arr_count(&_b->mod_data); ++i)
+    {
+        //@NOTE: the resolver still references the asts, so it has to go first
+        cmon_resolver_destroy(_b->mod_data[i].resolver);
+        cmon_allocator_dealloc(&_b->mod_data[i].arena);
+        for (j = 0; j < cmon_dyn_arr_count(&_b->mod_data[i].file_data); ++j)
+        {
+            cmon_parser_destroy(_b->mod_data[i].file_data[j].parser);
+            cmon_tokens_destroy(_b->mod_data[i].file_data[j].tokens);
+            cmon_allocator_dealloc(&_b->mod_data[i].file_data[j].tokens_arena);
+            cmon_allocator_dealloc(&_b->mod_data[i].file_data[j].ast_arena);
+        }
+        cmon_dyn_arr_dealloc(&_b->mod_data[i].file_data);
+    }
+    // the symbols of imported modules point into the interface files, so they go last
+    for (i = 0; i < cmon_dyn_arr_count(&_b->mod_data); ++i)
+    {
+        cmon_mod_iface_destroy(_b->mod_data[i].iface);
+    }
+    cmon_dyn_arr_dealloc(&_b->mod_data);
+    CMON_DESTROY(_b->alloc, _b);
+}
+
+void cmon_builder_mt_set_thread_count(cmon_builder_mt * _b, size_t _count)
+{
+    assert(!_b->job_pool);
+    _b->thread_count = _count;
+}
+
+void cmon_builder_mt_set_trace(cmon_builder_mt * _b, cmon_trace * _trace)
+{
+    _b->trace = _trace;
+}
+
+static inline cmon_allocator * _tag_alloc(cmon_builder_mt * _b, _mem_tag _tag)
+{
+    return _b->has_mem_stats ? &_b->tag_allocs[_tag] : _b->alloc;
+}
+
+void cmon_builder_mt_set_mem_stats(cmon_builder_mt * _b, cmon_mem_stats * _stats)
+{
+    size_t i;
+
+    //@NOTE: the (still empty) types and symbols are recreated to allocate through the tagged
+    // allocators, hence this has to be called before building.
+    assert(!cmon_dyn_arr_count(&_b->mod_data));
+    for (i = 0; i < _mem_tag_count; ++i)
+    {
+        _b->tag_allocs[i] = cmon_mem_stats_allocator(_stats, _b->alloc, _mem_tag_names[i]);
+    }
+    _b->has_mem_stats = cmon_true;
+
+    cmon_types_destroy(_b->types);
+    cmon_symbols_destroy(_b->symbols);
+    _b->symbols = cmon_symbols_create(
+        _tag_alloc(_b, _mem_tag_symbols), _b->src, _b->mods, _b->interner);
+    _b->types = cmon_types_create(_tag_alloc(_b, _mem_tag_types), _b->mods);
+}
+
+static inline void _add_resolver_errors(cmon_builder_mt * _b,
+                                        cmon_resolver * _r,
+                                        cmon_bool _jmp_on_any_err)
+{
+    cmon_err_report * errs;
+    size_t count, i;
+    cmon_resolver_errors(_r, &errs, &count);
+    for (i = 0; i < count; ++i)
+    {
+        cmon_err_handler_add_err(_b->err_handler, cmon_true, &errs[i]);
+    }
+    if (_jmp_on_any_err)
+    {
+        cmon_err_handler_jump(_b->err_handler, cmon_true);
+    }
+}
+
+static inline void _log_status(cmon_log * _log, const char * _fmt, ...)
+{
+    va_list args;
+    va_start(args, _fmt);
+    cmon_log_write_styled_v(_log,
+                            cmon_log_level_info,
+                            cmon_log_color_cyan,
+                            cmon_log_color_default,
+                            cmon_log_style_none,
+                            _fmt,
+                            args);
+    va_end(args);
+}
+
+// job that loads a single src file.
+//@NOTE: Every file only touches its own cmon_src entry, so this is safe to run concurrently as long
+// as the allocator is thread safe.
+static void _load_job(void * _data)
+{
+    _per_file_data * pfd = (_per_file_data *)_data;
+    cmon_idx span =
+        cmon_trace_begin(pfd->trace, "file", "load %s", cmon_src_filename(pfd->src, pfd->src_file_idx));
+
+    //@NOTE: If the src code was already set on the src file (i.e. during unit testing)
+    // the cmon_src_load_code funtions is a noop.
+    pfd->load_failed = cmon_src_load_code(pfd->src, pfd->src_file_idx);
+    cmon_trace_end(pfd->trace, span);
+}
+
+// job that tokenizes and parses a single src file.
+static void _file_job(void * _data)
+{
+    _per_file_data * pfd = (_per_file_data *)_data;
+    const char * filename = cmon_src_filename(pfd->src, pfd->src_file_idx);
+    cmon_idx span;
+
+    span = cmon_trace_begin(pfd->trace, "file", "tokenize %s", filename);
+    pfd->tokens = cmon_tokenize_with_interner(
+        &pfd->tokens_arena, pfd->src, pfd->interner, pfd->src_file_idx, &pfd->tokenize_err);
+    cmon_trace_end(pfd->trace, span);
+    pfd->parser = cmon_parser_create(&pfd->ast_arena);
+
+    // no point in parsing a file that failed to tokenize
+    if (!cmon_err_report_is_empty(&pfd->tokenize_err))
+        return;
+
+    span = cmon_trace_begin(pfd->trace, "file", "parse %s", filename);
+    pfd->ast = cmon_parser_parse(pfd->parser, pfd->src, pfd->src_file_idx, pfd->tokens);
+    cmon_trace_end(pfd->trace, span);
+    if (!pfd->ast)
+    {
+        pfd->parse_err = cmon_parser_err(pfd->parser);
+    }
+}
+
+// job that runs the resolver passes of a module that need to finish before its files can be
+// resolved (see _main_pass_job).
+//@NOTE: All modules the module depends on are finished by the time this runs, so the only shared
+// state that is modified concurrently are the types and symbols, which are thread safe. The resolver
+// keeps the errors around, they are merged by the builder.
+static inline cmon_bool _resolve_module_types(_per_module_data * _pmd)
+{
+    size_t i, file_count;
+    cmon_idx span;
+
+    file_count = cmon_dyn_arr_count(&_pmd->file_data);
+
+    span = cmon_trace_begin(_pmd->trace, "pass", "user type pass");
+    for (i = 0; i < file_count; ++i)
+    {
+        if (cmon_resolver_usertypes_pass(_pmd->resolver, i))
+            goto err_end;
+    }
+    cmon_trace_end(_pmd->trace, span);
+
+    span = cmon_trace_begin(_pmd->trace, "pass", "globals pass");
+    if (cmon_resolver_globals_pass(_pmd->resolver))
+        goto err_end;
+    cmon_trace_end(_pmd->trace, span);
+
+    span = cmon_trace_begin(_pmd->trace, "pass", "user type default expression pass");
+    for (i = 0; i < file_count; ++i)
+    {
+        if (cmon_resolver_usertypes_def_expr_pass(_pmd->resolver, i))
+            goto err_end;
+    }
+    cmon_trace_end(_pmd->trace, span);
+    return cmon_false;
+
+err_end:
+    cmon_trace_end(_pmd->trace, span);
+    return cmon_true;
+}
+
+static void _module_types_job(void * _data)
+{
+    _per_module_data * pmd = (_per_module_data *)_data;
+    cmon_idx span = cmon_trace_begin(pmd->trace, "module", "%s", pmd->path);
+    pmd->failed = _resolve_module_types(pmd);
+    cmon_trace_end(pmd->trace, span);
+}
+
+// job that runs the main pass (i.e. resolving all function bodies) of a single file. The files of a
+// module are resolved concurrently, see cmon_resolver_main_pass.
+static void _main_pass_job(void * _data)
+{
+    _per_file_data * pfd = (_per_file_data *)_data;
+    cmon_idx span = cmon_trace_begin(
+        pfd->trace, "file", "main pass %s", cmon_src_filename(pfd->src, pfd->src_file_idx));
+    pfd->main_pass_failed = cmon_resolver_main_pass(pfd->resolver, pfd->mod_file_idx);
+    cmon_trace_end(pfd->trace, span);
+}
+
+// job that finishes a module after the main pass of all its files is done and generates its IR.
+static void _module_ir_job(void * _data)
+{
+    _per_module_data * pmd = (_per_module_data *)_data;
+    cmon_idx span, mod_span;
+    size_t i;
+
+    for (i = 0; i < cmon_dyn_arr_count(&pmd->file_data); ++i)
+    {
+        if (pmd->file_data[i].main_pass_failed)
+        {
+            pmd->failed = cmon_true;
+            return;
+        }
+    }
+
+    mod_span = cmon_trace_begin(pmd->trace, "module", "%s", pmd->path);
+    span = cmon_trace_begin(pmd->trace, "pass", "dependency order pass");
+    pmd->failed = cmon_resolver_circ_pass(pmd->resolver);
+    cmon_trace_end(pmd->trace, span);
+
+    if (!pmd->failed)
+    {
+        span = cmon_trace_begin(pmd->trace, "pass", "IR generation");
+        pmd->ir = cmon_resolver_finalize(pmd->resolver);
+        cmon_trace_end(pmd->trace, span);
+    }
+    cmon_trace_end(pmd->trace, mod_span);
+}
+
+static inline cmon_bool _deps_resolved(cmon_builder_mt * _b, cmon_idx _mod_idx)
+{
+    size_t i;
+    for (i = 0; i < cmon_modules_dep_count(_b->mods, _mod_idx); ++i)
+    {
+        _per_module_data * dep = &_b->mod_data[cmon_modules_dep_mod_idx(_b->mods, _mod_idx, i)];
+        if (!dep->ir && dep->iface_state != _iface_state_imported)
+            return cmon_false;
+    }
+    return cmon_true;
+}
+
+static inline void _iface_path(cmon_builder_mt * _b,
+                               const char * _build_dir,
+                               cmon_idx _mod_idx,
+                               char * _buf,
+                               size_t _buf_size)
+{
+    char dir[CMON_PATH_MAX];
+    char file_name[CMON_PATH_MAX];
+    cmon_join_paths(_build_dir, "iface", dir, sizeof(dir));
+    snprintf(file_name, sizeof(file_name), "%s.cmi", cmon_modules_path(_b->mods, _mod_idx));
+    cmon_join_paths(dir, file_name, _buf, _buf_size);
+}
+
+// imports a module from the interface file of the previous build if its src did not change since
+// then, which makes tokenizing, parsing and resolving it unnecessary. All dependencies of the module
+// have to be imported, too. Returns cmon_true if the module needs to be compiled.
+static cmon_bool _import_module(cmon_builder_mt * _b,
+                                cmon_codegen * _codegen,
+                                const char * _build_dir,
+                                cmon_idx _mod_idx)
+{
+    _per_module_data * pmd = &_b->mod_data[_mod_idx];
+    char path[CMON_PATH_MAX];
+    uint64_t src_hash;
+    cmon_idx session, dep;
+    cmon_bool reuse_failed;
+    size_t i;
+
+    if (pmd->iface_state != _iface_state_unknown)
+        return pmd->iface_state != _iface_state_imported;
+
+    //@NOTE: set upfront, so circular dependencies are not imported (and reported once resolved)
+    pmd->iface_state = _iface_state_failed;
+
+    src_hash = cmon_build_manifest_hash_src(_b->manifest, _b->src, _mod_idx);
+    if (!cmon_build_manifest_module_reusable(_b->manifest, _mod_idx, src_hash))
+        return cmon_true;
+
+    _iface_path(_b, _build_dir, _mod_idx, path, sizeof(path));
+    pmd->iface = cmon_mod_iface_load(_b->alloc, path);
+    if (!pmd->iface || cmon_mod_iface_src_hash(pmd->iface) != src_hash)
+        goto failed;
+
+    for (i = 0; i < cmon_mod_iface_dep_count(pmd->iface); ++i)
+    {
+        dep = cmon_modules_find(_b->mods,
+                                cmon_str_view_make(cmon_mod_iface_dep_path(pmd->iface, i)));
+        if (!cmon_is_valid_idx(dep) || _import_module(_b, _codegen, _build_dir, dep))
+            goto failed;
+    }
+
+    // without the output of the previous build there is nothing to import from
+    session = cmon_codegen_begin_session(_codegen, _mod_idx, NULL);
+    reuse_failed = cmon_codegen_reuse(_codegen, session);
+    cmon_codegen_end_session(_codegen, session);
+    if (reuse_failed || cmon_mod_iface_import(pmd->iface, _b->mods, _b->symbols, _b->types, _mod_idx))
+        goto failed;
+
+    cmon_modules_set_iface(_b->mods, _mod_idx, pmd->iface);
+    pmd->iface_state = _iface_state_imported;
+    return cmon_false;
+
+failed:
+    cmon_mod_iface_destroy(pmd->iface);
+    pmd->iface = NULL;
+    return cmon_true;
+}
+
+// writes the interfaces of all modules that were compiled in this build for the next one to import.
+static inline void _write_ifaces(cmon_builder_mt * _b, const char * _build_dir)
+{
+    char dir[CMON_PATH_MAX];
+    char path[CMON_PATH_MAX];
+    size_t i;
+
+    cmon_join_paths(_build_dir, "iface", dir, sizeof(dir));
+    if (!cmon_fs_exists(dir) && cmon_fs_mkdir(dir) != 0)
+        return;
+
+    for (i = 0; i < cmon_modules_count(_b->mods); ++i)
+    {
+        _per_module_data * pmd = &_b->mod_data[i];
+        if (pmd->iface_state == _iface_state_imported)
+            continue;
+
+        //@NOTE: nothing depends on a module with a main function, so there is no point in importing
+        // it. Stale files of modules that can't be expressed as interface are removed.
+        _iface_path(_b, _build_dir, i, path, sizeof(path));
+        if (!pmd->ir || cmon_is_valid_idx(cmon_ir_main_fn(pmd->ir)) ||
+            cmon_mod_iface_write(_b->alloc,
+                                 path,
+                                 _b->src,
+                                 _b->mods,
+                                 _b->symbols,
+                                 _b->types,
+                                 i,
+                                 cmon_build_manifest_src_hash(_b->manifest, i)))
+        {
+            cmon_fs_remove(path);
+        }
+    }
+}
+
+cmon_bool cmon_builder_mt_build(cmon_builder_mt * _b,
+                                cmon_codegen * _codegen,
+                                const char * _build_dir,
+                                cmon_log * _log)
+{
+    size_t i, j;
+    //@NOTE: spans that are still open when an error jumps out of the build are closed when the trace
+    // is saved.
+    cmon_idx build_span, phase_span, span;
+
+    if (setjmp(_b->err_jmp))
+    {
+        goto err_end;
+    }
+    cmon_err_handler_set_jump(_b->err_handler, &_b->err_jmp);
+
+    if (!_b->job_pool)
+    {
+        _b->job_pool = cmon_job_pool_create(_b->alloc, _b->thread_count);
+    }
+
+    _log_status(_log,
+                "-> cmon_builder_mt start build (%lu threads)\n",
+                cmon_job_pool_thread_count(_b->job_pool));
+    build_span = cmon_trace_begin(_b->trace, "build", "cmon_builder_mt build");
+
+    _log_status(_log, "    01. loading src files\n");
+    phase_span = cmon_trace_begin(_b->trace, "phase", "loading src files");
+
+    // setup all the things needed per module. This needs to be done before any job is dispatched
+    // so that the per file data does not move in memory anymore.
+    for (i = 0; i < cmon_modules_count(_b->mods); ++i)
+    {
+        _log_status(_log, "        » %s\n", cmon_modules_path(_b->mods, i));
+        _per_module_data mod_data;
+        mod_data.arena =
+            cmon_arena_allocator_make(_tag_alloc(_b, _mem_tag_ir), _MODULE_ARENA_CHUNK_SIZE);
+        mod_data.resolver = NULL;
+        mod_data.trace = _b->trace;
+        mod_data.path = cmon_modules_path(_b->mods, i);
+        mod_data.failed = cmon_false;
+        mod_data.ir = NULL;
+        mod_data.iface_state = _iface_state_unknown;
+        mod_data.iface = NULL;
+        cmon_dyn_arr_init(&mod_data.file_data, _b->alloc, cmon_modules_src_file_count(_b->mods, i));
+        for (j = 0; j < cmon_modules_src_file_count(_b->mods, i); ++j)
+        {
+            _per_file_data pfd;
+            pfd.tokens_arena =
+                cmon_arena_allocator_make(_tag_alloc(_b, _mem_tag_tokens), _FILE_ARENA_CHUNK_SIZE);
+            pfd.ast_arena =
+                cmon_arena_allocator_make(_tag_alloc(_b, _mem_tag_ast), _FILE_ARENA_CHUNK_SIZE);
+            pfd.src = _b->src;
+            pfd.trace = _b->trace;
+            pfd.interner = _b->interner;
+            pfd.tokens = NULL;
+            pfd.parser = NULL;
+            pfd.ast = NULL;
+            pfd.src_file_idx = cmon_modules_src_file(_b->mods, i, j);
+            pfd.resolver = NULL;
+            pfd.mod_file_idx = j;
+            pfd.load_failed = cmon_false;
+            pfd.tokenize_err = cmon_err_report_make_empty();
+            pfd.parse_err = cmon_err_report_make_empty();
+            pfd.main_pass_failed = cmon_false;
+
+            _log_status(_log, "            » %s\n", cmon_src_filename(_b->src, pfd.src_file_idx));
+            cmon_dyn_arr_append(&mod_data.file_data, pfd);
+        }
+        cmon_dyn_arr_append(&_b->mod_data, mod_data);
+    }
+
+    for (i = 0; i < cmon_dyn_arr_count(&_b->mod_data); ++i)
+    {
+        for (j = 0; j < cmon_dyn_arr_count(&_b->mod_data[i].file_data); ++j)
+        {
+            cmon_job_pool_add(_b->job_pool, _load_job, &_b->mod_data[i].file_data[j]);
+        }
+    }
+    cmon_job_pool_wait(_b->job_pool);
+
+    for (i = 0; i < cmon_dyn_arr_count(&_b->mod_data); ++i)
+    {
+        for (j = 0; j < cmon_dyn_arr_count(&_b->mod_data[i].file_data); ++j)
+        {
+            _per_file_data * pfd = &_b->mod_data[i].file_data[j];
+            if (pfd->load_failed)
+            {
+                cmon_err_handler_err(_b->err_handler,
+                                     cmon_true,
+                                     pfd->src_file_idx,
+                                     CMON_INVALID_IDX,
+                                     CMON_INVALID_IDX,
+                                     CMON_INVALID_IDX,
+                                     "failed to load src file %s",
+                                     cmon_src_path(_b->src, pfd->src_file_idx));
+            }
+        }
+    }
+    cmon_trace_end(_b->trace, phase_span);
+
+    // return if files failed to load
+    cmon_err_handler_jump(_b->err_handler, cmon_true);
+
+    // if codegen fails, we panic for now and call it a day.
+    if (cmon_codegen_prepare(_codegen, _b->mods, _b->types, _build_dir))
+    {
+        cmon_panic(cmon_codegen_err_msg(_codegen));
+    }
+
+    // modules whose src, dependency interfaces and codegen flags did not change since the last build
+    // reuse the output of that build.
+    char manifest_path[CMON_PATH_MAX];
+    cmon_join_paths(_build_dir, "build_manifest.tini", manifest_path, sizeof(manifest_path));
+    cmon_build_manifest_load(_b->manifest, manifest_path);
+    cmon_build_manifest_set_flags(_b->manifest, cmon_codegen_flags(_codegen));
+
+    _log_status(_log, "    02. importing module interfaces\n");
+    phase_span = cmon_trace_begin(_b->trace, "phase", "importing module interfaces");
+    for (i = 0; i < cmon_modules_count(_b->mods); ++i)
+    {
+        if (!_import_module(_b, _codegen, _build_dir, i))
+        {
+            _log_status(_log, "        » %s\n", cmon_modules_path(_b->mods, i));
+        }
+    }
+    cmon_trace_end(_b->trace, phase_span);
+
+    _log_status(_log, "    03. tokenizing and parsing src files\n");
+    phase_span = cmon_trace_begin(_b->trace, "phase", "tokenizing and parsing src files");
+    for (i = 0; i < cmon_dyn_arr_count(&_b->mod_data); ++i)
+    {
+        if (_b->mod_data[i].iface_state == _iface_state_imported)
+            continue;
+
+        _b->mod_data[i].resolver = cmon_resolver_create(&_b->mod_data[i].arena, _b->max_errors);
+        //@NOTE: the files of a module are resolved concurrently during the main pass, so they can't
+        // allocate from the module arena.
+        cmon_resolver_set_file_allocator(_b->mod_data[i].resolver, _tag_alloc(_b, _mem_tag_ir));
+        for (j = 0; j < cmon_dyn_arr_count(&_b->mod_data[i].file_data); ++j)
+        {
+            _b->mod_data[i].file_data[j].resolver = _b->mod_data[i].resolver;
+            cmon_job_pool_add(_b->job_pool, _file_job, &_b->mod_data[i].file_data[j]);
+        }
+    }
+    cmon_job_pool_wait(_b->job_pool);
+    cmon_trace_end(_b->trace, phase_span);
+
+    // merge tokenize errors in module/file order, just like the single threaded builder would
+    // report them.
+    for (i = 0; i < cmon_dyn_arr_count(&_b->mod_data); ++i)
+    {
+        for (j = 0; j < cmon_dyn_arr_count(&_b->mod_data[i].file_data); ++j)
+        {
+            _per_file_data * pfd = &_b->mod_data[i].file_data[j];
+            if (!cmon_err_report_is_empty(&pfd->tokenize_err))
+            {
+                cmon_err_handler_add_err(_b->err_handler, cmon_true, &pfd->tokenize_err);
+            }
+        }
+    }
+
+    // return if files failed to tokenize
+    cmon_err_handler_jump(_b->err_handler, cmon_true);
+
+    // merge parse errors
+    for (i = 0; i < cmon_dyn_arr_count(&_b->mod_data); ++i)
+    {
+        if (_b->mod_data[i].iface_state == _iface_state_imported)
+            continue;
+
+        for (j = 0; j < cmon_dyn_arr_count(&_b->mod_data[i].file_data); ++j)
+        {
+            _per_file_data * pfd = &_b->mod_data[i].file_data[j];
+            if (!pfd->ast)
+            {
+                cmon_err_handler_add_err(_b->err_handler, cmon_true, &pfd->parse_err);
+            }
+        }
+    }
+
+    // return if files failed to parse
+    cmon_err_handler_jump(_b->err_handler, cmon_true);
+
+    // resolve all the top level names for each module to determine which other modules they depend
+    // on
+    _log_status(_log, "    04. resolving top level names\n");
+    phase_span = cmon_trace_begin(_b->trace, "phase", "resolving top level names");
+    for (i = 0; i < cmon_modules_count(_b->mods); ++i)
+    {
+        _per_module_data * pmd = &_b->mod_data[i];
+        if (pmd->iface_state == _iface_state_imported)
+            continue;
+
+        _log_status(_log, "        » %s\n", cmon_modules_path(_b->mods, i));
+        span = cmon_trace_begin(_b->trace, "module", "%s", pmd->path);
+        cmon_resolver_set_input(pmd->resolver, _b->src, _b->types, _b->symbols, _b->mods, i);
+        for (j = 0; j < cmon_modules_src_file_count(_b->mods, i); ++j)
+        {
+            if (cmon_resolver_top_lvl_pass(pmd->resolver, j))
+            {
+                _add_resolver_errors(_b, pmd->resolver, cmon_false);
+            }
+        }
+
+        if (cmon_resolver_finalize_top_lvl_names(pmd->resolver))
+        {
+            _add_resolver_errors(_b, pmd->resolver, cmon_true);
+        }
+        cmon_trace_end(_b->trace, span);
+    }
+    cmon_trace_end(_b->trace, phase_span);
+
+    // return if modules errored during top level pass.
+    cmon_err_handler_jump(_b->err_handler, cmon_true);
+
+    // resolve dependency order between modules
+    _log_status(_log, "    05. resolving module dependency order\n");
+    phase_span = cmon_trace_begin(_b->trace, "phase", "resolving module dependency order");
+    for (i = 0; i < cmon_modules_count(_b->mods); ++i)
+    {
+        cmon_dyn_arr_clear(&_b->dep_buf);
+        for (j = 0; j < cmon_modules_dep_count(_b->mods, i); ++j)
+        {
+            cmon_dyn_arr_append(&_b->dep_buf, cmon_modules_dep_mod_idx(_b->mods, i, j));
+        }
+
+        cmon_dep_graph_add(_b->dep_graph, i, &_b->dep_buf[0], cmon_dyn_arr_count(&_b->dep_buf));
+    }
+
+    cmon_dep_graph_result result = cmon_dep_graph_resolve(_b->dep_graph);
+    // ensure that there is no circular dependency
+    if (!result.array)
+    {
+        cmon_idx a, b;
+        a = cmon_dep_graph_conflict_a(_b->dep_graph);
+        b = cmon_dep_graph_conflict_b(_b->dep_graph);
+
+        cmon_idx dep_idx = cmon_modules_find_dep_idx(_b->mods, a, b);
+        assert(cmon_is_valid_idx(dep_idx));
+
+        cmon_idx src_idx = cmon_modules_dep_src_file_idx(_b->mods, a, dep_idx);
+        assert(cmon_is_valid_idx(src_idx));
+
+        cmon_idx tok_idx = cmon_modules_dep_tok_idx(_b->mods, a, dep_idx);
+        assert(cmon_is_valid_idx(tok_idx));
+
+        cmon_err_handler_err(_b->err_handler,
+                             cmon_true,
+                             src_idx,
+                             tok_idx,
+                             tok_idx,
+                             tok_idx,
+                             "circular dependency between modules '%s' and '%s'",
+                             cmon_modules_path(_b->mods, a),
+                             cmon_modules_path(_b->mods, b));
+
+        cmon_err_handler_jump(_b->err_handler, cmon_true);
+    }
+    cmon_trace_end(_b->trace, phase_span);
+
+    // resolve the modules wave by wave. All modules of a wave only depend on modules of previous
+    // waves and are resolved concurrently. Within a wave, the main pass of every file is a job of its
+    // own so that big modules don't end up resolving on a single thread.
+    _log_status(_log, "    06. compiling modules\n");
+    phase_span = cmon_trace_begin(_b->trace, "phase", "compiling modules");
+    for (i = 0; i < cmon_dep_graph_wave_count(_b->dep_graph); ++i)
+    {
+        size_t k;
+        cmon_dep_graph_result wave = cmon_dep_graph_wave(_b->dep_graph, i);
+        _log_status(_log, "        wave %lu\n", i + 1);
+        span = cmon_trace_begin(_b->trace, "wave", "wave %lu", i + 1);
+        for (j = 0; j < wave.count; ++j)
+        {
+            _per_module_data * pmd = &_b->mod_data[wave.array[j]];
+            if (pmd->iface_state == _iface_state_imported)
+                continue;
+
+            //@NOTE: We keep going after a module failed to find the error the single threaded
+            // builder would report (see below). Modules depending on a failed module are skipped.
+            if (!_deps_resolved(_b, wave.array[j]))
+            {
+                pmd->failed = cmon_true;
+                continue;
+            }
+
+            _log_status(_log, "        » %s\n", cmon_modules_path(_b->mods, wave.array[j]));
+            cmon_job_pool_add(_b->job_pool, _module_types_job, pmd);
+        }
+        cmon_job_pool_wait(_b->job_pool);
+
+        for (j = 0; j < wave.count; ++j)
+        {
+            _per_module_data * pmd = &_b->mod_data[wave.array[j]];
+            if (pmd->iface_state == _iface_state_imported || pmd->failed)
+                continue;
+
+            for (k = 0; k < cmon_dyn_arr_count(&pmd->file_data); ++k)
+            {
+                cmon_job_pool_add(_b->job_pool, _main_pass_job, &pmd->file_data[k]);
+            }
+        }
+        cmon_job_pool_wait(_b->job_pool);
+
+        for (j = 0; j < wave.count; ++j)
+        {
+            _per_module_data * pmd = &_b->mod_data[wave.array[j]];
+            if (pmd->iface_state == _iface_state_imported || pmd->failed)
+                continue;
+
+            cmon_job_pool_add(_b->job_pool, _module_ir_job, pmd);
+        }
+        cmon_job_pool_wait(_b->job_pool);
+        cmon_trace_end(_b->trace, span);
+    }
+    cmon_trace_end(_b->trace, phase_span);
+
+    // report the errors of the first module in dependency order that failed to resolve. Its
+    // dependencies all resolved, hence it was not skipped and this is exactly what the single
+    // threaded builder reports.
+    for (i = 0; i < result.count; ++i)
+    {
+        _per_module_data * pmd = &_b->mod_data[result.array[i]];
+        if (!pmd->ir && pmd->iface_state != _iface_state_imported)
+        {
+            assert(_deps_resolved(_b, result.array[i]));
+            _add_resolver_errors(_b, pmd->resolver, cmon_true);
+        }
+    }
+
+    _log_status(_log, "    07. code generation\n");
+    phase_span = cmon_trace_begin(_b->trace, "phase", "code generation");
+    for (i = 0; i < result.count; ++i)
+    {
+        _per_module_data * pmd = &_b->mod_data[result.array[i]];
+        span = cmon_trace_begin(_b->trace, "module", "%s", pmd->path);
+        cmon_build_manifest_hash_module(
+            _b->manifest, _b->src, _b->symbols, _b->types, result.array[i]);
+        cmon_idx session = cmon_codegen_begin_session(_codegen, result.array[i], pmd->ir);
+        //@NOTE: imported modules have no IR, _import_module made sure that their output can be reused
+        if ((pmd->iface_state == _iface_state_imported ||
+             !cmon_build_manifest_module_changed(_b->manifest, result.array[i])) &&
+            !cmon_codegen_reuse(_codegen, session))
+        {
+            _log_status(
+                _log, "        » %s (up to date)\n", cmon_modules_path(_b->mods, result.array[i]));
+        }
+        else
+        {
+            assert(pmd->ir);
+            _log_status(_log, "        » %s\n", cmon_modules_path(_b->mods, result.array[i]));
+            if (cmon_codegen_gen(_codegen, session))
+            {
+                cmon_panic(cmon_codegen_session_err_msg(_codegen, session));
+            }
+        }
+        cmon_codegen_end_session(_codegen, session);
+        cmon_trace_end(_b->trace, span);
+    }
+    cmon_trace_end(_b->trace, phase_span);
+
+    // wait for the c compiler (or whatever else the codegen does asynchronously)
+    phase_span = cmon_trace_begin(_b->trace, "phase", "waiting for codegen");
+    if (cmon_codegen_finish(_codegen))
+    {
+        cmon_panic(cmon_codegen_err_msg(_codegen));
+    }
+    cmon_trace_end(_b->trace, phase_span);
+
+    //@NOTE: the manifest is only a cache. If it can't be saved, the next build simply rebuilds
+    // everything.
+    cmon_build_manifest_save(_b->manifest, manifest_path);
+    _write_ifaces(_b, _build_dir);
+
+    _log_status(_log, "<- cmon_builder_mt finished\n");
+    cmon_trace_end(_b->trace, build_span);
+
+    return cmon_false;
+err_end:
+    return cmon_true;
+}
+
+cmon_bool cmon_builder_mt_errors(cmon_builder_mt * _b,
+                                 cmon_err_report ** _out_errs,
+                                 size_t * _out_count)
+{
+    if (cmon_err_handler_count(_b->err_handler))
+    {
+        *_out_errs = cmon_err_handler_err_report(_b->err_handler, 0);
+        *_out_count = cmon_err_handler_count(_b->err_handler);
+        return cmon_true;
+    }
+    *_out_errs = NULL;
+    *_out_count = 0;
+    return cmon_false;
+}
+
+cmon_types * cmon_builder_mt_types(cmon_builder_mt * _b)
+{
+    return _b->types;
+}
+
+cmon_symbols * cmon_builder_mt_symbols(cmon_builder_mt * _b)
+{
+    return _b->symbols;
+}
@@ -0,0 +1,37 @@
+#ifndef CMON_CMON_BUILDER_MT_H
+#define CMON_CMON_BUILDER_MT_H
+
+#include <cmon/cmon_codegen.h>
+#include <cmon/cmon_err_report.h>
+#include <cmon/cmon_modules.h>
+#include <cmon/cmon_log.h>
+#include <cmon/cmon_mem_stats.h>
+#include <cmon/cmon_src.h>
+#include <cmon/cmon_symbols.h>
+#include <cmon/cmon_trace.h>
+
+// multi threaded builder. Produces the same output (including errors and their order) as
+// cmon_builder_st, but loads, tokenizes and parses all src files concurrently. Modules are resolved
+// in waves of modules that don't depend on each other, resolving the modules of a wave concurrently.
+typedef struct cmon_builder_mt cmon_builder_mt;
+
+CMON_API cmon_builder_mt * cmon_builder_mt_create(cmon_allocator * _alloc,
+                                                  size_t _max_errors,
+                                                  cmon_src * _src,
+                                                  cmon_modules * _mods);
+CMON_API void cmon_builder_mt_destroy(cmon_builder_mt * _b);
+// set the number of worker threads to use. 0 (the default) uses one thread per hardware thread.
+CMON_API void cmon_builder_mt_set_thread_count(cmon_builder_mt * _b, size_t _count);
+// record spans for the build phases, modules and files in _trace. _trace may be NULL (the default).
+CMON_API void cmon_builder_mt_set_trace(cmon_builder_mt * _b, cmon_trace * _trace);
+// account the memory of the tokens, asts, symbols, types and IR (including the resolvers) in
+// _stats. Has to be called before building.
+CMON_API void cmon_builder_mt_set_mem_stats(cmon_builder_mt * _b, cmon_mem_stats * _stats);
+CMON_API cmon_bool cmon_builder_mt_build(cmon_builder_mt * _b, cmon_codegen * _codegen, const char * _build_dir, cmon_log * _log);
+CMON_API cmon_bool cmon_builder_mt_errors(cmon_builder_mt * _b,
+                                          cmon_err_report ** _out_errs,
+                                          size_t * _out_count);
+CMON_API cmon_types * cmon_builder_mt_types(cmon_builder_mt * _b);
+CMON_API cmon_symbols * cmon_builder_mt_symbols(cmon_builder_mt * _b);
+
+#endif // CMON_CMON_BUILDER_MT_H
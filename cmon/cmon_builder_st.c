@@ -1,25 +1,64 @@
+#include <cmon/cmon_build_manifest.h>
 #include <cmon/cmon_builder_st.h>
 #include <cmon/cmon_dep_graph.h>
 #include <cmon/cmon_dyn_arr.h>
 #include <cmon/cmon_err_handler.h>
+#include <cmon/cmon_fs.h>
+#include <cmon/cmon_interner.h>
+#include <cmon/cmon_mod_iface.h>
 #include <cmon/cmon_parser.h>
 #include <cmon/cmon_resolver.h>
 #include <cmon/cmon_str_builder.h>
 #include <setjmp.h>
 
+// chunk sizes of the arenas holding everything that lives as long as a file (tokens, parser and
+// ast) or module (resolver and IR).
+#define _FILE_ARENA_CHUNK_SIZE (64 * 1024)
+#define _MODULE_ARENA_CHUNK_SIZE (256 * 1024)
+
+// the subsystems memory is accounted for if mem stats are set
+typedef enum
+{
+    _mem_tag_tokens,
+    _mem_tag_ast,
+    _mem_tag_symbols,
+    _mem_tag_types,
+    _mem_tag_ir,
+    _mem_tag_count
+} _mem_tag;
+
+static const char * _mem_tag_names[] = { "tokens", "ast", "symbols", "types", "ir" };
+
 typedef struct
 {
+    cmon_allocator tokens_arena;
+    cmon_allocator ast_arena;
     cmon_tokens * tokens;
     cmon_parser * parser;
     cmon_ast * ast;
     cmon_idx src_file_idx;
 } _per_file_data;
 
+typedef enum
+{
+    _iface_state_unknown,
+    _iface_state_failed,
+    _iface_state_imported
+} _iface_state;
+
 typedef struct
 {
     cmon_dyn_arr(_per_file_data) file_data;
+    cmon_allocator arena;
     cmon_resolver * resolver;
     cmon_ir * ir;
+    _iface_state iface_state;
+    cmon_mod_iface * iface;
+    // number of modules compiled in this build that still need the ast of this module
+    size_t dependents_left;
+    // set once the src, tokens and ast of the module were released (see release_src)
+    cmon_bool released;
+    cmon_bool iface_written;
 } _per_module_data;
 
 typedef struct cmon_builder_st
@@ -29,11 +68,20 @@ typedef struct cmon_builder_st
     cmon_src * src;
     cmon_modules * mods;
     cmon_dyn_arr(_per_module_data) mod_data;
+    // shared by the tokenizer and symbols so identifier tokens can be looked up by id
+    cmon_interner * interner;
     cmon_symbols * symbols;
     cmon_types * types;
     cmon_dyn_arr(cmon_idx) dep_buf;
     cmon_dep_graph * dep_graph;
+    cmon_build_manifest * manifest;
     cmon_err_handler * err_handler;
+    cmon_trace * trace;
+    // allocators accounting into the mem stats, only used if has_mem_stats is set
+    cmon_bool has_mem_stats;
+    cmon_allocator tag_allocs[_mem_tag_count];
+    // release the src, tokens and ast of each module once nothing needs them anymore
+    cmon_bool release_src;
     jmp_buf err_jmp;
 } cmon_builder_st;
 
@@ -48,11 +96,16 @@ cmon_builder_st * cmon_builder_st_create(cmon_allocator * _alloc,
     ret->src = _src;
     ret->mods = _mods;
     cmon_dyn_arr_init(&ret->mod_data, _alloc, cmon_modules_count(_mods));
-    ret->symbols = cmon_symbols_create(_alloc, _src, _mods);
+    ret->interner = cmon_interner_create(_alloc);
+    ret->symbols = cmon_symbols_create(_alloc, _src, _mods, ret->interner);
     ret->types = cmon_types_create(_alloc, _mods);
     cmon_dyn_arr_init(&ret->dep_buf, _alloc, 4);
     ret->dep_graph = cmon_dep_graph_create(_alloc);
+    ret->manifest = cmon_build_manifest_create(_alloc, _mods);
     ret->err_handler = cmon_err_handler_create(_alloc, _src, _max_errors);
+    ret->trace = NULL;
+    ret->has_mem_stats = cmon_false;
+    ret->release_src = cmon_false;
     return ret;
 }
 
@@ -62,25 +115,72 @@ void cmon_builder_st_destroy(cmon_builder_st * _b)
         return;
 
     cmon_err_handler_destroy(_b->err_handler);
+    cmon_build_manifest_destroy(_b->manifest);
     cmon_dep_graph_destroy(_b->dep_graph);
     cmon_dyn_arr_dealloc(&_b->dep_buf);
     cmon_types_destroy(_b->types);
     cmon_symbols_destroy(_b->symbols);
+    cmon_interner_destroy(_b->interner);
     size_t i, j;
     for (i = 0; i < cmon_dyn_arr_count(&_b->mod_data); ++i)
     {
-        for (j = 0; j < cmon_dyn_arr_count(&_b->mod_data[i].file_data); ++j)
+        // the files of released modules were cleaned up already
+        for (j = 0; !_b->mod_data[i].released && j < cmon_dyn_arr_count(&_b->mod_data[i].file_data);
+             ++j)
         {
             cmon_parser_destroy(_b->mod_data[i].file_data[j].parser);
             cmon_tokens_destroy(_b->mod_data[i].file_data[j].tokens);
+            cmon_allocator_dealloc(&_b->mod_data[i].file_data[j].tokens_arena);
+            cmon_allocator_dealloc(&_b->mod_data[i].file_data[j].ast_arena);
         }
         cmon_dyn_arr_dealloc(&_b->mod_data[i].file_data);
         cmon_resolver_destroy(_b->mod_data[i].resolver);
+        cmon_allocator_dealloc(&_b->mod_data[i].arena);
+    }
+    // the symbols of imported modules point into the interface files, so they go last
+    for (i = 0; i < cmon_dyn_arr_count(&_b->mod_data); ++i)
+    {
+        cmon_mod_iface_destroy(_b->mod_data[i].iface);
     }
     cmon_dyn_arr_dealloc(&_b->mod_data);
     CMON_DESTROY(_b->alloc, _b);
 }
 
+void cmon_builder_st_set_trace(cmon_builder_st * _b, cmon_trace * _trace)
+{
+    _b->trace = _trace;
+}
+
+void cmon_builder_st_set_release_src(cmon_builder_st * _b, cmon_bool _release)
+{
+    _b->release_src = _release;
+}
+
+static inline cmon_allocator * _tag_alloc(cmon_builder_st * _b, _mem_tag _tag)
+{
+    return _b->has_mem_stats ? &_b->tag_allocs[_tag] : _b->alloc;
+}
+
+void cmon_builder_st_set_mem_stats(cmon_builder_st * _b, cmon_mem_stats * _stats)
+{
+    size_t i;
+
+    //@NOTE: the (still empty) types and symbols are recreated to allocate through the tagged
+    // allocators, hence this has to be called before building.
+    assert(!cmon_dyn_arr_count(&_b->mod_data));
+    for (i = 0; i < _mem_tag_count; ++i)
+    {
+        _b->tag_allocs[i] = cmon_mem_stats_allocator(_stats, _b->alloc, _mem_tag_names[i]);
+    }
+    _b->has_mem_stats = cmon_true;
+
+    cmon_types_destroy(_b->types);
+    cmon_symbols_destroy(_b->symbols);
+    _b->symbols = cmon_symbols_create(
+        _tag_alloc(_b, _mem_tag_symbols), _b->src, _b->mods, _b->interner);
+    _b->types = cmon_types_create(_tag_alloc(_b, _mem_tag_types), _b->mods);
+}
+
 static inline void _add_resolver_errors(cmon_builder_st * _b,
                                         cmon_resolver * _r,
                                         cmon_bool _jmp_on_any_err)
@@ -112,12 +212,167 @@ static inline void _log_status(cmon_log * _log, const char * _fmt, ...)
     va_end(args);
 }
 
+static inline void _iface_path(cmon_builder_st * _b,
+                               const char * _build_dir,
+                               cmon_idx _mod_idx,
+                               char * _buf,
+                               size_t _buf_size)
+{
+    char dir[CMON_PATH_MAX];
+    char file_name[CMON_PATH_MAX];
+    cmon_join_paths(_build_dir, "iface", dir, sizeof(dir));
+    snprintf(file_name, sizeof(file_name), "%s.cmi", cmon_modules_path(_b->mods, _mod_idx));
+    cmon_join_paths(dir, file_name, _buf, _buf_size);
+}
+
+// imports a module from the interface file of the previous build if its src did not change since
+// then, which makes tokenizing, parsing and resolving it unnecessary. All dependencies of the module
+// have to be imported, too. Returns cmon_true if the module needs to be compiled.
+static cmon_bool _import_module(cmon_builder_st * _b,
+                                cmon_codegen * _codegen,
+                                const char * _build_dir,
+                                cmon_idx _mod_idx)
+{
+    _per_module_data * pmd = &_b->mod_data[_mod_idx];
+    char path[CMON_PATH_MAX];
+    uint64_t src_hash;
+    cmon_idx session, dep;
+    cmon_bool reuse_failed;
+    size_t i;
+
+    if (pmd->iface_state != _iface_state_unknown)
+        return pmd->iface_state != _iface_state_imported;
+
+    //@NOTE: set upfront, so circular dependencies are not imported (and reported once resolved)
+    pmd->iface_state = _iface_state_failed;
+
+    src_hash = cmon_build_manifest_hash_src(_b->manifest, _b->src, _mod_idx);
+    if (!cmon_build_manifest_module_reusable(_b->manifest, _mod_idx, src_hash))
+        return cmon_true;
+
+    _iface_path(_b, _build_dir, _mod_idx, path, sizeof(path));
+    pmd->iface = cmon_mod_iface_load(_b->alloc, path);
+    if (!pmd->iface || cmon_mod_iface_src_hash(pmd->iface) != src_hash)
+        goto failed;
+
+    for (i = 0; i < cmon_mod_iface_dep_count(pmd->iface); ++i)
+    {
+        dep = cmon_modules_find(_b->mods,
+                                cmon_str_view_make(cmon_mod_iface_dep_path(pmd->iface, i)));
+        if (!cmon_is_valid_idx(dep) || _import_module(_b, _codegen, _build_dir, dep))
+            goto failed;
+    }
+
+    // without the output of the previous build there is nothing to import from
+    session = cmon_codegen_begin_session(_codegen, _mod_idx, NULL);
+    reuse_failed = cmon_codegen_reuse(_codegen, session);
+    cmon_codegen_end_session(_codegen, session);
+    if (reuse_failed || cmon_mod_iface_import(pmd->iface, _b->mods, _b->symbols, _b->types, _mod_idx))
+        goto failed;
+
+    cmon_modules_set_iface(_b->mods, _mod_idx, pmd->iface);
+    pmd->iface_state = _iface_state_imported;
+    return cmon_false;
+
+failed:
+    cmon_mod_iface_destroy(pmd->iface);
+    pmd->iface = NULL;
+    return cmon_true;
+}
+
+// writes the interface of a module that was compiled in this build for the next one to import.
+static inline void _write_iface(cmon_builder_st * _b, const char * _build_dir, cmon_idx _mod_idx)
+{
+    char dir[CMON_PATH_MAX];
+    char path[CMON_PATH_MAX];
+    _per_module_data * pmd = &_b->mod_data[_mod_idx];
+
+    cmon_join_paths(_build_dir, "iface", dir, sizeof(dir));
+    if (!cmon_fs_exists(dir) && cmon_fs_mkdir(dir) != 0)
+        return;
+
+    //@NOTE: nothing depends on a module with a main function, so there is no point in importing
+    // it. Stale files of modules that can't be expressed as interface are removed.
+    _iface_path(_b, _build_dir, _mod_idx, path, sizeof(path));
+    if (!pmd->ir || cmon_is_valid_idx(cmon_ir_main_fn(pmd->ir)) ||
+        cmon_mod_iface_write(_b->alloc,
+                             path,
+                             _b->src,
+                             _b->mods,
+                             _b->symbols,
+                             _b->types,
+                             _mod_idx,
+                             cmon_build_manifest_src_hash(_b->manifest, _mod_idx)))
+    {
+        cmon_fs_remove(path);
+    }
+    pmd->iface_written = cmon_true;
+}
+
+// writes the interfaces of all modules that were compiled in this build and were not written when
+// their src was released.
+static inline void _write_ifaces(cmon_builder_st * _b, const char * _build_dir)
+{
+    size_t i;
+    for (i = 0; i < cmon_modules_count(_b->mods); ++i)
+    {
+        _per_module_data * pmd = &_b->mod_data[i];
+        if (pmd->iface_state == _iface_state_imported || pmd->iface_written)
+            continue;
+        _write_iface(_b, _build_dir, i);
+    }
+}
+
+// releases the src, tokens and ast of a compiled module. Its interface is written right away as
+// that needs the ast, too. Modules with struct field default expressions are kept, as the
+// expressions get compiled into every module initializing the struct.
+static inline void _try_release(cmon_builder_st * _b, const char * _build_dir, cmon_idx _mod_idx)
+{
+    _per_module_data * pmd = &_b->mod_data[_mod_idx];
+    size_t i, j;
+
+    if (!_b->release_src || pmd->iface_state == _iface_state_imported || !pmd->ir ||
+        pmd->released || pmd->dependents_left)
+        return;
+
+    for (i = 0; i < cmon_types_count(_b->types); ++i)
+    {
+        if (cmon_types_kind(_b->types, i) != cmon_typek_struct ||
+            cmon_types_module(_b->types, i) != _mod_idx)
+            continue;
+
+        for (j = 0; j < cmon_types_struct_field_count(_b->types, i); ++j)
+        {
+            if (cmon_is_valid_idx(cmon_types_struct_field_def_expr(_b->types, i, j)))
+                return;
+        }
+    }
+
+    _write_iface(_b, _build_dir, _mod_idx);
+    for (i = 0; i < cmon_dyn_arr_count(&pmd->file_data); ++i)
+    {
+        _per_file_data * pfd = &pmd->file_data[i];
+        cmon_parser_destroy(pfd->parser);
+        cmon_tokens_destroy(pfd->tokens);
+        cmon_allocator_dealloc(&pfd->tokens_arena);
+        cmon_allocator_dealloc(&pfd->ast_arena);
+        pfd->parser = NULL;
+        pfd->tokens = NULL;
+        pfd->ast = NULL;
+        cmon_src_release(_b->src, pfd->src_file_idx);
+    }
+    pmd->released = cmon_true;
+}
+
 cmon_bool cmon_builder_st_build(cmon_builder_st * _b,
                                 cmon_codegen * _codegen,
                                 const char * _build_dir,
                                 cmon_log * _log)
 {
     size_t i, j;
+    //@NOTE: spans that are still open when an error jumps out of the build are closed when the trace
+    // is saved.
+    cmon_idx build_span, phase_span, mod_span, span;
 
     if (setjmp(_b->err_jmp))
     {
@@ -126,27 +381,43 @@ cmon_bool cmon_builder_st_build(cmon_builder_st * _b,
     cmon_err_handler_set_jump(_b->err_handler, &_b->err_jmp);
 
     _log_status(_log, "-> cmon_builder_st start build\n");
+    build_span = cmon_trace_begin(_b->trace, "build", "cmon_builder_st build");
 
-    _log_status(_log, "    01. loading and tokenizing src files\n");
-
-    // setup all the things needed per module
+    _log_status(_log, "    01. loading src files\n");
+    phase_span = cmon_trace_begin(_b->trace, "phase", "loading src files");
     for (i = 0; i < cmon_modules_count(_b->mods); ++i)
     {
         _log_status(_log, "        » %s\n", cmon_modules_path(_b->mods, i));
+        mod_span = cmon_trace_begin(_b->trace, "module", "%s", cmon_modules_path(_b->mods, i));
         _per_module_data mod_data;
-        mod_data.resolver = cmon_resolver_create(_b->alloc, _b->max_errors);
+        mod_data.arena =
+            cmon_arena_allocator_make(_tag_alloc(_b, _mem_tag_ir), _MODULE_ARENA_CHUNK_SIZE);
+        mod_data.resolver = NULL;
+        mod_data.ir = NULL;
+        mod_data.iface_state = _iface_state_unknown;
+        mod_data.iface = NULL;
+        mod_data.dependents_left = 0;
+        mod_data.released = cmon_false;
+        mod_data.iface_written = cmon_false;
         cmon_dyn_arr_init(&mod_data.file_data, _b->alloc, cmon_modules_src_file_count(_b->mods, i));
-        // setup everything needed per file
         for (j = 0; j < cmon_modules_src_file_count(_b->mods, i); ++j)
         {
-            cmon_err_report err = cmon_err_report_make_empty();
             _per_file_data pfd;
             pfd.src_file_idx = cmon_modules_src_file(_b->mods, i, j);
+            pfd.tokens_arena =
+                cmon_arena_allocator_make(_tag_alloc(_b, _mem_tag_tokens), _FILE_ARENA_CHUNK_SIZE);
+            pfd.ast_arena =
+                cmon_arena_allocator_make(_tag_alloc(_b, _mem_tag_ast), _FILE_ARENA_CHUNK_SIZE);
+            pfd.tokens = NULL;
+            pfd.parser = NULL;
+            pfd.ast = NULL;
 
             _log_status(_log, "            » %s\n", cmon_src_filename(_b->src, pfd.src_file_idx));
 
             //@NOTE: If the src code was already set on the src file (i.e. during unit testing)
             // the cmon_src_load_code funtions is a noop.
+            span = cmon_trace_begin(
+                _b->trace, "file", "load %s", cmon_src_filename(_b->src, pfd.src_file_idx));
             if (cmon_src_load_code(_b->src, pfd.src_file_idx))
             {
                 cmon_err_handler_err(_b->err_handler,
@@ -154,37 +425,97 @@ cmon_bool cmon_builder_st_build(cmon_builder_st * _b,
                                      pfd.src_file_idx,
                                      CMON_INVALID_IDX,
                                      CMON_INVALID_IDX,
+                                     CMON_INVALID_IDX,
                                      "failed to load src file %s",
                                      cmon_src_path(_b->src, pfd.src_file_idx));
             }
-            else
-            {
-                // tokenize the modules files right here
-                pfd.tokens = cmon_tokenize(_b->alloc, _b->src, pfd.src_file_idx, &err);
-                pfd.parser = cmon_parser_create(_b->alloc);
-                pfd.ast = NULL;
-
-                // buffer potential tokenize errors
-                if (!cmon_err_report_is_empty(&err))
-                {
-                    cmon_err_handler_add_err(_b->err_handler, cmon_true, &err);
-                }
-            }
+            cmon_trace_end(_b->trace, span);
 
             cmon_dyn_arr_append(&mod_data.file_data, pfd);
         }
         cmon_dyn_arr_append(&_b->mod_data, mod_data);
+        cmon_trace_end(_b->trace, mod_span);
     }
+    cmon_trace_end(_b->trace, phase_span);
+
+    // return if files failed to load
+    cmon_err_handler_jump(_b->err_handler, cmon_true);
+
+    // if codegen fails, we panic for now and call it a day.
+    if (cmon_codegen_prepare(_codegen, _b->mods, _b->types, _build_dir))
+    {
+        cmon_panic(cmon_codegen_err_msg(_codegen));
+    }
+
+    // modules whose src, dependency interfaces and codegen flags did not change since the last build
+    // reuse the output of that build.
+    char manifest_path[CMON_PATH_MAX];
+    cmon_join_paths(_build_dir, "build_manifest.tini", manifest_path, sizeof(manifest_path));
+    cmon_build_manifest_load(_b->manifest, manifest_path);
+    cmon_build_manifest_set_flags(_b->manifest, cmon_codegen_flags(_codegen));
+
+    _log_status(_log, "    02. importing module interfaces\n");
+    phase_span = cmon_trace_begin(_b->trace, "phase", "importing module interfaces");
+    for (i = 0; i < cmon_modules_count(_b->mods); ++i)
+    {
+        if (!_import_module(_b, _codegen, _build_dir, i))
+        {
+            _log_status(_log, "        » %s\n", cmon_modules_path(_b->mods, i));
+        }
+    }
+    cmon_trace_end(_b->trace, phase_span);
+
+    _log_status(_log, "    03. tokenizing src files\n");
+    phase_span = cmon_trace_begin(_b->trace, "phase", "tokenizing src files");
+    for (i = 0; i < cmon_modules_count(_b->mods); ++i)
+    {
+        _per_module_data * pmd = &_b->mod_data[i];
+        if (pmd->iface_state == _iface_state_imported)
+            continue;
+
+        _log_status(_log, "        » %s\n", cmon_modules_path(_b->mods, i));
+        mod_span = cmon_trace_begin(_b->trace, "module", "%s", cmon_modules_path(_b->mods, i));
+        pmd->resolver = cmon_resolver_create(&pmd->arena, _b->max_errors);
+        // setup everything needed per file
+        for (j = 0; j < cmon_modules_src_file_count(_b->mods, i); ++j)
+        {
+            cmon_err_report err = cmon_err_report_make_empty();
+            _per_file_data * pfd = &pmd->file_data[j];
+
+            _log_status(_log, "            » %s\n", cmon_src_filename(_b->src, pfd->src_file_idx));
+
+            // tokenize the modules files right here
+            span = cmon_trace_begin(
+                _b->trace, "file", "tokenize %s", cmon_src_filename(_b->src, pfd->src_file_idx));
+            pfd->tokens = cmon_tokenize_with_interner(
+                &pfd->tokens_arena, _b->src, _b->interner, pfd->src_file_idx, &err);
+            cmon_trace_end(_b->trace, span);
+            pfd->parser = cmon_parser_create(&pfd->ast_arena);
+
+            // buffer potential tokenize errors
+            if (!cmon_err_report_is_empty(&err))
+            {
+                cmon_err_handler_add_err(_b->err_handler, cmon_true, &err);
+            }
+        }
+        cmon_trace_end(_b->trace, mod_span);
+    }
+    cmon_trace_end(_b->trace, phase_span);
 
     // return if files failed to tokenize
     cmon_err_handler_jump(_b->err_handler, cmon_true);
 
     // parse all the files
-    _log_status(_log, "    02. parsing src files\n");
+    _log_status(_log, "    04. parsing src files\n");
+    phase_span = cmon_trace_begin(_b->trace, "phase", "parsing src files");
     for (i = 0; i < cmon_modules_count(_b->mods); ++i)
     {
-        _log_status(_log, "        » %s\n", cmon_modules_path(_b->mods, i));
         _per_module_data * pmd = &_b->mod_data[i];
+        if (pmd->iface_state == _iface_state_imported)
+            continue;
+
+        _log_status(_log, "        » %s\n", cmon_modules_path(_b->mods, i));
+        mod_span = cmon_trace_begin(_b->trace, "module", "%s", cmon_modules_path(_b->mods, i));
 
         // setup everything needed per file
         for (j = 0; j < cmon_modules_src_file_count(_b->mods, i); ++j)
@@ -194,25 +525,35 @@ cmon_bool cmon_builder_st_build(cmon_builder_st * _b,
             _log_status(_log, "            » %s\n", cmon_src_filename(_b->src, src_file_idx));
 
             _per_file_data * pfd = &pmd->file_data[j];
+            span = cmon_trace_begin(
+                _b->trace, "file", "parse %s", cmon_src_filename(_b->src, src_file_idx));
             pfd->ast = cmon_parser_parse(pfd->parser, _b->src, pfd->src_file_idx, pfd->tokens);
+            cmon_trace_end(_b->trace, span);
             if (!pfd->ast)
             {
                 cmon_err_report err = cmon_parser_err(pfd->parser);
                 cmon_err_handler_add_err(_b->err_handler, cmon_true, &err);
             }
         }
+        cmon_trace_end(_b->trace, mod_span);
     }
+    cmon_trace_end(_b->trace, phase_span);
 
     // return if files failed to parse
     cmon_err_handler_jump(_b->err_handler, cmon_true);
 
     // resolve all the top level names for each module to determine which other modules they depend
     // on
-    _log_status(_log, "    03. resolving top level names\n");
+    _log_status(_log, "    05. resolving top level names\n");
+    phase_span = cmon_trace_begin(_b->trace, "phase", "resolving top level names");
     for (i = 0; i < cmon_modules_count(_b->mods); ++i)
     {
-        _log_status(_log, "        » %s\n", cmon_modules_path(_b->mods, i));
         _per_module_data * pmd = &_b->mod_data[i];
+        if (pmd->iface_state == _iface_state_imported)
+            continue;
+
+        _log_status(_log, "        » %s\n", cmon_modules_path(_b->mods, i));
+        mod_span = cmon_trace_begin(_b->trace, "module", "%s", cmon_modules_path(_b->mods, i));
         cmon_resolver_set_input(pmd->resolver, _b->src, _b->types, _b->symbols, _b->mods, i);
         for (j = 0; j < cmon_modules_src_file_count(_b->mods, i); ++j)
         {
@@ -226,14 +567,17 @@ cmon_bool cmon_builder_st_build(cmon_builder_st * _b,
         {
             _add_resolver_errors(_b, pmd->resolver, cmon_true);
         }
+        cmon_trace_end(_b->trace, mod_span);
     }
+    cmon_trace_end(_b->trace, phase_span);
 
     // return if modules errored during top level pass.
     cmon_err_handler_jump(_b->err_handler, cmon_true);
 
     //@TODO: move that somewhere else so it can be used by different build implementations
     // resolve dependency order between modules
-    _log_status(_log, "    04. resolving module dependency order\n");
+    _log_status(_log, "    06. resolving module dependency order\n");
+    phase_span = cmon_trace_begin(_b->trace, "phase", "resolving module dependency order");
     for (i = 0; i < cmon_modules_count(_b->mods); ++i)
     {
         cmon_dyn_arr_clear(&_b->dep_buf);
@@ -274,16 +618,42 @@ cmon_bool cmon_builder_st_build(cmon_builder_st * _b,
 
         cmon_err_handler_jump(_b->err_handler, cmon_true);
     }
+    cmon_trace_end(_b->trace, phase_span);
+
+    // the resolver of a module reads the ast of its direct dependencies (i.e. for the types of
+    // external variables), so they are kept until all of those are compiled.
+    for (i = 0; i < cmon_modules_count(_b->mods); ++i)
+    {
+        if (_b->mod_data[i].iface_state == _iface_state_imported)
+            continue;
+        for (j = 0; j < cmon_modules_dep_count(_b->mods, i); ++j)
+        {
+            ++_b->mod_data[cmon_modules_dep_mod_idx(_b->mods, i, j)].dependents_left;
+        }
+    }
 
     // resolve each module
-    _log_status(_log, "    05. compiling modules\n");
+    _log_status(_log, "    07. compiling modules\n");
+    phase_span = cmon_trace_begin(_b->trace, "phase", "compiling modules");
     for (i = 0; i < result.count; ++i)
     {
-        _log_status(_log, "        » %s\n", cmon_modules_path(_b->mods, result.array[i]));
-        _per_module_data * pmd = &_b->mod_data[result.array[i]];
+        cmon_idx mod_idx = result.array[i];
+        _per_module_data * pmd = &_b->mod_data[mod_idx];
+        //@NOTE: modules are hashed in dependency order, as their hash includes the interface hashes
+        // of their dependencies. That happens right after compiling them, before the src is released.
+        if (pmd->iface_state == _iface_state_imported)
+        {
+            cmon_build_manifest_hash_module(
+                _b->manifest, _b->src, _b->symbols, _b->types, mod_idx);
+            continue;
+        }
+
+        _log_status(_log, "        » %s\n", cmon_modules_path(_b->mods, mod_idx));
+        mod_span = cmon_trace_begin(_b->trace, "module", "%s", cmon_modules_path(_b->mods, mod_idx));
 
         _log_status(_log, "        01. user type pass\n");
-        for (j = 0; j < cmon_modules_src_file_count(_b->mods, i); ++j)
+        span = cmon_trace_begin(_b->trace, "pass", "user type pass");
+        for (j = 0; j < cmon_modules_src_file_count(_b->mods, mod_idx); ++j)
         {
             if (cmon_resolver_usertypes_pass(pmd->resolver, j))
             {
@@ -291,14 +661,20 @@ cmon_bool cmon_builder_st_build(cmon_builder_st * _b,
             }
         }
 
+        cmon_trace_end(_b->trace, span);
+
         _log_status(_log, "        02. globals pass\n");
+        span = cmon_trace_begin(_b->trace, "pass", "globals pass");
         if (cmon_resolver_globals_pass(pmd->resolver))
         {
             _add_resolver_errors(_b, pmd->resolver, cmon_true);
         }
 
+        cmon_trace_end(_b->trace, span);
+
         _log_status(_log, "        03. user type default expression pass\n");
-        for (j = 0; j < cmon_modules_src_file_count(_b->mods, i); ++j)
+        span = cmon_trace_begin(_b->trace, "pass", "user type default expression pass");
+        for (j = 0; j < cmon_modules_src_file_count(_b->mods, mod_idx); ++j)
         {
             if (cmon_resolver_usertypes_def_expr_pass(pmd->resolver, j))
             {
@@ -306,23 +682,40 @@ cmon_bool cmon_builder_st_build(cmon_builder_st * _b,
             }
         }
 
-        _log_status(_log, "        05. main pass\n");
-        for (j = 0; j < cmon_modules_src_file_count(_b->mods, i); ++j)
+        cmon_trace_end(_b->trace, span);
+
+        //@NOTE: the files of a module don't depend on each other during the main pass, so the errors
+        // of all files are reported (which is also what the multi threaded builder does as it
+        // resolves them concurrently).
+        _log_status(_log, "        04. main pass\n");
+        cmon_bool main_pass_failed = cmon_false;
+        for (j = 0; j < cmon_modules_src_file_count(_b->mods, mod_idx); ++j)
         {
-            if (cmon_resolver_main_pass(pmd->resolver, j))
-            {
-                _add_resolver_errors(_b, pmd->resolver, cmon_true);
-            }
+            span = cmon_trace_begin(_b->trace,
+                                    "file",
+                                    "main pass %s",
+                                    cmon_src_filename(_b->src, pmd->file_data[j].src_file_idx));
+            main_pass_failed |= cmon_resolver_main_pass(pmd->resolver, j);
+            cmon_trace_end(_b->trace, span);
+        }
+        if (main_pass_failed)
+        {
+            _add_resolver_errors(_b, pmd->resolver, cmon_true);
         }
 
-        _log_status(_log, "        04. dependency order pass\n");
+        _log_status(_log, "        05. dependency order pass\n");
+        span = cmon_trace_begin(_b->trace, "pass", "dependency order pass");
         if (cmon_resolver_circ_pass(pmd->resolver))
         {
             _add_resolver_errors(_b, pmd->resolver, cmon_true);
         }
 
+        cmon_trace_end(_b->trace, span);
+
         _log_status(_log, "        06. IR generation\n");
+        span = cmon_trace_begin(_b->trace, "pass", "IR generation");
         cmon_ir * ir = cmon_resolver_finalize(pmd->resolver);
+        cmon_trace_end(_b->trace, span);
 
         if (!ir)
         {
@@ -330,28 +723,64 @@ cmon_bool cmon_builder_st_build(cmon_builder_st * _b,
         }
 
         pmd->ir = ir;
-    }
+        cmon_build_manifest_hash_module(_b->manifest, _b->src, _b->symbols, _b->types, mod_idx);
 
-    // if codegen fails, we panic for now and call it a day.
-    _log_status(_log, "    06. code generation\n");
-    if (cmon_codegen_prepare(_codegen, _b->mods, _b->types, _build_dir))
-    {
-        cmon_panic(cmon_codegen_err_msg(_codegen));
+        for (j = 0; j < cmon_modules_dep_count(_b->mods, mod_idx); ++j)
+        {
+            cmon_idx dep = cmon_modules_dep_mod_idx(_b->mods, mod_idx, j);
+            --_b->mod_data[dep].dependents_left;
+            _try_release(_b, _build_dir, dep);
+        }
+        _try_release(_b, _build_dir, mod_idx);
+        cmon_trace_end(_b->trace, mod_span);
     }
+    cmon_trace_end(_b->trace, phase_span);
 
+    _log_status(_log, "    08. code generation\n");
+    phase_span = cmon_trace_begin(_b->trace, "phase", "code generation");
     for (i = 0; i < result.count; ++i)
     {
-        _log_status(_log, "        » %s\n", cmon_modules_path(_b->mods, result.array[i]));
         _per_module_data * pmd = &_b->mod_data[result.array[i]];
+        mod_span =
+            cmon_trace_begin(_b->trace, "module", "%s", cmon_modules_path(_b->mods, result.array[i]));
         cmon_idx session = cmon_codegen_begin_session(_codegen, result.array[i], pmd->ir);
-        if (cmon_codegen_gen(_codegen, session))
+        //@NOTE: imported modules have no IR, _import_module made sure that their output can be reused
+        if ((pmd->iface_state == _iface_state_imported ||
+             !cmon_build_manifest_module_changed(_b->manifest, result.array[i])) &&
+            !cmon_codegen_reuse(_codegen, session))
+        {
+            _log_status(
+                _log, "        » %s (up to date)\n", cmon_modules_path(_b->mods, result.array[i]));
+        }
+        else
         {
-            cmon_panic(cmon_codegen_session_err_msg(_codegen, session));
+            assert(pmd->ir);
+            _log_status(_log, "        » %s\n", cmon_modules_path(_b->mods, result.array[i]));
+            if (cmon_codegen_gen(_codegen, session))
+            {
+                cmon_panic(cmon_codegen_session_err_msg(_codegen, session));
+            }
         }
         cmon_codegen_end_session(_codegen, session);
+        cmon_trace_end(_b->trace, mod_span);
+    }
+    cmon_trace_end(_b->trace, phase_span);
+
+    // wait for the c compiler (or whatever else the codegen does asynchronously)
+    phase_span = cmon_trace_begin(_b->trace, "phase", "waiting for codegen");
+    if (cmon_codegen_finish(_codegen))
+    {
+        cmon_panic(cmon_codegen_err_msg(_codegen));
     }
+    cmon_trace_end(_b->trace, phase_span);
+
+    //@NOTE: the manifest is only a cache. If it can't be saved, the next build simply rebuilds
+    // everything.
+    cmon_build_manifest_save(_b->manifest, manifest_path);
+    _write_ifaces(_b, _build_dir);
 
     _log_status(_log, "<- cmon_builder_st finished\n");
+    cmon_trace_end(_b->trace, build_span);
 
     return cmon_false;
 err_end:
@@ -376,4 +805,8 @@ cmon_bool cmon_builder_st_errors(cmon_builder_st * _b,
 cmon_types * cmon_builder_st_types(cmon_builder_st * _b)
 {
     return _b->types;
-}
\ No newline at end of file
+}
+cmon_symbols * cmon_builder_st_symbols(cmon_builder_st * _b)
+{
+    return _b->symbols;
+}
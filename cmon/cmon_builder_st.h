@@ -5,7 +5,10 @@
 #include <cmon/cmon_err_report.h>
 #include <cmon/cmon_modules.h>
 #include <cmon/cmon_log.h>
+#include <cmon/cmon_mem_stats.h>
 #include <cmon/cmon_src.h>
+#include <cmon/cmon_symbols.h>
+#include <cmon/cmon_trace.h>
 
 typedef struct cmon_builder_st cmon_builder_st;
 
@@ -14,10 +17,20 @@ CMON_API cmon_builder_st * cmon_builder_st_create(cmon_allocator * _alloc,
                                                   cmon_src * _src,
                                                   cmon_modules * _mods);
 CMON_API void cmon_builder_st_destroy(cmon_builder_st * _b);
+// record spans for the build phases, modules and files in _trace. _trace may be NULL (the default).
+CMON_API void cmon_builder_st_set_trace(cmon_builder_st * _b, cmon_trace * _trace);
+// account the memory of the tokens, asts, symbols, types and IR (including the resolvers) in
+// _stats. Has to be called before building.
+CMON_API void cmon_builder_st_set_mem_stats(cmon_builder_st * _b, cmon_mem_stats * _stats);
+// release the src, tokens and ast of each module as soon as it and all modules depending on it are
+// compiled, which keeps the peak memory of large builds down. Diagnostics that refer to a released
+// file load and tokenize it again. Off by default.
+CMON_API void cmon_builder_st_set_release_src(cmon_builder_st * _b, cmon_bool _release);
 CMON_API cmon_bool cmon_builder_st_build(cmon_builder_st * _b, cmon_codegen * _codegen, const char * _build_dir, cmon_log * _log);
 CMON_API cmon_bool cmon_builder_st_errors(cmon_builder_st * _b,
                                           cmon_err_report ** _out_errs,
                                           size_t * _out_count);
 CMON_API cmon_types * cmon_builder_st_types(cmon_builder_st * _b);
+CMON_API cmon_symbols * cmon_builder_st_symbols(cmon_builder_st * _b);
 
 #endif // CMON_CMON_BUILDER_ST_H
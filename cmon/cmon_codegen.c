@@ -21,6 +21,21 @@ static inline cmon_bool _empty_gen(void * _obj, cmon_idx _session_idx)
     return cmon_false;
 }
 
+static inline cmon_bool _empty_finish(void * _obj)
+{
+    return cmon_false;
+}
+
+static inline const char * _empty_flags(void * _obj)
+{
+    return "";
+}
+
+static inline cmon_bool _empty_reuse(void * _obj, cmon_idx _session_idx)
+{
+    return cmon_true;
+}
+
 static inline const char * _empty_err_msg(void * _obj)
 {
     return "";
@@ -41,6 +56,9 @@ cmon_codegen cmon_codegen_make_empty()
     ret.fn = _empty_gen;
     ret.err_msg_fn = _empty_err_msg;
     ret.sess_err_msg_fn = _empty_session_err_msg;
+    ret.finish_fn = _empty_finish;
+    ret.flags_fn = _empty_flags;
+    ret.reuse_fn = _empty_reuse;
     ret.shutdown_fn = NULL;
     return ret;
 }
@@ -69,6 +87,24 @@ cmon_bool cmon_codegen_gen(cmon_codegen * _cg, cmon_idx _session_idx)
     return _cg->fn(_cg->obj, _session_idx);
 }
 
+cmon_bool cmon_codegen_reuse(cmon_codegen * _cg, cmon_idx _session_idx)
+{
+    assert(_cg->reuse_fn);
+    return _cg->reuse_fn(_cg->obj, _session_idx);
+}
+
+const char * cmon_codegen_flags(cmon_codegen * _cg)
+{
+    assert(_cg->flags_fn);
+    return _cg->flags_fn(_cg->obj);
+}
+
+cmon_bool cmon_codegen_finish(cmon_codegen * _cg)
+{
+    assert(_cg->finish_fn);
+    return _cg->finish_fn(_cg->obj);
+}
+
 const char * cmon_codegen_err_msg(cmon_codegen * _cg)
 {
     assert(_cg->err_msg_fn);
@@ -13,6 +13,9 @@ typedef cmon_bool (*cmon_codegen_fn)(void *, cmon_idx);
 typedef void (*cmon_codegen_shutdown_fn)(void *);
 typedef const char * (*cmon_codegen_session_err_msg_fn)(void *, cmon_idx);
 typedef const char * (*cmon_codegen_err_msg_fn)(void *);
+typedef cmon_bool (*cmon_codegen_finish_fn)(void *);
+typedef const char * (*cmon_codegen_flags_fn)(void *);
+typedef cmon_bool (*cmon_codegen_reuse_fn)(void *, cmon_idx);
 
 typedef struct
 {
@@ -24,6 +27,9 @@ typedef struct
     cmon_codegen_shutdown_fn shutdown_fn;
     cmon_codegen_err_msg_fn err_msg_fn;
     cmon_codegen_session_err_msg_fn sess_err_msg_fn;
+    cmon_codegen_finish_fn finish_fn;
+    cmon_codegen_flags_fn flags_fn;
+    cmon_codegen_reuse_fn reuse_fn;
 } cmon_codegen;
 
 CMON_API cmon_codegen cmon_codegen_make_empty();
@@ -32,6 +38,18 @@ CMON_API cmon_bool cmon_codegen_prepare(cmon_codegen * _cg, cmon_modules * _mods
 CMON_API cmon_idx cmon_codegen_begin_session(cmon_codegen * _cg, cmon_idx _mod_idx, cmon_ir * _ir);
 CMON_API void cmon_codegen_end_session(cmon_codegen * _cg, cmon_idx _session_idx);
 CMON_API cmon_bool cmon_codegen_gen(cmon_codegen * _cg, cmon_idx _session_idx);
+// reuse the output of a previous build for the module of the session instead of generating it again.
+// Returns cmon_true if that is not possible (i.e. the output is missing), in which case the module has
+// to be generated via cmon_codegen_gen. The IR of the session may be NULL for modules that were
+// imported from an interface file (see cmon_mod_iface.h).
+CMON_API cmon_bool cmon_codegen_reuse(cmon_codegen * _cg, cmon_idx _session_idx);
+// describes all settings that affect the generated output (i.e. the c compiler command). Previous
+// output is only reused if the flags did not change.
+CMON_API const char * cmon_codegen_flags(cmon_codegen * _cg);
+// codegen backends might do some of their work asynchronously (i.e. running the c compiler). This
+// waits for all of it to finish and returns cmon_true if any of it failed (see
+// cmon_codegen_err_msg).
+CMON_API cmon_bool cmon_codegen_finish(cmon_codegen * _cg);
 CMON_API const char * cmon_codegen_err_msg(cmon_codegen * _cg);
 CMON_API const char * cmon_codegen_session_err_msg(cmon_codegen * _cg, cmon_idx _session_idx);
 
@@ -2,11 +2,36 @@
 #include <cmon/cmon_dyn_arr.h>
 #include <cmon/cmon_exec.h>
 #include <cmon/cmon_fs.h>
+#include <cmon/cmon_job_pool.h>
 #include <cmon/cmon_str_builder.h>
 #include <cmon/cmon_util.h>
+#include <pthread.h>
+
+// c compiler invocations to compile a module to an object file and to link executables
+#define _CC_COMPILE "gcc -c"
+#define _CC_LINK "gcc"
 
 typedef struct _codegen_c _codegen_c;
 
+// a single c compiler invocation. Jobs only start once all the jobs they depend on are done (i.e.
+// linking an executable waits for the object files it needs).
+typedef struct _c_job
+{
+    _codegen_c * cgen;
+    // what the job does (i.e. "compile" or "link") and for which module, only used for tracing
+    const char * kind;
+    cmon_idx mod_idx;
+    cmon_str_builder * cmd;
+    cmon_str_builder * output;
+    int status;
+    // the fields below are protected by the job mutex of the codegen
+    cmon_bool done;
+    // set if any of the jobs this job depends on failed, in which case the job does not run
+    cmon_bool skipped;
+    size_t pending_dep_count;
+    cmon_dyn_arr(struct _c_job *) dependents;
+} _c_job;
+
 typedef struct
 {
     _codegen_c * cgen;
@@ -14,7 +39,6 @@ typedef struct
     cmon_ir * ir;
     cmon_str_builder * str_builder;
     cmon_str_builder * tmp_str_builder;
-    cmon_str_builder * c_compiler_output_builder;
     char c_path[CMON_PATH_MAX];
     char o_path[CMON_PATH_MAX];
     char err_msg[CMON_ERR_MSG_MAX];
@@ -32,6 +56,14 @@ typedef struct _codegen_c
     char err_msg[CMON_ERR_MSG_MAX];
     cmon_dyn_arr(_session) sessions;
     cmon_dyn_arr(cmon_idx) free_sessions;
+    size_t job_count;
+    cmon_job_pool * job_pool;
+    cmon_trace * trace;
+    pthread_mutex_t job_mtx;
+    // all jobs in the order they were added
+    cmon_dyn_arr(_c_job *) jobs;
+    // the job producing the object file for each module (NULL if not generated yet)
+    cmon_dyn_arr(_c_job *) mod_jobs;
 } _codegen_c;
 
 static inline cmon_bool _set_err(_codegen_c * _cg, const char * _msg)
@@ -279,6 +311,14 @@ static inline void _write_named_fn_ptr(_session * _s, const char * _name, cmon_i
     cmon_str_builder_append(_s->str_builder, ")");
 }
 
+// literal initializers of global variables are emitted as static initializers and skipped in the
+// global init function
+static inline cmon_bool _is_static_init(_session * _s, cmon_idx _expr)
+{
+    cmon_irk kind = cmon_ir_kind(_s->ir, _expr);
+    return kind == cmon_irk_int_lit || kind == cmon_irk_float_lit || kind == cmon_irk_bool_lit;
+}
+
 static inline void _write_var_decl(_session * _s, cmon_idx _idx, cmon_bool _is_global)
 {
     cmon_idx expr = cmon_ir_var_decl_expr(_s->ir, _idx);
@@ -296,7 +336,7 @@ static inline void _write_var_decl(_session * _s, cmon_idx _idx, cmon_bool _is_g
         _write_type(_s, cmon_ir_var_decl_type(_s->ir, _idx));
         cmon_str_builder_append_fmt(_s->str_builder, " %s", cmon_ir_var_decl_name(_s->ir, _idx));
     }
-    if (!_is_global && cmon_is_valid_idx(expr))
+    if (cmon_is_valid_idx(expr) && (!_is_global || _is_static_init(_s, expr)))
     {
         cmon_str_builder_append(_s->str_builder, " = ");
         _write_expr(_s, expr);
@@ -337,6 +377,105 @@ static inline void _write_stmt(_session * _s, cmon_idx _idx, size_t _indent)
     }
 }
 
+static void _c_job_fn(void * _data)
+{
+    _c_job * job = (_c_job *)_data;
+    size_t i;
+
+    if (!job->skipped)
+    {
+        cmon_idx span = cmon_trace_begin(job->cgen->trace,
+                                         "cc",
+                                         "%s %s",
+                                         job->kind,
+                                         cmon_modules_name(job->cgen->mods, job->mod_idx));
+        job->status = cmon_exec(cmon_str_builder_c_str(job->cmd), job->output);
+        cmon_trace_end(job->cgen->trace, span);
+    }
+
+    pthread_mutex_lock(&job->cgen->job_mtx);
+    job->done = cmon_true;
+    for (i = 0; i < cmon_dyn_arr_count(&job->dependents); ++i)
+    {
+        _c_job * dep = job->dependents[i];
+        if (job->skipped || job->status != 0)
+            dep->skipped = cmon_true;
+
+        if (--dep->pending_dep_count == 0)
+            cmon_job_pool_add(job->cgen->job_pool, _c_job_fn, dep);
+    }
+    pthread_mutex_unlock(&job->cgen->job_mtx);
+}
+
+// adds a job running _cmd once all _deps are done. NULL entries in _deps are ignored.
+static inline _c_job * _add_c_job(_codegen_c * _cg,
+                                  const char * _kind,
+                                  cmon_idx _mod_idx,
+                                  const char * _cmd,
+                                  _c_job ** _deps,
+                                  size_t _dep_count)
+{
+    size_t i;
+    _c_job * ret = CMON_CREATE(_cg->alloc, _c_job);
+    ret->cgen = _cg;
+    ret->kind = _kind;
+    ret->mod_idx = _mod_idx;
+    ret->cmd = cmon_str_builder_create(_cg->alloc, CMON_PATH_MAX);
+    cmon_str_builder_append(ret->cmd, _cmd);
+    ret->output = cmon_str_builder_create(_cg->alloc, CMON_PATH_MAX);
+    ret->status = 0;
+    ret->done = cmon_false;
+    ret->skipped = cmon_false;
+    ret->pending_dep_count = 0;
+    cmon_dyn_arr_init(&ret->dependents, _cg->alloc, 2);
+
+    pthread_mutex_lock(&_cg->job_mtx);
+    cmon_dyn_arr_append(&_cg->jobs, ret);
+    for (i = 0; i < _dep_count; ++i)
+    {
+        _c_job * dep = _deps[i];
+        if (!dep)
+            continue;
+
+        if (!dep->done)
+        {
+            cmon_dyn_arr_append(&dep->dependents, ret);
+            ++ret->pending_dep_count;
+        }
+        else if (dep->skipped || dep->status != 0)
+        {
+            ret->skipped = cmon_true;
+        }
+    }
+
+    if (!ret->pending_dep_count)
+    {
+        cmon_job_pool_add(_cg->job_pool, _c_job_fn, ret);
+    }
+    pthread_mutex_unlock(&_cg->job_mtx);
+
+    return ret;
+}
+
+static inline void _destroy_c_job(_c_job * _job)
+{
+    cmon_dyn_arr_dealloc(&_job->dependents);
+    cmon_str_builder_destroy(_job->output);
+    cmon_str_builder_destroy(_job->cmd);
+    CMON_DESTROY(_job->cgen->alloc, _job);
+}
+
+static inline void _clear_c_jobs(_codegen_c * _cg)
+{
+    size_t i;
+    for (i = 0; i < cmon_dyn_arr_count(&_cg->jobs); ++i)
+    {
+        _destroy_c_job(_cg->jobs[i]);
+    }
+    cmon_dyn_arr_clear(&_cg->jobs);
+    cmon_dyn_arr_clear(&_cg->mod_jobs);
+}
+
 static inline cmon_bool _codegen_c_prep_fn(void * _cg,
                                            cmon_modules * _mods,
                                            cmon_types * _types,
@@ -348,6 +487,15 @@ static inline cmon_bool _codegen_c_prep_fn(void * _cg,
     cg->types = _types;
     strcpy(cg->build_dir, _build_dir);
 
+    if (!cg->job_pool)
+    {
+        cg->job_pool = cmon_job_pool_create(cg->alloc, cg->job_count);
+    }
+
+    _clear_c_jobs(cg);
+    cmon_dyn_arr_resize(&cg->mod_jobs, cmon_modules_count(_mods));
+    memset(&cg->mod_jobs[0], 0, sizeof(_c_job *) * cmon_modules_count(_mods));
+
     if (!cmon_fs_exists(cg->build_dir))
     {
         return _set_err(cg, "missing build directory");
@@ -401,7 +549,6 @@ static inline cmon_bool _create_mod_dirs(_session * _s,
     for (size_t i = 0; i < cmon_modules_path_token_count(_s->cgen->mods, _s->mod_idx); ++i)
     {
         cmon_str_view dn = cmon_modules_path_token(_s->cgen->mods, _s->mod_idx, i);
-        printf("PATH TOKEN %.*s\n", dn.end - dn.begin, dn.begin);
         //@NOTE: Hacky way to ignore the src path prefix for now
         // if (i == 0 && cmon_str_view_c_str_cmp(dn, "src") == 0)
         // {
@@ -446,6 +593,101 @@ static inline cmon_bool _create_dir(_session * _s, const char * _path)
     return cmon_false;
 }
 
+static inline cmon_bool _create_o_path(_session * _s)
+{
+    char odir_path[CMON_PATH_MAX];
+    if (_create_mod_dirs(_s, _s->cgen->o_dir, odir_path, sizeof(odir_path)))
+        return cmon_true;
+    cmon_join_paths(odir_path,
+                    cmon_str_builder_tmp_str(_s->tmp_str_builder,
+                                             "%s.o",
+                                             cmon_modules_prefix(_s->cgen->mods, _s->mod_idx)),
+                    _s->o_path,
+                    sizeof(_s->o_path));
+    return cmon_false;
+}
+
+// an executable only needs to be linked again if it is missing or if any of the object files it is
+// linked from got compiled again (or is newer than the executable).
+static inline cmon_bool _needs_link(_session * _s,
+                                    const char * _exe_path,
+                                    _c_job ** _deps,
+                                    size_t _dep_count)
+{
+    size_t i;
+    cmon_fs_timestamp exe_time, o_time;
+
+    for (i = 0; i < _dep_count; ++i)
+    {
+        if (_deps[i])
+            return cmon_true;
+    }
+
+    if (cmon_fs_last_chage_time(_exe_path, &exe_time) != 0)
+        return cmon_true;
+
+    if (cmon_fs_last_chage_time(_s->o_path, &o_time) != 0 ||
+        cmon_fs_timestamp_cmp(&o_time, &exe_time) > 0)
+        return cmon_true;
+
+    for (i = 0; i < cmon_ir_dep_count(_s->ir); ++i)
+    {
+        cmon_str_builder_clear(_s->tmp_str_builder);
+        _append_mod_o_path(_s, cmon_ir_dep_module(_s->ir, (cmon_idx)i), _s->tmp_str_builder);
+        if (cmon_fs_last_chage_time(cmon_str_builder_c_str(_s->tmp_str_builder), &o_time) != 0 ||
+            cmon_fs_timestamp_cmp(&o_time, &exe_time) > 0)
+            return cmon_true;
+    }
+
+    return cmon_false;
+}
+
+// link the executable. This only waits for the object files of this module and its dependencies.
+// _obj_job is the job compiling this module (NULL if the object file was reused).
+static inline cmon_bool _add_link_job(_session * _s, _c_job * _obj_job)
+{
+    size_t i;
+    char exe_dir_path[CMON_PATH_MAX];
+    char exe_path[CMON_PATH_MAX];
+    if (_create_mod_dirs(_s, _s->cgen->build_dir, exe_dir_path, sizeof(exe_dir_path)))
+        return cmon_true;
+
+    cmon_join_paths(
+        exe_dir_path, cmon_modules_prefix(_s->cgen->mods, _s->mod_idx), exe_path, sizeof(exe_path));
+
+    cmon_dyn_arr(_c_job *) deps;
+    cmon_dyn_arr_init(&deps, _s->cgen->alloc, cmon_ir_dep_count(_s->ir) + 1);
+    cmon_dyn_arr_append(&deps, _obj_job);
+    for (i = 0; i < cmon_ir_dep_count(_s->ir); ++i)
+    {
+        cmon_dyn_arr_append(&deps, _s->cgen->mod_jobs[cmon_ir_dep_module(_s->ir, (cmon_idx)i)]);
+    }
+
+    if (_needs_link(_s, exe_path, &deps[0], cmon_dyn_arr_count(&deps)))
+    {
+        cmon_str_builder_clear(_s->tmp_str_builder);
+        cmon_str_builder_append_fmt(_s->tmp_str_builder, "%s %s ", _CC_LINK, _s->o_path);
+        for (i = 0; i < cmon_ir_dep_count(_s->ir); ++i)
+        {
+            //@NOTE: for now we regenerate the path whenever needed. Makes it simple and also more
+            // suitable for threading in the future possibly?
+            _append_mod_o_path(_s, cmon_ir_dep_module(_s->ir, (cmon_idx)i), _s->tmp_str_builder);
+            cmon_str_builder_append(_s->tmp_str_builder, " ");
+        }
+        cmon_str_builder_append_fmt(_s->tmp_str_builder, "-o %s 2>&1", exe_path);
+
+        _add_c_job(_s->cgen,
+                   "link",
+                   _s->mod_idx,
+                   cmon_str_builder_c_str(_s->tmp_str_builder),
+                   &deps[0],
+                   cmon_dyn_arr_count(&deps));
+    }
+    cmon_dyn_arr_dealloc(&deps);
+
+    return cmon_false;
+}
+
 static inline cmon_bool _gen_fn(_session * _s)
 {
     cmon_str_builder_append(_s->str_builder, _top_code());
@@ -564,7 +806,8 @@ static inline cmon_bool _gen_fn(_session * _s)
     for (i = 0; i < cmon_ir_global_var_count(_s->ir); ++i)
     {
         cmon_idx var = cmon_ir_global_var(_s->ir, i);
-        if (cmon_is_valid_idx(cmon_ir_var_decl_expr(_s->ir, var)))
+        if (cmon_is_valid_idx(cmon_ir_var_decl_expr(_s->ir, var)) &&
+            !_is_static_init(_s, cmon_ir_var_decl_expr(_s->ir, var)))
         {
             _write_indent(_s, 1);
             cmon_str_builder_append_fmt(
@@ -622,65 +865,43 @@ static inline cmon_bool _gen_fn(_session * _s)
         return _set_sess_err(_s, "could not save c file");
     }
 
-    if (!cmon_is_valid_idx(main_fn))
-    {
-        char odir_path[CMON_PATH_MAX];
-        if (_create_mod_dirs(_s, _s->cgen->o_dir, odir_path, sizeof(odir_path)))
-            return cmon_true;
-        cmon_join_paths(odir_path,
-                        cmon_str_builder_tmp_str(_s->tmp_str_builder,
-                                                 "%s.o",
-                                                 cmon_modules_prefix(_s->cgen->mods, _s->mod_idx)),
-                        _s->o_path,
-                        sizeof(_s->o_path));
-    }
-    else
-    {
-        char exe_path[CMON_PATH_MAX];
-        if (_create_mod_dirs(_s, _s->cgen->build_dir, exe_path, sizeof(exe_path)))
-            return cmon_true;
+    // every module (including executables) gets compiled to an object file first
+    if (_create_o_path(_s))
+        return cmon_true;
 
-        cmon_join_paths(exe_path,
-                        cmon_str_builder_tmp_str(_s->tmp_str_builder,
-                                                 "%s",
-                                                 cmon_modules_prefix(_s->cgen->mods, _s->mod_idx)),
-                        _s->o_path,
-                        sizeof(_s->o_path));
-    }
+    _c_job * obj_job = _add_c_job(_s->cgen,
+                                  "compile",
+                                  _s->mod_idx,
+                                  cmon_str_builder_tmp_str(_s->tmp_str_builder,
+                                                           "%s %s -o %s 2>&1",
+                                                           _CC_COMPILE,
+                                                           _s->c_path,
+                                                           _s->o_path),
+                                  NULL,
+                                  0);
+    _s->cgen->mod_jobs[_s->mod_idx] = obj_job;
 
-    // generate the command to compile the c code
-    cmon_str_builder_clear(_s->tmp_str_builder);
-    if (!cmon_is_valid_idx(main_fn))
-    {
-        // for non-executable modules, simply build the .o file
-        cmon_str_builder_append_fmt(
-            _s->tmp_str_builder, "gcc -c %s -o %s 2>&1", _s->c_path, _s->o_path);
-    }
-    else
+    if (cmon_is_valid_idx(main_fn))
     {
-        // build the .c file and link all dependencies .o files to create the executable
-        cmon_str_builder_append_fmt(_s->tmp_str_builder, "gcc %s ", _s->c_path);
-        for (i = 0; i < cmon_ir_dep_count(_s->ir); ++i)
-        {
-            //@NOTE: for now we regenerate the path whenever needed. Makes it simple and also more
-            // suitable for threading in the future possibly?
-            _append_mod_o_path(_s, cmon_ir_dep_module(_s->ir, (cmon_idx)i), _s->tmp_str_builder);
-            cmon_str_builder_append(_s->tmp_str_builder, " ");
-        }
-        cmon_str_builder_append_fmt(_s->tmp_str_builder, "-o %s 2>&1", _s->o_path);
+        return _add_link_job(_s, obj_job);
     }
 
-    printf("DA CMD %s\n\n", cmon_str_builder_c_str(_s->tmp_str_builder));
-    int status =
-        cmon_exec(cmon_str_builder_c_str(_s->tmp_str_builder), _s->c_compiler_output_builder);
+    return cmon_false;
+}
+
+static inline cmon_bool _reuse_fn(_session * _s)
+{
+    if (_create_o_path(_s))
+        return cmon_true;
 
-    if (status != 0)
+    if (!cmon_fs_exists(_s->o_path))
+        return cmon_true;
+
+    //@NOTE: the object file is up to date, so there is no job producing it and mod_jobs stays NULL
+    // for this module. Modules imported from an interface file have no IR and are never main.
+    if (_s->ir && cmon_is_valid_idx(cmon_ir_main_fn(_s->ir)))
     {
-        return _set_sess_err(
-            _s,
-            cmon_str_builder_tmp_str(_s->tmp_str_builder,
-                                     "c compiler error: %s",
-                                     cmon_str_builder_c_str(_s->c_compiler_output_builder)));
+        return _add_link_job(_s, NULL);
     }
 
     return cmon_false;
@@ -693,6 +914,18 @@ static inline cmon_bool _codegen_c_gen_fn(void * _cg, cmon_idx _session_idx)
     return _gen_fn(s);
 }
 
+static inline cmon_bool _codegen_c_reuse_fn(void * _cg, cmon_idx _session_idx)
+{
+    _codegen_c * cg = (_codegen_c *)_cg;
+    _session * s = &cg->sessions[_session_idx];
+    return _reuse_fn(s);
+}
+
+static inline const char * _codegen_c_flags_fn(void * _cg)
+{
+    return _CC_COMPILE "; " _CC_LINK;
+}
+
 static inline cmon_idx _reset_session(_codegen_c * _cg,
                                       cmon_idx _session_idx,
                                       cmon_idx _mod_idx,
@@ -701,7 +934,6 @@ static inline cmon_idx _reset_session(_codegen_c * _cg,
     _session * s = &_cg->sessions[_session_idx];
     cmon_str_builder_clear(s->str_builder);
     cmon_str_builder_clear(s->tmp_str_builder);
-    cmon_str_builder_clear(s->c_compiler_output_builder);
     s->mod_idx = _mod_idx;
     s->ir = _ir;
     return _session_idx;
@@ -718,7 +950,6 @@ static inline cmon_idx _codegen_c_begin_session(void * _cg, cmon_idx _mod_idx, c
     _session s;
     s.str_builder = cmon_str_builder_create(cg->alloc, 2048);
     s.tmp_str_builder = cmon_str_builder_create(cg->alloc, CMON_PATH_MAX);
-    s.c_compiler_output_builder = cmon_str_builder_create(cg->alloc, CMON_PATH_MAX);
     s.mod_idx = _mod_idx;
     s.ir = _ir;
     s.cgen = cg;
@@ -732,14 +963,52 @@ static inline void _codegen_c_end_session(void * _cg, cmon_idx _session_idx)
     cmon_dyn_arr_append(&cg->free_sessions, _session_idx);
 }
 
+static inline cmon_bool _codegen_c_finish_fn(void * _cg)
+{
+    _codegen_c * cg = (_codegen_c *)_cg;
+    cmon_bool ret = cmon_false;
+    size_t i;
+
+    if (!cg->job_pool)
+        return cmon_false;
+
+    cmon_job_pool_wait(cg->job_pool);
+
+    // report the first job that failed in the order they were added to keep things deterministic
+    for (i = 0; i < cmon_dyn_arr_count(&cg->jobs); ++i)
+    {
+        _c_job * job = cg->jobs[i];
+        if (!job->skipped && job->status != 0)
+        {
+            //@NOTE: the compiler output can be long, so we truncate rather than use _set_err
+            snprintf(cg->err_msg,
+                     sizeof(cg->err_msg),
+                     "c compiler error: %s",
+                     cmon_str_builder_c_str(job->output));
+            ret = cmon_true;
+            break;
+        }
+    }
+
+    _clear_c_jobs(cg);
+    return ret;
+}
+
 static inline void _codegen_c_shutdown_fn(void * _cg)
 {
     _codegen_c * cg = (_codegen_c *)_cg;
+
+    //@NOTE: make sure that no job is running anymore before we pull the memory out from under it
+    cmon_job_pool_destroy(cg->job_pool);
+    _clear_c_jobs(cg);
+    cmon_dyn_arr_dealloc(&cg->mod_jobs);
+    cmon_dyn_arr_dealloc(&cg->jobs);
+    pthread_mutex_destroy(&cg->job_mtx);
+
     cmon_dyn_arr_dealloc(&cg->free_sessions);
     for (size_t i = 0; i < cmon_dyn_arr_count(&cg->sessions); ++i)
     {
         _session * s = &cg->sessions[i];
-        cmon_str_builder_destroy(s->c_compiler_output_builder);
         cmon_str_builder_destroy(s->tmp_str_builder);
         cmon_str_builder_destroy(s->str_builder);
     }
@@ -760,6 +1029,11 @@ static inline const char * _codegen_c_sess_err_msg_fn(void * _cg, cmon_idx _sess
 }
 
 cmon_codegen cmon_codegen_c_make(cmon_allocator * _alloc)
+{
+    return cmon_codegen_c_make_with_jobs(_alloc, 0);
+}
+
+cmon_codegen cmon_codegen_c_make_with_jobs(cmon_allocator * _alloc, size_t _job_count)
 {
     _codegen_c * cgen = CMON_CREATE(_alloc, _codegen_c);
     cgen->alloc = _alloc;
@@ -767,6 +1041,12 @@ cmon_codegen cmon_codegen_c_make(cmon_allocator * _alloc)
     cgen->mods = NULL;
     cmon_dyn_arr_init(&cgen->sessions, _alloc, 4);
     cmon_dyn_arr_init(&cgen->free_sessions, _alloc, 4);
+    cgen->job_count = _job_count;
+    cgen->job_pool = NULL;
+    cgen->trace = NULL;
+    pthread_mutex_init(&cgen->job_mtx, NULL);
+    cmon_dyn_arr_init(&cgen->jobs, _alloc, 16);
+    cmon_dyn_arr_init(&cgen->mod_jobs, _alloc, 16);
     return (cmon_codegen){ cgen,
                            _codegen_c_prep_fn,
                            _codegen_c_begin_session,
@@ -774,5 +1054,13 @@ cmon_codegen cmon_codegen_c_make(cmon_allocator * _alloc)
                            _codegen_c_gen_fn,
                            _codegen_c_shutdown_fn,
                            _codegen_c_err_msg_fn,
-                           _codegen_c_sess_err_msg_fn };
+                           _codegen_c_sess_err_msg_fn,
+                           _codegen_c_finish_fn,
+                           _codegen_c_flags_fn,
+                           _codegen_c_reuse_fn };
+}
+
+void cmon_codegen_c_set_trace(cmon_codegen * _cg, cmon_trace * _trace)
+{
+    ((_codegen_c *)_cg->obj)->trace = _trace;
 }
@@ -3,8 +3,14 @@
 
 #include <cmon/cmon_codegen.h>
 #include <cmon/cmon_modules.h>
+#include <cmon/cmon_trace.h>
 #include <cmon/cmon_types.h>
 
+// The c compiler is run asynchronously, running up to _job_count compiler processes at once (0 uses
+// one per hardware thread). cmon_codegen_c_make uses the default job count.
 CMON_API cmon_codegen cmon_codegen_c_make(cmon_allocator * _alloc);
+CMON_API cmon_codegen cmon_codegen_c_make_with_jobs(cmon_allocator * _alloc, size_t _job_count);
+// records a span for every c compiler invocation. _trace may be NULL (the default).
+CMON_API void cmon_codegen_c_set_trace(cmon_codegen * _cg, cmon_trace * _trace);
 
 #endif //CMON_CMON_CODEGEN_C_H
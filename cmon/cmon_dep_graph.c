@@ -13,6 +13,8 @@ typedef struct cmon_dep_graph_node
     cmon_idx data;
     cmon_dyn_arr(struct cmon_dep_graph_node *) deps;
     cmon_dep_graph_mark mark;
+    // length of the longest dependency chain below this node, set once the node is resolved
+    size_t level;
 } cmon_dep_graph_node;
 
 typedef struct cmon_dep_graph
@@ -22,6 +24,10 @@ typedef struct cmon_dep_graph
     cmon_dyn_arr(cmon_dep_graph_node *) unresolved;
     cmon_dyn_arr(cmon_dep_graph_node *) unmarked;
     cmon_dyn_arr(cmon_idx) resolved;
+    cmon_dyn_arr(size_t) resolved_levels;
+    // resolved items sorted by level. Items of the same level don't depend on each other.
+    cmon_dyn_arr(cmon_idx) waves;
+    cmon_dyn_arr(size_t) wave_offsets;
 
     // thse are set to the first nodes with a cyclic dependency
     cmon_idx conflict_a, conflict_b;
@@ -66,6 +72,7 @@ static cmon_dep_graph_node * _create_node(cmon_dep_graph * _g,
     cmon_dep_graph_node * ret = CMON_CREATE(_g->alloc, cmon_dep_graph_node);
     ret->data = _data;
     ret->mark = cmon_dep_graph_mark_none;
+    ret->level = 0;
 
     cmon_dyn_arr_init(&ret->deps, _g->alloc, 4);
     cmon_dyn_arr_append(&_g->nodes, ret);
@@ -104,6 +111,9 @@ cmon_dep_graph * cmon_dep_graph_create(cmon_allocator * _alloc)
     cmon_dyn_arr_init(&ret->unresolved, _alloc, 32);
     cmon_dyn_arr_init(&ret->unmarked, _alloc, 32);
     cmon_dyn_arr_init(&ret->resolved, _alloc, 32);
+    cmon_dyn_arr_init(&ret->resolved_levels, _alloc, 32);
+    cmon_dyn_arr_init(&ret->waves, _alloc, 32);
+    cmon_dyn_arr_init(&ret->wave_offsets, _alloc, 8);
     ret->resolved_count = 0;
     ret->conflict_a = ret->conflict_b = CMON_INVALID_IDX;
     return ret;
@@ -112,6 +122,9 @@ cmon_dep_graph * cmon_dep_graph_create(cmon_allocator * _alloc)
 void cmon_dep_graph_destroy(cmon_dep_graph * _g)
 {
     cmon_dep_graph_clear(_g);
+    cmon_dyn_arr_dealloc(&_g->wave_offsets);
+    cmon_dyn_arr_dealloc(&_g->waves);
+    cmon_dyn_arr_dealloc(&_g->resolved_levels);
     cmon_dyn_arr_dealloc(&_g->resolved);
     cmon_dyn_arr_dealloc(&_g->unmarked);
     cmon_dyn_arr_dealloc(&_g->unresolved);
@@ -129,6 +142,9 @@ void cmon_dep_graph_clear(cmon_dep_graph * _g)
         cmon_dyn_arr_dealloc(&n->deps);
         CMON_DESTROY(_g->alloc, n);
     }
+    cmon_dyn_arr_clear(&_g->wave_offsets);
+    cmon_dyn_arr_clear(&_g->waves);
+    cmon_dyn_arr_clear(&_g->resolved_levels);
     cmon_dyn_arr_clear(&_g->resolved);
     cmon_dyn_arr_clear(&_g->unmarked);
     cmon_dyn_arr_clear(&_g->unresolved);
@@ -171,8 +187,17 @@ static cmon_bool _visit(cmon_dep_graph * _g, cmon_dep_graph_node * _n)
             return cmon_true;
     }
 
+    //@NOTE: all deps are resolved at this point, so their levels are final
+    _n->level = 0;
+    for (i = 0; i < cmon_dyn_arr_count(&_n->deps); ++i)
+    {
+        if (_n->deps[i]->level + 1 > _n->level)
+            _n->level = _n->deps[i]->level + 1;
+    }
+
     _n->mark = cmon_dep_graph_mark_perm;
     cmon_dyn_arr_append(&_g->resolved, _n->data);
+    cmon_dyn_arr_append(&_g->resolved_levels, _n->level);
 
     for (i = 0; i < cmon_dyn_arr_count(&_g->unresolved); ++i)
     {
@@ -186,6 +211,47 @@ static cmon_bool _visit(cmon_dep_graph * _g, cmon_dep_graph_node * _n)
     return cmon_false;
 }
 
+// counting sort of the resolved items by level. Items keep their relative resolve order within a
+// wave.
+static void _build_waves(cmon_dep_graph * _g)
+{
+    size_t i, wave_count;
+
+    cmon_dyn_arr_clear(&_g->waves);
+    cmon_dyn_arr_clear(&_g->wave_offsets);
+
+    wave_count = 0;
+    for (i = 0; i < cmon_dyn_arr_count(&_g->resolved_levels); ++i)
+    {
+        if (_g->resolved_levels[i] + 1 > wave_count)
+            wave_count = _g->resolved_levels[i] + 1;
+    }
+
+    cmon_dyn_arr_resize(&_g->wave_offsets, wave_count + 1);
+    memset(&_g->wave_offsets[0], 0, sizeof(size_t) * (wave_count + 1));
+    for (i = 0; i < cmon_dyn_arr_count(&_g->resolved_levels); ++i)
+    {
+        ++_g->wave_offsets[_g->resolved_levels[i] + 1];
+    }
+    for (i = 1; i <= wave_count; ++i)
+    {
+        _g->wave_offsets[i] += _g->wave_offsets[i - 1];
+    }
+
+    cmon_dyn_arr_resize(&_g->waves, cmon_dyn_arr_count(&_g->resolved));
+    for (i = 0; i < cmon_dyn_arr_count(&_g->resolved); ++i)
+    {
+        //@NOTE: wave_offsets[level] is used as the insertion cursor here and ends up pointing at the
+        // end of the wave afterwards, which we fix up below.
+        _g->waves[_g->wave_offsets[_g->resolved_levels[i]]++] = _g->resolved[i];
+    }
+    for (i = wave_count; i > 0; --i)
+    {
+        _g->wave_offsets[i] = _g->wave_offsets[i - 1];
+    }
+    _g->wave_offsets[0] = 0;
+}
+
 cmon_dep_graph_result cmon_dep_graph_resolve(cmon_dep_graph * _g)
 {
     cmon_bool err = cmon_false;
@@ -204,9 +270,23 @@ cmon_dep_graph_result cmon_dep_graph_resolve(cmon_dep_graph * _g)
     if (err)
         return (cmon_dep_graph_result){ NULL, 0 };
 
+    _build_waves(_g);
+
     return (cmon_dep_graph_result){ _g->resolved, cmon_dyn_arr_count(&_g->resolved) };
 }
 
+size_t cmon_dep_graph_wave_count(cmon_dep_graph * _g)
+{
+    return cmon_dyn_arr_count(&_g->wave_offsets) ? cmon_dyn_arr_count(&_g->wave_offsets) - 1 : 0;
+}
+
+cmon_dep_graph_result cmon_dep_graph_wave(cmon_dep_graph * _g, size_t _wave)
+{
+    assert(_wave < cmon_dep_graph_wave_count(_g));
+    return (cmon_dep_graph_result){ &_g->waves[_g->wave_offsets[_wave]],
+                                    _g->wave_offsets[_wave + 1] - _g->wave_offsets[_wave] };
+}
+
 cmon_idx cmon_dep_graph_conflict_a(cmon_dep_graph * _g)
 {
     return _g->conflict_a;
@@ -16,6 +16,10 @@ CMON_API void cmon_dep_graph_destroy(cmon_dep_graph * _g);
 CMON_API void cmon_dep_graph_clear(cmon_dep_graph * _g);
 CMON_API void cmon_dep_graph_add(cmon_dep_graph * _g, cmon_idx _item, cmon_idx * _deps, size_t _count);
 CMON_API cmon_dep_graph_result cmon_dep_graph_resolve(cmon_dep_graph * _g);
+// after a successful resolve, the resolved items are also grouped into waves. Items in a wave only
+// depend on items of previous waves and can hence be processed concurrently.
+CMON_API size_t cmon_dep_graph_wave_count(cmon_dep_graph * _g);
+CMON_API cmon_dep_graph_result cmon_dep_graph_wave(cmon_dep_graph * _g, size_t _wave);
 CMON_API cmon_idx cmon_dep_graph_conflict_a(cmon_dep_graph * _g);
 CMON_API cmon_idx cmon_dep_graph_conflict_b(cmon_dep_graph * _g);
 
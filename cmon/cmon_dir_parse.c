@@ -70,7 +70,6 @@ static cmon_bool _recurse_src_dir(_src_session * _dir,
         // }
         // }
 
-        printf("ADDING MODULE %s\n", cmon_str_builder_c_str(_dir->str_builder));
         mod_idx = cmon_modules_add(_dir->mods, cmon_str_builder_c_str(_dir->str_builder), _dirname);
     }
 
@@ -224,14 +223,10 @@ cmon_bool cmon_dir_parse_deps(cmon_allocator * _alloc,
     }
 
     // set each dependency directory as a module search path on all modules
-    printf("ADDING DEP PATHS %lu %lu\n",
-           cmon_modules_count(_mods),
-           cmon_dyn_arr_count(&sess.search_prefixes));
     for (size_t i = 0; i < cmon_modules_count(_mods); ++i)
     {
         for (size_t j = 0; j < cmon_dyn_arr_count(&sess.search_prefixes); ++j)
         {
-            printf("ADDING DEP PATH %s\n", cmon_short_str_c_str(&sess.search_prefixes[j]));
             cmon_modules_add_search_prefix_c_str(
                 _mods, (cmon_idx)i, cmon_short_str_c_str(&sess.search_prefixes[j]));
         }
@@ -254,7 +249,6 @@ cmon_bool cmon_dir_parse_deps(cmon_allocator * _alloc,
 
         cmon_idx root = cmon_tini_root_obj(tini);
 
-        printf("TINI C COUNT %lu\n", cmon_tini_child_count(tini, root));
         // set all the path overwrites on all modules having the path prefix
         for (size_t i = 0; i < cmon_tini_child_count(tini, root); ++i)
         {
@@ -276,11 +270,6 @@ cmon_bool cmon_dir_parse_deps(cmon_allocator * _alloc,
                         for (size_t k = 0; k < cmon_tini_child_count(tini, val); ++k)
                         {
                             cmon_idx ochild = cmon_tini_child(tini, val, k);
-                            printf("DA FOCKING KEY %.*s\n",
-                                   cmon_tini_pair_key(tini, ochild).end -
-                                       cmon_tini_pair_key(tini, ochild).begin,
-                                   cmon_tini_pair_key(tini, ochild).begin);
-
                             cmon_modules_add_path_overwrite(
                                 _mods,
                                 (cmon_idx)j,
@@ -24,19 +24,21 @@
 #define cmon_dyn_arr_reserve(_arr, _count)                                                         \
     do                                                                                             \
     {                                                                                              \
+        /* evaluate _count only once, it might depend on the array itself */                     \
+        size_t _rc = (_count);                                                                     \
         _cmon_dyn_arr_meta * _md = _cmon_dyn_arr_md((_arr));                                       \
-        if (_md->cap < _count)                                                                     \
+        if (_md->cap < _rc)                                                                        \
         {                                                                                          \
             _cmon_dyn_arr_meta _old_md = *_md;                                                     \
             void * _mem = cmon_allocator_realloc(                                                  \
                               _md->alloc,                                                          \
                               (cmon_mem_blk){                                                      \
                                   _md, sizeof(**(_arr)) * _md->cap + sizeof(_cmon_dyn_arr_meta) }, \
-                              sizeof(**(_arr)) * _count + sizeof(_cmon_dyn_arr_meta))              \
+                              sizeof(**(_arr)) * _rc + sizeof(_cmon_dyn_arr_meta))                 \
                               .ptr;                                                                \
             _cmon_dyn_arr_meta * _nmd = _mem;                                                      \
             *_nmd = _old_md;                                                                       \
-            _nmd->cap = _count;                                                                    \
+            _nmd->cap = _rc;                                                                       \
             *(_arr) = _mem + sizeof(_cmon_dyn_arr_meta);                                           \
         }                                                                                          \
     } while (0)
@@ -52,12 +54,12 @@
     do                                                                                             \
     {                                                                                              \
         void * _mem =                                                                              \
-            cmon_allocator_alloc(_alloc, sizeof(_cmon_dyn_arr_meta) + sizeof(**(_arr)) * _cap)     \
+            cmon_allocator_alloc(_alloc, sizeof(_cmon_dyn_arr_meta) + sizeof(**(_arr)) * (_cap))   \
                 .ptr;                                                                              \
         _cmon_dyn_arr_meta * _md = _mem;                                                           \
         _md->alloc = _alloc;                                                                       \
         _md->count = 0;                                                                            \
-        _md->cap = _cap;                                                                           \
+        _md->cap = (_cap);                                                                         \
         *(_arr) = _mem + sizeof(_cmon_dyn_arr_meta);                                               \
     } while (0)
 #define cmon_dyn_arr_dealloc(_arr)                                                                 \
@@ -1,10 +1,14 @@
 #include <cmon/cmon_fs.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <unistd.h>
 
 static int _advance(cmon_fs_dir * _dir)
 {
     assert(_dir && _dir->_native_dir);
+    // readdir only sets errno on failure, so a stale value would make the end look like an error
+    errno = 0;
     _dir->_native_dirent = readdir(_dir->_native_dir);
     if (!_dir->_native_dirent)
     {
@@ -173,6 +177,83 @@ err:
     return NULL;
 }
 
+int cmon_fs_map_txt_file(cmon_allocator * _alloc, const char * _path, cmon_fs_txt_file * _out_file)
+{
+    struct stat st;
+    size_t page_size, off;
+    ssize_t read_len;
+    cmon_mem_blk blk;
+    int fd;
+
+    _out_file->data = NULL;
+    _out_file->byte_count = 0;
+    _out_file->is_mapped = cmon_false;
+
+    fd = open(_path, O_RDONLY);
+    if (fd == -1)
+        return -1;
+
+    if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode))
+        goto err;
+
+    _out_file->byte_count = st.st_size;
+    page_size = sysconf(_SC_PAGESIZE);
+
+    //@NOTE: the rest of the last page of a mapping is zero filled, which gives us the nul terminator
+    // for free. If the file size is a multiple of the page size (or zero) there is no room for it, in
+    // that case we fall back to reading the file.
+    if (st.st_size % page_size != 0)
+    {
+        void * mem = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mem != MAP_FAILED)
+        {
+            close(fd);
+            _out_file->data = mem;
+            _out_file->is_mapped = cmon_true;
+            return 0;
+        }
+    }
+
+    blk = cmon_allocator_alloc(_alloc, st.st_size + 1);
+    _out_file->data = blk.ptr;
+    off = 0;
+    while (off < (size_t)st.st_size)
+    {
+        read_len = read(fd, _out_file->data + off, st.st_size - off);
+        if (read_len == -1 && errno == EINTR)
+            continue;
+        if (read_len <= 0)
+        {
+            cmon_allocator_free(_alloc, blk);
+            _out_file->data = NULL;
+            goto err;
+        }
+        off += read_len;
+    }
+    _out_file->data[st.st_size] = '\0';
+    close(fd);
+    return 0;
+
+err:
+    close(fd);
+    return -1;
+}
+
+void cmon_fs_unmap_txt_file(cmon_allocator * _alloc, cmon_fs_txt_file * _file)
+{
+    if (!_file->data)
+        return;
+
+    if (_file->is_mapped)
+        munmap(_file->data, _file->byte_count);
+    else
+        cmon_allocator_free(_alloc, (cmon_mem_blk){ _file->data, _file->byte_count + 1 });
+
+    _file->data = NULL;
+    _file->byte_count = 0;
+    _file->is_mapped = cmon_false;
+}
+
 int cmon_fs_mkdir(const char * _path)
 {
     return mkdir(_path, S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
@@ -35,6 +35,16 @@ typedef struct CMON_API
     struct timespec _native_time;
 } cmon_fs_timestamp;
 
+// a text file loaded with cmon_fs_map_txt_file. data is always nul terminated.
+typedef struct CMON_API
+{
+    char * data;
+    size_t byte_count;
+    // true if data points into a read only mapping of the file, false if it was read into memory
+    // allocated from the allocator passed to cmon_fs_map_txt_file
+    cmon_bool is_mapped;
+} cmon_fs_txt_file;
+
 //@TODO: sort this better
 CMON_API int cmon_fs_open(const char * _path, cmon_fs_dir * _dir);
 CMON_API int cmon_fs_close(cmon_fs_dir * _dir);
@@ -43,6 +53,12 @@ CMON_API int cmon_fs_next(cmon_fs_dir * _dir, cmon_fs_dirent * _dirent);
 CMON_API int cmon_fs_chdir(const char * _dir);
 CMON_API const char * cmon_fs_getcwd(char * _buf, size_t _len);
 CMON_API char * cmon_fs_load_txt_file(cmon_allocator * _alloc, const char * _path);
+// maps the file into memory without copying it if possible, otherwise reads it into memory
+// allocated from _alloc. Returns -1 on failure.
+CMON_API int cmon_fs_map_txt_file(cmon_allocator * _alloc,
+                                  const char * _path,
+                                  cmon_fs_txt_file * _out_file);
+CMON_API void cmon_fs_unmap_txt_file(cmon_allocator * _alloc, cmon_fs_txt_file * _file);
 //@TODO better error handling/messaging for this one specifically but most likely all of these functions
 CMON_API int cmon_fs_write_txt_file(const char * _path, const char * _txt);
 CMON_API int cmon_fs_mkdir(const char * _path);
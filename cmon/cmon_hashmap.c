@@ -1,214 +1,285 @@
 #include <cmon/cmon_hashmap.h>
 #include <stdalign.h>
 
-static cmon_hashmap_node * _create_node(cmon_hashmap_base * _m,
-                                        size_t _hash,
-                                        const void * _key_ref,
-                                        size_t _ksize,
-                                        void * _value,
-                                        size_t _vsize)
+// the slot table is grown once it is more than 3/4 full
+#define _MAX_LOAD_NUM 3
+#define _MAX_LOAD_DEN 4
+#define _MIN_BUCKET_COUNT 8
+
+// slots store entry index + 1, so that zeroed slots are empty
+#define _EMPTY_SLOT 0
+
+static inline size_t _align_ptr(size_t _v)
 {
-    cmon_hashmap_node * node;
-    //@TODO: Cache all these allocation things in the map_base?
-    size_t hash = _hash;
     size_t align_hlpr = alignof(void *) - 1;
-    size_t key_padding = (-sizeof(cmon_hashmap_node) & align_hlpr);
-    size_t koff = sizeof(cmon_hashmap_node) + key_padding;
-    size_t voff = koff + _ksize;
-    voff += (-voff & align_hlpr);
-    if (_m->node_byte_count == 0)
-    {
-        _m->node_byte_count = voff + _vsize;
-    }
-    node = cmon_allocator_alloc_od(_m->alloc, _m->node_byte_count).ptr;
-    node->hash = hash;
-    node->key = ((char *)node) + koff;
-    node->value = ((char *)node) + voff;
-    node->next = NULL;
-    memcpy(node->key, _key_ref, _ksize);
-    memcpy(node->value, _value, _vsize);
-    return node;
+    return _v + (-_v & align_hlpr);
 }
 
-static inline size_t _bucket_idx(cmon_hashmap_base * _m, size_t _hash)
+static inline char * _entry(cmon_hashmap_base * _m, size_t _idx)
 {
-    // bucket count needs to be power of 2, based on Java implementation
-    return _hash & (_m->bucket_count - 1);
+    return _m->entries + _m->entry_byte_count * _idx;
 }
 
-static inline void _add_node(cmon_hashmap_base * _m, cmon_hashmap_node * _node)
+static inline size_t _entry_hash(cmon_hashmap_base * _m, size_t _idx)
 {
-    size_t idx = _bucket_idx(_m, _node->hash);
-    _node->next = _m->buckets[idx];
-    _m->buckets[idx] = _node;
+    return *(size_t *)_entry(_m, _idx);
 }
 
-static void _resize(cmon_hashmap_base * _m, size_t _count)
+static inline size_t _home(cmon_hashmap_base * _m, size_t _hash)
 {
-    cmon_hashmap_node *nodes, *node, *next;
-    cmon_hashmap_node ** buckets;
-    size_t i;
-
-    // Chain all nodes together
-    nodes = NULL;
-    i = _m->bucket_count;
-    while (i--)
-    {
-        node = (_m->buckets)[i];
-        while (node)
-        {
-            next = node->next;
-            node->next = nodes;
-            nodes = node;
-            node = next;
-        }
-    }
+    return _hash & (_m->bucket_count - 1);
+}
 
-    // Reset buckets
-    buckets = cmon_allocator_realloc_od(
-                  _m->alloc,
-                  (cmon_mem_blk){ _m->buckets, sizeof(*_m->buckets) * _m->bucket_count },
-                  sizeof(*_m->buckets) * _count)
-                  .ptr;
+// the part of the hash stored in the slot. The upper bits are used, as the lower ones pick the slot.
+static inline uint32_t _slot_hash(size_t _hash)
+{
+    return (uint32_t)((uint64_t)_hash >> 32) ^ (uint32_t)_hash;
+}
 
-    _m->buckets = buckets;
-    _m->bucket_count = _count;
+void _cmon_hashmap_init(cmon_hashmap_base * _m,
+                        cmon_allocator * _alloc,
+                        size_t _ksize,
+                        size_t _vsize,
+                        cmon_hashmap_cmp_fn _cmp_fn,
+                        void * _cmp_user_data)
+{
+    _m->alloc = _alloc;
+    _m->slots = NULL;
+    _m->entries = NULL;
+    _m->bucket_count = 0;
+    _m->node_count = 0;
+    _m->entry_cap = 0;
+    _m->key_size = _ksize;
+    _m->value_size = _vsize;
+    _m->key_offset = _align_ptr(sizeof(size_t));
+    _m->value_offset = _align_ptr(_m->key_offset + _ksize);
+    _m->entry_byte_count = _align_ptr(_m->value_offset + _vsize);
+    _m->cmp_fn = _cmp_fn;
+    _m->cmp_user_data = _cmp_user_data;
+}
 
-    memset(_m->buckets, 0, sizeof(*_m->buckets) * _m->bucket_count);
-    /* Re-add nodes to buckets */
-    node = nodes;
-    while (node)
+void _cmon_hashmap_deinit(cmon_hashmap_base * _m)
+{
+    if (_m->slots)
     {
-        next = node->next;
-        _add_node(_m, node);
-        node = next;
+        cmon_allocator_free(_m->alloc,
+                            (cmon_mem_blk){ _m->slots, sizeof(*_m->slots) * _m->bucket_count });
+    }
+    if (_m->entries)
+    {
+        cmon_allocator_free(_m->alloc,
+                            (cmon_mem_blk){ _m->entries, _m->entry_byte_count * _m->entry_cap });
     }
 }
 
-static cmon_hashmap_node ** _getref(cmon_hashmap_base * _m,
-                                    size_t _hash,
-                                    const void * _key_ref,
-                                    size_t _key_size)
+// finds the slot of _key or the empty slot it would go into
+static inline size_t _find_slot(cmon_hashmap_base * _m, size_t _hash, const void * _key_ref)
 {
-    cmon_hashmap_node ** next;
-    if (_m->bucket_count > 0)
+    size_t mask = _m->bucket_count - 1;
+    size_t i = _home(_m, _hash);
+    uint32_t sh = _slot_hash(_hash);
+
+    while (_m->slots[i].entry != _EMPTY_SLOT)
     {
-        size_t hash = _hash;
-        next = &_m->buckets[_bucket_idx(_m, hash)];
-        while (*next)
+        if (_m->slots[i].hash == sh)
         {
-            if ((*next)->hash == hash && _m->cmp_fn(_key_ref, (*next)->key, _key_size, _m->cmp_user_data))
+            char * e = _entry(_m, _m->slots[i].entry - 1);
+            if (*(size_t *)e == _hash &&
+                _m->cmp_fn(_key_ref, e + _m->key_offset, _m->key_size, _m->cmp_user_data))
             {
-                return next;
+                return i;
             }
-            next = &(*next)->next;
         }
+        i = (i + 1) & mask;
     }
-    return NULL;
+    return i;
 }
 
-void _cmon_hashmap_deinit(cmon_hashmap_base * _m)
+static void _rehash(cmon_hashmap_base * _m, size_t _bucket_count)
 {
-    cmon_hashmap_node *next, *node;
-    size_t i;
+    size_t i, j, mask;
 
-    i = _m->bucket_count;
-    while (i--)
+    if (_m->slots)
     {
-        node = _m->buckets[i];
-        while (node)
-        {
-            next = node->next;
-            cmon_allocator_free(_m->alloc, (cmon_mem_blk){ node, _m->node_byte_count });
-            node = next;
-        }
+        cmon_allocator_free(_m->alloc,
+                            (cmon_mem_blk){ _m->slots, sizeof(*_m->slots) * _m->bucket_count });
+    }
+    _m->slots = cmon_allocator_alloc_od(_m->alloc, sizeof(*_m->slots) * _bucket_count).ptr;
+    memset(_m->slots, 0, sizeof(*_m->slots) * _bucket_count);
+    _m->bucket_count = _bucket_count;
+
+    mask = _bucket_count - 1;
+    for (i = 0; i < _m->node_count; ++i)
+    {
+        size_t hash = _entry_hash(_m, i);
+        j = _home(_m, hash);
+        while (_m->slots[j].entry != _EMPTY_SLOT)
+            j = (j + 1) & mask;
+        _m->slots[j].entry = (uint32_t)i + 1;
+        _m->slots[j].hash = _slot_hash(hash);
     }
-    cmon_allocator_free(_m->alloc,
-                        (cmon_mem_blk){ _m->buckets, sizeof(*_m->buckets) * _m->bucket_count });
 }
 
-void * _cmon_hashmap_get(cmon_hashmap_base * _m,
-                         size_t _hash,
-                         const void * _key_ref,
-                         size_t _key_size)
+void _cmon_hashmap_reserve(cmon_hashmap_base * _m, size_t _count)
 {
-    cmon_hashmap_node ** n = _getref(_m, _hash, _key_ref, _key_size);
-    return n ? (*n)->value : NULL;
+    size_t bucket_count;
+
+    if (_m->entry_cap < _count)
+    {
+        _m->entries = cmon_allocator_realloc_od(
+                          _m->alloc,
+                          (cmon_mem_blk){ _m->entries, _m->entry_byte_count * _m->entry_cap },
+                          _m->entry_byte_count * _count)
+                          .ptr;
+        _m->entry_cap = _count;
+    }
+
+    bucket_count = _m->bucket_count ? _m->bucket_count : _MIN_BUCKET_COUNT;
+    while (_count * _MAX_LOAD_DEN > bucket_count * _MAX_LOAD_NUM)
+        bucket_count <<= 1;
+
+    if (bucket_count != _m->bucket_count)
+        _rehash(_m, bucket_count);
 }
 
-cmon_bool _cmon_hashmap_set(cmon_hashmap_base * _m,
-                            size_t _hash,
-                            const void * _key_ref,
-                            size_t _ksize,
-                            void * _value,
-                            size_t _vsize)
+void * _cmon_hashmap_get(cmon_hashmap_base * _m, size_t _hash, const void * _key_ref)
 {
-    size_t n;
-    cmon_hashmap_node **next, *node;
-    /* Find & replace existing node */
-    next = _getref(_m, _hash, _key_ref, _ksize);
-    if (next)
+    size_t slot;
+
+    if (!_m->node_count)
+        return NULL;
+
+    slot = _find_slot(_m, _hash, _key_ref);
+    if (_m->slots[slot].entry == _EMPTY_SLOT)
+        return NULL;
+    return _entry(_m, _m->slots[slot].entry - 1) + _m->value_offset;
+}
+
+// returns the value of _key (inserting _value if needed) and whether it was inserted
+static inline void * _insert(cmon_hashmap_base * _m,
+                             size_t _hash,
+                             const void * _key_ref,
+                             const void * _value,
+                             cmon_bool * _out_inserted)
+{
+    size_t slot;
+    char * e;
+
+    if ((_m->node_count + 1) * _MAX_LOAD_DEN > _m->bucket_count * _MAX_LOAD_NUM ||
+        _m->node_count == _m->entry_cap)
     {
-        memcpy((*next)->value, _value, _vsize);
-        return cmon_true;
+        _cmon_hashmap_reserve(_m, _m->entry_cap ? _m->entry_cap * 2 : _MIN_BUCKET_COUNT / 2);
     }
 
-    /* Add new node */
-    node = _create_node(_m, _hash, _key_ref, _ksize, _value, _vsize);
-    if (_m->node_count >= _m->bucket_count)
+    slot = _find_slot(_m, _hash, _key_ref);
+    if (_m->slots[slot].entry != _EMPTY_SLOT)
     {
-        n = (_m->bucket_count > 0) ? (_m->bucket_count << 1) : 1;
-        _resize(_m, n);
+        *_out_inserted = cmon_false;
+        return _entry(_m, _m->slots[slot].entry - 1) + _m->value_offset;
     }
-    _add_node(_m, node);
-    ++_m->node_count;
-    return cmon_false;
+
+    e = _entry(_m, _m->node_count);
+    *(size_t *)e = _hash;
+    memcpy(e + _m->key_offset, _key_ref, _m->key_size);
+    memcpy(e + _m->value_offset, _value, _m->value_size);
+    _m->slots[slot].entry = (uint32_t)++_m->node_count;
+    _m->slots[slot].hash = _slot_hash(_hash);
+    *_out_inserted = cmon_true;
+    return e + _m->value_offset;
 }
 
-cmon_bool _cmon_hashmap_remove(cmon_hashmap_base * _m,
-                               size_t _hash,
-                               const void * _key_ref,
-                               size_t _key_size)
+cmon_bool _cmon_hashmap_set(cmon_hashmap_base * _m,
+                            size_t _hash,
+                            const void * _key_ref,
+                            const void * _value)
 {
-    cmon_hashmap_node * node;
-    cmon_hashmap_node ** next = _getref(_m, _hash, _key_ref, _key_size);
-    if (next)
+    cmon_bool inserted;
+    void * v = _insert(_m, _hash, _key_ref, _value, &inserted);
+    if (!inserted)
     {
-        node = *next;
-        *next = (*next)->next;
-        cmon_allocator_free(_m->alloc, (cmon_mem_blk){ node, _m->node_byte_count });
-        --_m->node_count;
+        memcpy(v, _value, _m->value_size);
         return cmon_true;
     }
     return cmon_false;
 }
 
-cmon_hashmap_iter_t _cmon_hashmap_iter()
+void * _cmon_hashmap_get_or_insert(cmon_hashmap_base * _m,
+                                   size_t _hash,
+                                   const void * _key_ref,
+                                   const void * _value)
 {
-    return (cmon_hashmap_iter_t){ -1, NULL };
+    cmon_bool inserted;
+    return _insert(_m, _hash, _key_ref, _value, &inserted);
 }
 
-void * _cmon_hashmap_next(cmon_hashmap_base * _m, cmon_hashmap_iter_t * _iter)
+cmon_bool _cmon_hashmap_remove(cmon_hashmap_base * _m, size_t _hash, const void * _key_ref)
 {
-    if (_iter->node)
+    size_t i, slot, next, home, mask, entry;
+
+    if (!_m->node_count)
+        return cmon_false;
+
+    slot = _find_slot(_m, _hash, _key_ref);
+    if (_m->slots[slot].entry == _EMPTY_SLOT)
+        return cmon_false;
+
+    entry = _m->slots[slot].entry - 1;
+    mask = _m->bucket_count - 1;
+
+    // backward shift deletion, moves following entries of the probe sequence closer to their home
+    // slot so that no tombstones are needed.
+    next = (slot + 1) & mask;
+    while (_m->slots[next].entry != _EMPTY_SLOT)
     {
-        _iter->node = _iter->node->next;
-        if (_iter->node == NULL)
-            goto next_bucket;
+        home = _home(_m, _entry_hash(_m, _m->slots[next].entry - 1));
+        // only move the slot if its home is not in (slot, next]
+        if (((next - home) & mask) >= ((next - slot) & mask))
+        {
+            _m->slots[slot] = _m->slots[next];
+            slot = next;
+        }
+        next = (next + 1) & mask;
     }
-    else
+    _m->slots[slot].entry = _EMPTY_SLOT;
+
+    // keep the entries dense and in insertion order by shifting the following ones into the hole.
+    // The slots referring to them have to follow.
+    --_m->node_count;
+    if (entry != _m->node_count)
     {
-    next_bucket:
-        do
+        memmove(_entry(_m, entry),
+                _entry(_m, entry + 1),
+                _m->entry_byte_count * (_m->node_count - entry));
+        for (i = 0; i < _m->bucket_count; ++i)
         {
-            if (++_iter->bucket_idx >= _m->bucket_count)
-            {
-                return NULL;
-            }
-            _iter->node = _m->buckets[_iter->bucket_idx];
-        } while (_iter->node == NULL);
+            if (_m->slots[i].entry > entry + 1)
+                --_m->slots[i].entry;
+        }
     }
-    return _iter->node->key;
+    return cmon_true;
+}
+
+cmon_hashmap_iter_t _cmon_hashmap_iter()
+{
+    cmon_hashmap_iter_t ret;
+    ret.idx = 0;
+    ret.node = NULL;
+    ret.entry.key = NULL;
+    ret.entry.value = NULL;
+    return ret;
+}
+
+void * _cmon_hashmap_next(cmon_hashmap_base * _m, cmon_hashmap_iter_t * _iter)
+{
+    char * e;
+    if (_iter->idx >= _m->node_count)
+        return NULL;
+
+    e = _entry(_m, _iter->idx++);
+    _iter->entry.key = e + _m->key_offset;
+    _iter->entry.value = e + _m->value_offset;
+    _iter->node = &_iter->entry;
+    return _iter->entry.key;
 }
 
 uint64_t _cmon_ptr_hash(const void * _ptr)
@@ -3,33 +3,44 @@
 
 #include <cmon/cmon_allocator.h>
 
-struct cmon_hashmap_node;
-typedef struct cmon_hashmap_node cmon_hashmap_node;
+typedef cmon_bool (*cmon_hashmap_cmp_fn)(const void *, const void *, size_t, void *);
 
-struct cmon_hashmap_node
+// open addressing hash map. Entries (hash, key and value) are stored inline in one dense array in
+// insertion order, which is also the iteration order. A separate power of two sized slot table maps
+// hashes to entries via linear probing. Each slot holds the entry index and part of the hash, so
+// mismatches are mostly rejected without touching the entries.
+//@NOTE: pointers to values are invalidated by any insertion or removal. Removing keeps the order
+// of the remaining entries, but is linear in the size of the map.
+typedef struct
 {
-    size_t hash;
-    void * key;
-    void * value;
-    cmon_hashmap_node * next;
-};
-
-typedef cmon_bool (*cmon_hashmap_cmp_fn)(const void *, const void *, size_t, void *);
+    uint32_t entry;
+    uint32_t hash;
+} cmon_hashmap_slot;
 
 typedef struct
 {
     cmon_allocator * alloc;
-    cmon_hashmap_node ** buckets;
-    size_t bucket_count, node_count;
+    cmon_hashmap_slot * slots;
+    char * entries;
+    size_t bucket_count, node_count, entry_cap;
+    size_t key_size, value_size;
+    size_t key_offset, value_offset, entry_byte_count;
     cmon_hashmap_cmp_fn cmp_fn;
     void * cmp_user_data;
-    size_t node_byte_count; // how many bytes does a node take? Needed for cmon_allocator_free
 } cmon_hashmap_base;
 
+// the entry an iterator points at
 typedef struct
 {
-    size_t bucket_idx;
-    cmon_hashmap_node * node;
+    void * key;
+    void * value;
+} cmon_hashmap_entry;
+
+typedef struct
+{
+    size_t idx;
+    cmon_hashmap_entry * node;
+    cmon_hashmap_entry entry;
 } cmon_hashmap_iter_t;
 
 #define cmon_hashmap(K, V)                                                                         \
@@ -43,49 +54,63 @@ typedef struct
     }
 #define cmon_hashmap_init(_m, _alloc, _hash_fn, _cmp_fn, _cmp_user_data)                           \
     (memset((_m), 0, sizeof(*(_m))),                                                               \
-     (_m)->base.alloc = (_alloc),                                                                  \
-     (_m)->base.cmp_fn = (_cmp_fn),                                                                \
-     (_m)->base.cmp_user_data = (_cmp_user_data),                                                  \
+     _cmon_hashmap_init(&(_m)->base,                                                               \
+                        (_alloc),                                                                  \
+                        sizeof((_m)->tmp_key),                                                     \
+                        sizeof((_m)->tmp),                                                         \
+                        (_cmp_fn),                                                                 \
+                        (_cmp_user_data)),                                                         \
      (_m)->hash_fn = (_hash_fn))
 #define cmon_hashmap_dealloc(_m) _cmon_hashmap_deinit(&(_m)->base)
 #define cmon_hashmap_get(_m, _key)                                                                 \
     ((_m)->tmp_key = (_key),                                                                       \
-     (_m)->ref = _cmon_hashmap_get(                                                                \
-         &(_m)->base, (_m)->hash_fn((_m)->tmp_key), &(_m)->tmp_key, sizeof((_m)->tmp_key)))
+     (_m)->ref = _cmon_hashmap_get(&(_m)->base, (_m)->hash_fn((_m)->tmp_key), &(_m)->tmp_key))
+// like cmon_hashmap_get but takes a pointer to the key and does not write to the map, so it can be
+// used by multiple threads reading the map concurrently.
+#define cmon_hashmap_find(_m, _key_ref)                                                            \
+    ((__typeof__((_m)->ref))_cmon_hashmap_get(                                                     \
+        &(_m)->base, (_m)->hash_fn(*(_key_ref)), (_key_ref)))
 #define cmon_hashmap_set(_m, _key, _value)                                                         \
     ((_m)->tmp_key = (_key),                                                                       \
      (_m)->tmp = (_value),                                                                         \
-     _cmon_hashmap_set(&(_m)->base,                                                                \
-                       (_m)->hash_fn((_m)->tmp_key),                                               \
-                       &(_m)->tmp_key,                                                             \
-                       sizeof((_m)->tmp_key),                                                      \
-                       &(_m)->tmp,                                                                 \
-                       sizeof((_m)->tmp)))
+     _cmon_hashmap_set(&(_m)->base, (_m)->hash_fn((_m)->tmp_key), &(_m)->tmp_key, &(_m)->tmp))
+// returns a pointer to the value of _key, inserting _value first if _key is not in the map yet.
+#define cmon_hashmap_get_or_insert(_m, _key, _value)                                               \
+    ((_m)->tmp_key = (_key),                                                                       \
+     (_m)->tmp = (_value),                                                                         \
+     (_m)->ref = _cmon_hashmap_get_or_insert(                                                      \
+         &(_m)->base, (_m)->hash_fn((_m)->tmp_key), &(_m)->tmp_key, &(_m)->tmp))
 #define cmon_hashmap_remove(_m, _key)                                                              \
     ((_m)->tmp_key = (_key),                                                                       \
-     _cmon_hashmap_remove(                                                                         \
-         &(_m)->base, (_m)->hash_fn((_m)->tmp_key), &(_m)->tmp_key, sizeof((_m)->tmp_key)))
+     _cmon_hashmap_remove(&(_m)->base, (_m)->hash_fn((_m)->tmp_key), &(_m)->tmp_key))
+// makes room for _count entries without further allocations
+#define cmon_hashmap_reserve(_m, _count) _cmon_hashmap_reserve(&(_m)->base, (_count))
 #define cmon_hashmap_count(_m) ((_m)->base.node_count)
 #define cmon_hashmap_bucket_count(_m) ((_m)->base.bucket_count)
 #define cmon_hashmap_iter(_m) _cmon_hashmap_iter()
 #define cmon_hashmap_iter_value(_m, _iter) *((_m)->ref = (_iter)->node->value)
 #define cmon_hashmap_next(_m, _iter) _cmon_hashmap_next(&(_m)->base, _iter)
 
+CMON_API void _cmon_hashmap_init(cmon_hashmap_base * _m,
+                                 cmon_allocator * _alloc,
+                                 size_t _ksize,
+                                 size_t _vsize,
+                                 cmon_hashmap_cmp_fn _cmp_fn,
+                                 void * _cmp_user_data);
 CMON_API void _cmon_hashmap_deinit(cmon_hashmap_base * _m);
-CMON_API void * _cmon_hashmap_get(cmon_hashmap_base * _m,
-                                  size_t _hash,
-                                  const void * _key_ref,
-                                  size_t _ksize);
+CMON_API void _cmon_hashmap_reserve(cmon_hashmap_base * _m, size_t _count);
+CMON_API void * _cmon_hashmap_get(cmon_hashmap_base * _m, size_t _hash, const void * _key_ref);
 CMON_API cmon_bool _cmon_hashmap_set(cmon_hashmap_base * _m,
                                      size_t _hash,
                                      const void * _key_ref,
-                                     size_t _ksize,
-                                     void * _value,
-                                     size_t _vsize);
+                                     const void * _value);
+CMON_API void * _cmon_hashmap_get_or_insert(cmon_hashmap_base * _m,
+                                            size_t _hash,
+                                            const void * _key_ref,
+                                            const void * _value);
 CMON_API cmon_bool _cmon_hashmap_remove(cmon_hashmap_base * _m,
                                         size_t _hash,
-                                        const void * _key_ref,
-                                        size_t _ksize);
+                                        const void * _key_ref);
 CMON_API cmon_hashmap_iter_t _cmon_hashmap_iter();
 CMON_API void * _cmon_hashmap_next(cmon_hashmap_base * _m, cmon_hashmap_iter_t * _iter);
 
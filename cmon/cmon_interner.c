@@ -0,0 +1,166 @@
+#include <cmon/cmon_dyn_arr.h>
+#include <cmon/cmon_hashmap.h>
+#include <cmon/cmon_interner.h>
+#include <pthread.h>
+
+// ids index into fixed size blocks that never move, so strings can be retrieved without locking
+// while other threads intern new ones.
+#define _BLOCK_SHIFT 12
+#define _BLOCK_SIZE (1 << _BLOCK_SHIFT)
+#define _MAX_BLOCKS 4096
+#define _STR_CHUNK_SIZE 16384
+// the strings are spread over stripes by hash, each with its own lock, map and string storage. That
+// way threads interning different names (which is most of the time, as identifiers are mostly
+// interned already) rarely wait on each other.
+#define _STRIPE_COUNT 64
+
+typedef struct
+{
+    // holds the copied strings
+    cmon_allocator str_arena;
+    cmon_hashmap(cmon_str_view, cmon_idx) map;
+    pthread_mutex_t mtx;
+} _stripe;
+
+typedef struct cmon_interner
+{
+    cmon_allocator * alloc;
+    _stripe stripes[_STRIPE_COUNT];
+    cmon_str_view * blocks[_MAX_BLOCKS];
+    size_t count;
+    // protects count and allocating blocks, only locked when adding a new string
+    pthread_mutex_t id_mtx;
+} cmon_interner;
+
+static inline uint64_t _str_view_hash(cmon_str_view _view)
+{
+    return _cmon_str_range_hash(_view.begin, _view.end);
+}
+
+static inline cmon_bool _str_view_cmp(const void * _stra,
+                                       const void * _strb,
+                                       size_t _byte_count,
+                                       void * _user_data)
+{
+    return cmon_str_view_cmp(*(cmon_str_view *)_stra, *(cmon_str_view *)_strb) == 0;
+}
+
+cmon_interner * cmon_interner_create(cmon_allocator * _alloc)
+{
+    size_t i;
+    cmon_interner * ret = CMON_CREATE(_alloc, cmon_interner);
+    ret->alloc = _alloc;
+    for (i = 0; i < _STRIPE_COUNT; ++i)
+    {
+        ret->stripes[i].str_arena = cmon_arena_allocator_make(_alloc, _STR_CHUNK_SIZE);
+        cmon_hashmap_init(&ret->stripes[i].map, _alloc, _str_view_hash, _str_view_cmp, NULL);
+        cmon_hashmap_reserve(&ret->stripes[i].map, 1024 / _STRIPE_COUNT);
+        pthread_mutex_init(&ret->stripes[i].mtx, NULL);
+    }
+    memset(ret->blocks, 0, sizeof(ret->blocks));
+    ret->count = 0;
+    pthread_mutex_init(&ret->id_mtx, NULL);
+    return ret;
+}
+
+void cmon_interner_destroy(cmon_interner * _i)
+{
+    size_t i;
+
+    if (!_i)
+        return;
+
+    for (i = 0; i < _MAX_BLOCKS && _i->blocks[i]; ++i)
+    {
+        cmon_allocator_free(_i->alloc,
+                            (cmon_mem_blk){ _i->blocks[i], sizeof(cmon_str_view) * _BLOCK_SIZE });
+    }
+    pthread_mutex_destroy(&_i->id_mtx);
+    for (i = 0; i < _STRIPE_COUNT; ++i)
+    {
+        pthread_mutex_destroy(&_i->stripes[i].mtx);
+        cmon_hashmap_dealloc(&_i->stripes[i].map);
+        cmon_allocator_dealloc(&_i->stripes[i].str_arena);
+    }
+    CMON_DESTROY(_i->alloc, _i);
+}
+
+static inline _stripe * _stripe_for(cmon_interner * _i, cmon_str_view _str)
+{
+    //@NOTE: the high bits pick the stripe, the map of the stripe uses the low bits for its buckets.
+    return &_i->stripes[(_str_view_hash(_str) >> 32) & (_STRIPE_COUNT - 1)];
+}
+
+cmon_idx cmon_interner_intern(cmon_interner * _i, cmon_str_view _str)
+{
+    cmon_idx * existing;
+    cmon_idx ret;
+    size_t len, block;
+    char * copy;
+    _stripe * stripe = _stripe_for(_i, _str);
+
+    pthread_mutex_lock(&stripe->mtx);
+    if ((existing = cmon_hashmap_get(&stripe->map, _str)))
+    {
+        ret = *existing;
+        pthread_mutex_unlock(&stripe->mtx);
+        return ret;
+    }
+
+    pthread_mutex_lock(&_i->id_mtx);
+    ret = _i->count++;
+    block = ret >> _BLOCK_SHIFT;
+    assert(block < _MAX_BLOCKS);
+    if (!_i->blocks[block])
+    {
+        _i->blocks[block] =
+            cmon_allocator_alloc(_i->alloc, sizeof(cmon_str_view) * _BLOCK_SIZE).ptr;
+    }
+    pthread_mutex_unlock(&_i->id_mtx);
+
+    len = _str.end - _str.begin;
+    copy = cmon_allocator_alloc(&stripe->str_arena, len + 1).ptr;
+    memcpy(copy, _str.begin, len);
+    copy[len] = '\0';
+
+    _i->blocks[block][ret & (_BLOCK_SIZE - 1)] = (cmon_str_view){ copy, copy + len };
+    //@NOTE: the key points to the copy so it stays valid after _str goes away
+    cmon_hashmap_set(&stripe->map, ((cmon_str_view){ copy, copy + len }), ret);
+    pthread_mutex_unlock(&stripe->mtx);
+
+    return ret;
+}
+
+cmon_idx cmon_interner_find(cmon_interner * _i, cmon_str_view _str)
+{
+    cmon_idx * existing;
+    cmon_idx ret;
+    _stripe * stripe = _stripe_for(_i, _str);
+
+    pthread_mutex_lock(&stripe->mtx);
+    existing = cmon_hashmap_get(&stripe->map, _str);
+    ret = existing ? *existing : CMON_INVALID_IDX;
+    pthread_mutex_unlock(&stripe->mtx);
+    return ret;
+}
+
+cmon_str_view cmon_interner_str_view(cmon_interner * _i, cmon_idx _id)
+{
+    assert(cmon_is_valid_idx(_id) && (_id >> _BLOCK_SHIFT) < _MAX_BLOCKS);
+    assert(_i->blocks[_id >> _BLOCK_SHIFT]);
+    return _i->blocks[_id >> _BLOCK_SHIFT][_id & (_BLOCK_SIZE - 1)];
+}
+
+const char * cmon_interner_c_str(cmon_interner * _i, cmon_idx _id)
+{
+    return cmon_interner_str_view(_i, _id).begin;
+}
+
+size_t cmon_interner_count(cmon_interner * _i)
+{
+    size_t ret;
+    pthread_mutex_lock(&_i->id_mtx);
+    ret = _i->count;
+    pthread_mutex_unlock(&_i->id_mtx);
+    return ret;
+}
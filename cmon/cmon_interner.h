@@ -0,0 +1,23 @@
+#ifndef CMON_CMON_INTERNER_H
+#define CMON_CMON_INTERNER_H
+
+#include <cmon/cmon_allocator.h>
+#include <cmon/cmon_util.h>
+
+// maps every distinct string to a small integer id so names can be compared and hashed as integers.
+// Interning and finding can be called from any thread. They only lock the stripe of the string
+// (picked by its hash), so threads rarely contend. Interned strings never move and are nul
+// terminated, retrieving them by id does not lock.
+typedef struct cmon_interner cmon_interner;
+
+CMON_API cmon_interner * cmon_interner_create(cmon_allocator * _alloc);
+CMON_API void cmon_interner_destroy(cmon_interner * _i);
+// returns the id of _str, adding a copy of it if it was not interned yet
+CMON_API cmon_idx cmon_interner_intern(cmon_interner * _i, cmon_str_view _str);
+// returns the id of _str or CMON_INVALID_IDX if it was never interned
+CMON_API cmon_idx cmon_interner_find(cmon_interner * _i, cmon_str_view _str);
+CMON_API cmon_str_view cmon_interner_str_view(cmon_interner * _i, cmon_idx _id);
+CMON_API const char * cmon_interner_c_str(cmon_interner * _i, cmon_idx _id);
+CMON_API size_t cmon_interner_count(cmon_interner * _i);
+
+#endif // CMON_CMON_INTERNER_H
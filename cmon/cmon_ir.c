@@ -137,13 +137,14 @@ cmon_irb * cmon_irb_create(cmon_allocator * _alloc,
     cmon_dyn_arr_init(&ret->types, _alloc, _type_count);
     cmon_dyn_arr_init(&ret->kinds, _alloc, _node_count_estimate);
     cmon_dyn_arr_init(&ret->data, _alloc, _node_count_estimate);
-    cmon_dyn_arr_init(&ret->binops, _alloc, 32);
-    cmon_dyn_arr_init(&ret->prefixes, _alloc, 8);
-    cmon_dyn_arr_init(&ret->calls, _alloc, 16);
-    cmon_dyn_arr_init(&ret->inits, _alloc, 16);
-    cmon_dyn_arr_init(&ret->idx_pairs, _alloc, 16);
-    cmon_dyn_arr_init(&ret->var_decls, _alloc, 32);
-    cmon_dyn_arr_init(&ret->idx_buffer, _alloc, _node_count_estimate / 8);
+    // the fractions of the node count are what typical code ends up with
+    cmon_dyn_arr_init(&ret->binops, _alloc, CMON_MAX(32, _node_count_estimate / 4));
+    cmon_dyn_arr_init(&ret->prefixes, _alloc, CMON_MAX(8, _node_count_estimate / 64));
+    cmon_dyn_arr_init(&ret->calls, _alloc, CMON_MAX(16, _node_count_estimate / 32));
+    cmon_dyn_arr_init(&ret->inits, _alloc, CMON_MAX(16, _node_count_estimate / 32));
+    cmon_dyn_arr_init(&ret->idx_pairs, _alloc, CMON_MAX(16, _node_count_estimate / 8));
+    cmon_dyn_arr_init(&ret->var_decls, _alloc, CMON_MAX(32, _node_count_estimate / 8));
+    cmon_dyn_arr_init(&ret->idx_buffer, _alloc, CMON_MAX(16, _node_count_estimate / 4));
     cmon_dyn_arr_init(&ret->fn_data, _alloc, _fn_count);
     cmon_dyn_arr_init(&ret->global_vars, _alloc, _global_var_count);
     cmon_dyn_arr_init(&ret->fns, _alloc, _fn_count);
@@ -251,7 +252,6 @@ cmon_idx cmon_irb_add_deref(cmon_irb * _b, cmon_idx _expr)
 
 cmon_idx cmon_irb_add_binary(cmon_irb * _b, char _op, cmon_idx _left, cmon_idx _right)
 {
-    printf("cmon_irb_add_binary %c\n", _op);
     cmon_dyn_arr_append(&_b->binops, ((_binop){ _op, _left, _right }));
     return _add_node(_b, cmon_irk_binary, cmon_dyn_arr_count(&_b->binops) - 1);
 }
@@ -316,7 +316,6 @@ cmon_idx cmon_irb_add_index(cmon_irb * _b, cmon_idx _lhs, cmon_idx _index_expr)
 cmon_idx cmon_irb_add_block(cmon_irb * _b, cmon_idx * _stmt_indices, size_t _count)
 {
     cmon_idx begin = _add_indices(_b, _stmt_indices, _count);
-    printf("cmon_irb_add_block %lu\n", begin);
     cmon_dyn_arr_append(&_b->idx_pairs,
                         ((_idx_pair){ begin, cmon_dyn_arr_count(&_b->idx_buffer) }));
     return _add_node(_b, cmon_irk_block, cmon_dyn_arr_count(&_b->idx_pairs) - 1);
@@ -371,7 +370,6 @@ cmon_idx cmon_irb_add_fn(cmon_irb * _b,
 void cmon_irb_fn_set_body(cmon_irb * _b, cmon_idx _fn, cmon_idx _body)
 {
     assert(_fn < cmon_dyn_arr_count(&_b->kinds));
-    printf("ir kind %i\n", _b->kinds[_fn]);
     assert(_b->kinds[_fn] == cmon_irk_fn);
     _b->fn_data[_b->data[_fn]].body_idx = _body;
 }
@@ -924,13 +922,11 @@ static inline void _debug_write_fn(cmon_ir * _ir,
                                    cmon_str_builder * _b,
                                    cmon_idx _ir_idx)
 {
-    printf("a\n");
     cmon_idx body = cmon_ir_fn_body(_ir, _ir_idx);
     if (!cmon_is_valid_idx(body))
     {
         cmon_str_builder_append(_b, "extern ");
     }
-    printf("a2\n");
     cmon_str_builder_append_fmt(_b, "fn %s(", cmon_ir_fn_name(_ir, _ir_idx));
     for (size_t i = 0; i < cmon_ir_fn_param_count(_ir, _ir_idx); ++i)
     {
@@ -940,17 +936,13 @@ static inline void _debug_write_fn(cmon_ir * _ir,
             cmon_str_builder_append(_b, ", ");
         }
     }
-    printf("a3\n");
     cmon_str_builder_append(_b, ") -> ");
-    printf("DA RET TYPE %lu\n", cmon_ir_fn_return_type(_ir, _ir_idx));
     _debug_write_type(_ir, _types, _b, cmon_ir_fn_return_type(_ir, _ir_idx));
     if (cmon_is_valid_idx(body))
     {
-        printf("a4\n");
         cmon_str_builder_append(_b, "\n");
         _debug_write_stmt(_ir, _types, _b, body, 0);
     }
-    printf("b\n");
 }
 
 const char * cmon_ir_debug_str(cmon_ir * _ir, cmon_types * _types, cmon_str_builder * _b)
@@ -0,0 +1,145 @@
+#include <cmon/cmon_dyn_arr.h>
+#include <cmon/cmon_job_pool.h>
+#include <cmon/cmon_util.h>
+#include <pthread.h>
+#include <unistd.h>
+
+typedef struct
+{
+    cmon_job_fn fn;
+    void * user_data;
+} _job;
+
+typedef struct cmon_job_pool
+{
+    cmon_allocator * alloc;
+    pthread_mutex_t mtx;
+    pthread_cond_t job_cond;  // signaled when new jobs are added or the pool shuts down
+    pthread_cond_t done_cond; // signaled when the last pending job finished
+    cmon_dyn_arr(_job) jobs;
+    size_t next_job;
+    size_t pending; // number of jobs added but not finished yet
+    cmon_bool shutdown;
+    size_t thread_count;
+    pthread_t * threads;
+} cmon_job_pool;
+
+static void * _worker_fn(void * _data)
+{
+    cmon_job_pool * p = (cmon_job_pool *)_data;
+    _job job;
+
+    pthread_mutex_lock(&p->mtx);
+    while (1)
+    {
+        while (!p->shutdown && p->next_job >= cmon_dyn_arr_count(&p->jobs))
+        {
+            pthread_cond_wait(&p->job_cond, &p->mtx);
+        }
+
+        if (p->next_job >= cmon_dyn_arr_count(&p->jobs))
+        {
+            assert(p->shutdown);
+            break;
+        }
+
+        job = p->jobs[p->next_job++];
+        pthread_mutex_unlock(&p->mtx);
+
+        job.fn(job.user_data);
+
+        pthread_mutex_lock(&p->mtx);
+        if (--p->pending == 0)
+        {
+            //@NOTE: all jobs are done, so we can reuse the job array from the start
+            cmon_dyn_arr_clear(&p->jobs);
+            p->next_job = 0;
+            pthread_cond_broadcast(&p->done_cond);
+        }
+    }
+    pthread_mutex_unlock(&p->mtx);
+
+    return NULL;
+}
+
+size_t cmon_hardware_thread_count()
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (size_t)count : 1;
+}
+
+cmon_job_pool * cmon_job_pool_create(cmon_allocator * _alloc, size_t _thread_count)
+{
+    size_t i;
+    cmon_job_pool * ret = CMON_CREATE(_alloc, cmon_job_pool);
+    ret->alloc = _alloc;
+    pthread_mutex_init(&ret->mtx, NULL);
+    pthread_cond_init(&ret->job_cond, NULL);
+    pthread_cond_init(&ret->done_cond, NULL);
+    cmon_dyn_arr_init(&ret->jobs, _alloc, 64);
+    ret->next_job = 0;
+    ret->pending = 0;
+    ret->shutdown = cmon_false;
+    ret->thread_count = _thread_count ? _thread_count : cmon_hardware_thread_count();
+    ret->threads = cmon_allocator_alloc(_alloc, sizeof(pthread_t) * ret->thread_count).ptr;
+
+    for (i = 0; i < ret->thread_count; ++i)
+    {
+        if (pthread_create(&ret->threads[i], NULL, _worker_fn, ret) != 0)
+        {
+            cmon_panic("failed to create worker thread");
+        }
+    }
+
+    return ret;
+}
+
+void cmon_job_pool_destroy(cmon_job_pool * _p)
+{
+    size_t i;
+
+    if (!_p)
+        return;
+
+    pthread_mutex_lock(&_p->mtx);
+    _p->shutdown = cmon_true;
+    pthread_cond_broadcast(&_p->job_cond);
+    pthread_mutex_unlock(&_p->mtx);
+
+    for (i = 0; i < _p->thread_count; ++i)
+    {
+        pthread_join(_p->threads[i], NULL);
+    }
+
+    cmon_allocator_free(_p->alloc,
+                        (cmon_mem_blk){ _p->threads, sizeof(pthread_t) * _p->thread_count });
+    cmon_dyn_arr_dealloc(&_p->jobs);
+    pthread_cond_destroy(&_p->done_cond);
+    pthread_cond_destroy(&_p->job_cond);
+    pthread_mutex_destroy(&_p->mtx);
+    CMON_DESTROY(_p->alloc, _p);
+}
+
+void cmon_job_pool_add(cmon_job_pool * _p, cmon_job_fn _fn, void * _user_data)
+{
+    pthread_mutex_lock(&_p->mtx);
+    cmon_dyn_arr_append(&_p->jobs, ((_job){ _fn, _user_data }));
+    ++_p->pending;
+    pthread_cond_signal(&_p->job_cond);
+    pthread_mutex_unlock(&_p->mtx);
+}
+
+void cmon_job_pool_wait(cmon_job_pool * _p)
+{
+    pthread_mutex_lock(&_p->mtx);
+    while (_p->pending)
+    {
+        pthread_cond_wait(&_p->done_cond, &_p->mtx);
+    }
+    pthread_mutex_unlock(&_p->mtx);
+}
+
+size_t cmon_job_pool_thread_count(cmon_job_pool * _p)
+{
+    return _p->thread_count;
+}
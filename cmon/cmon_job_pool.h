@@ -0,0 +1,24 @@
+#ifndef CMON_CMON_JOB_POOL_H
+#define CMON_CMON_JOB_POOL_H
+
+#include <cmon/cmon_allocator.h>
+
+// simple fixed size pthread worker pool. Jobs are executed in FIFO order by whichever worker picks
+// them up first. The pool itself makes no ordering guarantees about when jobs finish, so anything
+// that needs deterministic output (i.e. error reports) has to be merged by the caller after
+// cmon_job_pool_wait returns.
+typedef void (*cmon_job_fn)(void *);
+
+typedef struct cmon_job_pool cmon_job_pool;
+
+CMON_API cmon_job_pool * cmon_job_pool_create(cmon_allocator * _alloc, size_t _thread_count);
+CMON_API void cmon_job_pool_destroy(cmon_job_pool * _p);
+CMON_API void cmon_job_pool_add(cmon_job_pool * _p, cmon_job_fn _fn, void * _user_data);
+// blocks until all jobs added so far are finished
+CMON_API void cmon_job_pool_wait(cmon_job_pool * _p);
+CMON_API size_t cmon_job_pool_thread_count(cmon_job_pool * _p);
+
+// number of hardware threads available to the process (at least 1)
+CMON_API size_t cmon_hardware_thread_count();
+
+#endif // CMON_CMON_JOB_POOL_H
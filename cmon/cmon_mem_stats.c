@@ -0,0 +1,235 @@
+#include <cmon/cmon_dyn_arr.h>
+#include <cmon/cmon_mem_stats.h>
+#include <pthread.h>
+
+typedef struct
+{
+    cmon_mem_stats * stats;
+    cmon_allocator * parent;
+    const char * name;
+    cmon_mem_stats_tag data;
+} _tag_data;
+
+typedef struct cmon_mem_stats
+{
+    cmon_allocator * alloc;
+    pthread_mutex_t mtx;
+    //@NOTE: the tags are individually allocated, as the allocators returned by
+    // cmon_mem_stats_allocator point to them.
+    cmon_dyn_arr(_tag_data *) tags;
+    size_t current;
+    size_t peak;
+} cmon_mem_stats;
+
+static inline size_t _bucket(size_t _byte_count)
+{
+    size_t ret = 0;
+    while (ret < CMON_MEM_STATS_BUCKET_COUNT - 1 && _byte_count > ((size_t)16 << ret))
+        ++ret;
+    return ret;
+}
+
+// needs to be called with the mutex locked
+static inline void _add(_tag_data * _t, size_t _byte_count)
+{
+    cmon_mem_stats * s = _t->stats;
+    _t->data.current += _byte_count;
+    if (_t->data.current > _t->data.peak)
+        _t->data.peak = _t->data.current;
+    s->current += _byte_count;
+    if (s->current > s->peak)
+        s->peak = s->current;
+}
+
+// needs to be called with the mutex locked
+static inline void _remove(_tag_data * _t, size_t _byte_count)
+{
+    assert(_t->data.current >= _byte_count);
+    _t->data.current -= _byte_count;
+    _t->stats->current -= _byte_count;
+}
+
+static inline cmon_mem_blk stats_alloc(size_t _s, void * _user_data)
+{
+    _tag_data * t = (_tag_data *)_user_data;
+    cmon_mem_blk ret = cmon_allocator_alloc(t->parent, _s);
+    if (!ret.ptr)
+        return ret;
+
+    pthread_mutex_lock(&t->stats->mtx);
+    ++t->data.alloc_count;
+    ++t->data.histogram[_bucket(_s)];
+    _add(t, ret.byte_count);
+    pthread_mutex_unlock(&t->stats->mtx);
+    return ret;
+}
+
+static inline cmon_mem_blk stats_realloc(cmon_mem_blk _blk, size_t _s, void * _user_data)
+{
+    _tag_data * t = (_tag_data *)_user_data;
+    cmon_mem_blk ret = cmon_allocator_realloc(t->parent, _blk, _s);
+    if (!ret.ptr)
+        return ret;
+
+    pthread_mutex_lock(&t->stats->mtx);
+    ++t->data.realloc_count;
+    ++t->data.histogram[_bucket(_s)];
+    _remove(t, _blk.ptr ? _blk.byte_count : 0);
+    _add(t, ret.byte_count);
+    pthread_mutex_unlock(&t->stats->mtx);
+    return ret;
+}
+
+static inline void stats_free(cmon_mem_blk _blk, void * _user_data)
+{
+    _tag_data * t = (_tag_data *)_user_data;
+    cmon_allocator_free(t->parent, _blk);
+    if (!_blk.ptr)
+        return;
+
+    pthread_mutex_lock(&t->stats->mtx);
+    ++t->data.free_count;
+    _remove(t, _blk.byte_count);
+    pthread_mutex_unlock(&t->stats->mtx);
+}
+
+cmon_mem_stats * cmon_mem_stats_create(cmon_allocator * _alloc)
+{
+    cmon_mem_stats * ret = CMON_CREATE(_alloc, cmon_mem_stats);
+    ret->alloc = _alloc;
+    pthread_mutex_init(&ret->mtx, NULL);
+    cmon_dyn_arr_init(&ret->tags, _alloc, 8);
+    ret->current = 0;
+    ret->peak = 0;
+    return ret;
+}
+
+void cmon_mem_stats_destroy(cmon_mem_stats * _s)
+{
+    size_t i;
+
+    if (!_s)
+        return;
+
+    for (i = 0; i < cmon_dyn_arr_count(&_s->tags); ++i)
+    {
+        CMON_DESTROY(_s->alloc, _s->tags[i]);
+    }
+    cmon_dyn_arr_dealloc(&_s->tags);
+    pthread_mutex_destroy(&_s->mtx);
+    CMON_DESTROY(_s->alloc, _s);
+}
+
+cmon_allocator cmon_mem_stats_allocator(cmon_mem_stats * _s,
+                                        cmon_allocator * _parent,
+                                        const char * _tag)
+{
+    cmon_allocator ret;
+    _tag_data * t = NULL;
+    size_t i;
+
+    pthread_mutex_lock(&_s->mtx);
+    for (i = 0; i < cmon_dyn_arr_count(&_s->tags); ++i)
+    {
+        if (_s->tags[i]->parent == _parent && strcmp(_s->tags[i]->name, _tag) == 0)
+        {
+            t = _s->tags[i];
+            break;
+        }
+    }
+
+    if (!t)
+    {
+        t = CMON_CREATE(_s->alloc, _tag_data);
+        memset(t, 0, sizeof(*t));
+        t->stats = _s;
+        t->parent = _parent;
+        t->name = _tag;
+        cmon_dyn_arr_append(&_s->tags, t);
+    }
+    pthread_mutex_unlock(&_s->mtx);
+
+    ret.user_data = t;
+    ret.alloc_fn = stats_alloc;
+    ret.realloc_fn = stats_realloc;
+    ret.free_fn = stats_free;
+    ret.shutdown_fn = NULL;
+    return ret;
+}
+
+size_t cmon_mem_stats_tag_count(cmon_mem_stats * _s)
+{
+    return cmon_dyn_arr_count(&_s->tags);
+}
+
+const char * cmon_mem_stats_tag_name(cmon_mem_stats * _s, size_t _idx)
+{
+    return _s->tags[_idx]->name;
+}
+
+cmon_mem_stats_tag cmon_mem_stats_tag_stats(cmon_mem_stats * _s, size_t _idx)
+{
+    cmon_mem_stats_tag ret;
+    pthread_mutex_lock(&_s->mtx);
+    ret = _s->tags[_idx]->data;
+    pthread_mutex_unlock(&_s->mtx);
+    return ret;
+}
+
+size_t cmon_mem_stats_peak(cmon_mem_stats * _s)
+{
+    size_t ret;
+    pthread_mutex_lock(&_s->mtx);
+    ret = _s->peak;
+    pthread_mutex_unlock(&_s->mtx);
+    return ret;
+}
+
+static inline void _append_bytes(cmon_str_builder * _b, size_t _byte_count)
+{
+    if (_byte_count >= 1024 * 1024)
+        cmon_str_builder_append_fmt(_b, "%10.2fMiB", (double)_byte_count / (1024.0 * 1024.0));
+    else
+        cmon_str_builder_append_fmt(_b, "%10.2fKiB", (double)_byte_count / 1024.0);
+}
+
+void cmon_mem_stats_report(cmon_mem_stats * _s, cmon_str_builder * _b)
+{
+    size_t i, j;
+
+    cmon_str_builder_append_fmt(_b,
+                                "%-12s %13s %13s %10s %10s %10s\n",
+                                "tag",
+                                "current",
+                                "peak",
+                                "allocs",
+                                "reallocs",
+                                "frees");
+    for (i = 0; i < cmon_mem_stats_tag_count(_s); ++i)
+    {
+        cmon_mem_stats_tag t = cmon_mem_stats_tag_stats(_s, i);
+        cmon_str_builder_append_fmt(_b, "%-12s ", cmon_mem_stats_tag_name(_s, i));
+        _append_bytes(_b, t.current);
+        cmon_str_builder_append(_b, " ");
+        _append_bytes(_b, t.peak);
+        cmon_str_builder_append_fmt(
+            _b, " %10lu %10lu %10lu\n", t.alloc_count, t.realloc_count, t.free_count);
+
+        cmon_str_builder_append(_b, "    sizes:");
+        for (j = 0; j < CMON_MEM_STATS_BUCKET_COUNT; ++j)
+        {
+            if (!t.histogram[j])
+                continue;
+
+            if (j < CMON_MEM_STATS_BUCKET_COUNT - 1)
+                cmon_str_builder_append_fmt(_b, " <=%lu: %lu", (size_t)16 << j, t.histogram[j]);
+            else
+                cmon_str_builder_append_fmt(
+                    _b, " >%lu: %lu", (size_t)16 << (j - 1), t.histogram[j]);
+        }
+        cmon_str_builder_append(_b, "\n");
+    }
+    cmon_str_builder_append(_b, "total peak ");
+    _append_bytes(_b, cmon_mem_stats_peak(_s));
+    cmon_str_builder_append(_b, "\n");
+}
@@ -0,0 +1,39 @@
+#ifndef CMON_CMON_MEM_STATS_H
+#define CMON_CMON_MEM_STATS_H
+
+#include <cmon/cmon_str_builder.h>
+
+// number of buckets of the allocation size histogram. Bucket i counts allocations of up to 16 << i
+// bytes, the last one everything bigger.
+#define CMON_MEM_STATS_BUCKET_COUNT 16
+
+// accounts the memory allocated through wrapping allocators, grouped by tag (i.e. "tokens" or
+// "types"). Thread safe.
+typedef struct cmon_mem_stats cmon_mem_stats;
+
+typedef struct
+{
+    size_t current;
+    size_t peak;
+    size_t alloc_count;
+    size_t realloc_count;
+    size_t free_count;
+    size_t histogram[CMON_MEM_STATS_BUCKET_COUNT];
+} cmon_mem_stats_tag;
+
+CMON_API cmon_mem_stats * cmon_mem_stats_create(cmon_allocator * _alloc);
+CMON_API void cmon_mem_stats_destroy(cmon_mem_stats * _s);
+// returns an allocator that forwards to _parent and accounts everything under _tag. The returned
+// allocator does not need to be deallocated and stays valid as long as _s does.
+CMON_API cmon_allocator cmon_mem_stats_allocator(cmon_mem_stats * _s,
+                                                 cmon_allocator * _parent,
+                                                 const char * _tag);
+CMON_API size_t cmon_mem_stats_tag_count(cmon_mem_stats * _s);
+CMON_API const char * cmon_mem_stats_tag_name(cmon_mem_stats * _s, size_t _idx);
+CMON_API cmon_mem_stats_tag cmon_mem_stats_tag_stats(cmon_mem_stats * _s, size_t _idx);
+// peak of the bytes allocated across all tags at once
+CMON_API size_t cmon_mem_stats_peak(cmon_mem_stats * _s);
+// appends a human readable report to _b
+CMON_API void cmon_mem_stats_report(cmon_mem_stats * _s, cmon_str_builder * _b);
+
+#endif // CMON_CMON_MEM_STATS_H
@@ -0,0 +1,751 @@
+#include <cmon/cmon_ast.h>
+#include <cmon/cmon_dyn_arr.h>
+#include <cmon/cmon_hashmap.h>
+#include <cmon/cmon_mod_iface.h>
+#include <cmon/cmon_str_builder.h>
+#include <cmon/cmon_util.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// file layout (native byte order, everything 4 byte aligned):
+// _header | deps (u32 str offsets) | _type_rec[] | _field_rec[] | u32 idx[] | _sym_rec[] | strings
+#define _MAGIC "CMIF"
+#define _VERSION 1
+#define _NO_IDX ((uint32_t)-1)
+
+typedef enum
+{
+    _ifk_extern, // builtin or a struct of another module, referenced by unique name
+    _ifk_struct,
+    _ifk_ptr,
+    _ifk_view,
+    _ifk_array,
+    _ifk_fn
+} _ifk;
+
+typedef enum
+{
+    _symf_mut = 1,
+    _symf_fn = 2
+} _symf;
+
+typedef struct
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t src_hash;
+    uint32_t dep_count;
+    uint32_t type_count;
+    uint32_t field_count;
+    uint32_t idx_count;
+    uint32_t sym_count;
+    uint32_t str_size;
+} _header;
+
+// a, b and c depend on the kind:
+// extern: -
+// struct: first field, field count
+// ptr/view: type, is_mut
+// array: type, count
+// fn: return type, first param type in idx, param count
+typedef struct
+{
+    uint32_t kind;
+    uint32_t name;
+    uint32_t a;
+    uint32_t b;
+    uint32_t c;
+} _type_rec;
+
+typedef struct
+{
+    uint32_t name;
+    uint32_t type;
+} _field_rec;
+
+// fn params are stored as (name, type, is_mut) triplets in idx
+typedef struct
+{
+    uint32_t kind;
+    uint32_t name;
+    uint32_t type;
+    uint32_t flags;
+    uint32_t first_param;
+    uint32_t param_count;
+} _sym_rec;
+
+typedef struct cmon_mod_iface
+{
+    cmon_allocator * alloc;
+    void * data;
+    size_t size;
+    const _header * header;
+    const uint32_t * deps;
+    const _type_rec * types;
+    const _field_rec * fields;
+    const uint32_t * idx;
+    const _sym_rec * syms;
+    const char * strs;
+    // filled in by cmon_mod_iface_import
+    cmon_dyn_arr(cmon_idx) type_map;
+    // imported symbol -> index of its record
+    cmon_hashmap(cmon_idx, cmon_idx) sym_map;
+} cmon_mod_iface;
+
+typedef struct
+{
+    cmon_src * src;
+    cmon_modules * mods;
+    cmon_symbols * symbols;
+    cmon_types * types;
+    cmon_idx mod_idx;
+    cmon_str_buf * strs;
+    cmon_str_builder * tmp_str_builder;
+    cmon_dyn_arr(uint32_t) deps;
+    cmon_dyn_arr(_type_rec) type_recs;
+    cmon_dyn_arr(_field_rec) field_recs;
+    cmon_dyn_arr(uint32_t) idx;
+    cmon_dyn_arr(_sym_rec) sym_recs;
+    // maps cmon_types indices to type records
+    cmon_dyn_arr(uint32_t) type_map;
+    cmon_dyn_arr(uint32_t) tmp_idx;
+} _writer;
+
+static inline size_t _align4(size_t _v)
+{
+    return (_v + 3) & ~(size_t)3;
+}
+
+static inline uint32_t _add_str(_writer * _w, const char * _str)
+{
+    return (uint32_t)cmon_str_buf_append(_w->strs, _str);
+}
+
+static inline uint32_t _add_str_view(_writer * _w, cmon_str_view _sv)
+{
+    return _add_str(
+        _w, cmon_str_builder_tmp_str(_w->tmp_str_builder, "%.*s", _sv.end - _sv.begin, _sv.begin));
+}
+
+static uint32_t _write_type(_writer * _w, cmon_idx _type)
+{
+    _type_rec rec;
+    size_t i, tmp_begin;
+
+    if (_w->type_map[_type] != _NO_IDX)
+        return _w->type_map[_type];
+
+    memset(&rec, 0, sizeof(rec));
+    cmon_typek kind = cmon_types_kind(_w->types, _type);
+
+    //@NOTE: the records a type refers to are always written before the type itself (except for
+    // struct fields), so they can be imported in order.
+    if (kind == cmon_typek_ptr)
+    {
+        rec.kind = _ifk_ptr;
+        rec.a = _write_type(_w, cmon_types_ptr_type(_w->types, _type));
+        rec.b = cmon_types_ptr_is_mut(_w->types, _type);
+    }
+    else if (kind == cmon_typek_view)
+    {
+        rec.kind = _ifk_view;
+        rec.a = _write_type(_w, cmon_types_view_type(_w->types, _type));
+        rec.b = cmon_types_view_is_mut(_w->types, _type);
+    }
+    else if (kind == cmon_typek_array)
+    {
+        rec.kind = _ifk_array;
+        rec.a = _write_type(_w, cmon_types_array_type(_w->types, _type));
+        rec.b = (uint32_t)cmon_types_array_count(_w->types, _type);
+    }
+    else if (kind == cmon_typek_fn)
+    {
+        rec.kind = _ifk_fn;
+        rec.a = _write_type(_w, cmon_types_fn_return_type(_w->types, _type));
+        // params might add more records, so collect them before adding them to idx
+        tmp_begin = cmon_dyn_arr_count(&_w->tmp_idx);
+        for (i = 0; i < cmon_types_fn_param_count(_w->types, _type); ++i)
+        {
+            uint32_t param = _write_type(_w, cmon_types_fn_param(_w->types, _type, i));
+            cmon_dyn_arr_append(&_w->tmp_idx, param);
+        }
+        rec.b = cmon_dyn_arr_count(&_w->idx);
+        rec.c = cmon_dyn_arr_count(&_w->tmp_idx) - tmp_begin;
+        for (i = tmp_begin; i < cmon_dyn_arr_count(&_w->tmp_idx); ++i)
+        {
+            cmon_dyn_arr_append(&_w->idx, _w->tmp_idx[i]);
+        }
+        cmon_dyn_arr_resize(&_w->tmp_idx, tmp_begin);
+    }
+    else
+    {
+        //@NOTE: structs of this module are all written upfront, so this is either a builtin or a
+        // struct of another module.
+        assert(kind != cmon_typek_struct || cmon_types_module(_w->types, _type) != _w->mod_idx);
+        rec.kind = _ifk_extern;
+        rec.name = _add_str(_w, cmon_types_unique_name(_w->types, _type));
+    }
+
+    cmon_dyn_arr_append(&_w->type_recs, rec);
+    _w->type_map[_type] = cmon_dyn_arr_count(&_w->type_recs) - 1;
+    return _w->type_map[_type];
+}
+
+static cmon_bool _write_sym(_writer * _w, cmon_idx _sym)
+{
+    _sym_rec rec;
+    size_t i;
+
+    memset(&rec, 0, sizeof(rec));
+    rec.kind = cmon_symbols_kind(_w->symbols, _sym);
+    rec.name = _add_str_view(_w, cmon_symbols_name(_w->symbols, _sym));
+
+    if (rec.kind == cmon_symk_var)
+    {
+        rec.type = _write_type(_w, cmon_symbols_var_type(_w->symbols, _sym));
+        if (cmon_symbols_var_is_mut(_w->symbols, _sym))
+            rec.flags |= _symf_mut;
+
+        // other modules need the param names of functions to declare them
+        cmon_ast * ast = cmon_src_ast(_w->src, cmon_symbols_src_file(_w->symbols, _sym));
+        cmon_idx expr = cmon_ast_var_decl_expr(ast, cmon_symbols_ast(_w->symbols, _sym));
+        if (cmon_is_valid_idx(expr) && cmon_ast_kind(ast, expr) == cmon_astk_fn_decl)
+        {
+            size_t tmp_begin = cmon_dyn_arr_count(&_w->tmp_idx);
+            rec.flags |= _symf_fn;
+            for (i = 0; i < cmon_ast_fn_params_count(ast, expr); ++i)
+            {
+                cmon_idx param = cmon_ast_fn_param(ast, expr, i);
+                cmon_idx psym = cmon_ast_var_decl_sym(ast, param);
+                cmon_dyn_arr_append(&_w->tmp_idx,
+                                    _add_str(_w, cmon_symbols_unique_name(_w->symbols, psym)));
+                cmon_dyn_arr_append(&_w->tmp_idx,
+                                    _write_type(_w, cmon_symbols_var_type(_w->symbols, psym)));
+                cmon_dyn_arr_append(&_w->tmp_idx, (uint32_t)cmon_ast_var_decl_is_mut(ast, param));
+            }
+
+            rec.first_param = cmon_dyn_arr_count(&_w->idx);
+            rec.param_count = (cmon_dyn_arr_count(&_w->tmp_idx) - tmp_begin) / 3;
+            for (i = tmp_begin; i < cmon_dyn_arr_count(&_w->tmp_idx); ++i)
+            {
+                cmon_dyn_arr_append(&_w->idx, _w->tmp_idx[i]);
+            }
+            cmon_dyn_arr_resize(&_w->tmp_idx, tmp_begin);
+        }
+    }
+    else if (rec.kind == cmon_symk_type || rec.kind == cmon_symk_alias)
+    {
+        rec.type = _write_type(_w, cmon_symbols_type(_w->symbols, _sym));
+    }
+    else
+    {
+        // imports are never pub
+        return cmon_true;
+    }
+
+    cmon_dyn_arr_append(&_w->sym_recs, rec);
+    return cmon_false;
+}
+
+static cmon_bool _write_iface(_writer * _w)
+{
+    size_t i, j, type_count;
+
+    for (i = 0; i < cmon_modules_dep_count(_w->mods, _w->mod_idx); ++i)
+    {
+        cmon_dyn_arr_append(
+            &_w->deps,
+            _add_str(_w,
+                     cmon_modules_path(_w->mods,
+                                       cmon_modules_dep_mod_idx(_w->mods, _w->mod_idx, i))));
+    }
+
+    // all structs of the module are part of the interface (see _hash_iface in
+    // cmon_build_manifest.c). They are written first and in type order so that importing them
+    // recreates them in the same order.
+    type_count = cmon_types_count(_w->types);
+    cmon_dyn_arr_resize(&_w->type_map, type_count);
+    memset(&_w->type_map[0], 0xff, sizeof(uint32_t) * type_count);
+    for (i = 0; i < type_count; ++i)
+    {
+        if (cmon_types_kind(_w->types, i) != cmon_typek_struct ||
+            cmon_types_module(_w->types, i) != _w->mod_idx)
+            continue;
+
+        _type_rec rec;
+        memset(&rec, 0, sizeof(rec));
+        rec.kind = _ifk_struct;
+        rec.name = _add_str(_w, cmon_types_name(_w->types, i));
+        cmon_dyn_arr_append(&_w->type_recs, rec);
+        _w->type_map[i] = cmon_dyn_arr_count(&_w->type_recs) - 1;
+    }
+
+    cmon_idx scope = cmon_modules_global_scope(_w->mods, _w->mod_idx);
+    for (i = 0; i < cmon_symbols_scope_symbol_count(_w->symbols, scope); ++i)
+    {
+        cmon_idx sym = cmon_symbols_scope_symbol(_w->symbols, scope, i);
+        if (cmon_symbols_is_pub(_w->symbols, sym) && _write_sym(_w, sym))
+            return cmon_true;
+    }
+
+    for (i = 0; i < type_count; ++i)
+    {
+        if (_w->type_map[i] == _NO_IDX || cmon_types_kind(_w->types, i) != cmon_typek_struct ||
+            cmon_types_module(_w->types, i) != _w->mod_idx)
+            continue;
+
+        _type_rec * rec = &_w->type_recs[_w->type_map[i]];
+        size_t field_count = cmon_types_struct_field_count(_w->types, i);
+
+        // field types might add more records, collect them first so the fields stay contiguous
+        for (j = 0; j < field_count; ++j)
+        {
+            //@NOTE: default expressions get copied into the code of the module initializing the
+            // struct, which needs the ast of this module.
+            if (cmon_is_valid_idx(cmon_types_struct_field_def_expr(_w->types, i, j)))
+                return cmon_true;
+            uint32_t ftype = _write_type(_w, cmon_types_struct_field_type(_w->types, i, j));
+            cmon_dyn_arr_append(&_w->tmp_idx, ftype);
+        }
+
+        rec = &_w->type_recs[_w->type_map[i]];
+        rec->a = cmon_dyn_arr_count(&_w->field_recs);
+        rec->b = field_count;
+        for (j = 0; j < field_count; ++j)
+        {
+            cmon_dyn_arr_append(
+                &_w->field_recs,
+                ((_field_rec){ _add_str(_w, cmon_types_struct_field_name(_w->types, i, j)),
+                               _w->tmp_idx[j] }));
+        }
+        cmon_dyn_arr_clear(&_w->tmp_idx);
+    }
+
+    return cmon_false;
+}
+
+static inline cmon_bool _save(_writer * _w, const char * _path, uint64_t _src_hash)
+{
+    _header h;
+    FILE * fp;
+    cmon_bool ret;
+    static const char padding[4] = { 0 };
+
+    memcpy(h.magic, _MAGIC, sizeof(h.magic));
+    h.version = _VERSION;
+    h.src_hash = _src_hash;
+    h.dep_count = cmon_dyn_arr_count(&_w->deps);
+    h.type_count = cmon_dyn_arr_count(&_w->type_recs);
+    h.field_count = cmon_dyn_arr_count(&_w->field_recs);
+    h.idx_count = cmon_dyn_arr_count(&_w->idx);
+    h.sym_count = cmon_dyn_arr_count(&_w->sym_recs);
+    h.str_size = cmon_str_buf_count(_w->strs);
+
+    fp = fopen(_path, "wb");
+    if (!fp)
+        return cmon_true;
+
+    ret = fwrite(&h, sizeof(h), 1, fp) != 1;
+    ret |= h.dep_count && fwrite(&_w->deps[0], sizeof(uint32_t), h.dep_count, fp) != h.dep_count;
+    ret |= h.type_count &&
+           fwrite(&_w->type_recs[0], sizeof(_type_rec), h.type_count, fp) != h.type_count;
+    ret |= h.field_count &&
+           fwrite(&_w->field_recs[0], sizeof(_field_rec), h.field_count, fp) != h.field_count;
+    ret |= h.idx_count && fwrite(&_w->idx[0], sizeof(uint32_t), h.idx_count, fp) != h.idx_count;
+    ret |= h.sym_count && fwrite(&_w->sym_recs[0], sizeof(_sym_rec), h.sym_count, fp) != h.sym_count;
+    ret |= h.str_size && fwrite(cmon_str_buf_get(_w->strs, 0), 1, h.str_size, fp) != h.str_size;
+    ret |= fwrite(padding, 1, _align4(h.str_size) - h.str_size, fp) != _align4(h.str_size) - h.str_size;
+    ret |= fclose(fp) != 0;
+    return ret;
+}
+
+cmon_bool cmon_mod_iface_write(cmon_allocator * _alloc,
+                               const char * _path,
+                               cmon_src * _src,
+                               cmon_modules * _mods,
+                               cmon_symbols * _symbols,
+                               cmon_types * _types,
+                               cmon_idx _mod_idx,
+                               uint64_t _src_hash)
+{
+    _writer w;
+    cmon_bool ret;
+
+    w.src = _src;
+    w.mods = _mods;
+    w.symbols = _symbols;
+    w.types = _types;
+    w.mod_idx = _mod_idx;
+    w.strs = cmon_str_buf_create(_alloc, 1024);
+    w.tmp_str_builder = cmon_str_builder_create(_alloc, 64);
+    cmon_dyn_arr_init(&w.deps, _alloc, 4);
+    cmon_dyn_arr_init(&w.type_recs, _alloc, 32);
+    cmon_dyn_arr_init(&w.field_recs, _alloc, 32);
+    cmon_dyn_arr_init(&w.idx, _alloc, 32);
+    cmon_dyn_arr_init(&w.sym_recs, _alloc, 32);
+    cmon_dyn_arr_init(&w.type_map, _alloc, 64);
+    cmon_dyn_arr_init(&w.tmp_idx, _alloc, 16);
+
+    ret = _write_iface(&w) || _save(&w, _path, _src_hash);
+
+    cmon_dyn_arr_dealloc(&w.tmp_idx);
+    cmon_dyn_arr_dealloc(&w.type_map);
+    cmon_dyn_arr_dealloc(&w.sym_recs);
+    cmon_dyn_arr_dealloc(&w.idx);
+    cmon_dyn_arr_dealloc(&w.field_recs);
+    cmon_dyn_arr_dealloc(&w.type_recs);
+    cmon_dyn_arr_dealloc(&w.deps);
+    cmon_str_builder_destroy(w.tmp_str_builder);
+    cmon_str_buf_destroy(w.strs);
+    return ret;
+}
+
+static inline cmon_bool _valid_str(cmon_mod_iface * _m, uint32_t _off)
+{
+    return _off < _m->header->str_size;
+}
+
+static inline cmon_bool _valid_type_ref(cmon_mod_iface * _m, uint32_t _ref, uint32_t _before)
+{
+    return _ref < _before && _ref < _m->header->type_count;
+}
+
+// makes sure that all offsets and indices in the file are in range, so the rest of the code can
+// trust them.
+static inline cmon_bool _validate(cmon_mod_iface * _m)
+{
+    const _header * h = _m->header;
+    size_t i, j, size;
+
+    if (_m->size < sizeof(_header) || memcmp(h->magic, _MAGIC, sizeof(h->magic)) != 0 ||
+        h->version != _VERSION)
+        return cmon_true;
+
+    size = sizeof(_header) + sizeof(uint32_t) * ((size_t)h->dep_count + h->idx_count) +
+           sizeof(_type_rec) * h->type_count + sizeof(_field_rec) * h->field_count +
+           sizeof(_sym_rec) * h->sym_count;
+    //@NOTE: the string table is padded to a multiple of 4 bytes, so truncated files are detected
+    if (_m->size != _align4(size + h->str_size))
+        return cmon_true;
+
+    _m->deps = (const uint32_t *)(h + 1);
+    _m->types = (const _type_rec *)(_m->deps + h->dep_count);
+    _m->fields = (const _field_rec *)(_m->types + h->type_count);
+    _m->idx = (const uint32_t *)(_m->fields + h->field_count);
+    _m->syms = (const _sym_rec *)(_m->idx + h->idx_count);
+    _m->strs = (const char *)(_m->syms + h->sym_count);
+
+    if (h->str_size && _m->strs[h->str_size - 1] != '\0')
+        return cmon_true;
+
+    for (i = 0; i < h->dep_count; ++i)
+    {
+        if (!_valid_str(_m, _m->deps[i]))
+            return cmon_true;
+    }
+
+    for (i = 0; i < h->type_count; ++i)
+    {
+        const _type_rec * t = &_m->types[i];
+        if (t->kind == _ifk_extern || t->kind == _ifk_struct)
+        {
+            if (!_valid_str(_m, t->name))
+                return cmon_true;
+            if (t->kind == _ifk_struct &&
+                ((size_t)t->a + t->b > h->field_count))
+                return cmon_true;
+        }
+        else if (t->kind == _ifk_ptr || t->kind == _ifk_view || t->kind == _ifk_array)
+        {
+            if (!_valid_type_ref(_m, t->a, i))
+                return cmon_true;
+        }
+        else if (t->kind == _ifk_fn)
+        {
+            if (!_valid_type_ref(_m, t->a, i) || (size_t)t->b + t->c > h->idx_count)
+                return cmon_true;
+            for (j = 0; j < t->c; ++j)
+            {
+                if (!_valid_type_ref(_m, _m->idx[t->b + j], i))
+                    return cmon_true;
+            }
+        }
+        else
+        {
+            return cmon_true;
+        }
+    }
+
+    for (i = 0; i < h->field_count; ++i)
+    {
+        if (!_valid_str(_m, _m->fields[i].name) ||
+            !_valid_type_ref(_m, _m->fields[i].type, h->type_count))
+            return cmon_true;
+    }
+
+    for (i = 0; i < h->sym_count; ++i)
+    {
+        const _sym_rec * s = &_m->syms[i];
+        if ((s->kind != cmon_symk_var && s->kind != cmon_symk_type && s->kind != cmon_symk_alias) ||
+            !_valid_str(_m, s->name) || !_valid_type_ref(_m, s->type, h->type_count) ||
+            (size_t)s->first_param + (size_t)s->param_count * 3 > h->idx_count)
+            return cmon_true;
+
+        for (j = 0; j < s->param_count; ++j)
+        {
+            if (!_valid_str(_m, _m->idx[s->first_param + j * 3]) ||
+                !_valid_type_ref(_m, _m->idx[s->first_param + j * 3 + 1], h->type_count))
+                return cmon_true;
+        }
+    }
+
+    return cmon_false;
+}
+
+cmon_mod_iface * cmon_mod_iface_load(cmon_allocator * _alloc, const char * _path)
+{
+    int fd;
+    struct stat st;
+    void * data;
+    cmon_mod_iface * ret;
+
+    fd = open(_path, O_RDONLY);
+    if (fd == -1)
+        return NULL;
+
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(_header))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    //@NOTE: the mapping stays valid after closing the file
+    close(fd);
+    if (data == MAP_FAILED)
+        return NULL;
+
+    ret = CMON_CREATE(_alloc, cmon_mod_iface);
+    ret->alloc = _alloc;
+    ret->data = data;
+    ret->size = st.st_size;
+    ret->header = (const _header *)data;
+    cmon_dyn_arr_init(&ret->type_map, _alloc, 1);
+    cmon_hashmap_int_key_init(&ret->sym_map, _alloc);
+
+    if (_validate(ret))
+    {
+        cmon_mod_iface_destroy(ret);
+        return NULL;
+    }
+
+    return ret;
+}
+
+void cmon_mod_iface_destroy(cmon_mod_iface * _m)
+{
+    if (!_m)
+        return;
+
+    cmon_hashmap_dealloc(&_m->sym_map);
+    cmon_dyn_arr_dealloc(&_m->type_map);
+    munmap(_m->data, _m->size);
+    CMON_DESTROY(_m->alloc, _m);
+}
+
+uint64_t cmon_mod_iface_src_hash(cmon_mod_iface * _m)
+{
+    return _m->header->src_hash;
+}
+
+size_t cmon_mod_iface_dep_count(cmon_mod_iface * _m)
+{
+    return _m->header->dep_count;
+}
+
+const char * cmon_mod_iface_dep_path(cmon_mod_iface * _m, size_t _idx)
+{
+    assert(_idx < _m->header->dep_count);
+    return _m->strs + _m->deps[_idx];
+}
+
+cmon_bool cmon_mod_iface_import(cmon_mod_iface * _m,
+                                cmon_modules * _mods,
+                                cmon_symbols * _symbols,
+                                cmon_types * _types,
+                                cmon_idx _mod_idx)
+{
+    const _header * h = _m->header;
+    size_t i, j;
+    cmon_idx scope, sym;
+    cmon_dyn_arr(cmon_idx) params;
+
+    assert(!cmon_is_valid_idx(cmon_modules_global_scope(_mods, _mod_idx)));
+
+    // make sure that everything the interface refers to exists before adding anything
+    for (i = 0; i < h->dep_count; ++i)
+    {
+        if (!cmon_is_valid_idx(
+                cmon_modules_find(_mods, cmon_str_view_make(cmon_mod_iface_dep_path(_m, i)))))
+            return cmon_true;
+    }
+
+    cmon_dyn_arr_resize(&_m->type_map, h->type_count);
+    for (i = 0; i < h->type_count; ++i)
+    {
+        _m->type_map[i] = CMON_INVALID_IDX;
+        if (_m->types[i].kind == _ifk_extern)
+        {
+            _m->type_map[i] = cmon_types_find(_types, _m->strs + _m->types[i].name);
+            if (!cmon_is_valid_idx(_m->type_map[i]))
+                return cmon_true;
+        }
+    }
+
+    for (i = 0; i < h->dep_count; ++i)
+    {
+        cmon_modules_add_dep(_mods,
+                             _mod_idx,
+                             cmon_modules_find(_mods, cmon_str_view_make(cmon_mod_iface_dep_path(_m, i))),
+                             CMON_INVALID_IDX,
+                             CMON_INVALID_IDX);
+    }
+
+    cmon_dyn_arr_init(&params, _m->alloc, 8);
+    for (i = 0; i < h->type_count; ++i)
+    {
+        const _type_rec * t = &_m->types[i];
+        if (t->kind == _ifk_struct)
+        {
+            _m->type_map[i] = cmon_types_add_struct(_types,
+                                                    _mod_idx,
+                                                    cmon_str_view_make(_m->strs + t->name),
+                                                    CMON_INVALID_IDX,
+                                                    CMON_INVALID_IDX);
+        }
+        else if (t->kind == _ifk_ptr)
+        {
+            _m->type_map[i] = cmon_types_find_ptr(_types, _m->type_map[t->a], t->b, _mod_idx);
+        }
+        else if (t->kind == _ifk_view)
+        {
+            _m->type_map[i] = cmon_types_find_view(_types, _m->type_map[t->a], t->b, _mod_idx);
+        }
+        else if (t->kind == _ifk_array)
+        {
+            _m->type_map[i] = cmon_types_find_array(_types, _m->type_map[t->a], t->b, _mod_idx);
+        }
+        else if (t->kind == _ifk_fn)
+        {
+            cmon_dyn_arr_clear(&params);
+            for (j = 0; j < t->c; ++j)
+            {
+                cmon_dyn_arr_append(&params, _m->type_map[_m->idx[t->b + j]]);
+            }
+            _m->type_map[i] = cmon_types_find_fn(
+                _types, _m->type_map[t->a], &params[0], cmon_dyn_arr_count(&params), _mod_idx);
+        }
+    }
+    cmon_dyn_arr_dealloc(&params);
+
+    for (i = 0; i < h->type_count; ++i)
+    {
+        const _type_rec * t = &_m->types[i];
+        if (t->kind != _ifk_struct)
+            continue;
+
+        for (j = t->a; j < t->a + t->b; ++j)
+        {
+            cmon_types_struct_add_field(_types,
+                                        _m->type_map[i],
+                                        cmon_str_view_make(_m->strs + _m->fields[j].name),
+                                        _m->type_map[_m->fields[j].type],
+                                        CMON_INVALID_IDX);
+        }
+    }
+
+    //@NOTE: imported symbols have no src file or ast, the remaining information other modules need
+    // is available through the cmon_mod_iface_fn_* functions.
+    scope = cmon_symbols_scope_begin(_symbols, CMON_INVALID_IDX, _mod_idx);
+    cmon_modules_set_global_scope(_mods, _mod_idx, scope);
+    cmon_hashmap_reserve(&_m->sym_map, h->sym_count);
+    for (i = 0; i < h->sym_count; ++i)
+    {
+        const _sym_rec * s = &_m->syms[i];
+        cmon_str_view name = cmon_str_view_make(_m->strs + s->name);
+        if (s->kind == cmon_symk_var)
+        {
+            sym = cmon_symbols_scope_add_var(_symbols,
+                                             scope,
+                                             name,
+                                             _m->type_map[s->type],
+                                             cmon_true,
+                                             (s->flags & _symf_mut) != 0,
+                                             CMON_INVALID_IDX,
+                                             CMON_INVALID_IDX);
+        }
+        else if (s->kind == cmon_symk_type)
+        {
+            sym = cmon_symbols_scope_add_type(_symbols,
+                                              scope,
+                                              name,
+                                              _m->type_map[s->type],
+                                              cmon_true,
+                                              CMON_INVALID_IDX,
+                                              CMON_INVALID_IDX);
+        }
+        else
+        {
+            sym = cmon_symbols_scope_add_alias(_symbols,
+                                               scope,
+                                               name,
+                                               _m->type_map[s->type],
+                                               cmon_true,
+                                               CMON_INVALID_IDX,
+                                               CMON_INVALID_IDX);
+        }
+        cmon_hashmap_set(&_m->sym_map, sym, i);
+    }
+
+    return cmon_false;
+}
+
+static inline const _sym_rec * _find_sym(cmon_mod_iface * _m, cmon_idx _sym)
+{
+    cmon_idx * rec = cmon_hashmap_find(&_m->sym_map, &_sym);
+    assert(rec);
+    return &_m->syms[*rec];
+}
+
+cmon_bool cmon_mod_iface_sym_is_fn(cmon_mod_iface * _m, cmon_idx _sym)
+{
+    return (_find_sym(_m, _sym)->flags & _symf_fn) != 0;
+}
+
+size_t cmon_mod_iface_fn_param_count(cmon_mod_iface * _m, cmon_idx _sym)
+{
+    return _find_sym(_m, _sym)->param_count;
+}
+
+const char * cmon_mod_iface_fn_param_name(cmon_mod_iface * _m, cmon_idx _sym, size_t _param_idx)
+{
+    const _sym_rec * s = _find_sym(_m, _sym);
+    assert(_param_idx < s->param_count);
+    return _m->strs + _m->idx[s->first_param + _param_idx * 3];
+}
+
+cmon_idx cmon_mod_iface_fn_param_type(cmon_mod_iface * _m, cmon_idx _sym, size_t _param_idx)
+{
+    const _sym_rec * s = _find_sym(_m, _sym);
+    assert(_param_idx < s->param_count);
+    return _m->type_map[_m->idx[s->first_param + _param_idx * 3 + 1]];
+}
+
+cmon_bool cmon_mod_iface_fn_param_is_mut(cmon_mod_iface * _m, cmon_idx _sym, size_t _param_idx)
+{
+    const _sym_rec * s = _find_sym(_m, _sym);
+    assert(_param_idx < s->param_count);
+    return _m->idx[s->first_param + _param_idx * 3 + 2] != 0;
+}
@@ -0,0 +1,56 @@
+#ifndef CMON_CMON_MOD_IFACE_H
+#define CMON_CMON_MOD_IFACE_H
+
+#include <cmon/cmon_modules.h>
+#include <cmon/cmon_symbols.h>
+#include <cmon/cmon_types.h>
+
+// binary module interface. Contains everything other modules need to compile against a module: its
+// dependencies, the struct types it defines (and all types those or its pub symbols refer to) and its
+// pub symbols including the signatures of pub functions. Interface files are memory mapped and
+// imported instead of tokenizing, parsing and resolving the module again if its src did not change.
+typedef struct cmon_mod_iface cmon_mod_iface;
+
+// writes the interface of a resolved module to _path. Returns cmon_true if the file could not be
+// written or if the module can't be expressed as an interface (i.e. struct fields with default
+// expressions, as other modules need their ast).
+CMON_API cmon_bool cmon_mod_iface_write(cmon_allocator * _alloc,
+                                        const char * _path,
+                                        cmon_src * _src,
+                                        cmon_modules * _mods,
+                                        cmon_symbols * _symbols,
+                                        cmon_types * _types,
+                                        cmon_idx _mod_idx,
+                                        uint64_t _src_hash);
+
+// maps an interface file into memory. Returns NULL if it does not exist or is not valid.
+CMON_API cmon_mod_iface * cmon_mod_iface_load(cmon_allocator * _alloc, const char * _path);
+// symbols imported from the interface reference its memory, so it has to outlive them.
+CMON_API void cmon_mod_iface_destroy(cmon_mod_iface * _m);
+CMON_API uint64_t cmon_mod_iface_src_hash(cmon_mod_iface * _m);
+CMON_API size_t cmon_mod_iface_dep_count(cmon_mod_iface * _m);
+CMON_API const char * cmon_mod_iface_dep_path(cmon_mod_iface * _m, size_t _idx);
+
+// adds the dependencies, types and pub symbols of the interface to the module (which has to have no
+// global scope yet). All dependencies of the module need to be resolved or imported before. Returns
+// cmon_true (without adding anything) if the interface refers to types that don't exist.
+CMON_API cmon_bool cmon_mod_iface_import(cmon_mod_iface * _m,
+                                         cmon_modules * _mods,
+                                         cmon_symbols * _symbols,
+                                         cmon_types * _types,
+                                         cmon_idx _mod_idx);
+
+// information about imported symbols that is otherwise taken from the ast of the module
+CMON_API cmon_bool cmon_mod_iface_sym_is_fn(cmon_mod_iface * _m, cmon_idx _sym);
+CMON_API size_t cmon_mod_iface_fn_param_count(cmon_mod_iface * _m, cmon_idx _sym);
+CMON_API const char * cmon_mod_iface_fn_param_name(cmon_mod_iface * _m,
+                                                   cmon_idx _sym,
+                                                   size_t _param_idx);
+CMON_API cmon_idx cmon_mod_iface_fn_param_type(cmon_mod_iface * _m,
+                                               cmon_idx _sym,
+                                               size_t _param_idx);
+CMON_API cmon_bool cmon_mod_iface_fn_param_is_mut(cmon_mod_iface * _m,
+                                                  cmon_idx _sym,
+                                                  size_t _param_idx);
+
+#endif // CMON_CMON_MOD_IFACE_H
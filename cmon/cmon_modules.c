@@ -26,6 +26,7 @@ typedef struct
     cmon_dyn_arr(_dep) deps; // module indices that this module depends on
     cmon_idx global_scope;
     cmon_resolver * resolver;
+    cmon_mod_iface * iface;
 } _module;
 
 typedef struct cmon_modules
@@ -35,7 +36,8 @@ typedef struct cmon_modules
     cmon_str_builder * str_builder;
     cmon_str_buf * str_buf;
     cmon_dyn_arr(_module) mods;
-    cmon_dyn_arr(cmon_str_view) path_toks;
+    // begin/end offsets of each path token into the module path copy in str_buf
+    cmon_dyn_arr(_str_off_pair) path_toks;
 } cmon_modules;
 
 cmon_modules * cmon_modules_create(cmon_allocator * _a, cmon_src * _src)
@@ -87,6 +89,7 @@ cmon_idx cmon_modules_add(cmon_modules * _m, const char * _path, const char * _n
     mod.name_str_off = cmon_str_buf_append(_m->str_buf, _name);
     mod.global_scope = CMON_INVALID_IDX;
     mod.resolver = NULL;
+    mod.iface = NULL;
 
     size_t count = 0;
     for (size_t i = 0; i < cmon_dyn_arr_count(&_m->mods); ++i)
@@ -112,6 +115,8 @@ cmon_idx cmon_modules_add(cmon_modules * _m, const char * _path, const char * _n
     cmon_dyn_arr_init(&mod.search_prefixes_offs, _m->alloc, 2);
     cmon_dyn_arr_init(&mod.path_overwrite_offs, _m->alloc, 2);
 
+    //@NOTE: _path is owned by the caller and might be temporary, so we tokenize based on
+    // offsets into our own copy of it.
     const char * c = _path;
     const char * start = c;
 
@@ -120,7 +125,9 @@ cmon_idx cmon_modules_add(cmon_modules * _m, const char * _path, const char * _n
     {
         if (*c == '.' || *c == '\0')
         {
-            cmon_dyn_arr_append(&_m->path_toks, ((cmon_str_view){ start, c }));
+            cmon_dyn_arr_append(&_m->path_toks,
+                                ((_str_off_pair){ mod.path_str_off + (start - _path),
+                                                  mod.path_str_off + (c - _path) }));
             if (*c == '\0')
                 break;
             ++c;
@@ -174,14 +181,22 @@ cmon_resolver * cmon_modules_resolver(cmon_modules * _m, cmon_idx _mod_idx)
     return _get_module(_m, _mod_idx)->resolver;
 }
 
+void cmon_modules_set_iface(cmon_modules * _m, cmon_idx _mod_idx, cmon_mod_iface * _iface)
+{
+    _get_module(_m, _mod_idx)->iface = _iface;
+}
+
+cmon_mod_iface * cmon_modules_iface(cmon_modules * _m, cmon_idx _mod_idx)
+{
+    return _get_module(_m, _mod_idx)->iface;
+}
+
 cmon_idx cmon_modules_find(cmon_modules * _m, cmon_str_view _path)
 {
     //@NOTE: for now we just linear search. maybe hashmap in the future
     cmon_idx i;
-    printf("TRYING TO FIND %.*s\n", _path.end - _path.begin, _path.begin);
     for (i = 0; i < cmon_dyn_arr_count(&_m->mods); ++i)
     {
-        printf("path %s\n", cmon_modules_path(_m, i));
         if (cmon_str_view_c_str_cmp(_path, cmon_modules_path(_m, i)) == 0)
         {
             return i;
@@ -230,10 +245,8 @@ cmon_idx cmon_modules_find_import(cmon_modules * _m, cmon_idx _looking_mod_idx,
     // 03. prepend the search path prefixes and try to get a match
     // char full_path[CMON_PATH_MAX];
     _module * mod = _get_module(_m, _looking_mod_idx);
-    printf("TRYING TO FIND THE IMPORT IN SEARCH PATHS\n");
     for (size_t i = 0; i < cmon_dyn_arr_count(&mod->search_prefixes_offs); ++i)
     {
-        printf("SEARCH PATH %s\n", cmon_str_buf_get(_m->str_buf, mod->search_prefixes_offs[i]));
         cmon_idx idx =
             cmon_modules_find(_m,
                               cmon_str_view_make(cmon_str_builder_tmp_str(
@@ -311,7 +324,8 @@ cmon_str_view cmon_modules_path_token(cmon_modules * _m, cmon_idx _mod_idx, size
 {
     size_t abs_idx = _get_module(_m, _mod_idx)->path_toks_begin + _tok_idx;
     assert(abs_idx < cmon_dyn_arr_count(&_m->path_toks));
-    return _m->path_toks[abs_idx];
+    return (cmon_str_view){ cmon_str_buf_get(_m->str_buf, _m->path_toks[abs_idx].first),
+                            cmon_str_buf_get(_m->str_buf, _m->path_toks[abs_idx].second) };
 }
 
 cmon_idx cmon_modules_src_file(cmon_modules * _m, cmon_idx _mod_idx, cmon_idx _src_file_idx)
@@ -356,7 +370,6 @@ cmon_idx cmon_modules_find_dep_idx(cmon_modules * _m, cmon_idx _mod_idx, cmon_id
 
     for (i = 0; i < cmon_dyn_arr_count(&_get_module(_m, _mod_idx)->deps); ++i)
     {
-        printf("Wopp %lu %lu\n", _dep_mod_idx, cmon_modules_dep_mod_idx(_m, _mod_idx, i));
         if (cmon_modules_dep_mod_idx(_m, _mod_idx, i) == _dep_mod_idx)
         {
             return i;
@@ -5,6 +5,7 @@
 
 typedef struct cmon_modules cmon_modules;
 typedef struct cmon_resolver cmon_resolver;
+typedef struct cmon_mod_iface cmon_mod_iface;
 
 CMON_API cmon_modules * cmon_modules_create(cmon_allocator * _a, cmon_src * _src);
 CMON_API void cmon_modules_destroy(cmon_modules * _m);
@@ -18,6 +19,9 @@ CMON_API void cmon_modules_add_dep(cmon_modules * _m,
 CMON_API void cmon_modules_set_global_scope(cmon_modules * _m, cmon_idx _mod_idx, cmon_idx _scope);
 CMON_API void cmon_modules_set_resolver(cmon_modules * _m, cmon_idx _mod_idx, cmon_resolver * _r);
 CMON_API cmon_resolver * cmon_modules_resolver(cmon_modules * _m, cmon_idx _mod_idx);
+// modules imported from an interface file have no resolver (see cmon_mod_iface.h)
+CMON_API void cmon_modules_set_iface(cmon_modules * _m, cmon_idx _mod_idx, cmon_mod_iface * _iface);
+CMON_API cmon_mod_iface * cmon_modules_iface(cmon_modules * _m, cmon_idx _mod_idx);
 
 CMON_API cmon_idx cmon_modules_find(cmon_modules * _m, cmon_str_view _path);
 CMON_API cmon_idx cmon_modules_find_import(cmon_modules * _m, cmon_idx _looking_mod_idx, cmon_str_view _path);
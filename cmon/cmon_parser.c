@@ -4,7 +4,6 @@
 #include <cmon/cmon_parser.h>
 #include <cmon/cmon_str_builder.h>
 #include <setjmp.h>
-#include <stdarg.h>
 
 // for now the parser stops on the first error. we simpy save the error and jump out of parsing.
 #define _err(_p, _tok, _fmt, ...)                                                                  \
@@ -69,6 +68,19 @@ static _precedence _tok_prec(cmon_tokk _kind)
     }
 }
 
+// token and node ranges of a top level statement, used to reparse only the statements that were
+// touched by an edit
+typedef struct
+{
+    cmon_idx node;
+    // first node that was added while parsing the statement. All nodes of a statement are
+    // added consecutively and the statement node itself is added last.
+    cmon_idx node_begin;
+    cmon_idx tok_begin;
+    // the current token after the statement was parsed
+    cmon_idx tok_end;
+} _top_lvl_stmt;
+
 typedef struct cmon_parser
 {
     cmon_allocator * alloc;
@@ -80,38 +92,37 @@ typedef struct cmon_parser
     cmon_tokens * tokens;
     cmon_err_handler * err_handler;
     jmp_buf err_jmp;
+    cmon_dyn_arr(_top_lvl_stmt) stmts;
+    cmon_dyn_arr(_top_lvl_stmt) tmp_stmts;
+    // true if the last parse failed, in that case cmon_parser_reparse parses the whole file
+    cmon_bool stale;
 } cmon_parser;
 
-static inline const char * _token_kinds_to_str(cmon_str_builder * _b, va_list _args)
+// only used to build error messages, so it is fine to walk all bits of the set
+static inline const char * _token_kinds_to_str(cmon_str_builder * _b, cmon_tokk_set _kinds)
 {
     cmon_tokk kind;
 
     cmon_str_builder_clear(_b);
-    do
+    for (kind = 0; kind < cmon_tokk_count; ++kind)
     {
-        kind = va_arg(_args, cmon_tokk);
-        if (kind != -1)
-        {
-            if (cmon_str_builder_count(_b))
-                cmon_str_builder_append(_b, " or ");
-            cmon_str_builder_append_fmt(_b, "'%s'", cmon_tokk_to_str(kind));
-        }
-    } while (kind != -1);
+        if (!cmon_tokk_set_has(_kinds, kind))
+            continue;
+        if (cmon_str_builder_count(_b))
+            cmon_str_builder_append(_b, " or ");
+        cmon_str_builder_append_fmt(_b, "'%s'", cmon_tokk_to_str(kind));
+    }
     return cmon_str_builder_c_str(_b);
 }
 
-static inline cmon_idx _token_check_impl(cmon_parser * _p, cmon_bool _allow_line_break, ...)
+static inline cmon_idx _token_check_impl(cmon_parser * _p,
+                                         cmon_bool _allow_line_break,
+                                         cmon_tokk_set _kinds)
 {
-    va_list args, cpy;
-    va_start(args, _allow_line_break);
-    va_copy(cpy, args);
-    cmon_idx tok = cmon_tokens_accept_impl_v(_p->tokens, args);
+    cmon_idx tok = cmon_tokens_accept_in(_p->tokens, _kinds);
     if (!cmon_is_valid_idx(tok))
     {
-        const char * tk_kinds_str = _token_kinds_to_str(_p->tk_str_builder, cpy);
-        va_end(cpy);
-        va_end(args);
-
+        const char * tk_kinds_str = _token_kinds_to_str(_p->tk_str_builder, _kinds);
         cmon_idx cur = cmon_tokens_current(_p->tokens);
         if (cmon_tokens_kind(_p->tokens, cur) != cmon_tokk_eof)
         {
@@ -131,13 +142,11 @@ static inline cmon_idx _token_check_impl(cmon_parser * _p, cmon_bool _allow_line
 
     //@TODO: error if it does not _allow_line_break
 
-    va_end(args);
     return tok;
 }
 
 #define _tok_check(_p, _allow_line_break, ...)                                                     \
-    _token_check_impl(                                                                             \
-        _p, _allow_line_break, _CMON_VARARG_APPEND_LAST(CMON_INVALID_IDX, __VA_ARGS__))
+    _token_check_impl(_p, _allow_line_break, CMON_TOKK_SET(__VA_ARGS__))
 
 #define _accept(_p, _out_tok, ...)                                                                 \
     (cmon_is_valid_idx(*(_out_tok) = cmon_tokens_accept(_p->tokens, __VA_ARGS__)))
@@ -159,22 +168,20 @@ static cmon_idx _parse_type(cmon_parser * _p)
     }
     else if (_accept(_p, &tok, cmon_tokk_square_open))
     {
-        //@TODO: Once there is some more elaborate compile time expressions, we need to take that
-        // into account here
-        cmon_idx count_tok;
-        cmon_bool is_array = _accept(_p, &count_tok, cmon_tokk_int);
+        //@NOTE: The count is an arbitrary expression, the resolver makes sure that it evaluates to
+        // a compile time int constant.
+        cmon_idx count_expr = CMON_INVALID_IDX;
+        if (!cmon_tokens_is_current(_p->tokens, cmon_tokk_square_close))
+            count_expr = _parse_expr(_p, _precedence_nil);
         _tok_check(_p, cmon_true, cmon_tokk_square_close);
 
-        if (is_array)
+        if (cmon_is_valid_idx(count_expr))
         {
-            return cmon_astb_add_type_array(_p->ast_builder,
-                                            tok,
-                                            atol(cmon_tokens_str_view(_p->tokens, count_tok).begin),
-                                            _parse_type(_p));
+            return cmon_astb_add_type_array(_p->ast_builder, tok, count_expr, _parse_type(_p));
         }
         else
         {
-            cmon_bool is_mut = _accept(_p, &count_tok, cmon_tokk_mut);
+            cmon_bool is_mut = _accept(_p, &tmp, cmon_tokk_mut);
             return cmon_astb_add_type_view(_p->ast_builder, tok, is_mut, _parse_type(_p));
         }
     }
@@ -833,6 +840,9 @@ cmon_parser * cmon_parser_create(cmon_allocator * _alloc)
     ret->tk_str_builder = cmon_str_builder_create(_alloc, 64);
     ret->idx_buf_mng = cmon_idx_buf_mng_create(_alloc);
     ret->err_handler = cmon_err_handler_create(_alloc, NULL, 1);
+    cmon_dyn_arr_init(&ret->stmts, _alloc, 32);
+    cmon_dyn_arr_init(&ret->tmp_stmts, _alloc, 8);
+    ret->stale = cmon_false;
     return ret;
 }
 
@@ -841,6 +851,8 @@ void cmon_parser_destroy(cmon_parser * _p)
     if (!_p)
         return;
 
+    cmon_dyn_arr_dealloc(&_p->tmp_stmts);
+    cmon_dyn_arr_dealloc(&_p->stmts);
     cmon_err_handler_destroy(_p->err_handler);
     cmon_idx_buf_mng_destroy(_p->idx_buf_mng);
     cmon_str_builder_destroy(_p->tk_str_builder);
@@ -855,60 +867,160 @@ cmon_err_report cmon_parser_err(cmon_parser * _p)
                : cmon_err_report_make_empty();
 }
 
+static inline void _parse_and_record_top_lvl_stmt(cmon_parser * _p, _top_lvl_stmt ** _out)
+{
+    _top_lvl_stmt stmt;
+    stmt.tok_begin = cmon_tokens_current(_p->tokens);
+    stmt.node_begin = cmon_astb_count(_p->ast_builder);
+    stmt.node = _parse_top_lvl_stmt(_p);
+    stmt.tok_end = cmon_tokens_current(_p->tokens);
+    if (cmon_is_valid_idx(stmt.node))
+    {
+        cmon_dyn_arr_append(_out, stmt);
+    }
+}
+
+static inline cmon_ast * _finalize_ast(cmon_parser * _p)
+{
+    cmon_idx b, root_block_idx;
+    size_t i, tok_count;
+    cmon_ast * ret;
+
+    b = cmon_idx_buf_mng_get(_p->idx_buf_mng);
+    for (i = 0; i < cmon_dyn_arr_count(&_p->stmts); ++i)
+    {
+        cmon_idx_buf_append(_p->idx_buf_mng, b, _p->stmts[i].node);
+    }
+
+    tok_count = cmon_tokens_count(_p->tokens);
+    root_block_idx = cmon_astb_add_block(_p->ast_builder,
+                                         tok_count ? 0 : CMON_INVALID_IDX,
+                                         tok_count ? tok_count - 1 : CMON_INVALID_IDX,
+                                         cmon_idx_buf_ptr(_p->idx_buf_mng, b),
+                                         cmon_idx_buf_count(_p->idx_buf_mng, b));
+    cmon_idx_buf_mng_return(_p->idx_buf_mng, b);
+    cmon_astb_set_root_block(_p->ast_builder, root_block_idx);
+
+    ret = cmon_astb_ast(_p->ast_builder);
+    cmon_src_set_ast(_p->src, _p->src_file_idx, ret);
+    return ret;
+}
+
 cmon_ast * cmon_parser_parse(cmon_parser * _p,
                              cmon_src * _src,
                              cmon_idx _src_file_idx,
                              cmon_tokens * _tokens)
 {
-    cmon_idx stmt_idx, root_block_idx, first_tok, last_tok;
-    cmon_ast * ast;
-    cmon_idx b;
-
-    ast = NULL;
-
     // for now a parser can't be reset, this is just a sanity check to make sure cmon_parser_parse
-    // is only called once for every instance
+    // is only called once for every instance. Use cmon_parser_reparse after an edit.
     assert(_p->ast_builder == NULL);
 
     _p->src = _src;
     _p->src_file_idx = _src_file_idx;
     _p->tokens = _tokens;
     _p->ast_builder = cmon_astb_create(_p->alloc, _tokens);
-
-    first_tok = cmon_tokens_count(_p->tokens) ? 0 : CMON_INVALID_IDX;
-    last_tok = cmon_tokens_count(_p->tokens) ? cmon_tokens_count(_p->tokens) - 1 : CMON_INVALID_IDX;
+    _p->stale = cmon_true;
 
     cmon_src_set_tokens(_src, _src_file_idx, _tokens);
     cmon_err_handler_set_src(_p->err_handler, _src);
 
     if (setjmp(_p->err_jmp))
     {
-        goto end;
+        return NULL;
     }
     cmon_err_handler_set_jump(_p->err_handler, &_p->err_jmp);
 
-    b = cmon_idx_buf_mng_get(_p->idx_buf_mng);
+    while (!cmon_tokens_is_current(_p->tokens, cmon_tokk_eof))
+    {
+        _parse_and_record_top_lvl_stmt(_p, &_p->stmts);
+    }
+
+    _p->stale = cmon_false;
+    return _finalize_ast(_p);
+}
+
+cmon_ast * cmon_parser_reparse(cmon_parser * _p, const cmon_tokens_edit * _edit)
+{
+    size_t s0, s1, count, i;
+    cmon_idx cur;
+    long delta;
+
+    assert(_p->ast_builder);
+
+    count = cmon_dyn_arr_count(&_p->stmts);
+    delta = (long)_edit->new_end - (long)_edit->old_end;
+
+    if (_p->stale)
+    {
+        s0 = 0;
+        s1 = count;
+        cmon_dyn_arr_clear(&_p->stmts);
+        count = 0;
+    }
+    else
+    {
+        if (_edit->first == _edit->old_end && _edit->first == _edit->new_end)
+            return cmon_astb_ast(_p->ast_builder);
+
+        // the statements [s0, s1) overlap or touch the edit. Touching ones are parsed again as
+        // they might depend on the token that follows them, see _check_stmt_end.
+        for (s0 = 0; s0 < count && _p->stmts[s0].tok_end < _edit->first; ++s0)
+            ;
+        for (s1 = s0; s1 < count && _p->stmts[s1].tok_begin <= _edit->old_end; ++s1)
+            ;
+    }
+
+    cmon_err_handler_clear(_p->err_handler);
+    if (setjmp(_p->err_jmp))
+    {
+        // the statements are out of sync with the tokens now
+        _p->stale = cmon_true;
+        return NULL;
+    }
+    cmon_err_handler_set_jump(_p->err_handler, &_p->err_jmp);
 
+    // parse from the end of the last statement in front of the edit until the parser ends up
+    // exactly at the beginning of a statement behind the edit. If a statement swallows the
+    // beginning of the next one (i.e. because a closing bracket was removed), the next one needs
+    // to be parsed again, too.
+    cmon_dyn_arr_clear(&_p->tmp_stmts);
+    cmon_tokens_set_current(_p->tokens, s0 ? _p->stmts[s0 - 1].tok_end : 0);
     while (!cmon_tokens_is_current(_p->tokens, cmon_tokk_eof))
     {
-        stmt_idx = _parse_top_lvl_stmt(_p);
-        if (cmon_is_valid_idx(stmt_idx))
+        cur = cmon_tokens_current(_p->tokens);
+        while (s1 < count && (long)_p->stmts[s1].tok_begin + delta < (long)cur)
+            ++s1;
+        if (s1 < count && (long)_p->stmts[s1].tok_begin + delta == (long)cur)
+            break;
+        _parse_and_record_top_lvl_stmt(_p, &_p->tmp_stmts);
+    }
+    if (cmon_tokens_is_current(_p->tokens, cmon_tokk_eof))
+        s1 = count;
+
+    // the statements after the edit are reused as they are, only their tokens moved
+    for (i = s1; i < count; ++i)
+    {
+        if (delta)
         {
-            cmon_idx_buf_append(_p->idx_buf_mng, b, stmt_idx);
+            cmon_astb_shift_tokens(_p->ast_builder,
+                                   _p->stmts[i].node_begin,
+                                   _p->stmts[i].node + 1,
+                                   _edit->old_end,
+                                   delta);
+            _p->stmts[i].tok_begin += delta;
+            _p->stmts[i].tok_end += delta;
         }
+        cmon_dyn_arr_append(&_p->tmp_stmts, _p->stmts[i]);
     }
 
-    root_block_idx = cmon_astb_add_block(_p->ast_builder,
-                                         first_tok,
-                                         last_tok,
-                                         cmon_idx_buf_ptr(_p->idx_buf_mng, b),
-                                         cmon_idx_buf_count(_p->idx_buf_mng, b));
-    cmon_astb_set_root_block(_p->ast_builder, root_block_idx);
-
-    ast = cmon_astb_ast(_p->ast_builder);
-    cmon_src_set_ast(_src, _src_file_idx, ast);
+    //@NOTE: the nodes of the replaced statements stay in the ast builder unreferenced. They are
+    // reclaimed when the parser is destroyed.
+    cmon_dyn_arr_resize(&_p->stmts, s0);
+    for (i = 0; i < cmon_dyn_arr_count(&_p->tmp_stmts); ++i)
+    {
+        cmon_dyn_arr_append(&_p->stmts, _p->tmp_stmts[i]);
+    }
 
-end:
-    cmon_idx_buf_mng_return(_p->idx_buf_mng, b);
-    return ast;
+    _p->stale = cmon_false;
+    return _finalize_ast(_p);
 }
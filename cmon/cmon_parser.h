@@ -10,5 +10,9 @@ CMON_API cmon_parser * cmon_parser_create(cmon_allocator * _alloc);
 CMON_API void cmon_parser_destroy(cmon_parser * _p);
 CMON_API cmon_err_report cmon_parser_err(cmon_parser * _p);
 CMON_API cmon_ast * cmon_parser_parse(cmon_parser * _p, cmon_src * _src, cmon_idx _src_file_idx, cmon_tokens * _tokens);
+// updates the ast after its tokens were changed via cmon_tokens_retokenize. Only the top level
+// statements that overlap the edit are parsed again. All other statements keep their nodes, node
+// indices and everything the resolver stored in them.
+CMON_API cmon_ast * cmon_parser_reparse(cmon_parser * _p, const cmon_tokens_edit * _edit);
 
 #endif // CMON_CMON_PARSER_H
@@ -2,6 +2,7 @@
 #include <cmon/cmon_dyn_arr.h>
 #include <cmon/cmon_err_handler.h>
 #include <cmon/cmon_idx_buf_mng.h>
+#include <cmon/cmon_mod_iface.h>
 #include <cmon/cmon_resolver.h>
 #include <cmon/cmon_str_builder.h>
 #include <cmon/cmon_tokens.h>
@@ -19,6 +20,27 @@ typedef struct
     cmon_idx type_idx;
 } _ast_type_pair;
 
+typedef enum
+{
+    _constk_none,
+    _constk_int,
+    _constk_float,
+    _constk_bool
+} _constk;
+
+// compile time value of a constant expression
+typedef struct
+{
+    _constk kind;
+    union
+    {
+        // ints are stored as their two's complement bits, the resolved type tells the signedness
+        uintmax_t i;
+        double f;
+        cmon_bool b;
+    } val;
+} _const_val;
+
 typedef struct
 {
     cmon_resolver * resolver;
@@ -35,6 +57,8 @@ typedef struct
     // all local function declarations in the file (i.e. not top lvl)
     cmon_dyn_arr(cmon_idx) local_fns;
     cmon_idx * resolved_types; // maps ast expr idx to type
+    _const_val * const_vals;   // maps ast expr idx to its folded value (if any)
+    size_t resolved_types_count;
     cmon_idx main_fn_sym;
     cmon_err_handler * err_handler;
     jmp_buf err_jmp;
@@ -43,6 +67,8 @@ typedef struct
 typedef struct cmon_resolver
 {
     cmon_allocator * alloc;
+    // allocates everything owned by the file resolvers, see cmon_resolver_set_file_allocator
+    cmon_allocator * file_alloc;
     cmon_src * src;
     cmon_symbols * symbols;
     cmon_idx global_scope;
@@ -190,6 +216,218 @@ static inline cmon_bool _is_literal(_file_resolver * _fr, cmon_idx _ast_idx)
     return cmon_false;
 }
 
+static inline _const_val * _const_of(_file_resolver * _fr, cmon_idx _ast_idx)
+{
+    return &_fr->const_vals[_remove_paran(_fr, _ast_idx)];
+}
+
+static inline cmon_bool _int_const_fits(cmon_typek _kind, uintmax_t _v)
+{
+    intmax_t sv = (intmax_t)_v;
+    return (_kind == cmon_typek_u8 && _v <= UCHAR_MAX) ||
+           (_kind == cmon_typek_s8 && sv >= SCHAR_MIN && sv <= SCHAR_MAX) ||
+           (_kind == cmon_typek_u16 && _v <= USHRT_MAX) ||
+           (_kind == cmon_typek_s16 && sv >= SHRT_MIN && sv <= SHRT_MAX) ||
+           (_kind == cmon_typek_u32 && _v <= UINT_MAX) ||
+           (_kind == cmon_typek_s32 && sv >= INT_MIN && sv <= INT_MAX) ||
+           (_kind == cmon_typek_u64 && _v <= UINT64_MAX) ||
+           (_kind == cmon_typek_s64 && sv >= INT64_MIN && sv <= INT64_MAX);
+}
+
+// returns cmon_true if the operation overflows, division by zero needs to be checked by the caller
+static inline cmon_bool _fold_int(
+    cmon_tokk _op, cmon_bool _is_signed, uintmax_t _l, uintmax_t _r, uintmax_t * _out)
+{
+    if (_is_signed)
+    {
+        intmax_t l = (intmax_t)_l;
+        intmax_t r = (intmax_t)_r;
+        intmax_t res;
+        if (_op == cmon_tokk_plus)
+            return __builtin_add_overflow(l, r, (intmax_t *)_out);
+        else if (_op == cmon_tokk_minus)
+            return __builtin_sub_overflow(l, r, (intmax_t *)_out);
+        else if (_op == cmon_tokk_mult)
+            return __builtin_mul_overflow(l, r, (intmax_t *)_out);
+        else if ((_op == cmon_tokk_div || _op == cmon_tokk_mod) && l == INTMAX_MIN && r == -1)
+            return cmon_true;
+        else if (_op == cmon_tokk_div)
+            res = l / r;
+        else if (_op == cmon_tokk_mod)
+            res = l % r;
+        else if (_op == cmon_tokk_bw_and)
+            res = l & r;
+        else if (_op == cmon_tokk_bw_or)
+            res = l | r;
+        else if (_op == cmon_tokk_bw_xor)
+            res = l ^ r;
+        else
+        {
+            assert(0);
+            return cmon_true;
+        }
+        *_out = (uintmax_t)res;
+    }
+    else
+    {
+        uintmax_t res;
+        if (_op == cmon_tokk_plus)
+            return __builtin_add_overflow(_l, _r, _out);
+        else if (_op == cmon_tokk_minus)
+            return __builtin_sub_overflow(_l, _r, _out);
+        else if (_op == cmon_tokk_mult)
+            return __builtin_mul_overflow(_l, _r, _out);
+        else if (_op == cmon_tokk_div)
+            res = _l / _r;
+        else if (_op == cmon_tokk_mod)
+            res = _l % _r;
+        else if (_op == cmon_tokk_bw_and)
+            res = _l & _r;
+        else if (_op == cmon_tokk_bw_or)
+            res = _l | _r;
+        else if (_op == cmon_tokk_bw_xor)
+            res = _l ^ _r;
+        else
+        {
+            assert(0);
+            return cmon_true;
+        }
+        *_out = res;
+    }
+    return cmon_false;
+}
+
+static inline void _const_overflow_err(_file_resolver * _fr, cmon_idx _ast_idx, cmon_idx _type)
+{
+    _fr_err(_fr,
+            cmon_ast_token_first(_fr_ast(_fr), _ast_idx),
+            cmon_ast_token(_fr_ast(_fr), _ast_idx),
+            cmon_ast_token_last(_fr_ast(_fr), _ast_idx),
+            "constant expression overflows '%s'",
+            cmon_types_name(_fr->resolver->types, _type));
+}
+
+// sets the constant value of a float/int typed expression, reporting an error if it does not fit
+static inline void _set_numeric_const(_file_resolver * _fr,
+                                      cmon_idx _ast_idx,
+                                      cmon_idx _type,
+                                      _const_val _val)
+{
+    cmon_typek kind = cmon_types_kind(_fr->resolver->types, _type);
+    if (_val.kind == _constk_float)
+    {
+        if (isinf(_val.val.f) || (kind == cmon_typek_f32 && fabs(_val.val.f) > FLT_MAX))
+        {
+            _const_overflow_err(_fr, _ast_idx, _type);
+            return;
+        }
+        if (kind == cmon_typek_f32)
+            _val.val.f = (float)_val.val.f;
+    }
+    else if (_val.kind == _constk_int && !_int_const_fits(kind, _val.val.i))
+    {
+        _const_overflow_err(_fr, _ast_idx, _type);
+        return;
+    }
+    _fr->const_vals[_ast_idx] = _val;
+}
+
+static inline void _fold_prefix(_file_resolver * _fr, cmon_idx _ast_idx, cmon_idx _type)
+{
+    _const_val * c = _const_of(_fr, cmon_ast_prefix_expr(_fr_ast(_fr), _ast_idx));
+    cmon_tokk op =
+        cmon_tokens_kind(_fr_tokens(_fr), cmon_ast_prefix_op_tok(_fr_ast(_fr), _ast_idx));
+    _const_val res = *c;
+
+    if (op == cmon_tokk_minus && c->kind == _constk_int)
+    {
+        if (_fold_int(cmon_tokk_minus,
+                      cmon_types_is_signed_int(_fr->resolver->types, _type),
+                      0,
+                      c->val.i,
+                      &res.val.i))
+        {
+            _const_overflow_err(_fr, _ast_idx, _type);
+            return;
+        }
+        _set_numeric_const(_fr, _ast_idx, _type, res);
+    }
+    else if (op == cmon_tokk_minus && c->kind == _constk_float)
+    {
+        res.val.f = -c->val.f;
+        _set_numeric_const(_fr, _ast_idx, _type, res);
+    }
+    else if (op == cmon_tokk_exclam && c->kind == _constk_bool)
+    {
+        res.val.b = !c->val.b;
+        _fr->const_vals[_ast_idx] = res;
+    }
+}
+
+static inline void _fold_binary(_file_resolver * _fr, cmon_idx _ast_idx, cmon_idx _type)
+{
+    _const_val *l, *r;
+    _const_val res;
+    cmon_tokk op;
+    cmon_bool is_signed;
+
+    l = _const_of(_fr, cmon_ast_binary_left(_fr_ast(_fr), _ast_idx));
+    r = _const_of(_fr, cmon_ast_binary_right(_fr_ast(_fr), _ast_idx));
+    if (l->kind == _constk_none || l->kind != r->kind)
+        return;
+
+    op = cmon_tokens_kind(_fr_tokens(_fr), cmon_ast_binary_op_tok(_fr_ast(_fr), _ast_idx));
+    is_signed = cmon_types_is_signed_int(_fr->resolver->types, _type);
+    res.kind = l->kind;
+
+    //@TODO: fold comparisons and logical operators once the parser accepts them and they resolve
+    // to bool.
+    if ((res.kind == _constk_int && cmon_tokens_is(_fr_tokens(_fr),
+                                                   cmon_ast_binary_op_tok(_fr_ast(_fr), _ast_idx),
+                                                   cmon_tokk_plus,
+                                                   cmon_tokk_minus,
+                                                   cmon_tokk_mult,
+                                                   cmon_tokk_div,
+                                                   cmon_tokk_mod,
+                                                   cmon_tokk_bw_and,
+                                                   cmon_tokk_bw_or,
+                                                   cmon_tokk_bw_xor)) ||
+        (res.kind == _constk_float && (op == cmon_tokk_plus || op == cmon_tokk_minus ||
+                                       op == cmon_tokk_mult || op == cmon_tokk_div)))
+    {
+        if ((op == cmon_tokk_div || op == cmon_tokk_mod) &&
+            ((res.kind == _constk_int && r->val.i == 0) ||
+             (res.kind == _constk_float && r->val.f == 0.0)))
+        {
+            _fr_err(_fr,
+                    cmon_ast_token_first(_fr_ast(_fr), _ast_idx),
+                    cmon_ast_token(_fr_ast(_fr), _ast_idx),
+                    cmon_ast_token_last(_fr_ast(_fr), _ast_idx),
+                    "division by zero in constant expression");
+            return;
+        }
+
+        if (res.kind == _constk_int)
+        {
+            if (_fold_int(op, is_signed, l->val.i, r->val.i, &res.val.i))
+            {
+                _const_overflow_err(_fr, _ast_idx, _type);
+                return;
+            }
+        }
+        else if (op == cmon_tokk_plus)
+            res.val.f = l->val.f + r->val.f;
+        else if (op == cmon_tokk_minus)
+            res.val.f = l->val.f - r->val.f;
+        else if (op == cmon_tokk_mult)
+            res.val.f = l->val.f * r->val.f;
+        else
+            res.val.f = l->val.f / r->val.f;
+
+        _set_numeric_const(_fr, _ast_idx, _type, res);
+    }
+}
+
 static inline cmon_bool _is_indexable(_file_resolver * _fr, cmon_idx _type)
 {
     cmon_typek kind =
@@ -197,13 +435,32 @@ static inline cmon_bool _is_indexable(_file_resolver * _fr, cmon_idx _type)
     return kind == cmon_typek_array || kind == cmon_typek_view || kind == cmon_typek_tuple;
 }
 
+// looks up the symbol named by an identifier token. Uses the interned id of the token if the
+// tokenizer interned it, which avoids hashing the name again.
+static inline cmon_idx _find_sym_for_tok(_file_resolver * _fr,
+                                         cmon_idx _scope,
+                                         cmon_idx _name_tok,
+                                         cmon_bool _local_only)
+{
+    cmon_idx id = cmon_tokens_str_id(_fr_tokens(_fr), _name_tok);
+    if (cmon_is_valid_idx(id))
+    {
+        return _local_only ? cmon_symbols_find_local_id(_fr->resolver->symbols, _scope, id)
+                           : cmon_symbols_find_id(_fr->resolver->symbols, _scope, id);
+    }
+
+    cmon_str_view str_view = cmon_tokens_str_view(_fr_tokens(_fr), _name_tok);
+    return _local_only ? cmon_symbols_find_local(_fr->resolver->symbols, _scope, str_view)
+                       : cmon_symbols_find(_fr->resolver->symbols, _scope, str_view);
+}
+
 static inline cmon_bool _check_redec(_file_resolver * _fr, cmon_idx _scope, cmon_idx _name_tok)
 {
     cmon_idx s;
     cmon_str_view str_view;
 
     str_view = cmon_tokens_str_view(_fr_tokens(_fr), _name_tok);
-    if (cmon_is_valid_idx(s = cmon_symbols_find(_fr->resolver->symbols, _scope, str_view)))
+    if (cmon_is_valid_idx(s = _find_sym_for_tok(_fr, _scope, _name_tok, cmon_false)))
     {
         _fr_err(_fr,
                 _name_tok,
@@ -428,6 +685,45 @@ static inline void _add_unique_idx(cmon_dyn_arr(cmon_idx) * _arr, cmon_idx _idx)
 //     _add_unique_idx(&_fr->implicit_types, _type_idx);
 // }
 
+static inline cmon_bool _resolve_array_count(_file_resolver * _fr,
+                                             cmon_idx _scope,
+                                             cmon_idx _ast_idx,
+                                             size_t * _out_count)
+{
+    cmon_idx type =
+        _resolve_expr(_fr, _scope, _ast_idx, cmon_types_builtin_u64(_fr->resolver->types));
+    //@NOTE: a literal expression without a value failed to fold and already reported why
+    if (!cmon_is_valid_idx(type) ||
+        (_const_of(_fr, _ast_idx)->kind == _constk_none && _is_literal(_fr, _ast_idx) &&
+         cmon_types_is_int(_fr->resolver->types, type)))
+        return cmon_true;
+
+    if (!cmon_types_is_int(_fr->resolver->types, type) ||
+        _const_of(_fr, _ast_idx)->kind != _constk_int)
+    {
+        _fr_err(_fr,
+                cmon_ast_token_first(_fr_ast(_fr), _ast_idx),
+                cmon_ast_token(_fr_ast(_fr), _ast_idx),
+                cmon_ast_token_last(_fr_ast(_fr), _ast_idx),
+                "array count must be a constant int expression");
+        return cmon_true;
+    }
+
+    if (cmon_types_is_signed_int(_fr->resolver->types, type) &&
+        (intmax_t)_const_of(_fr, _ast_idx)->val.i < 0)
+    {
+        _fr_err(_fr,
+                cmon_ast_token_first(_fr_ast(_fr), _ast_idx),
+                cmon_ast_token(_fr_ast(_fr), _ast_idx),
+                cmon_ast_token_last(_fr_ast(_fr), _ast_idx),
+                "negative array count");
+        return cmon_true;
+    }
+
+    *_out_count = (size_t)_const_of(_fr, _ast_idx)->val.i;
+    return cmon_false;
+}
+
 static inline cmon_idx _resolve_parsed_type(_file_resolver * _fr,
                                             cmon_idx _scope,
                                             cmon_idx _ast_idx)
@@ -589,12 +885,12 @@ static inline cmon_idx _resolve_parsed_type(_file_resolver * _fr,
     }
     else if (kind == cmon_astk_type_array)
     {
+        size_t count;
         cmon_idx rt = _resolve_parsed_type(_fr, _scope, cmon_ast_type_array_type(ast, _ast_idx));
-        ret = cmon_is_valid_idx(rt)
-                  ? cmon_types_find_array(_fr->resolver->types,
-                                          rt,
-                                          cmon_ast_type_array_count(ast, _ast_idx),
-                                          _fr->resolver->mod_idx)
+        cmon_bool count_err = _resolve_array_count(
+            _fr, _scope, cmon_ast_type_array_count_expr(ast, _ast_idx), &count);
+        ret = cmon_is_valid_idx(rt) && !count_err
+                  ? cmon_types_find_array(_fr->resolver->types, rt, count, _fr->resolver->mod_idx)
                   : CMON_INVALID_IDX;
     }
     else if (kind == cmon_astk_type_fn)
@@ -653,7 +949,7 @@ static inline cmon_idx _resolve_ident(_file_resolver * _fr, cmon_idx _scope, cmo
     cmon_symk skind;
 
     name = cmon_ast_ident_name(_fr_ast(_fr), _ast_idx);
-    sym = cmon_symbols_find(_fr->resolver->symbols, _scope, name);
+    sym = _find_sym_for_tok(_fr, _scope, cmon_ast_token(_fr_ast(_fr), _ast_idx), cmon_false);
     if (cmon_is_valid_idx(sym))
     {
         cmon_ast_ident_set_sym(_fr_ast(_fr), _ast_idx, sym);
@@ -789,6 +1085,11 @@ static inline cmon_idx _resolve_int_literal(_file_resolver * _fr,
                         "int literal out of range for '%s'",
                         cmon_types_name(_fr->resolver->types, ret));
             }
+            else
+            {
+                _fr->const_vals[_ast_idx].kind = _constk_int;
+                _fr->const_vals[_ast_idx].val.i = v;
+            }
         }
     }
     return ret;
@@ -832,6 +1133,11 @@ static inline cmon_idx _resolve_float_literal(_file_resolver * _fr,
                 "float literal out of range for '%s'",
                 cmon_types_name(_fr->resolver->types, ret));
     }
+    else
+    {
+        _fr->const_vals[_ast_idx].kind = _constk_float;
+        _fr->const_vals[_ast_idx].val.f = v;
+    }
     return ret;
 }
 
@@ -924,6 +1230,10 @@ static inline cmon_idx _resolve_prefix(_file_resolver * _fr,
                 "prefix minus with non-numeric type '%s'",
                 cmon_types_name(_fr->resolver->types, ret));
     }
+    else if (cmon_is_valid_idx(ret))
+    {
+        _fold_prefix(_fr, _ast_idx, ret);
+    }
     return ret;
 }
 
@@ -1046,6 +1356,9 @@ static inline cmon_idx _resolve_binary(_file_resolver * _fr,
         return CMON_INVALID_IDX;
     }
 
+    if (!cmon_ast_binary_is_assignment(_fr_ast(_fr), _ast_idx))
+        _fold_binary(_fr, _ast_idx, left_type);
+
     return left_type;
 }
 
@@ -1513,7 +1826,7 @@ static inline cmon_bool _add_fn_param_sym(
 {
     cmon_idx sym;
     cmon_str_view str_view = cmon_tokens_str_view(_fr_tokens(_fr), _name_tok);
-    if (cmon_is_valid_idx(sym = cmon_symbols_find_local(_fr->resolver->symbols, _scope, str_view)))
+    if (cmon_is_valid_idx(sym = _find_sym_for_tok(_fr, _scope, _name_tok, cmon_true)))
     {
         _fr_err(_fr,
                 _name_tok,
@@ -1602,6 +1915,7 @@ static inline cmon_idx _resolve_expr(_file_resolver * _fr,
     _ast_idx = _remove_paran(_fr, _ast_idx);
     ast = _fr_ast(_fr);
     kind = cmon_ast_kind(ast, _ast_idx);
+    _fr->const_vals[_ast_idx].kind = _constk_none;
 
     if (kind == cmon_astk_int_literal)
     {
@@ -1614,6 +1928,9 @@ static inline cmon_idx _resolve_expr(_file_resolver * _fr,
     else if (kind == cmon_astk_bool_literal)
     {
         ret = cmon_types_builtin_bool(_fr->resolver->types);
+        _fr->const_vals[_ast_idx].kind = _constk_bool;
+        _fr->const_vals[_ast_idx].val.b =
+            cmon_tokens_kind(_fr_tokens(_fr), cmon_ast_token(ast, _ast_idx)) == cmon_tokk_true;
     }
     else if (kind == cmon_astk_string_literal)
     {
@@ -1761,7 +2078,10 @@ static inline void _resolve_var_decl(_file_resolver * _fr, cmon_idx _scope, cmon
         cmon_idx sym = cmon_ast_var_decl_sym(_fr_ast(_fr), _ast_idx);
         assert(cmon_is_valid_idx(sym));
         assert(cmon_is_valid_idx(expr_type_idx));
-        cmon_symbols_var_set_type(_fr->resolver->symbols, sym, expr_type_idx);
+        //@NOTE: the globals pass already set the type. Other files might read it concurrently during
+        // the main pass, so don't write it again.
+        if (cmon_symbols_var_type(_fr->resolver->symbols, sym) != expr_type_idx)
+            cmon_symbols_var_set_type(_fr->resolver->symbols, sym, expr_type_idx);
     }
 
     if (cmon_is_valid_idx(parsed_type_idx))
@@ -1844,6 +2164,7 @@ cmon_resolver * cmon_resolver_create(cmon_allocator * _alloc, size_t _max_errors
     cmon_resolver * ret;
     ret = CMON_CREATE(_alloc, cmon_resolver);
     ret->alloc = _alloc;
+    ret->file_alloc = _alloc;
     ret->symbols = NULL;
     ret->global_scope = CMON_INVALID_IDX;
     ret->types = NULL;
@@ -1873,12 +2194,18 @@ void cmon_resolver_destroy(cmon_resolver * _r)
 {
     size_t i;
 
+    if (!_r)
+        return;
+
     for (i = 0; i < cmon_dyn_arr_count(&_r->file_resolvers); ++i)
     {
         _file_resolver * fr = &_r->file_resolvers[i];
         cmon_allocator_free(
-            _r->alloc,
-            (cmon_mem_blk){ fr->resolved_types, sizeof(cmon_idx) * cmon_ast_count(_fr_ast(fr)) });
+            _r->file_alloc,
+            (cmon_mem_blk){ fr->resolved_types, sizeof(cmon_idx) * fr->resolved_types_count });
+        cmon_allocator_free(
+            _r->file_alloc,
+            (cmon_mem_blk){ fr->const_vals, sizeof(_const_val) * fr->resolved_types_count });
         cmon_dyn_arr_dealloc(&fr->local_fns);
         cmon_dyn_arr_dealloc(&fr->global_fns);
         cmon_dyn_arr_dealloc(&fr->external_variables);
@@ -1905,6 +2232,12 @@ void cmon_resolver_destroy(cmon_resolver * _r)
     CMON_DESTROY(_r->alloc, _r);
 }
 
+void cmon_resolver_set_file_allocator(cmon_resolver * _r, cmon_allocator * _alloc)
+{
+    assert(!cmon_dyn_arr_count(&_r->file_resolvers));
+    _r->file_alloc = _alloc;
+}
+
 void cmon_resolver_set_input(cmon_resolver * _r,
                              cmon_src * _src,
                              cmon_types * _types,
@@ -1950,22 +2283,28 @@ void cmon_resolver_set_input(cmon_resolver * _r,
         assert(cmon_is_valid_idx(src_file_idx));
         ast = cmon_src_ast(_r->src, src_file_idx);
 
-        fr.idx_buf_mng = cmon_idx_buf_mng_create(_r->alloc);
+        fr.idx_buf_mng = cmon_idx_buf_mng_create(_r->file_alloc);
         fr.src_file_idx = src_file_idx;
         fr.resolver = _r;
         fr.file_scope = cmon_symbols_scope_begin(_r->symbols, _r->global_scope, _r->mod_idx);
         //@TODO: More educated guesses based on the ast to allocated correcty to begin with?
-        cmon_dyn_arr_init(&fr.type_decls, _r->alloc, 16);
-        cmon_dyn_arr_init(&fr.global_var_decls, _r->alloc, 16);
-        cmon_dyn_arr_init(&fr.global_alias_decls, _r->alloc, 16);
-        cmon_dyn_arr_init(&fr.external_variables, _r->alloc, 16);
-        cmon_dyn_arr_init(&fr.global_fns, _r->alloc, 16);
-        cmon_dyn_arr_init(&fr.local_fns, _r->alloc, 16);
+        cmon_dyn_arr_init(&fr.type_decls, _r->file_alloc, 16);
+        cmon_dyn_arr_init(&fr.global_var_decls, _r->file_alloc, 16);
+        cmon_dyn_arr_init(&fr.global_alias_decls, _r->file_alloc, 16);
+        cmon_dyn_arr_init(&fr.external_variables, _r->file_alloc, 16);
+        cmon_dyn_arr_init(&fr.global_fns, _r->file_alloc, 16);
+        cmon_dyn_arr_init(&fr.local_fns, _r->file_alloc, 16);
+        fr.resolved_types_count = cmon_ast_count(ast);
         fr.resolved_types =
-            cmon_allocator_alloc(_r->alloc, sizeof(cmon_idx) * cmon_ast_count(ast)).ptr;
+            cmon_allocator_alloc(_r->file_alloc, sizeof(cmon_idx) * fr.resolved_types_count).ptr;
+        fr.const_vals =
+            cmon_allocator_alloc(_r->file_alloc, sizeof(_const_val) * fr.resolved_types_count).ptr;
         fr.main_fn_sym = CMON_INVALID_IDX;
-        memset(fr.resolved_types, (int)CMON_INVALID_IDX, sizeof(cmon_idx) * cmon_ast_count(ast));
-        fr.err_handler = cmon_err_handler_create(_r->alloc, _r->src, _r->max_errors);
+        memset(fr.resolved_types,
+               (int)CMON_INVALID_IDX,
+               sizeof(cmon_idx) * fr.resolved_types_count);
+        memset(fr.const_vals, 0, sizeof(_const_val) * fr.resolved_types_count);
+        fr.err_handler = cmon_err_handler_create(_r->file_alloc, _r->src, _r->max_errors);
         cmon_dyn_arr_append(&_r->file_resolvers, fr);
     }
 }
@@ -2426,41 +2765,41 @@ cmon_bool cmon_resolver_circ_pass(cmon_resolver * _r)
     //     }
     // }
 
-    for (i = 0; i < cmon_types_count(_r->types); ++i)
+    for (i = 0; i < cmon_types_used_in_module_count(_r->types, _r->mod_idx); ++i)
     {
-        if (!cmon_types_is_builtin(_r->types, (cmon_idx)i) &&
-            cmon_types_is_used_in_module(_r->types, (cmon_idx)i, _r->mod_idx))
+        cmon_idx type = cmon_types_used_in_module_type(_r->types, _r->mod_idx, i);
+        if (!cmon_types_is_builtin(_r->types, type))
         {
             cmon_dyn_arr_clear(&_r->dep_buffer);
-            if (cmon_types_kind(_r->types, (cmon_idx)i) == cmon_typek_array)
+            if (cmon_types_kind(_r->types, type) == cmon_typek_array)
             {
-                _add_type_dep(_r, &_r->dep_buffer, cmon_types_array_type(_r->types, (cmon_idx)i));
+                _add_type_dep(_r, &_r->dep_buffer, cmon_types_array_type(_r->types, type));
                 cmon_dep_graph_add(_r->dep_graph,
-                                   (cmon_idx)i,
+                                   type,
                                    &_r->dep_buffer[0],
                                    cmon_dyn_arr_count(&_r->dep_buffer));
             }
-            else if (cmon_types_is_implicit(_r->types, (cmon_idx)i))
+            else if (cmon_types_is_implicit(_r->types, type))
             {
                 // implicit types are just added without any dependencies
                 cmon_dep_graph_add(_r->dep_graph,
-                                   (cmon_idx)i,
+                                   type,
                                    &_r->dep_buffer[0],
                                    cmon_dyn_arr_count(&_r->dep_buffer));
             }
             else
             {
                 // only user defined type can be a struct so far
-                assert(cmon_types_kind(_r->types, (cmon_idx)i) == cmon_typek_struct);
+                assert(cmon_types_kind(_r->types, type) == cmon_typek_struct);
 
-                for (j = 0; j < cmon_types_struct_field_count(_r->types, (cmon_idx)i); ++j)
+                for (j = 0; j < cmon_types_struct_field_count(_r->types, type); ++j)
                 {
                     _add_type_dep(_r,
                                   &_r->dep_buffer,
-                                  cmon_types_struct_field_type(_r->types, (cmon_idx)i, j));
+                                  cmon_types_struct_field_type(_r->types, type, j));
                 }
                 cmon_dep_graph_add(_r->dep_graph,
-                                   (cmon_idx)i,
+                                   type,
                                    &_r->dep_buffer[0],
                                    cmon_dyn_arr_count(&_r->dep_buffer));
             }
@@ -2645,6 +2984,11 @@ static inline void _add_global_init_dep(_file_resolver * _fr,
         _add_global_init_dep(
             _fr, _global_sym, cmon_ast_prefix_expr(_fr_ast(_fr), _ast_idx), _out_deps);
     }
+    else if (kind == cmon_astk_paran_expr)
+    {
+        _add_global_init_dep(
+            _fr, _global_sym, cmon_ast_paran_expr(_fr_ast(_fr), _ast_idx), _out_deps);
+    }
     else if (kind == cmon_astk_binary)
     {
         _add_global_init_dep(
@@ -2880,6 +3224,22 @@ static inline cmon_idx _ir_add_global_var_decl(cmon_resolver * _r,
     cmon_idx mod_idx = cmon_symbols_module(_r->symbols, _sym);
     cmon_idx src_file_idx = cmon_symbols_src_file(_r->symbols, _sym);
     cmon_resolver * r = cmon_modules_resolver(_r->mods, mod_idx);
+
+    // the module was imported from an interface file, there is no ast to take the decl from
+    if (!r)
+    {
+        assert(_is_external);
+        _r->symbol_ir_map[_sym] = cmon_irb_add_global_var_decl(
+            _r->ir_builder,
+            cmon_str_builder_tmp_str(
+                _r->str_builder, "%s_%s", _prefix, cmon_symbols_unique_name(_r->symbols, _sym)),
+            cmon_true,
+            cmon_symbols_var_is_mut(_r->symbols, _sym),
+            cmon_symbols_var_type(_r->symbols, _sym),
+            CMON_INVALID_IDX);
+        return _r->symbol_ir_map[_sym];
+    }
+
     _file_resolver * fr = &r->file_resolvers[cmon_src_mod_src_idx(_r->src, src_file_idx)];
     return _ir_add_var_decl_impl(
         _r,
@@ -2891,10 +3251,60 @@ static inline cmon_idx _ir_add_global_var_decl(cmon_resolver * _r,
         !_is_external);
 }
 
+static inline cmon_idx _ir_add_const(cmon_resolver * _r, _file_resolver * _fr, cmon_idx _ast_idx)
+{
+    _const_val * c = &_fr->const_vals[_ast_idx];
+    cmon_idx type = _fr->resolved_types[_ast_idx];
+
+    if (c->kind == _constk_bool)
+    {
+        return cmon_irb_add_bool_lit(_r->ir_builder, c->val.b);
+    }
+    else if (c->kind == _constk_float)
+    {
+        char buf[64];
+        snprintf(buf,
+                 sizeof(buf) - 2,
+                 cmon_types_kind(_r->types, type) == cmon_typek_f32 ? "%.9g" : "%.17g",
+                 c->val.f);
+        // make sure that the literal does not turn into an int literal in the generated code
+        if (!strpbrk(buf, ".eE"))
+            strcat(buf, ".0");
+        return cmon_irb_add_float_lit(_r->ir_builder, buf);
+    }
+
+    assert(c->kind == _constk_int);
+    if (!cmon_types_is_signed_int(_r->types, type))
+    {
+        return cmon_irb_add_int_lit(_r->ir_builder,
+                                    cmon_str_builder_tmp_str(_r->str_builder,
+                                                             c->val.i > INTMAX_MAX ? "%" PRIuMAX "u"
+                                                                                   : "%" PRIuMAX,
+                                                             c->val.i));
+    }
+    else if ((intmax_t)c->val.i == INTMAX_MIN)
+    {
+        //@NOTE: the positive part of INTMAX_MIN is not representable as an int literal in C
+        return cmon_irb_add_int_lit(
+            _r->ir_builder,
+            cmon_str_builder_tmp_str(_r->str_builder, "(%" PRIdMAX " - 1)", INTMAX_MIN + 1));
+    }
+    return cmon_irb_add_int_lit(
+        _r->ir_builder, cmon_str_builder_tmp_str(_r->str_builder, "%" PRIdMAX, (intmax_t)c->val.i));
+}
+
 static inline cmon_idx _ir_add(cmon_resolver * _r, _file_resolver * _fr, cmon_idx _ast_idx)
 {
     cmon_astk kind = cmon_ast_kind(_fr_ast(_fr), _ast_idx);
 
+    // emit the folded value of constant expressions rather than the expression itself
+    if (kind == cmon_astk_prefix || kind == cmon_astk_binary || kind == cmon_astk_paran_expr)
+    {
+        cmon_idx expr = _remove_paran(_fr, _ast_idx);
+        if (_fr->const_vals[expr].kind != _constk_none)
+            return _ir_add_const(_r, _fr, expr);
+    }
+
     if (kind == cmon_astk_block)
     {
         return _ir_add_block(_r, _fr, _ast_idx);
@@ -3089,14 +3499,57 @@ static inline cmon_idx _ir_add_block(cmon_resolver * _r, _file_resolver * _fr, c
     return ret;
 }
 
+// declares a function of a module that was imported from an interface file
+static inline cmon_idx _ir_add_fn_from_iface(cmon_resolver * _r,
+                                             cmon_mod_iface * _iface,
+                                             cmon_idx _var_sym,
+                                             const char * _prefix)
+{
+    cmon_idx idx_buf = cmon_idx_buf_mng_get(_r->idx_buf_mng);
+    assert(_iface);
+
+    for (size_t i = 0; i < cmon_mod_iface_fn_param_count(_iface, _var_sym); ++i)
+    {
+        cmon_idx_buf_append(
+            _r->idx_buf_mng,
+            idx_buf,
+            cmon_irb_add_var_decl(_r->ir_builder,
+                                  cmon_mod_iface_fn_param_name(_iface, _var_sym, i),
+                                  cmon_mod_iface_fn_param_is_mut(_iface, _var_sym, i),
+                                  cmon_mod_iface_fn_param_type(_iface, _var_sym, i),
+                                  CMON_INVALID_IDX));
+    }
+
+    cmon_idx ret = cmon_irb_add_fn(
+        _r->ir_builder,
+        cmon_str_builder_tmp_str(
+            _r->str_builder, "%s_%s", _prefix, cmon_symbols_unique_name(_r->symbols, _var_sym)),
+        cmon_types_fn_return_type(_r->types, cmon_symbols_var_type(_r->symbols, _var_sym)),
+        cmon_idx_buf_ptr(_r->idx_buf_mng, idx_buf),
+        cmon_idx_buf_count(_r->idx_buf_mng, idx_buf),
+        cmon_false);
+    _r->symbol_ir_map[_var_sym] = ret;
+
+    cmon_idx_buf_mng_return(_r->idx_buf_mng, idx_buf);
+
+    return ret;
+}
+
 static inline cmon_idx _ir_add_fn_from_sym(cmon_resolver * _r,
                                            cmon_idx _var_sym,
                                            const char * _prefix)
 {
-    cmon_idx idx_buf = cmon_idx_buf_mng_get(_r->idx_buf_mng);
     cmon_idx mod_idx = cmon_symbols_module(_r->symbols, _var_sym);
-    cmon_idx src_file_idx = cmon_symbols_src_file(_r->symbols, _var_sym);
     cmon_resolver * r = cmon_modules_resolver(_r->mods, mod_idx);
+
+    if (!r)
+    {
+        return _ir_add_fn_from_iface(
+            _r, cmon_modules_iface(_r->mods, mod_idx), _var_sym, _prefix);
+    }
+
+    cmon_idx idx_buf = cmon_idx_buf_mng_get(_r->idx_buf_mng);
+    cmon_idx src_file_idx = cmon_symbols_src_file(_r->symbols, _var_sym);
     _file_resolver * fr = &r->file_resolvers[cmon_src_mod_src_idx(_r->src, src_file_idx)];
     assert(cmon_ast_kind(_fr_ast(fr), cmon_symbols_ast(_r->symbols, _var_sym)) ==
            cmon_astk_var_decl);
@@ -3105,7 +3558,6 @@ static inline cmon_idx _ir_add_fn_from_sym(cmon_resolver * _r,
     assert(cmon_ast_kind(_fr_ast(fr), fn_ast) == cmon_astk_fn_decl);
 
     // generate params IR
-    printf("pre\n");
     for (size_t i = 0; i < cmon_ast_fn_params_count(_fr_ast(fr), fn_ast); ++i)
     {
         cmon_idx_buf_append(
@@ -3113,7 +3565,6 @@ static inline cmon_idx _ir_add_fn_from_sym(cmon_resolver * _r,
             idx_buf,
             _ir_add_local_var_decl(_r, fr, cmon_ast_fn_param(_fr_ast(fr), fn_ast, i)));
     }
-    printf("post\n");
 
     // add the function
     cmon_idx sig = fr->resolved_types[fn_ast];
@@ -3173,7 +3624,7 @@ cmon_ir * cmon_resolver_finalize(cmon_resolver * _r)
     // count global vars and fns
     size_t globals_count = 0;
     size_t fns_count = 0;
-    printf("a\n");
+    size_t ast_node_count;
     for (i = 0; i < cmon_dyn_arr_count(&_r->file_resolvers); ++i)
     {
         _file_resolver * fr = &_r->file_resolvers[i];
@@ -3196,6 +3647,17 @@ cmon_ir * cmon_resolver_finalize(cmon_resolver * _r)
         // vars
         for (j = 0; j < cmon_dyn_arr_count(&fr->external_variables); ++j)
         {
+            cmon_mod_iface * iface = cmon_modules_iface(
+                _r->mods, cmon_symbols_module(_r->symbols, fr->external_variables[j]));
+            if (iface)
+            {
+                if (cmon_mod_iface_sym_is_fn(iface, fr->external_variables[j]))
+                    _add_unique_idx(&external_fns, fr->external_variables[j]);
+                else
+                    _add_unique_idx(&external_vars, fr->external_variables[j]);
+                continue;
+            }
+
             cmon_ast * ast = _sym_ast(_r, fr->external_variables[j]);
 
             assert(cmon_symbols_kind(_r->symbols, fr->external_variables[j]) == cmon_symk_var);
@@ -3222,18 +3684,22 @@ cmon_ir * cmon_resolver_finalize(cmon_resolver * _r)
         fns_count += cmon_dyn_arr_count(&fr->local_fns);
     }
 
-    printf("b\n");
     fns_count += cmon_dyn_arr_count(&external_fns);
     globals_count += cmon_dyn_arr_count(&external_vars);
 
-    // create the IR builder
+    // create the IR builder. Typical code ends up with somewhat fewer IR nodes than ast nodes, so the
+    // ast node count is used as the estimate.
+    ast_node_count = 0;
+    for (i = 0; i < cmon_dyn_arr_count(&_r->file_resolvers); ++i)
+        ast_node_count += cmon_ast_count(_fr_ast(&_r->file_resolvers[i]));
+
     assert(!_r->ir_builder);
     _r->ir_builder = cmon_irb_create(_r->alloc,
                                      cmon_modules_dep_count(_r->mods, _r->mod_idx),
                                      cmon_dyn_arr_count(&_r->sorted_types),
                                      fns_count,
                                      globals_count,
-                                     1024);
+                                     CMON_MAX(1024, ast_node_count));
 
     // allocate symbol to IR map
     cmon_dyn_arr_resize(&_r->symbol_ir_map, cmon_symbols_count(_r->symbols));
@@ -3263,14 +3729,12 @@ cmon_ir * cmon_resolver_finalize(cmon_resolver * _r)
         _ir_add_dep(
             _r, dep_added_map, cmon_modules_dep_mod_idx(_r->mods, _r->mod_idx, (cmon_idx)i));
     }
-    printf("c\n");
 
     // add sorted types to ir builder
     for (i = 0; i < cmon_dyn_arr_count(&_r->sorted_types); ++i)
     {
         cmon_irb_add_type(_r->ir_builder, _r->sorted_types[i]);
     }
-    printf("d\n");
     // add external symbols to IR
     for (i = 0; i < cmon_dyn_arr_count(&external_vars); ++i)
     {
@@ -3280,7 +3744,6 @@ cmon_ir * cmon_resolver_finalize(cmon_resolver * _r)
             cmon_modules_prefix(_r->mods, cmon_symbols_module(_r->symbols, external_vars[i])),
             cmon_true);
     }
-    printf("e\n");
     for (i = 0; i < cmon_dyn_arr_count(&external_fns); ++i)
     {
         _ir_add_fn_from_sym(
@@ -3291,7 +3754,6 @@ cmon_ir * cmon_resolver_finalize(cmon_resolver * _r)
 
     const char * mod_pref = cmon_modules_prefix(_r->mods, _r->mod_idx);
 
-    printf("f\n");
     // figure out the initialization order or all globals
     cmon_dep_graph_clear(_r->dep_graph);
     for (i = 0; i < cmon_dyn_arr_count(&_r->file_resolvers); ++i)
@@ -3322,7 +3784,6 @@ cmon_ir * cmon_resolver_finalize(cmon_resolver * _r)
         }
     }
 
-    printf("g\n");
     cmon_dep_graph_result res = cmon_dep_graph_resolve(_r->dep_graph);
     if (!res.array)
     {
@@ -3349,8 +3810,6 @@ cmon_ir * cmon_resolver_finalize(cmon_resolver * _r)
         }
     }
 
-    printf("h\n");
-
     // add local functions to ir builder
     for (i = 0; i < cmon_dyn_arr_count(&_r->file_resolvers); ++i)
     {
@@ -3364,8 +3823,6 @@ cmon_ir * cmon_resolver_finalize(cmon_resolver * _r)
         }
     }
 
-    printf("i\n");
-
     // add sorted globals to ir builder
     for (i = 0; i < res.count; ++i)
     {
@@ -3385,7 +3842,6 @@ cmon_ir * cmon_resolver_finalize(cmon_resolver * _r)
     {
         for (j = 0; j < cmon_dyn_arr_count(&_r->file_resolvers[i].local_fns); ++j)
         {
-            printf("ADDING BODY TO LOCAL FN %i\n", j);
             _ir_add_fn_body(_r, &_r->file_resolvers[i], _r->file_resolvers[i].local_fns[j]);
         }
     }
@@ -18,6 +18,10 @@ typedef struct cmon_file_ast_pair
 
 CMON_API cmon_resolver * cmon_resolver_create(cmon_allocator * _alloc, size_t _max_errors);
 CMON_API void cmon_resolver_destroy(cmon_resolver * _r);
+// sets the allocator for everything the resolver allocates per file (defaults to the allocator the
+// resolver was created with). Needs to be called before cmon_resolver_set_input. If the main pass of
+// multiple files runs concurrently, this allocator has to be thread safe.
+CMON_API void cmon_resolver_set_file_allocator(cmon_resolver * _r, cmon_allocator * _alloc);
 CMON_API void cmon_resolver_set_input(cmon_resolver * _r,
                                       cmon_src * _src,
                                       cmon_types * _types,
@@ -32,6 +36,9 @@ CMON_API cmon_bool cmon_resolver_usertypes_pass(cmon_resolver * _r, cmon_idx _fi
 CMON_API cmon_bool cmon_resolver_globals_pass(cmon_resolver * _r);
 CMON_API cmon_bool cmon_resolver_usertypes_def_expr_pass(cmon_resolver * _r, cmon_idx _file_idx);
 CMON_API cmon_bool cmon_resolver_circ_pass(cmon_resolver * _r);
+//@NOTE: once all passes above are done, the main pass of the different files of a module can run
+// concurrently (given that the symbols and types were reserved, see cmon_symbols_reserve and
+// cmon_types_reserve). Each file only modifies its own scopes and reads the global ones.
 CMON_API cmon_bool cmon_resolver_main_pass(cmon_resolver * _r, cmon_idx _file_idx);
 CMON_API cmon_ir * cmon_resolver_finalize(cmon_resolver * _r);
 
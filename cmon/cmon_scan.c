@@ -0,0 +1,201 @@
+#include <cmon/cmon_scan.h>
+#include <pthread.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define _HAS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+// scalar versions, these also handle the tails of the vectorized versions
+
+static inline int _is_blank(char _c)
+{
+    return _c == ' ' || _c == '\t' || _c == '\r' || _c == '\v' || _c == '\f';
+}
+
+static inline int _is_ident(char _c)
+{
+    return CMON_SCAN_IS_IDENT(_c);
+}
+
+static const char * _skip_blanks_scalar(const char * _pos, const char * _end)
+{
+    while (_pos < _end && _is_blank(*_pos))
+        ++_pos;
+    return _pos;
+}
+
+static const char * _ident_end_scalar(const char * _pos, const char * _end)
+{
+    while (_pos < _end && _is_ident(*_pos))
+        ++_pos;
+    return _pos;
+}
+
+static const char * _find_any3_scalar(
+    const char * _pos, const char * _end, char _a, char _b, char _c)
+{
+    while (_pos < _end && *_pos != _a && *_pos != _b && *_pos != _c)
+        ++_pos;
+    return _pos;
+}
+
+static const cmon_scanner _scalar = {
+    "scalar", _skip_blanks_scalar, _ident_end_scalar, _find_any3_scalar
+};
+
+#ifdef _HAS_X86_SIMD
+
+//@NOTE: all range checks below use signed compares. Bytes >= 0x80 are negative and thus outside of
+// all the (ascii) ranges we check for, which is what we want.
+
+#define _SSE2 __attribute__((target("sse2")))
+#define _AVX2 __attribute__((target("avx2")))
+
+_SSE2 static inline __m128i _in_range_sse2(__m128i _v, char _lo, char _hi)
+{
+    return _mm_and_si128(_mm_cmpgt_epi8(_v, _mm_set1_epi8(_lo - 1)),
+                         _mm_cmpgt_epi8(_mm_set1_epi8(_hi + 1), _v));
+}
+
+_SSE2 static const char * _skip_blanks_sse2(const char * _pos, const char * _end)
+{
+    // \t, \v, \f and \r are 9..13, which also contains \n
+    while (_end - _pos >= 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)_pos);
+        __m128i m = _mm_andnot_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')),
+                                     _in_range_sse2(v, '\t', '\r'));
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+        unsigned int mask = ~(unsigned int)_mm_movemask_epi8(m) & 0xFFFF;
+        if (mask)
+            return _pos + __builtin_ctz(mask);
+        _pos += 16;
+    }
+    return _skip_blanks_scalar(_pos, _end);
+}
+
+_SSE2 static const char * _ident_end_sse2(const char * _pos, const char * _end)
+{
+    while (_end - _pos >= 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)_pos);
+        // setting bit 5 maps upper case letters to lower case ones without creating new letters
+        __m128i m = _in_range_sse2(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z');
+        m = _mm_or_si128(m, _in_range_sse2(v, '0', '9'));
+        m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+        unsigned int mask = ~(unsigned int)_mm_movemask_epi8(m) & 0xFFFF;
+        if (mask)
+            return _pos + __builtin_ctz(mask);
+        _pos += 16;
+    }
+    return _ident_end_scalar(_pos, _end);
+}
+
+_SSE2 static const char * _find_any3_sse2(
+    const char * _pos, const char * _end, char _a, char _b, char _c)
+{
+    __m128i a = _mm_set1_epi8(_a);
+    __m128i b = _mm_set1_epi8(_b);
+    __m128i c = _mm_set1_epi8(_c);
+    while (_end - _pos >= 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)_pos);
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, a), _mm_cmpeq_epi8(v, b)),
+                                 _mm_cmpeq_epi8(v, c));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(m);
+        if (mask)
+            return _pos + __builtin_ctz(mask);
+        _pos += 16;
+    }
+    return _find_any3_scalar(_pos, _end, _a, _b, _c);
+}
+
+static const cmon_scanner _sse2 = { "sse2", _skip_blanks_sse2, _ident_end_sse2, _find_any3_sse2 };
+
+_AVX2 static inline __m256i _in_range_avx2(__m256i _v, char _lo, char _hi)
+{
+    return _mm256_and_si256(_mm256_cmpgt_epi8(_v, _mm256_set1_epi8(_lo - 1)),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(_hi + 1), _v));
+}
+
+_AVX2 static const char * _skip_blanks_avx2(const char * _pos, const char * _end)
+{
+    while (_end - _pos >= 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)_pos);
+        __m256i m = _mm256_andnot_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')),
+                                        _in_range_avx2(v, '\t', '\r'));
+        m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')));
+        unsigned int mask = ~(unsigned int)_mm256_movemask_epi8(m);
+        if (mask)
+            return _pos + __builtin_ctz(mask);
+        _pos += 32;
+    }
+    return _skip_blanks_sse2(_pos, _end);
+}
+
+_AVX2 static const char * _ident_end_avx2(const char * _pos, const char * _end)
+{
+    while (_end - _pos >= 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)_pos);
+        __m256i m = _in_range_avx2(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z');
+        m = _mm256_or_si256(m, _in_range_avx2(v, '0', '9'));
+        m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+        unsigned int mask = ~(unsigned int)_mm256_movemask_epi8(m);
+        if (mask)
+            return _pos + __builtin_ctz(mask);
+        _pos += 32;
+    }
+    return _ident_end_sse2(_pos, _end);
+}
+
+_AVX2 static const char * _find_any3_avx2(
+    const char * _pos, const char * _end, char _a, char _b, char _c)
+{
+    __m256i a = _mm256_set1_epi8(_a);
+    __m256i b = _mm256_set1_epi8(_b);
+    __m256i c = _mm256_set1_epi8(_c);
+    while (_end - _pos >= 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)_pos);
+        __m256i m = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, a), _mm256_cmpeq_epi8(v, b)),
+            _mm256_cmpeq_epi8(v, c));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(m);
+        if (mask)
+            return _pos + __builtin_ctz(mask);
+        _pos += 32;
+    }
+    return _find_any3_sse2(_pos, _end, _a, _b, _c);
+}
+
+static const cmon_scanner _avx2 = { "avx2", _skip_blanks_avx2, _ident_end_avx2, _find_any3_avx2 };
+
+#endif // _HAS_X86_SIMD
+
+static const cmon_scanner * _best = &_scalar;
+static pthread_once_t _best_once = PTHREAD_ONCE_INIT;
+
+static void _select_best()
+{
+#ifdef _HAS_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        _best = &_avx2;
+    else if (__builtin_cpu_supports("sse2"))
+        _best = &_sse2;
+#endif
+}
+
+const cmon_scanner * cmon_scanner_get()
+{
+    pthread_once(&_best_once, _select_best);
+    return _best;
+}
+
+const cmon_scanner * cmon_scanner_scalar()
+{
+    return &_scalar;
+}
@@ -0,0 +1,31 @@
+#ifndef CMON_CMON_SCAN_H
+#define CMON_CMON_SCAN_H
+
+#include <cmon/cmon_base.h>
+
+// byte scanning primitives used by the tokenizer. There is a portable scalar implementation and
+// SSE2/AVX2 implementations that process 16/32 bytes at a time on x86. cmon_scanner_get picks the
+// best one the cpu supports at runtime.
+// All functions scan [_pos, _end) and return _end if no matching byte was found.
+typedef struct
+{
+    const char * name;
+    // first byte that is not a space, tab, carriage return, vertical tab or form feed. Newlines
+    // are not skipped so the caller can count lines.
+    const char * (*skip_blanks)(const char * _pos, const char * _end);
+    // first byte that can't be part of an identifier, i.e. not in [a-zA-Z0-9_]
+    const char * (*ident_end)(const char * _pos, const char * _end);
+    // first byte that is equal to _a, _b or _c
+    const char * (*find_any3)(const char * _pos, const char * _end, char _a, char _b, char _c);
+} cmon_scanner;
+
+// true if _c can be part of an identifier, i.e. is in [a-zA-Z0-9_]. Unlike isalnum this does not
+// depend on the locale or the signedness of char.
+#define CMON_SCAN_IS_IDENT(_c)                                                                     \
+    (((_c) >= 'a' && (_c) <= 'z') || ((_c) >= 'A' && (_c) <= 'Z') ||                               \
+     ((_c) >= '0' && (_c) <= '9') || (_c) == '_')
+
+CMON_API const cmon_scanner * cmon_scanner_get();
+CMON_API const cmon_scanner * cmon_scanner_scalar();
+
+#endif // CMON_CMON_SCAN_H
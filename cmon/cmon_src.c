@@ -8,10 +8,18 @@ typedef struct
 {
     char path[CMON_PATH_MAX];
     char filename[CMON_FILENAME_MAX];
-    char * code;
+    // points into file, code_copy or code that was set with cmon_src_set_code_ref
+    const char * code;
+    // set if the code was loaded from disk
+    cmon_fs_txt_file file;
+    // set if the code was copied in cmon_src_set_code
+    char * code_copy;
     cmon_ast * ast;
     cmon_tokens * tokens;
     cmon_idx mod_src_idx; // src file index within the module
+    // set by cmon_src_release, the tokens are created again when they are needed for diagnostics
+    cmon_bool released;
+    cmon_tokens * reloaded_tokens;
 } cmon_src_file;
 
 typedef struct cmon_src
@@ -39,7 +47,8 @@ void cmon_src_destroy(cmon_src * _src)
     size_t i;
     for (i = 0; i < cmon_dyn_arr_count(&_src->files); ++i)
     {
-        cmon_c_str_free(_src->alloc, _src->files[i].code);
+        cmon_tokens_destroy(_src->files[i].reloaded_tokens);
+        cmon_src_release_code(_src, i);
     }
     cmon_dyn_arr_dealloc(&_src->files);
     CMON_DESTROY(_src->alloc, _src);
@@ -51,27 +60,87 @@ cmon_idx cmon_src_add(cmon_src * _src, const char * _path, const char * _filenam
     strcpy(f.path, _path);
     strcpy(f.filename, _filename);
     f.code = NULL;
+    f.file = (cmon_fs_txt_file){ NULL, 0, cmon_false };
+    f.code_copy = NULL;
     f.ast = NULL;
     f.tokens = NULL;
     f.mod_src_idx = CMON_INVALID_IDX;
+    f.released = cmon_false;
+    f.reloaded_tokens = NULL;
     cmon_dyn_arr_append(&_src->files, f);
     return cmon_dyn_arr_count(&_src->files) - 1;
 }
 
 cmon_bool cmon_src_load_code(cmon_src * _src, cmon_idx _file_idx)
-{   
+{
     cmon_src_file * s = _get_file(_src, _file_idx);
     if (s->code)
         return cmon_false;
 
-    s->code = cmon_fs_load_txt_file(_src->alloc, s->path);
+    if (cmon_fs_map_txt_file(_src->alloc, s->path, &s->file) == -1)
+        return cmon_true;
 
-    return s->code == NULL;
+    s->code = s->file.data;
+    return cmon_false;
 }
 
 void cmon_src_set_code(cmon_src * _src, cmon_idx _file_idx, const char * _code)
 {
-    _get_file(_src, _file_idx)->code = cmon_c_str_copy(_src->alloc, _code);
+    cmon_src_file * s = _get_file(_src, _file_idx);
+    cmon_src_release_code(_src, _file_idx);
+    s->code_copy = cmon_c_str_copy(_src->alloc, _code);
+    s->code = s->code_copy;
+}
+
+void cmon_src_set_code_ref(cmon_src * _src, cmon_idx _file_idx, const char * _code)
+{
+    cmon_src_release_code(_src, _file_idx);
+    _get_file(_src, _file_idx)->code = _code;
+}
+
+void cmon_src_release_code(cmon_src * _src, cmon_idx _file_idx)
+{
+    cmon_src_file * s = _get_file(_src, _file_idx);
+    cmon_fs_unmap_txt_file(_src->alloc, &s->file);
+    if (s->code_copy)
+    {
+        cmon_c_str_free(_src->alloc, s->code_copy);
+        s->code_copy = NULL;
+    }
+    s->code = NULL;
+}
+
+void cmon_src_release(cmon_src * _src, cmon_idx _file_idx)
+{
+    cmon_src_file * s = _get_file(_src, _file_idx);
+    //@NOTE: only code that was loaded from disk can be loaded again, code set via
+    // cmon_src_set_code(_ref) is kept.
+    if (s->file.data)
+        cmon_src_release_code(_src, _file_idx);
+    cmon_tokens_destroy(s->reloaded_tokens);
+    s->reloaded_tokens = NULL;
+    s->ast = NULL;
+    s->tokens = NULL;
+    s->released = cmon_true;
+}
+
+// loads and tokenizes a released file again. This only happens if an error has to be reported for
+// it, so the tokens are not interned.
+static inline cmon_src_file * _reload_if_released(cmon_src * _src, cmon_idx _file_idx)
+{
+    cmon_err_report err;
+    cmon_src_file * s = _get_file(_src, _file_idx);
+    if (!s->released)
+        return s;
+
+    //@NOTE: reset upfront as the tokenizer reads the code through cmon_src_code
+    s->released = cmon_false;
+    if (!s->code && cmon_src_load_code(_src, _file_idx))
+        return s;
+
+    s->reloaded_tokens = cmon_tokenize(_src->alloc, _src, _file_idx, &err);
+    s->tokens = s->reloaded_tokens;
+    return s;
 }
 
 void cmon_src_set_ast(cmon_src * _src, cmon_idx _file_idx, cmon_ast * _ast)
@@ -96,7 +165,7 @@ void cmon_src_set_mod_src_idx(cmon_src * _src, cmon_idx _file_idx, cmon_idx _idx
 
 cmon_tokens * cmon_src_tokens(cmon_src * _src, cmon_idx _file_idx)
 {
-    return _get_file(_src, _file_idx)->tokens;
+    return _reload_if_released(_src, _file_idx)->tokens;
 }
 
 const char * cmon_src_path(cmon_src * _src, cmon_idx _file_idx)
@@ -111,7 +180,7 @@ const char * cmon_src_filename(cmon_src * _src, cmon_idx _file_idx)
 
 const char * cmon_src_code(cmon_src * _src, cmon_idx _file_idx)
 {
-    return _get_file(_src, _file_idx)->code;
+    return _reload_if_released(_src, _file_idx)->code;
 }
 
 cmon_str_view cmon_src_line(cmon_src * _src, cmon_idx _file_idx, size_t _line)
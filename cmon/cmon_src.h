@@ -11,8 +11,21 @@ CMON_API cmon_src * cmon_src_create(cmon_allocator * _alloc);
 CMON_API void cmon_src_destroy(cmon_src * _src);
 
 CMON_API cmon_idx cmon_src_add(cmon_src * _src, const char * _path, const char * _filename);
+// loads the code of a file from disk. The file is memory mapped if possible, so tokens point
+// directly into the mapping. Noop if the file already has code.
 CMON_API cmon_bool cmon_src_load_code(cmon_src * _src, cmon_idx _file_idx);
+// sets the code of a file to a copy of _code
 CMON_API void cmon_src_set_code(cmon_src * _src, cmon_idx _file_idx, const char * _code);
+// sets the code of a file without copying it, _code has to stay alive until the code is released
+CMON_API void cmon_src_set_code_ref(cmon_src * _src, cmon_idx _file_idx, const char * _code);
+// frees (or unmaps) the code of a file. Tokens, ASTs and symbol names point into the code, so this
+// should only be called once they are not used anymore (i.e. after a module's IR was produced).
+// Files that were loaded from disk can be loaded again with cmon_src_load_code.
+CMON_API void cmon_src_release_code(cmon_src * _src, cmon_idx _file_idx);
+// releases the code of a file that was loaded from disk and forgets its tokens and ast (which are
+// owned by the caller). Once a module's IR is produced nothing but diagnostics need them anymore,
+// and for those cmon_src_tokens and cmon_src_code load and tokenize the file again.
+CMON_API void cmon_src_release(cmon_src * _src, cmon_idx _file_idx);
 CMON_API void cmon_src_set_ast(cmon_src * _src, cmon_idx _file_idx, cmon_ast * _ast);
 CMON_API cmon_ast * cmon_src_ast(cmon_src * _src, cmon_idx _file_idx);
 CMON_API void cmon_src_set_tokens(cmon_src * _src, cmon_idx _file_idx, cmon_tokens * _tokens);
@@ -1,19 +1,59 @@
+#include <cmon/cmon_blk_arr.h>
 #include <cmon/cmon_dyn_arr.h>
 #include <cmon/cmon_hashmap.h>
+#include <cmon/cmon_interner.h>
 #include <cmon/cmon_src.h>
 #include <cmon/cmon_str_builder.h>
 #include <cmon/cmon_symbols.h>
 #include <cmon/cmon_util.h>
+#include <pthread.h>
+
+// scopes with more symbols than this get a hash index, smaller ones are searched linearly
+#define _SCOPE_INDEX_THRESHOLD 16
+// the capacity of the first range a scope allocates in its tree
+#define _RANGE_MIN_CAP 4
+
+// a range of entries owned by a scope inside one of the arrays of its scope tree
+typedef struct
+{
+    cmon_idx begin;
+    cmon_idx count;
+    cmon_idx cap;
+} _range;
+
+typedef struct
+{
+    cmon_idx sym;
+    cmon_idx name_id;
+} _scope_entry;
+
+typedef struct
+{
+    // maps interned name ids to the latest symbol of that name
+    cmon_hashmap(cmon_idx, cmon_idx) name_map;
+} _scope_index;
+
+//@NOTE: scopes store their symbols and children in the arrays of a shared tree rather than owning
+// arrays themselves. Global scopes and file scopes each start a new tree that all of their
+// descendants share. A tree is only ever modified by the module (or, during the main pass, the file)
+// it belongs to which is why none of this needs to lock.
+typedef struct
+{
+    cmon_allocator * alloc;
+    cmon_dyn_arr(_scope_entry) entries;
+    cmon_dyn_arr(cmon_idx) children;
+    cmon_dyn_arr(_scope_index) indices;
+} _scope_tree;
 
 typedef struct
 {
     cmon_idx parent;
     cmon_idx mod_idx;
-    //@TODO: similar to ast and IR, have one linear array for each of these in cmon_symbols and only
-    // save being/end in here?
-    cmon_dyn_arr(cmon_idx) symbols;
-    cmon_dyn_arr(cmon_idx) children;
-    cmon_hashmap(cmon_str_view, cmon_idx) name_map;
+    _scope_tree * tree;
+    _range symbols;
+    _range children;
+    // index into tree->indices, invalid as long as the scope is small
+    cmon_idx index;
 } _scope;
 
 typedef struct
@@ -25,13 +65,14 @@ typedef struct
 typedef struct
 {
     cmon_str_view name;
+    cmon_idx name_id;
     cmon_symk kind;
     cmon_bool is_pub;
     cmon_idx scope_idx;
     cmon_idx redecl_idx;
     cmon_idx src_file_idx;
     cmon_idx ast_idx;
-    size_t uname_str_off;
+    char * uname_str;
     union
     {
         cmon_idx idx;
@@ -44,54 +85,152 @@ typedef struct cmon_symbols
     cmon_allocator * alloc;
     cmon_src * src;
     cmon_modules * mods;
+    cmon_interner * interner;
+    cmon_bool owns_interner;
     cmon_str_builder * str_builder;
-    cmon_str_buf * str_buf;
-    cmon_dyn_arr(_symbol) symbols;
-    cmon_dyn_arr(_scope) scopes;
+    //@NOTE: symbols and scopes live in blocks that never move, so lookups can read them without
+    // locking while other threads add to them.
+    cmon_blk_arr(_symbol) symbols;
+    cmon_blk_arr(_scope) scopes;
+    cmon_dyn_arr(_scope_tree *) trees;
+    // protects adding symbols, scopes and trees
+    pthread_mutex_t mtx;
 } cmon_symbols;
 
-static inline uint64_t _str_view_hash(cmon_str_view _view)
+static inline _scope * _get_scope(cmon_symbols * _s, cmon_idx _scope)
 {
-    return _cmon_str_range_hash(_view.begin, _view.end);
+    assert(_scope < cmon_blk_arr_count(&_s->scopes));
+    return &cmon_blk_arr_get(&_s->scopes, _scope);
 }
 
-static inline cmon_bool _str_view_cmp(const void * _stra, const void * _strb, size_t _byte_count)
+static inline _symbol * _get_symbol(cmon_symbols * _s, cmon_idx _sym)
 {
-    return cmon_str_view_cmp(*(cmon_str_view *)_stra, *(cmon_str_view *)_strb) == 0;
+    assert(_sym < cmon_blk_arr_count(&_s->symbols));
+    return &cmon_blk_arr_get(&_s->symbols, _sym);
 }
 
-static inline _scope * _get_scope(cmon_symbols * _s, cmon_idx _scope)
+static inline cmon_idx _get_sym_tok_idx(cmon_symbols * _s, cmon_idx _sym)
 {
-    assert(_scope < cmon_dyn_arr_count(&_s->scopes));
-    return &_s->scopes[_scope];
+    return cmon_ast_token(cmon_symbols_ast(_s, _sym), cmon_symbols_ast(_s, _sym));
 }
 
-static inline _symbol * _get_symbol(cmon_symbols * _s, cmon_idx _sym)
-{
-    assert(_sym < cmon_dyn_arr_count(&_s->symbols));
-    return &_s->symbols[_sym];
+// makes room for one more element in _range (which lives in _pool). If the range is the last one in
+// the pool it simply grows in place, otherwise it moves to the end of the pool with twice its
+// capacity, leaving its old slots unused.
+#define _range_append(_pool, _range, _val)                                                         \
+    do                                                                                             \
+    {                                                                                              \
+        if ((_range)->count == (_range)->cap)                                                      \
+        {                                                                                          \
+            cmon_idx _old_begin = (_range)->begin;                                                 \
+            cmon_idx _new_cap = (_range)->cap ? (_range)->cap * 2 : _RANGE_MIN_CAP;                \
+            if ((_range)->begin + (_range)->cap != cmon_dyn_arr_count(_pool))                      \
+                (_range)->begin = cmon_dyn_arr_count(_pool);                                       \
+            cmon_dyn_arr_resize(_pool, (_range)->begin + _new_cap);                                \
+            if ((_range)->begin != _old_begin)                                                     \
+                memcpy(&(*(_pool))[(_range)->begin],                                               \
+                       &(*(_pool))[_old_begin],                                                    \
+                       (_range)->count * sizeof((*(_pool))[0]));                                   \
+            (_range)->cap = _new_cap;                                                              \
+        }                                                                                          \
+        (*(_pool))[(_range)->begin + (_range)->count++] = (_val);                                  \
+    } while (0)
+
+static inline _scope_tree * _create_tree(cmon_allocator * _alloc)
+{
+    _scope_tree * ret = CMON_CREATE(_alloc, _scope_tree);
+    ret->alloc = _alloc;
+    cmon_dyn_arr_init(&ret->entries, _alloc, 64);
+    cmon_dyn_arr_init(&ret->children, _alloc, 16);
+    cmon_dyn_arr_init(&ret->indices, _alloc, 4);
+    return ret;
 }
 
-static inline cmon_idx _get_sym_tok_idx(cmon_symbols * _s, cmon_idx _sym)
+static inline void _destroy_tree(_scope_tree * _tree)
 {
-    return cmon_ast_token(cmon_symbols_ast(_s, _sym), cmon_symbols_ast(_s, _sym));
+    size_t i;
+    for (i = 0; i < cmon_dyn_arr_count(&_tree->indices); ++i)
+        cmon_hashmap_dealloc(&_tree->indices[i].name_map);
+    cmon_dyn_arr_dealloc(&_tree->indices);
+    cmon_dyn_arr_dealloc(&_tree->children);
+    cmon_dyn_arr_dealloc(&_tree->entries);
+    CMON_DESTROY(_tree->alloc, _tree);
 }
 
 static inline cmon_idx _add_scope(cmon_symbols * _s, cmon_idx _parent_scope, cmon_idx _mod_idx)
 {
+    cmon_idx ret;
+    cmon_bool owns_tree;
     _scope s;
     s.parent = _parent_scope;
     s.mod_idx = _mod_idx;
-    cmon_dyn_arr_init(&s.symbols, _s->alloc, 16);
-    cmon_dyn_arr_init(&s.children, _s->alloc, 4);
-    cmon_hashmap_init(&s.name_map, _s->alloc, _str_view_hash, _str_view_cmp, NULL);
-    cmon_dyn_arr_append(&_s->scopes, s);
+    s.symbols = s.children = (_range){ 0, 0, 0 };
+    s.index = CMON_INVALID_IDX;
+    owns_tree = !cmon_is_valid_idx(_parent_scope) || cmon_symbols_scope_is_global(_s, _parent_scope);
+    s.tree = owns_tree ? _create_tree(_s->alloc) : _get_scope(_s, _parent_scope)->tree;
+
+    pthread_mutex_lock(&_s->mtx);
+    cmon_blk_arr_append(&_s->scopes, s);
+    ret = cmon_blk_arr_count(&_s->scopes) - 1;
+    if (owns_tree)
+        cmon_dyn_arr_append(&_s->trees, s.tree);
+    pthread_mutex_unlock(&_s->mtx);
+
+    //@NOTE: a scope is only ever modified by the module (or file) it belongs to, so adding the child
+    // (and adding symbols to the scope in _add_symbol) does not need to lock.
     if (cmon_is_valid_idx(_parent_scope))
     {
-        cmon_dyn_arr_append(&_get_scope(_s, _parent_scope)->children,
-                            cmon_dyn_arr_count(&_s->scopes) - 1);
+        _scope * parent = _get_scope(_s, _parent_scope);
+        _range_append(&parent->tree->children, &parent->children, ret);
+    }
+    return ret;
+}
+
+static inline void _add_scope_entry(_scope * _scp, cmon_idx _sym, cmon_idx _name_id)
+{
+    _scope_tree * tree = _scp->tree;
+    _range_append(&tree->entries, &_scp->symbols, ((_scope_entry){ _sym, _name_id }));
+
+    if (cmon_is_valid_idx(_scp->index))
+    {
+        cmon_hashmap_set(&tree->indices[_scp->index].name_map, _name_id, _sym);
+    }
+    else if (_scp->symbols.count > _SCOPE_INDEX_THRESHOLD)
+    {
+        //@NOTE: the scope just outgrew a linear search, index everything it declared so far.
+        // Entries are visited in declaration order so the latest symbol of each name wins.
+        _scope_index idx;
+        size_t i;
+        cmon_hashmap_int_key_init(&idx.name_map, tree->alloc);
+        for (i = 0; i < _scp->symbols.count; ++i)
+        {
+            _scope_entry * e = &tree->entries[_scp->symbols.begin + i];
+            cmon_hashmap_set(&idx.name_map, e->name_id, e->sym);
+        }
+        cmon_dyn_arr_append(&tree->indices, idx);
+        _scp->index = cmon_dyn_arr_count(&tree->indices) - 1;
+    }
+}
+
+static inline cmon_idx _find_in_scope(_scope * _scp, cmon_idx _name_id)
+{
+    _scope_tree * tree = _scp->tree;
+    if (cmon_is_valid_idx(_scp->index))
+    {
+        //@NOTE: global scopes are read by multiple threads concurrently, so this must not write
+        // to the map
+        cmon_idx * fidx = cmon_hashmap_find(&tree->indices[_scp->index].name_map, &_name_id);
+        return fidx ? *fidx : CMON_INVALID_IDX;
+    }
+
+    // search backwards to find the latest symbol of that name
+    _scope_entry * entries = tree->entries + _scp->symbols.begin;
+    for (size_t i = _scp->symbols.count; i > 0; --i)
+    {
+        if (entries[i - 1].name_id == _name_id)
+            return entries[i - 1].sym;
     }
-    return cmon_dyn_arr_count(&_s->scopes) - 1;
+    return CMON_INVALID_IDX;
 }
 
 static inline cmon_idx _add_symbol(cmon_symbols * _s,
@@ -102,8 +241,12 @@ static inline cmon_idx _add_symbol(cmon_symbols * _s,
                                    cmon_idx _src_file_idx,
                                    cmon_idx _ast_idx)
 {
+    cmon_idx ret;
     _symbol s;
-    s.name = _name;
+    //@NOTE: the name points into the interner rather than the source code, so the code can be
+    // released once the module is compiled (see cmon_src_release).
+    s.name_id = cmon_interner_intern(_s->interner, _name);
+    s.name = cmon_interner_str_view(_s->interner, s.name_id);
     s.kind = _kind;
     s.is_pub = _is_pub;
     s.scope_idx = _scp;
@@ -111,13 +254,11 @@ static inline cmon_idx _add_symbol(cmon_symbols * _s,
     s.src_file_idx = _src_file_idx;
     s.ast_idx = _ast_idx;
 
-    //@TODO: right now hashmap does not provide an API to manualy update the value for a found node
-    // causing us to basically find _name twice right now, once below and once in cmon_hashmap_set
-    // at the end
-    cmon_idx existing = cmon_symbols_find_local(_s, _scp, _name);
+    cmon_idx existing = cmon_symbols_find_local_id(_s, _scp, s.name_id);
     if (cmon_is_valid_idx(existing))
         s.redecl_idx = _get_symbol(_s, existing)->redecl_idx + 1;
 
+    pthread_mutex_lock(&_s->mtx);
     cmon_str_builder_clear(_s->str_builder);
 
     if (s.redecl_idx > 0)
@@ -130,40 +271,52 @@ static inline cmon_idx _add_symbol(cmon_symbols * _s,
         cmon_str_builder_append_fmt(_s->str_builder, "%.*s", _name.end - _name.begin, _name.begin);
     }
 
-    s.uname_str_off = cmon_str_buf_append(_s->str_buf, cmon_str_builder_c_str(_s->str_builder));
-    _scope * scope = _get_scope(_s, _scp);
-    cmon_dyn_arr_append(&scope->symbols, cmon_dyn_arr_count(&_s->symbols));
-    cmon_dyn_arr_append(&_s->symbols, s);
-    cmon_hashmap_set(&scope->name_map, _name, cmon_dyn_arr_count(&_s->symbols) - 1);
-    return cmon_dyn_arr_count(&_s->symbols) - 1;
+    s.uname_str = cmon_c_str_copy(_s->alloc, cmon_str_builder_c_str(_s->str_builder));
+    cmon_blk_arr_append(&_s->symbols, s);
+    ret = cmon_blk_arr_count(&_s->symbols) - 1;
+    pthread_mutex_unlock(&_s->mtx);
+
+    _add_scope_entry(_get_scope(_s, _scp), ret, s.name_id);
+    return ret;
 }
 
-cmon_symbols * cmon_symbols_create(cmon_allocator * _alloc, cmon_src * _src, cmon_modules * _mods)
+cmon_symbols * cmon_symbols_create(cmon_allocator * _alloc,
+                                   cmon_src * _src,
+                                   cmon_modules * _mods,
+                                   cmon_interner * _interner)
 {
     cmon_symbols * ret = CMON_CREATE(_alloc, cmon_symbols);
     ret->alloc = _alloc;
     ret->src = _src;
     ret->mods = _mods;
+    ret->owns_interner = _interner == NULL;
+    ret->interner = _interner ? _interner : cmon_interner_create(_alloc);
     ret->str_builder = cmon_str_builder_create(_alloc, 128);
-    ret->str_buf = cmon_str_buf_create(_alloc, 512);
-    cmon_dyn_arr_init(&ret->symbols, _alloc, 256);
-    cmon_dyn_arr_init(&ret->scopes, _alloc, 256);
+    cmon_blk_arr_init(&ret->symbols, _alloc);
+    cmon_blk_arr_init(&ret->scopes, _alloc);
+    cmon_dyn_arr_init(&ret->trees, _alloc, 8);
+    pthread_mutex_init(&ret->mtx, NULL);
     return ret;
 }
 
 void cmon_symbols_destroy(cmon_symbols * _s)
 {
     size_t i;
-    for (i = 0; i < cmon_dyn_arr_count(&_s->scopes); ++i)
+    for (i = 0; i < cmon_dyn_arr_count(&_s->trees); ++i)
     {
-        cmon_hashmap_dealloc(&_s->scopes[i].name_map);
-        cmon_dyn_arr_dealloc(&_s->scopes[i].children);
-        cmon_dyn_arr_dealloc(&_s->scopes[i].symbols);
+        _destroy_tree(_s->trees[i]);
     }
-    cmon_str_buf_destroy(_s->str_buf);
+    for (i = 0; i < cmon_blk_arr_count(&_s->symbols); ++i)
+    {
+        cmon_c_str_free(_s->alloc, cmon_blk_arr_get(&_s->symbols, i).uname_str);
+    }
+    pthread_mutex_destroy(&_s->mtx);
+    if (_s->owns_interner)
+        cmon_interner_destroy(_s->interner);
     cmon_str_builder_destroy(_s->str_builder);
-    cmon_dyn_arr_dealloc(&_s->scopes);
-    cmon_dyn_arr_dealloc(&_s->symbols);
+    cmon_dyn_arr_dealloc(&_s->trees);
+    cmon_blk_arr_dealloc(&_s->scopes);
+    cmon_blk_arr_dealloc(&_s->symbols);
     CMON_DESTROY(_s->alloc, _s);
 }
 
@@ -260,34 +413,31 @@ void cmon_symbols_alias_set_type(cmon_symbols * _s, cmon_idx _sym, cmon_idx _typ
     _get_symbol(_s, _sym)->data.idx = _type_idx;
 }
 
-cmon_idx cmon_symbols_find_local_before(cmon_symbols * _s,
-                                        cmon_idx _scope_idx,
-                                        cmon_str_view _name,
-                                        cmon_idx _tok)
+cmon_idx cmon_symbols_find_local_before_id(cmon_symbols * _s,
+                                           cmon_idx _scope_idx,
+                                           cmon_idx _name_id,
+                                           cmon_idx _tok)
 {
-    cmon_idx * fidx;
-    _scope * scope;
-
-    scope = _get_scope(_s, _scope_idx);
-    if ((fidx = cmon_hashmap_get(&scope->name_map, _name)))
-    {
-        if (!cmon_is_valid_idx(_tok) || _get_sym_tok_idx(_s, *fidx) < _tok)
-            return *fidx;
-    }
+    cmon_idx ret = _find_in_scope(_get_scope(_s, _scope_idx), _name_id);
+    if (cmon_is_valid_idx(ret) && (!cmon_is_valid_idx(_tok) || _get_sym_tok_idx(_s, ret) < _tok))
+        return ret;
     return CMON_INVALID_IDX;
 }
 
-cmon_idx cmon_symbols_find_before(cmon_symbols * _s,
-                                  cmon_idx _scope,
-                                  cmon_str_view _name,
-                                  cmon_idx _tok)
+cmon_idx cmon_symbols_find_before_id(cmon_symbols * _s,
+                                     cmon_idx _scope,
+                                     cmon_idx _name_id,
+                                     cmon_idx _tok)
 {
     cmon_idx scope, ret;
 
+    if (!cmon_is_valid_idx(_name_id))
+        return CMON_INVALID_IDX;
+
     scope = _scope;
     do
     {
-        if (cmon_is_valid_idx(ret = cmon_symbols_find_local_before(_s, scope, _name, _tok)))
+        if (cmon_is_valid_idx(ret = cmon_symbols_find_local_before_id(_s, scope, _name_id, _tok)))
             return ret;
         scope = _get_scope(_s, scope)->parent;
     } while (cmon_is_valid_idx(scope));
@@ -295,6 +445,39 @@ cmon_idx cmon_symbols_find_before(cmon_symbols * _s,
     return CMON_INVALID_IDX;
 }
 
+cmon_idx cmon_symbols_find_local_id(cmon_symbols * _s, cmon_idx _scope, cmon_idx _name_id)
+{
+    if (!cmon_is_valid_idx(_name_id))
+        return CMON_INVALID_IDX;
+    return cmon_symbols_find_local_before_id(_s, _scope, _name_id, CMON_INVALID_IDX);
+}
+
+cmon_idx cmon_symbols_find_id(cmon_symbols * _s, cmon_idx _scope, cmon_idx _name_id)
+{
+    return cmon_symbols_find_before_id(_s, _scope, _name_id, CMON_INVALID_IDX);
+}
+
+//@NOTE: a name that was never interned can't be the name of any symbol, so these bail early in that
+// case
+cmon_idx cmon_symbols_find_local_before(cmon_symbols * _s,
+                                        cmon_idx _scope_idx,
+                                        cmon_str_view _name,
+                                        cmon_idx _tok)
+{
+    cmon_idx id = cmon_interner_find(_s->interner, _name);
+    if (!cmon_is_valid_idx(id))
+        return CMON_INVALID_IDX;
+    return cmon_symbols_find_local_before_id(_s, _scope_idx, id, _tok);
+}
+
+cmon_idx cmon_symbols_find_before(cmon_symbols * _s,
+                                  cmon_idx _scope,
+                                  cmon_str_view _name,
+                                  cmon_idx _tok)
+{
+    return cmon_symbols_find_before_id(_s, _scope, cmon_interner_find(_s->interner, _name), _tok);
+}
+
 cmon_idx cmon_symbols_find_local(cmon_symbols * _s, cmon_idx _scope, cmon_str_view _name)
 {
     return cmon_symbols_find_local_before(_s, _scope, _name, CMON_INVALID_IDX);
@@ -320,9 +503,14 @@ cmon_str_view cmon_symbols_name(cmon_symbols * _s, cmon_idx _sym)
     return _get_symbol(_s, _sym)->name;
 }
 
+cmon_idx cmon_symbols_name_id(cmon_symbols * _s, cmon_idx _sym)
+{
+    return _get_symbol(_s, _sym)->name_id;
+}
+
 const char * cmon_symbols_unique_name(cmon_symbols * _s, cmon_idx _sym)
 {
-    return cmon_str_buf_get(_s->str_buf, _get_symbol(_s, _sym)->uname_str_off);
+    return _get_symbol(_s, _sym)->uname_str;
 }
 
 cmon_bool cmon_symbols_is_pub(cmon_symbols * _s, cmon_idx _sym)
@@ -372,7 +560,7 @@ cmon_bool cmon_symbols_var_is_mut(cmon_symbols * _s, cmon_idx _sym)
 
 size_t cmon_symbols_scope_symbol_count(cmon_symbols * _s, cmon_idx _scope)
 {
-    return cmon_dyn_arr_count(&_get_scope(_s, _scope)->symbols);
+    return _get_scope(_s, _scope)->symbols.count;
 }
 
 size_t cmon_symbols_scope_recursive_symbol_count(cmon_symbols * _s, cmon_idx _scope)
@@ -386,21 +574,23 @@ size_t cmon_symbols_scope_recursive_symbol_count(cmon_symbols * _s, cmon_idx _sc
     return ret;
 }
 
-cmon_idx cmon_symbols_scope_symbol(cmon_symbols * _s, cmon_idx _scope, cmon_idx _idx)
+cmon_idx cmon_symbols_scope_symbol(cmon_symbols * _s, cmon_idx _scope_idx, cmon_idx _idx)
 {
-    assert(_idx < cmon_symbols_scope_symbol_count(_s, _scope));
-    return _get_scope(_s, _scope)->symbols[_idx];
+    _scope * scope = _get_scope(_s, _scope_idx);
+    assert(_idx < scope->symbols.count);
+    return scope->tree->entries[scope->symbols.begin + _idx].sym;
 }
 
 size_t cmon_symbols_scope_child_count(cmon_symbols * _s, cmon_idx _scope)
 {
-    return cmon_dyn_arr_count(&_get_scope(_s, _scope)->children);
+    return _get_scope(_s, _scope)->children.count;
 }
 
-cmon_idx cmon_symbols_scope_child(cmon_symbols * _s, cmon_idx _scope, cmon_idx _idx)
+cmon_idx cmon_symbols_scope_child(cmon_symbols * _s, cmon_idx _scope_idx, cmon_idx _idx)
 {
-    assert(_idx < cmon_symbols_scope_child_count(_s, _scope));
-    return _get_scope(_s, _scope)->children[_idx];
+    _scope * scope = _get_scope(_s, _scope_idx);
+    assert(_idx < scope->children.count);
+    return scope->tree->children[scope->children.begin + _idx];
 }
 
 cmon_idx cmon_symbols_scope_module(cmon_symbols * _s, cmon_idx _scope)
@@ -408,7 +598,16 @@ cmon_idx cmon_symbols_scope_module(cmon_symbols * _s, cmon_idx _scope)
     return _get_scope(_s, _scope)->mod_idx;
 }
 
+cmon_interner * cmon_symbols_interner(cmon_symbols * _s)
+{
+    return _s->interner;
+}
+
 size_t cmon_symbols_count(cmon_symbols * _s)
 {
-    return cmon_dyn_arr_count(&_s->symbols);
+    size_t ret;
+    pthread_mutex_lock(&_s->mtx);
+    ret = cmon_blk_arr_count(&_s->symbols);
+    pthread_mutex_unlock(&_s->mtx);
+    return ret;
 }
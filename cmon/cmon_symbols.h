@@ -1,6 +1,7 @@
 #ifndef CMON_CMON_SYMBOLS_H
 #define CMON_CMON_SYMBOLS_H
 
+#include <cmon/cmon_interner.h>
 #include <cmon/cmon_modules.h>
 #include <cmon/cmon_src.h>
 
@@ -14,9 +15,13 @@ typedef enum
 
 typedef struct cmon_symbols cmon_symbols;
 
+// symbol names are keyed by their interned id. Pass the interner that was used to tokenize so
+// the ids of identifier tokens can be used for lookups directly. If _interner is NULL, cmon_symbols
+// creates its own.
 CMON_API cmon_symbols * cmon_symbols_create(cmon_allocator * _alloc,
                                             cmon_src * _src,
-                                            cmon_modules * _mods);
+                                            cmon_modules * _mods,
+                                            cmon_interner * _interner);
 CMON_API void cmon_symbols_destroy(cmon_symbols * _s);
 CMON_API cmon_idx cmon_symbols_scope_begin(cmon_symbols * _s, cmon_idx _scope, cmon_idx _mod_idx);
 CMON_API cmon_idx cmon_symbols_scope_end(cmon_symbols * _s, cmon_idx _scope);
@@ -75,10 +80,23 @@ CMON_API cmon_idx cmon_symbols_find_before(cmon_symbols * _s,
 CMON_API cmon_idx cmon_symbols_find_local(cmon_symbols * _s, cmon_idx _scope, cmon_str_view _name);
 CMON_API cmon_idx cmon_symbols_find(cmon_symbols * _s, cmon_idx _scope, cmon_str_view _name);
 
+// find symbols by interned name id, see cmon_symbols_interner
+CMON_API cmon_idx cmon_symbols_find_local_before_id(cmon_symbols * _s,
+                                                    cmon_idx _scope,
+                                                    cmon_idx _name_id,
+                                                    cmon_idx _tok);
+CMON_API cmon_idx cmon_symbols_find_before_id(cmon_symbols * _s,
+                                              cmon_idx _scope,
+                                              cmon_idx _name_id,
+                                              cmon_idx _tok);
+CMON_API cmon_idx cmon_symbols_find_local_id(cmon_symbols * _s, cmon_idx _scope, cmon_idx _name_id);
+CMON_API cmon_idx cmon_symbols_find_id(cmon_symbols * _s, cmon_idx _scope, cmon_idx _name_id);
+
 // get symbol info
 CMON_API cmon_symk cmon_symbols_kind(cmon_symbols * _s, cmon_idx _sym);
 CMON_API cmon_idx cmon_symbols_scope(cmon_symbols * _s, cmon_idx _sym);
 CMON_API cmon_str_view cmon_symbols_name(cmon_symbols * _s, cmon_idx _sym);
+CMON_API cmon_idx cmon_symbols_name_id(cmon_symbols * _s, cmon_idx _sym);
 CMON_API const char * cmon_symbols_unique_name(cmon_symbols * _s, cmon_idx _sym);
 CMON_API cmon_bool cmon_symbols_is_pub(cmon_symbols * _s, cmon_idx _sym);
 CMON_API cmon_idx cmon_symbols_src_file(cmon_symbols * _s, cmon_idx _sym);
@@ -103,6 +121,9 @@ CMON_API size_t cmon_symbols_scope_child_count(cmon_symbols * _s, cmon_idx _scop
 CMON_API cmon_idx cmon_symbols_scope_child(cmon_symbols * _s, cmon_idx _scope, cmon_idx _idx);
 CMON_API cmon_idx cmon_symbols_scope_module(cmon_symbols * _s, cmon_idx _scope);
 
+// Different modules can add scopes and symbols concurrently as long as every module only modifies
+// its own scopes. Lookups are lock free.
 CMON_API size_t cmon_symbols_count(cmon_symbols * _s);
+CMON_API cmon_interner * cmon_symbols_interner(cmon_symbols * _s);
 
 #endif // CMON_CMON_SYMBOLS_H
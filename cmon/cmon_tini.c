@@ -6,7 +6,6 @@
 #include <cmon/cmon_util.h>
 #include <cmon/cmon_fs.h>
 #include <setjmp.h>
-#include <stdarg.h>
 
 typedef enum
 {
@@ -313,45 +312,24 @@ static inline cmon_bool _is_valid_identifier(_tokparse * _t, cmon_idx _tok_idx)
     return cmon_true;
 }
 
-static inline cmon_bool _tokens_is_impl_v(_tokparse * _t, cmon_idx _idx, va_list _args)
-{
-    _tokk kind;
-    do
-    {
-        kind = va_arg(_args, _tokk);
-        if (_tok_kind(_t, _idx) == kind)
-            return cmon_true;
-    } while (kind != -1);
+// a set of _tokk kinds, one bit per kind
+typedef uint32_t _tokk_set;
 
-    return cmon_false;
-}
+#define _TOKK_BIT(_kind) ((_tokk_set)1 << (_kind))
+#define _TOKK_SET(...) _CMON_MAP_OR(_TOKK_BIT, __VA_ARGS__)
 
-static inline cmon_bool _tokens_is_impl(_tokparse * _t, cmon_idx _idx, ...)
+static inline cmon_bool _tokens_is_in(_tokparse * _t, cmon_idx _idx, _tokk_set _set)
 {
-    va_list args;
-    va_start(args, _idx);
-    cmon_idx ret = _tokens_is_impl_v(_t, _idx, args);
-    va_end(args);
-    return ret;
+    return (_set & _TOKK_BIT(_tok_kind(_t, _idx))) != 0;
 }
 
-static inline cmon_idx _tokens_accept_impl_v(_tokparse * _t, va_list _args)
+static inline cmon_idx _tokens_accept_in(_tokparse * _t, _tokk_set _set)
 {
-    if (_tokens_is_impl_v(_t, _t->tok_idx, _args))
+    if (_tokens_is_in(_t, _t->tok_idx, _set))
         return _token_advance(_t, cmon_true);
     return CMON_INVALID_IDX;
 }
 
-static inline cmon_idx _tokens_accept_impl(_tokparse * _t, ...)
-{
-    va_list args;
-    cmon_idx ret;
-    va_start(args, _t);
-    ret = _tokens_accept_impl_v(_t, args);
-    va_end(args);
-    return ret;
-}
-
 static inline const char * _tokk_to_str(_tokk _kind)
 {
     switch (_kind)
@@ -379,35 +357,27 @@ static inline const char * _tokk_to_str(_tokk _kind)
     }
 }
 
-static inline const char * _token_kinds_to_str(cmon_str_builder * _b, va_list _args)
+static inline const char * _token_kinds_to_str(cmon_str_builder * _b, _tokk_set _kinds)
 {
     _tokk kind;
     cmon_str_builder_clear(_b);
-    do
+    for (kind = 0; kind < _tokk_none; ++kind)
     {
-        kind = va_arg(_args, _tokk);
-        if (kind != -1)
-        {
-            if (cmon_str_builder_count(_b))
-                cmon_str_builder_append(_b, " or ");
-            cmon_str_builder_append_fmt(_b, "'%s'", _tokk_to_str(kind));
-        }
-    } while (kind != -1);
+        if (!(_kinds & _TOKK_BIT(kind)))
+            continue;
+        if (cmon_str_builder_count(_b))
+            cmon_str_builder_append(_b, " or ");
+        cmon_str_builder_append_fmt(_b, "'%s'", _tokk_to_str(kind));
+    }
     return cmon_str_builder_c_str(_b);
 }
 
-static inline cmon_idx _tok_check_impl(_tokparse * _t, ...)
+static inline cmon_idx _tok_check_impl(_tokparse * _t, _tokk_set _kinds)
 {
-    va_list args, cpy;
-    va_start(args, _t);
-    va_copy(cpy, args);
-    cmon_idx tok = _tokens_accept_impl_v(_t, args);
+    cmon_idx tok = _tokens_accept_in(_t, _kinds);
     if (!cmon_is_valid_idx(tok))
     {
-        const char * tk_kinds_str = _token_kinds_to_str(_t->tk_str_builder, cpy);
-        va_end(cpy);
-        va_end(args);
-
+        const char * tk_kinds_str = _token_kinds_to_str(_t->tk_str_builder, _kinds);
         cmon_idx cur = _t->tok_idx;
         if (_tok_kind(_t, cur) != _tokk_eof)
         {
@@ -420,18 +390,15 @@ static inline cmon_idx _tok_check_impl(_tokparse * _t, ...)
         }
     }
 
-    va_end(args);
     return tok;
 }
 
-#define _tok_is(_t, _idx, ...)                                                                     \
-    _tokens_is_impl((_t), _idx, _CMON_VARARG_APPEND_LAST(-1, __VA_ARGS__))
-#define _tok_is_current(_t, ...)                                                                   \
-    _tokens_is_impl((_t), (_t)->tok_idx, _CMON_VARARG_APPEND_LAST(-1, __VA_ARGS__))
-#define _tok_accept(_t, ...) _tokens_accept_impl((_t), _CMON_VARARG_APPEND_LAST(-1, __VA_ARGS__))
+#define _tok_is(_t, _idx, ...) _tokens_is_in((_t), _idx, _TOKK_SET(__VA_ARGS__))
+#define _tok_is_current(_t, ...) _tokens_is_in((_t), (_t)->tok_idx, _TOKK_SET(__VA_ARGS__))
+#define _tok_accept(_t, ...) _tokens_accept_in((_t), _TOKK_SET(__VA_ARGS__))
 #define _tok_accept_ot(_t, _out_tok, ...)                                                          \
-    (cmon_is_valid_idx(*(_out_tok) = _tokens_accept_impl((_t), __VA_ARGS__)))
-#define _tok_check(_t, ...) _tok_check_impl((_t), _CMON_VARARG_APPEND_LAST(-1, __VA_ARGS__))
+    (cmon_is_valid_idx(*(_out_tok) = _tok_accept((_t), __VA_ARGS__)))
+#define _tok_check(_t, ...) _tok_check_impl((_t), _TOKK_SET(__VA_ARGS__))
 
 static inline cmon_idx _add_node(_tokparse * _t, cmon_tinik _kind, cmon_idx _data)
 {
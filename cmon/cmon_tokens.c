@@ -1,8 +1,9 @@
 #include <cmon/cmon_dyn_arr.h>
 #include <cmon/cmon_err_report.h>
+#include <cmon/cmon_interner.h>
+#include <cmon/cmon_scan.h>
 #include <cmon/cmon_str_builder.h>
 #include <cmon/cmon_tokens.h>
-#include <stdarg.h>
 
 //@TODO: a lot of this is pretty messy, especially how kinds/token are separate right now (which is
 // good, but a lot of the code can be a lot nicer). i.e. instead of having some stuff live in
@@ -16,52 +17,62 @@
         cmon_str_builder_clear(_l->tmp_str_b);                                                     \
         cmon_str_builder_append_fmt(_l->tmp_str_b, _msg, ##__VA_ARGS__);                           \
         _l->err = cmon_err_report_make(_l->src_file_idx,                                           \
-                                       cmon_dyn_arr_count(&_l->tokens),                            \
-                                       cmon_dyn_arr_count(&_l->tokens),                            \
-                                       cmon_dyn_arr_count(&_l->tokens),                            \
+                                       _l->tok_base + cmon_dyn_arr_count(&_l->kinds),              \
+                                       _l->tok_base + cmon_dyn_arr_count(&_l->kinds),              \
+                                       _l->tok_base + cmon_dyn_arr_count(&_l->kinds),              \
                                        cmon_str_builder_c_str(_l->tmp_str_b));                     \
     } while (0)
 
+// the token that is currently being lexed, only used during tokenization
 typedef struct
 {
-    cmon_idx line;
-    cmon_idx line_end;
-    cmon_idx line_off;
     cmon_str_view str_view;
+    // interned name of identifiers, CMON_INVALID_IDX for all other tokens
+    cmon_idx str_id;
     // true if the token is preceeded by a new line
     cmon_bool follows_nl;
 } _token;
 
-typedef struct
-{
-    cmon_idx tok_begin, tok_end;
-    cmon_str_view str_view;
-} _line;
+// all token kinds fit into 7 bits, the remaining bit of the kind array stores follows_nl
+#define _KIND_MASK 0x7F
+#define _FOLLOWS_NL_BIT 0x80
+#define _NO_STR_ID UINT32_MAX
 
+//@NOTE: tokens are stored as a struct of arrays with 32 bit byte offsets into the code. Line numbers
+// and columns are only needed for diagnostics, so they are computed from a newline index that is
+// built the first time they are asked for.
 typedef struct cmon_tokens
 {
     cmon_allocator * alloc;
-    cmon_dyn_arr(cmon_tokk) kinds;
-    cmon_dyn_arr(_token) tokens;
-    cmon_dyn_arr(_line) lines;
+    const char * code;
+    size_t code_len;
+    cmon_dyn_arr(uint8_t) kinds;
+    cmon_dyn_arr(uint32_t) offsets;
+    cmon_dyn_arr(uint32_t) lens;
+    cmon_dyn_arr(uint32_t) str_ids;
+    // byte offset of the first character of each line, NULL until needed
+    cmon_dyn_arr(uint32_t) line_starts;
     cmon_idx tok_idx;
+    // the token that stopped the lexer with an error, no tokens after it were lexed
+    cmon_idx err_tok_idx;
 } cmon_tokens;
 
 typedef struct
 {
     cmon_allocator * alloc;
     cmon_src * src;
+    cmon_interner * interner;
+    const cmon_scanner * scan;
     cmon_idx src_file_idx;
     const char * input;
     const char * pos;
     const char * end;
-    const char * line_start;
-    cmon_idx line_tok_start;
-    cmon_dyn_arr(cmon_tokk) kinds;
-    cmon_dyn_arr(_token) tokens;
-    cmon_dyn_arr(_line) lines;
-    cmon_idx current_line;
-    cmon_idx current_line_off;
+    cmon_dyn_arr(uint8_t) kinds;
+    cmon_dyn_arr(uint32_t) offsets;
+    cmon_dyn_arr(uint32_t) lens;
+    cmon_dyn_arr(uint32_t) str_ids;
+    // index of the first lexed token in the final token list, only non zero when re-tokenizing
+    size_t tok_base;
     cmon_err_report err;
     cmon_str_builder * tmp_str_b;
 } _tokenize_session;
@@ -69,113 +80,197 @@ typedef struct
 static inline void _advance_pos(_tokenize_session * _l, size_t _advance)
 {
     _l->pos += _advance;
-    _l->current_line_off += _advance;
 }
 
-static inline void _finish_current_line(_tokenize_session * _l, cmon_bool _is_last_line, _token * _current)
+static inline void _advance_to(_tokenize_session * _l, const char * _pos)
 {
-    const char * end = _is_last_line ? _l->end : _l->pos;
+    _advance_pos(_l, _pos - _l->pos);
+}
+
+// most whitespace runs and identifiers are short. Checking the first few bytes inline avoids the
+// call into the vectorized scanner for those.
+#define _SCAN_INLINE_COUNT 8
 
-    //this is a little messy to accomodate tokens that span over multiple lines.
-    cmon_dyn_arr_append(&_l->lines,
-                        ((_line){ _l->line_tok_start,
-                                  _current ? cmon_dyn_arr_count(&_l->tokens) + 1 : cmon_dyn_arr_count(&_l->tokens),
-                                  (cmon_str_view){ _l->line_start, end } }));
-    _l->line_start = _l->pos + 1;
-    _l->line_tok_start = cmon_dyn_arr_count(&_l->tokens);
+static inline const char * _skip_blanks(_tokenize_session * _l)
+{
+    const char * p = _l->pos;
+    const char * e = CMON_MIN(_l->end, p + _SCAN_INLINE_COUNT);
+    while (p < e && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\v' || *p == '\f'))
+        ++p;
+    return p < e ? p : _l->scan->skip_blanks(p, _l->end);
 }
 
-static inline void _advance_line(_tokenize_session * _l, _token * _current)
+static inline const char * _ident_end(_tokenize_session * _l)
 {
-    _finish_current_line(_l, cmon_false, _current);
-    ++_l->current_line;
-    _l->current_line_off = 0;
+    const char * p = _l->pos;
+    const char * e = CMON_MIN(_l->end, p + _SCAN_INLINE_COUNT);
+    while (p < e && CMON_SCAN_IS_IDENT(*p))
+        ++p;
+    return p < e ? p : _l->scan->ident_end(p, _l->end);
 }
 
 static inline size_t _skip_whitespace(_tokenize_session * _l)
 {
     size_t count = 0;
-    while (isspace(*_l->pos))
+    while (1)
     {
-        if (*_l->pos == '\n')
-        {
-            _advance_line(_l, NULL);
-            ++count;
-        }
+        _advance_to(_l, _skip_blanks(_l));
+        if (_l->pos >= _l->end || *_l->pos != '\n')
+            break;
+        ++count;
         _advance_pos(_l, 1);
     }
     return count;
 }
 
-static inline cmon_bool _name_equals(const char * _begin, int _len, const char * _keyword)
-{
-    return strncmp(_begin, _keyword, CMON_MAX(_len, strlen(_keyword))) == 0;
-}
+// compares the remaining characters of a name whose length and first character already matched
+#define _kw_rest(_begin, _kw) (memcmp((_begin) + 1, (_kw) + 1, sizeof(_kw) - 2) == 0)
 
+// keywords are identified by switching on their length and first character, which leaves at most two
+// candidates that need a memcmp. Most identifiers are rejected without comparing any characters.
+// This needs to be kept in sync with the keyword tokens in cmon_tokk.
 static cmon_tokk _tok_kind_for_name(const char * _begin, const char * _end)
 {
-    int len = _end - _begin;
-
-    if (_name_equals(_begin, len, "if"))
-        return cmon_tokk_if;
-    else if (_name_equals(_begin, len, "else"))
-        return cmon_tokk_else;
-    else if (_name_equals(_begin, len, "fn"))
-        return cmon_tokk_fn;
-    else if (_name_equals(_begin, len, "return"))
-        return cmon_tokk_return;
-    else if (_name_equals(_begin, len, "break"))
-        return cmon_tokk_break;
-    else if (_name_equals(_begin, len, "and"))
-        return cmon_tokk_and;
-    else if (_name_equals(_begin, len, "or"))
-        return cmon_tokk_or;
-    else if (_name_equals(_begin, len, "struct"))
-        return cmon_tokk_struct;
-    else if (_name_equals(_begin, len, "true"))
-        return cmon_tokk_true;
-    else if (_name_equals(_begin, len, "false"))
-        return cmon_tokk_false;
-    else if (_name_equals(_begin, len, "mut"))
-        return cmon_tokk_mut;
-    else if (_name_equals(_begin, len, "pub"))
-        return cmon_tokk_pub;
-    else if (_name_equals(_begin, len, "as"))
-        return cmon_tokk_as;
-    else if (_name_equals(_begin, len, "in"))
-        return cmon_tokk_in;
-    else if (_name_equals(_begin, len, "for"))
-        return cmon_tokk_for;
-    else if (_name_equals(_begin, len, "module"))
-        return cmon_tokk_module;
-    else if (_name_equals(_begin, len, "import"))
-        return cmon_tokk_import;
-    else if (_name_equals(_begin, len, "none"))
-        return cmon_tokk_none;
-    else if (_name_equals(_begin, len, "embed"))
-        return cmon_tokk_embed;
-    else if (_name_equals(_begin, len, "interface"))
-        return cmon_tokk_interface;
-    else if (_name_equals(_begin, len, "self"))
-        return cmon_tokk_self;
-    else if (_name_equals(_begin, len, "type"))
-        return cmon_tokk_type;
-    else if (_name_equals(_begin, len, "alias"))
-        return cmon_tokk_alias;
-    else if (_name_equals(_begin, len, "defer"))
-        return cmon_tokk_defer;
-    else if (_name_equals(_begin, len, "try"))
-        return cmon_tokk_try;
-    else if (_name_equals(_begin, len, "continue"))
-        return cmon_tokk_continue;
-    else if (_name_equals(_begin, len, "scoped"))
-        return cmon_tokk_scoped;
-    else if (_name_equals(_begin, len, "scope_exit"))
-        return cmon_tokk_scope_exit;
+    switch (_end - _begin)
+    {
+    case 2:
+        switch (_begin[0])
+        {
+        case 'i':
+            if (_begin[1] == 'f')
+                return cmon_tokk_if;
+            if (_begin[1] == 'n')
+                return cmon_tokk_in;
+            break;
+        case 'f':
+            if (_begin[1] == 'n')
+                return cmon_tokk_fn;
+            break;
+        case 'o':
+            if (_begin[1] == 'r')
+                return cmon_tokk_or;
+            break;
+        case 'a':
+            if (_begin[1] == 's')
+                return cmon_tokk_as;
+            break;
+        }
+        break;
+    case 3:
+        switch (_begin[0])
+        {
+        case 'a':
+            if (_kw_rest(_begin, "and"))
+                return cmon_tokk_and;
+            break;
+        case 'm':
+            if (_kw_rest(_begin, "mut"))
+                return cmon_tokk_mut;
+            break;
+        case 'p':
+            if (_kw_rest(_begin, "pub"))
+                return cmon_tokk_pub;
+            break;
+        case 'f':
+            if (_kw_rest(_begin, "for"))
+                return cmon_tokk_for;
+            break;
+        case 't':
+            if (_kw_rest(_begin, "try"))
+                return cmon_tokk_try;
+            break;
+        }
+        break;
+    case 4:
+        switch (_begin[0])
+        {
+        case 'e':
+            if (_kw_rest(_begin, "else"))
+                return cmon_tokk_else;
+            break;
+        case 't':
+            if (_kw_rest(_begin, "true"))
+                return cmon_tokk_true;
+            if (_kw_rest(_begin, "type"))
+                return cmon_tokk_type;
+            break;
+        case 'n':
+            if (_kw_rest(_begin, "none"))
+                return cmon_tokk_none;
+            break;
+        case 's':
+            if (_kw_rest(_begin, "self"))
+                return cmon_tokk_self;
+            break;
+        }
+        break;
+    case 5:
+        switch (_begin[0])
+        {
+        case 'b':
+            if (_kw_rest(_begin, "break"))
+                return cmon_tokk_break;
+            break;
+        case 'f':
+            if (_kw_rest(_begin, "false"))
+                return cmon_tokk_false;
+            break;
+        case 'e':
+            if (_kw_rest(_begin, "embed"))
+                return cmon_tokk_embed;
+            break;
+        case 'a':
+            if (_kw_rest(_begin, "alias"))
+                return cmon_tokk_alias;
+            break;
+        case 'd':
+            if (_kw_rest(_begin, "defer"))
+                return cmon_tokk_defer;
+            break;
+        }
+        break;
+    case 6:
+        switch (_begin[0])
+        {
+        case 'r':
+            if (_kw_rest(_begin, "return"))
+                return cmon_tokk_return;
+            break;
+        case 's':
+            if (_kw_rest(_begin, "struct"))
+                return cmon_tokk_struct;
+            if (_kw_rest(_begin, "scoped"))
+                return cmon_tokk_scoped;
+            break;
+        case 'm':
+            if (_kw_rest(_begin, "module"))
+                return cmon_tokk_module;
+            break;
+        case 'i':
+            if (_kw_rest(_begin, "import"))
+                return cmon_tokk_import;
+            break;
+        }
+        break;
+    case 8:
+        if (_begin[0] == 'c' && _kw_rest(_begin, "continue"))
+            return cmon_tokk_continue;
+        break;
+    case 9:
+        if (_begin[0] == 'i' && _kw_rest(_begin, "interface"))
+            return cmon_tokk_interface;
+        break;
+    case 10:
+        if (_begin[0] == 's' && _kw_rest(_begin, "scope_exit"))
+            return cmon_tokk_scope_exit;
+        break;
+    }
 
     return cmon_tokk_ident;
 }
 
+#undef _kw_rest
+
 static cmon_bool _peek_float_lit(_tokenize_session * _l)
 {
     const char * pos = _l->pos + 1;
@@ -289,8 +384,7 @@ static cmon_bool _next_token(_tokenize_session * _l, cmon_tokk * _out_kind, _tok
         return cmon_false;
 
     _out_tok->str_view.begin = _l->pos;
-    _out_tok->line = _l->current_line;
-    _out_tok->line_off = _l->current_line_off;
+    _out_tok->str_id = CMON_INVALID_IDX;
 
     if (*_l->pos == '{')
         return _finalize_tok(_l, cmon_tokk_curl_open, 1, _out_kind, _out_tok);
@@ -426,12 +520,7 @@ static cmon_bool _next_token(_tokenize_session * _l, cmon_tokk * _out_kind, _tok
         // assert(0);
         char marks = *_l->pos;
         _advance_pos(_l, 1);
-        while (*_l->pos != marks && _l->pos != _l->end)
-        {
-            // if (*_l->pos == '\n')
-            //     _advance_line(_l);
-            _advance_pos(_l, 1);
-        }
+        _advance_to(_l, _l->scan->find_any3(_l->pos, _l->end, marks, marks, marks));
         *_out_kind = cmon_tokk_string;
         _out_tok->str_view.end = _l->pos;
         _advance_pos(_l, 1); // skip closing "
@@ -442,10 +531,7 @@ static cmon_bool _next_token(_tokenize_session * _l, cmon_tokk * _out_kind, _tok
         // single line comment
         if (_next_char_is(_l, '/'))
         {
-            while (*_l->pos != '\n' && _l->pos != _l->end)
-            {
-                _advance_pos(_l, 1);
-            }
+            _advance_to(_l, _l->scan->find_any3(_l->pos, _l->end, '\n', '\n', '\n'));
             *_out_kind = cmon_tokk_comment;
             _out_tok->str_view.end = _l->pos;
             return cmon_true;
@@ -457,6 +543,11 @@ static cmon_bool _next_token(_tokenize_session * _l, cmon_tokk * _out_kind, _tok
             _advance_pos(_l, 2);
             while (openings_to_match > 0 && _l->pos != _l->end)
             {
+                // jump to the next character that can open or close a comment
+                _advance_to(_l, _l->scan->find_any3(_l->pos, _l->end, '*', '/', '/'));
+                if (_l->pos == _l->end)
+                    break;
+
                 if (*_l->pos == '*' && _next_char_is(_l, '/'))
                 {
                     --openings_to_match;
@@ -469,8 +560,6 @@ static cmon_bool _next_token(_tokenize_session * _l, cmon_tokk * _out_kind, _tok
                 }
                 else
                 {
-                    if (*_l->pos == '\n')
-                        _advance_line(_l, _out_tok);
                     _advance_pos(_l, 1);
                 }
             }
@@ -480,7 +569,6 @@ static cmon_bool _next_token(_tokenize_session * _l, cmon_tokk * _out_kind, _tok
 
             *_out_kind = cmon_tokk_comment;
             _out_tok->str_view.end = _l->pos;
-            _out_tok->line_end = _l->current_line;
 
             return cmon_true;
         }
@@ -500,11 +588,15 @@ static cmon_bool _next_token(_tokenize_session * _l, cmon_tokk * _out_kind, _tok
         const char * startp = _l->pos;
         if (isalpha(*_l->pos) || *_l->pos == '_')
         {
-            while (isalnum(*_l->pos) || *_l->pos == '_')
-                _advance_pos(_l, 1);
+            _advance_to(_l, _ident_end(_l));
 
             // this will set it to either cmon_tok_type_ident or the correct keyword token type
             *_out_kind = _tok_kind_for_name(startp, _l->pos);
+            if (*_out_kind == cmon_tokk_ident && _l->interner)
+            {
+                _out_tok->str_id =
+                    cmon_interner_intern(_l->interner, (cmon_str_view){ startp, _l->pos });
+            }
         }
         // integer or float
         //@TODO: Make this work for hex, octal, scientific float notation etc.
@@ -533,95 +625,132 @@ static inline cmon_tokens * _tokens_create(cmon_allocator * _alloc)
 {
     cmon_tokens * ret = CMON_CREATE(_alloc, cmon_tokens);
     ret->alloc = _alloc;
+    ret->code = NULL;
+    ret->code_len = 0;
     ret->kinds = NULL;
-    ret->tokens = NULL;
-    ret->lines = NULL;
+    ret->offsets = NULL;
+    ret->lens = NULL;
+    ret->str_ids = NULL;
+    ret->line_starts = NULL;
     ret->tok_idx = CMON_INVALID_IDX;
+    ret->err_tok_idx = CMON_INVALID_IDX;
     return ret;
 }
 
+//@NOTE: Typical cmon code has around 3.3 bytes per token (less for dense expressions, a lot more
+// for comment heavy code). Reserving for 3 bytes per token means the token arrays of a whole file
+// are allocated once without having to grow in most cases.
+#define _BYTES_PER_TOKEN_ESTIMATE 3
+
 static inline void _tokenize_session_init(_tokenize_session * _s,
                                           cmon_allocator * _alloc,
                                           cmon_src * _src,
-                                          cmon_idx _src_file_idx)
+                                          cmon_interner * _interner,
+                                          cmon_idx _src_file_idx,
+                                          cmon_bool _whole_file)
 {
+    size_t cap;
     const char * code;
     code = cmon_src_code(_src, _src_file_idx);
 
     _s->alloc = _alloc;
     _s->src = _src;
+    _s->interner = _interner;
+    _s->scan = cmon_scanner_get();
     _s->src_file_idx = _src_file_idx;
     _s->input = code;
     _s->pos = code;
     _s->end = code + strlen(code);
-    _s->line_start = code;
-    _s->line_tok_start = 0;
-    _s->current_line = 1;
-    _s->current_line_off = 1;
-    cmon_dyn_arr_init(&_s->kinds, _alloc, 128);
-    cmon_dyn_arr_init(&_s->tokens, _alloc, 128);
-    cmon_dyn_arr_init(&_s->lines, _alloc, 32);
+    // when retokenizing only the tokens around an edit are lexed again
+    cap = _whole_file ? CMON_MAX(128, (_s->end - _s->input) / _BYTES_PER_TOKEN_ESTIMATE + 1) : 128;
+    cmon_dyn_arr_init(&_s->kinds, _alloc, cap);
+    cmon_dyn_arr_init(&_s->offsets, _alloc, cap);
+    cmon_dyn_arr_init(&_s->lens, _alloc, cap);
+    cmon_dyn_arr_init(&_s->str_ids, _alloc, cap);
+    _s->tok_base = 0;
     _s->err = cmon_err_report_make_empty();
     //@TODO: lazy init the string builder only on error
     _s->tmp_str_b = cmon_str_builder_create(_alloc, 512);
 }
 
-static inline void _tokenize_session_dealloc(_tokenize_session * _s, cmon_bool _was_successful)
+static inline void _tokenize_session_dealloc(_tokenize_session * _s)
 {
-    // if tokenization was successful, some ownership was moved to cmon_tokens, in that case we
-    // don't free it
-    // if (!_was_successful)
-    // {
-    //     cmon_dyn_arr_dealloc(&_s->lines);
-    //     cmon_dyn_arr_dealloc(&_s->tokens);
-    //     cmon_dyn_arr_dealloc(&_s->kinds);
-    // }
+    // the token arrays are owned by cmon_tokens now
     cmon_str_builder_destroy(_s->tmp_str_b);
 }
 
+// index of the token that caused an error after the eof token was appended
+static inline cmon_idx _err_tok_idx(_tokenize_session * _s)
+{
+    if (cmon_err_report_is_empty(&_s->err))
+        return CMON_INVALID_IDX;
+    return _s->tok_base + cmon_dyn_arr_count(&_s->kinds) -
+           CMON_MIN(cmon_dyn_arr_count(&_s->kinds), 2);
+}
+
+static inline void _append_token(_tokenize_session * _s, cmon_tokk _kind, _token * _tok)
+{
+    cmon_dyn_arr_append(&_s->kinds, (uint8_t)_kind | (_tok->follows_nl ? _FOLLOWS_NL_BIT : 0));
+    cmon_dyn_arr_append(&_s->offsets, (uint32_t)(_tok->str_view.begin - _s->input));
+    cmon_dyn_arr_append(&_s->lens, (uint32_t)(_tok->str_view.end - _tok->str_view.begin));
+    cmon_dyn_arr_append(&_s->str_ids,
+                        cmon_is_valid_idx(_tok->str_id) ? (uint32_t)_tok->str_id : _NO_STR_ID);
+}
+
 cmon_tokens * cmon_tokenize(cmon_allocator * _alloc,
                             cmon_src * _src,
                             cmon_idx _src_file_idx,
                             cmon_err_report * _out_err)
+{
+    return cmon_tokenize_with_interner(_alloc, _src, NULL, _src_file_idx, _out_err);
+}
+
+cmon_tokens * cmon_tokenize_with_interner(cmon_allocator * _alloc,
+                                          cmon_src * _src,
+                                          cmon_interner * _interner,
+                                          cmon_idx _src_file_idx,
+                                          cmon_err_report * _out_err)
 {
     _token tok;
     cmon_tokk kind;
     _tokenize_session s;
 
-    _tokenize_session_init(&s, _alloc, _src, _src_file_idx);
+    _tokenize_session_init(&s, _alloc, _src, _interner, _src_file_idx, cmon_true);
     cmon_tokens * ret = _tokens_create(_alloc);
+
+    if (s.end - s.input >= UINT32_MAX)
+    {
+        _err((&s), "source files larger than 4GB are not supported");
+        s.pos = s.end;
+    }
+
     while (_next_token(&s, &kind, &tok))
     {
         // sanity check. tokens can't consume no characters
         // assert(tok.str_view.begin < tok.str_view.end);
-        cmon_dyn_arr_append(&s.kinds, kind);
-        cmon_dyn_arr_append(&s.tokens, tok);
+        _append_token(&s, kind, &tok);
 
         if (!cmon_err_report_is_empty(&s.err))
             break;
     }
 
-    _finish_current_line(&s, cmon_true, NULL);
-
     tok.str_view.begin = s.end;
     tok.str_view.end = s.end;
-    cmon_dyn_arr_append(&s.kinds, cmon_tokk_eof);
-    cmon_dyn_arr_append(&s.tokens, tok);
+    tok.str_id = CMON_INVALID_IDX;
+    tok.follows_nl = cmon_false;
+    _append_token(&s, cmon_tokk_eof, &tok);
 
     ret->tok_idx = 0;
+    ret->err_tok_idx = _err_tok_idx(&s);
+    ret->code = s.input;
+    ret->code_len = s.end - s.input;
     ret->kinds = s.kinds;
-    ret->tokens = s.tokens;
-    ret->lines = s.lines;
-
-    // printf("DA FOCKING LINES %lu %lu\n", cmon_dyn_arr_count(&s.lines), cmon_dyn_arr_count(&s.tokens));
-    // for (size_t i = 0; i < cmon_dyn_arr_count(&s.lines); ++i)
-    // {
-    //     printf("%lu: %.*s (tok count: %lu %lu)\n", i + 1, s.lines[i].str_view.end - s.lines[i].str_view.begin, s.lines[i].str_view.begin, s.lines[i].tok_begin, s.lines[i].tok_end);
-    // }
-    // printf("\n\n");
+    ret->offsets = s.offsets;
+    ret->lens = s.lens;
+    ret->str_ids = s.str_ids;
 
     *_out_err = s.err;
-    _tokenize_session_dealloc(&s, ret != NULL);
+    _tokenize_session_dealloc(&s);
     return ret;
 }
 
@@ -629,12 +758,16 @@ void cmon_tokens_destroy(cmon_tokens * _t)
 {
     if (!_t)
         return;
-    cmon_dyn_arr_dealloc(&_t->lines);
-    cmon_dyn_arr_dealloc(&_t->tokens);
+    cmon_dyn_arr_dealloc(&_t->line_starts);
+    cmon_dyn_arr_dealloc(&_t->str_ids);
+    cmon_dyn_arr_dealloc(&_t->lens);
+    cmon_dyn_arr_dealloc(&_t->offsets);
     cmon_dyn_arr_dealloc(&_t->kinds);
     CMON_DESTROY(_t->alloc, _t);
 }
 
+#define _kind_at(_t, _idx) ((cmon_tokk)((_t)->kinds[(_idx)] & _KIND_MASK))
+
 size_t cmon_tokens_count(cmon_tokens * _t)
 {
     return cmon_dyn_arr_count(&_t->kinds);
@@ -646,7 +779,7 @@ cmon_idx cmon_tokens_prev(cmon_tokens * _t, cmon_bool _skip_comments)
     while (ret > 0)
     {
         --ret;
-        if (!_skip_comments || _t->kinds[ret] != cmon_tokk_comment)
+        if (!_skip_comments || _kind_at(_t, ret) != cmon_tokk_comment)
             return ret;
     }
 
@@ -661,10 +794,10 @@ cmon_idx cmon_tokens_current(cmon_tokens * _t)
 static inline cmon_idx _inline_next(cmon_tokens * _t, cmon_bool _skip_comments)
 {
     size_t ret = _t->tok_idx;
-    while (ret < cmon_dyn_arr_count(&_t->tokens))
+    while (ret < cmon_dyn_arr_count(&_t->kinds))
     {
         ++ret;
-        if (!_skip_comments || _t->kinds[ret] != cmon_tokk_comment)
+        if (!_skip_comments || _kind_at(_t, ret) != cmon_tokk_comment)
             return ret;
     }
 
@@ -685,8 +818,8 @@ cmon_idx cmon_tokens_advance(cmon_tokens * _t, cmon_bool _skip_comments)
     return ret;
 }
 
-#define _get_token(_t, _idx) (assert(_idx < cmon_dyn_arr_count(&_t->tokens)), _t->tokens[_idx])
-#define _get_kind(_t, _idx) (assert(_idx < cmon_dyn_arr_count(&_t->kinds)), _t->kinds[_idx])
+#define _check_idx(_t, _idx) assert((_idx) < cmon_dyn_arr_count(&(_t)->kinds))
+#define _get_kind(_t, _idx) (_check_idx(_t, _idx), _kind_at(_t, _idx))
 
 cmon_tokk cmon_tokens_kind(cmon_tokens * _t, cmon_idx _idx)
 {
@@ -695,131 +828,320 @@ cmon_tokk cmon_tokens_kind(cmon_tokens * _t, cmon_idx _idx)
 
 cmon_str_view cmon_tokens_str_view(cmon_tokens * _t, cmon_idx _idx)
 {
-    return _get_token(_t, _idx).str_view;
+    _check_idx(_t, _idx);
+    const char * begin = _t->code + _t->offsets[_idx];
+    return (cmon_str_view){ begin, begin + _t->lens[_idx] };
+}
+
+cmon_idx cmon_tokens_str_id(cmon_tokens * _t, cmon_idx _idx)
+{
+    _check_idx(_t, _idx);
+    return _t->str_ids[_idx] == _NO_STR_ID ? CMON_INVALID_IDX : _t->str_ids[_idx];
+}
+
+static inline void _ensure_line_starts(cmon_tokens * _t)
+{
+    const cmon_scanner * scan;
+    const char * pos;
+    const char * end;
+
+    if (_t->line_starts)
+        return;
+
+    scan = cmon_scanner_get();
+    cmon_dyn_arr_init(&_t->line_starts, _t->alloc, 64);
+    cmon_dyn_arr_append(&_t->line_starts, 0);
+    pos = _t->code;
+    end = _t->code + _t->code_len;
+    while ((pos = scan->find_any3(pos, end, '\n', '\n', '\n')) != end)
+    {
+        ++pos;
+        cmon_dyn_arr_append(&_t->line_starts, (uint32_t)(pos - _t->code));
+    }
+}
+
+static inline size_t _line_count(cmon_tokens * _t)
+{
+    _ensure_line_starts(_t);
+    return cmon_dyn_arr_count(&_t->line_starts);
+}
+
+// byte offset of the first character of a line (starting at 1) and of the new line that ends it
+static inline uint32_t _line_begin(cmon_tokens * _t, cmon_idx _line)
+{
+    assert(_line > 0 && _line <= _line_count(_t));
+    return _t->line_starts[_line - 1];
+}
+
+static inline uint32_t _line_end(cmon_tokens * _t, cmon_idx _line)
+{
+    assert(_line > 0 && _line <= _line_count(_t));
+    return _line < _line_count(_t) ? _t->line_starts[_line] - 1 : _t->code_len;
+}
+
+// index of the first element in a sorted array that is greater than _val
+static inline size_t _upper_bound(uint32_t * _arr, size_t _count, uint32_t _val)
+{
+    size_t lo = 0, hi = _count;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (_arr[mid] <= _val)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
 }
 
 cmon_idx cmon_tokens_line(cmon_tokens * _t, cmon_idx _idx)
 {
-    return _get_token(_t, _idx).line;
+    _check_idx(_t, _idx);
+    _ensure_line_starts(_t);
+    // the line is the number of line starts before the token
+    return _upper_bound(
+        _t->line_starts, cmon_dyn_arr_count(&_t->line_starts), _t->offsets[_idx]);
+}
+
+// tokens overlapping a line are the ones that end after the line begins (or begin on it if they
+// are empty) up to the last one that begins before the line ends. Tokens can span multiple lines
+// (i.e. multiline comments), in that case they are part of all of them.
+static inline cmon_idx _line_tok_begin(cmon_tokens * _t, cmon_idx _line)
+{
+    uint32_t begin = _line_begin(_t, _line);
+    size_t lo = 0, hi = cmon_dyn_arr_count(&_t->kinds);
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if (_t->offsets[mid] + _t->lens[mid] <= begin && _t->offsets[mid] < begin)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
 }
 
-static inline _line * _get_line(cmon_tokens * _t, cmon_idx _l)
+static inline cmon_idx _line_tok_end(cmon_tokens * _t, cmon_idx _line)
 {
-    assert(_l <= cmon_dyn_arr_count(&_t->lines));
-    return &_t->lines[_l - 1];
+    return _upper_bound(_t->offsets, cmon_dyn_arr_count(&_t->kinds), _line_end(_t, _line));
 }
 
 size_t cmon_tokens_line_token_count(cmon_tokens * _t, cmon_idx _l)
 {
-    _line * l = _get_line(_t, _l);
-    return l->tok_end - l->tok_begin;
+    cmon_idx begin = _line_tok_begin(_t, _l);
+    cmon_idx end = _line_tok_end(_t, _l);
+    return end > begin ? end - begin : 0;
 }
 
 cmon_idx cmon_tokens_line_token(cmon_tokens * _t, cmon_idx _l, size_t _toki)
 {
-    _line * l = _get_line(_t, _l);
     assert(_toki < cmon_tokens_line_token_count(_t, _l));
-    return l->tok_begin + _toki;
+    return _line_tok_begin(_t, _l) + _toki;
 }
 
-// size_t cmon_tokens_line_count(cmon_tokens * _t, cmon_idx _idx)
-// {
-//     cmon_idx next_idx = _idx + 1;
-//     if (next_idx < cmon_dyn_arr_count(&_t->kinds))
-//     {
-//         size_t a = cmon_tokens_line(_t, _idx);
-//         cmon_str_view sv = cmon_tokens_str_view(_t, _idx);
-//         size_t count = 0;
-//         while (_t->lines[a - 1].str_view.begin <= sv.end)
-//         {
-//             ++count;
-//             ++a;
-//         }
-//         return count;
-//     }
-//     return 1;
-// }
-
 cmon_idx cmon_tokens_line_offset(cmon_tokens * _t, cmon_idx _idx)
 {
-    return _get_token(_t, _idx).line_off;
+    // columns start at 1
+    return _t->offsets[_idx] - _line_begin(_t, cmon_tokens_line(_t, _idx)) + 1;
 }
 
 cmon_bool cmon_tokens_follows_nl(cmon_tokens * _t, cmon_idx _idx)
 {
-    return _get_token(_t, _idx).follows_nl;
+    _check_idx(_t, _idx);
+    return (_t->kinds[_idx] & _FOLLOWS_NL_BIT) != 0;
 }
 
-static inline cmon_bool _is_impl_v(cmon_tokens * _t, cmon_idx _idx, va_list _args)
+// index of the first element in a sorted array that is not less than _val
+static inline size_t _lower_bound(uint32_t * _arr, size_t _count, uint32_t _val)
 {
-    cmon_tokk kind;
-    do
+    size_t lo = 0, hi = _count;
+    while (lo < hi)
     {
-        kind = va_arg(_args, cmon_tokk);
-        if (_get_kind(_t, _idx) == kind)
-            return cmon_true;
-    } while (kind != -1);
-
-    return cmon_false;
+        size_t mid = lo + (hi - lo) / 2;
+        if (_arr[mid] < _val)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
 }
 
-cmon_bool cmon_tokens_is_impl_v(cmon_tokens * _t, cmon_idx _idx, va_list _args)
+// replaces the elements [_first, _old_end) of a token array with _count elements from _vals
+#define _splice(_arr, _first, _old_end, _vals, _count)                                             \
+    do                                                                                             \
+    {                                                                                              \
+        size_t _old_count = cmon_dyn_arr_count(_arr);                                             \
+        size_t _tail = _old_count - (_old_end);                                                    \
+        size_t _new_count = (_first) + (_count) + _tail;                                           \
+        if (_new_count > _old_count)                                                               \
+            cmon_dyn_arr_resize(_arr, _new_count);                                                 \
+        memmove(&(*(_arr))[(_first) + (_count)], &(*(_arr))[_old_end], _tail * sizeof(**(_arr)));  \
+        memcpy(&(*(_arr))[_first], (_vals), (_count) * sizeof(**(_arr)));                          \
+        cmon_dyn_arr_resize(_arr, _new_count);                                                     \
+    } while (0)
+
+// length of the code a token covers, string tokens don't include their closing mark
+static inline uint32_t _tok_extent(uint8_t _kind, uint32_t _len)
 {
-    return _is_impl_v(_t, _idx, _args);
+    return (_kind & _KIND_MASK) == cmon_tokk_string ? _len + 1 : _len;
 }
 
-cmon_bool cmon_tokens_is_impl(cmon_tokens * _t, cmon_idx _idx, ...)
+void cmon_tokens_retokenize(cmon_tokens * _t,
+                            cmon_src * _src,
+                            cmon_interner * _interner,
+                            cmon_idx _src_file_idx,
+                            size_t _edit_begin,
+                            size_t _edit_end,
+                            size_t _new_len,
+                            cmon_tokens_edit * _out_edit,
+                            cmon_err_report * _out_err)
 {
-    va_list args;
-    cmon_bool ret;
-    va_start(args, _idx);
-    ret = _is_impl_v(_t, _idx, args);
-    va_end(args);
-    return ret;
+    _token tok;
+    cmon_tokk kind;
+    _tokenize_session s;
+    size_t old_count, first, old_end, new_end, count, i, k;
+    long delta;
+    uint32_t old_pos;
+    cmon_bool sync;
+
+    assert(_edit_begin <= _edit_end && _edit_end <= _t->code_len);
+
+    old_count = cmon_tokens_count(_t);
+    delta = (long)_new_len - (long)(_edit_end - _edit_begin);
+
+    _tokenize_session_init(&s, _t->alloc, _src, _interner, _src_file_idx, cmon_false);
+    assert(s.end - s.input == (long)_t->code_len + delta);
+
+    // restart at the last token that begins before the edit. Tokens that are not separated by
+    // whitespace can merge or depend on each others lookahead (i.e. foo|bar, 1|.5), so we keep
+    // stepping back until a token follows whitespace. The code before the edit did not change, so
+    // the new code can be used to check.
+    first = _edit_begin ? _lower_bound(_t->offsets, old_count, (uint32_t)_edit_begin) : 0;
+    if (first)
+        --first;
+    if (cmon_is_valid_idx(_t->err_tok_idx))
+        first = CMON_MIN(first, _t->err_tok_idx);
+    while (first > 0 && !isspace(s.input[_t->offsets[first] - 1]))
+        --first;
+
+    if (s.end - s.input >= UINT32_MAX)
+    {
+        _err((&s), "source files larger than 4GB are not supported");
+        first = 0;
+        s.pos = s.end;
+    }
+    else if (first)
+    {
+        s.pos = s.input + _t->offsets[first];
+    }
+    s.tok_base = first;
+
+    // lex until a token begins past the edit at the same spot an old token began. From there on
+    // the lexer would produce the same tokens as before, shifted by delta. If lexing stopped with
+    // an error before, we lex until the end to find out if the error is still there.
+    old_end = old_count;
+    sync = !cmon_is_valid_idx(_t->err_tok_idx);
+    while (_next_token(&s, &kind, &tok))
+    {
+        // the whitespace in front of the first token was skipped when it was lexed originally
+        if (first && !cmon_dyn_arr_count(&s.kinds))
+            tok.follows_nl = (_t->kinds[first] & _FOLLOWS_NL_BIT) != 0;
+
+        _append_token(&s, kind, &tok);
+
+        if (!cmon_err_report_is_empty(&s.err))
+            break;
+
+        if (sync && tok.str_view.begin - s.input >= (long)(_edit_begin + _new_len))
+        {
+            old_pos = (uint32_t)(tok.str_view.begin - s.input - delta);
+            k = _lower_bound(_t->offsets, old_count - 1, old_pos);
+            if (k < old_count - 1 && _t->offsets[k] == old_pos)
+            {
+                old_end = k + 1;
+                break;
+            }
+        }
+    }
+
+    if (old_end == old_count)
+    {
+        tok.str_view.begin = s.end;
+        tok.str_view.end = s.end;
+        tok.str_id = CMON_INVALID_IDX;
+        tok.follows_nl = cmon_false;
+        _append_token(&s, cmon_tokk_eof, &tok);
+    }
+
+    count = cmon_dyn_arr_count(&s.kinds);
+    new_end = first + count;
+
+    // the edit is reported without the tokens at both ends that were lexed exactly like before
+    _out_edit->first = first;
+    _out_edit->old_end = old_end;
+    _out_edit->new_end = new_end;
+    for (i = 0; _out_edit->first < _out_edit->old_end && i < count; ++i, ++_out_edit->first)
+    {
+        k = _out_edit->first;
+        if (_t->kinds[k] != s.kinds[i] || _t->lens[k] != s.lens[i] ||
+            _t->offsets[k] != s.offsets[i] ||
+            _t->offsets[k] + _tok_extent(_t->kinds[k], _t->lens[k]) > _edit_begin)
+            break;
+    }
+    for (i = count; _out_edit->old_end > _out_edit->first && i > _out_edit->first - first; --i)
+    {
+        k = _out_edit->old_end - 1;
+        if (_t->kinds[k] != s.kinds[i - 1] || _t->lens[k] != s.lens[i - 1] ||
+            _t->offsets[k] < _edit_end || _t->offsets[k] + delta != s.offsets[i - 1])
+            break;
+        --_out_edit->old_end;
+        --_out_edit->new_end;
+    }
+
+    _splice(&_t->kinds, first, old_end, s.kinds, count);
+    _splice(&_t->offsets, first, old_end, s.offsets, count);
+    _splice(&_t->lens, first, old_end, s.lens, count);
+    _splice(&_t->str_ids, first, old_end, s.str_ids, count);
+    for (i = new_end; i < cmon_dyn_arr_count(&_t->offsets); ++i)
+        _t->offsets[i] += delta;
+
+    _t->code = s.input;
+    _t->code_len = s.end - s.input;
+    _t->tok_idx = 0;
+    _t->err_tok_idx = _err_tok_idx(&s);
+    // the newline index is rebuilt the next time it is needed
+    cmon_dyn_arr_dealloc(&_t->line_starts);
+    _t->line_starts = NULL;
+
+    *_out_err = s.err;
+    cmon_dyn_arr_dealloc(&s.str_ids);
+    cmon_dyn_arr_dealloc(&s.lens);
+    cmon_dyn_arr_dealloc(&s.offsets);
+    cmon_dyn_arr_dealloc(&s.kinds);
+    _tokenize_session_dealloc(&s);
 }
 
-cmon_bool cmon_tokens_is_current_impl(cmon_tokens * _t, ...)
+void cmon_tokens_set_current(cmon_tokens * _t, cmon_idx _idx)
 {
-    va_list args;
-    cmon_bool ret;
-    va_start(args, _t);
-    ret = _is_impl_v(_t, _t->tok_idx, args);
-    va_end(args);
-    return ret;
+    _check_idx(_t, _idx);
+    _t->tok_idx = _idx;
 }
 
-cmon_bool cmon_tokens_is_next_impl(cmon_tokens * _t, ...)
+cmon_bool cmon_tokens_is_in(cmon_tokens * _t, cmon_idx _idx, cmon_tokk_set _set)
 {
-    va_list args;
-    cmon_bool ret;
-    va_start(args, _t);
-    ret = _is_impl_v(_t, _t->tok_idx + 1, args);
-    va_end(args);
-    return ret;
+    return cmon_tokk_set_has(_set, _get_kind(_t, _idx));
 }
 
-cmon_idx cmon_tokens_accept_impl_v(cmon_tokens * _t, va_list _args)
+cmon_idx cmon_tokens_accept_in(cmon_tokens * _t, cmon_tokk_set _set)
 {
-    if (_is_impl_v(_t, _t->tok_idx, _args))
+    if (cmon_tokk_set_has(_set, _get_kind(_t, _t->tok_idx)))
         return cmon_tokens_advance(_t, cmon_true);
     return CMON_INVALID_IDX;
 }
 
-cmon_idx cmon_tokens_accept_impl(cmon_tokens * _t, ...)
-{
-    va_list args;
-    cmon_idx ret;
-    va_start(args, _t);
-    ret = cmon_tokens_accept_impl_v(_t, args);
-    va_end(args);
-    return ret;
-}
-
 cmon_str_view cmon_tokens_line_str_view(cmon_tokens * _t, size_t _line)
 {
-    assert(_line > 0);
-    assert(_line <= cmon_dyn_arr_count(&_t->lines));
-    return _t->lines[_line - 1].str_view;
+    return (cmon_str_view){ _t->code + _line_begin(_t, _line), _t->code + _line_end(_t, _line) };
 }
 
 // cmon_bool cmon_tokens_is(cmon_tokens * _t, cmon_idx _idx, cmon_tokk _kind)
@@ -1014,6 +1336,8 @@ const char * cmon_tokk_to_str(cmon_tokk _kind)
         return "scope_exit";
     case cmon_tokk_eof:
         return "EOF";
+    case cmon_tokk_count:
+        break;
     }
     return "unknown";
 }
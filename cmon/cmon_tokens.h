@@ -2,6 +2,7 @@
 #define CMON_CMON_TOKENS_H
 
 #include <cmon/cmon_err_report.h>
+#include <cmon/cmon_interner.h>
 #include <cmon/cmon_src.h>
 #include <cmon/cmon_util.h>
 
@@ -90,16 +91,57 @@ typedef enum
     cmon_tokk_comment,
     cmon_tokk_scoped,
     cmon_tokk_scope_exit,
-    cmon_tokk_eof
+    cmon_tokk_eof,
+    cmon_tokk_count // has to stay <= 128 so all kinds fit into a cmon_tokk_set
 } cmon_tokk;
 
+// the token kinds are also stored in 7 bits (see cmon_tokens.c), which holds as long as they fit
+// into a cmon_tokk_set.
+_Static_assert(cmon_tokk_count <= 128, "too many token kinds for cmon_tokk_set and the kind mask");
+
+// a set of token kinds, one bit per kind. Use CMON_TOKK_SET to create one.
+__extension__ typedef unsigned __int128 cmon_tokk_set;
+
+#define CMON_TOKK_BIT(_kind) ((cmon_tokk_set)1 << (_kind))
+// i.e. CMON_TOKK_SET(cmon_tokk_comma, cmon_tokk_semicolon), up to 32 kinds
+#define CMON_TOKK_SET(...) _CMON_MAP_OR(CMON_TOKK_BIT, __VA_ARGS__)
+#define cmon_tokk_set_has(_set, _kind) (((_set) & CMON_TOKK_BIT(_kind)) != 0)
+
 typedef struct cmon_tokens cmon_tokens;
 
+// the range of tokens that changed when re-tokenizing an edited file. The old tokens in
+// [first, old_end) were replaced by the new tokens in [first, new_end), all tokens after that are
+// the same as before, shifted by new_end - old_end.
+typedef struct
+{
+    cmon_idx first;
+    cmon_idx old_end;
+    cmon_idx new_end;
+} cmon_tokens_edit;
+
 CMON_API cmon_tokens * cmon_tokenize(cmon_allocator * _alloc,
                                      cmon_src * _src,
                                      cmon_idx _src_file_idx,
                                      cmon_err_report * _out_err);
+// same as cmon_tokenize but interns the name of every identifier token, see cmon_tokens_str_id
+CMON_API cmon_tokens * cmon_tokenize_with_interner(cmon_allocator * _alloc,
+                                                   cmon_src * _src,
+                                                   cmon_interner * _interner,
+                                                   cmon_idx _src_file_idx,
+                                                   cmon_err_report * _out_err);
 CMON_API void cmon_tokens_destroy(cmon_tokens * _t);
+// updates the tokens after the bytes [_edit_begin, _edit_end) of the code they were created from
+// were replaced by _new_len bytes. _src has to hold the new code already. Only the tokens around
+// the edit are lexed again, the rest is reused. The changed range is written to _out_edit.
+CMON_API void cmon_tokens_retokenize(cmon_tokens * _t,
+                                     cmon_src * _src,
+                                     cmon_interner * _interner,
+                                     cmon_idx _src_file_idx,
+                                     size_t _edit_begin,
+                                     size_t _edit_end,
+                                     size_t _new_len,
+                                     cmon_tokens_edit * _out_edit,
+                                     cmon_err_report * _out_err);
 
 CMON_API size_t cmon_tokens_count(cmon_tokens * _t);
 
@@ -108,10 +150,13 @@ CMON_API cmon_idx cmon_tokens_prev(cmon_tokens * _t, cmon_bool _skip_comments);
 CMON_API cmon_idx cmon_tokens_current(cmon_tokens * _t);
 CMON_API cmon_idx cmon_tokens_next(cmon_tokens * _t, cmon_bool _skip_comments);
 CMON_API cmon_idx cmon_tokens_advance(cmon_tokens * _t, cmon_bool _skip_comments);
+CMON_API void cmon_tokens_set_current(cmon_tokens * _t, cmon_idx _idx);
 
 // functions to get information about a token
 CMON_API cmon_tokk cmon_tokens_kind(cmon_tokens * _t, cmon_idx _idx);
 CMON_API cmon_str_view cmon_tokens_str_view(cmon_tokens * _t, cmon_idx _idx);
+// interned id of an identifier token, CMON_INVALID_IDX for other tokens or if no interner was used
+CMON_API cmon_idx cmon_tokens_str_id(cmon_tokens * _t, cmon_idx _idx);
 CMON_API cmon_idx cmon_tokens_line(cmon_tokens * _t, cmon_idx _idx);
 CMON_API size_t cmon_tokens_line_token_count(cmon_tokens * _t, cmon_idx _line);
 CMON_API cmon_idx cmon_tokens_line_token(cmon_tokens * _t, cmon_idx _line, size_t _toki);
@@ -119,11 +164,10 @@ CMON_API cmon_idx cmon_tokens_line_token(cmon_tokens * _t, cmon_idx _line, size_
 CMON_API cmon_idx cmon_tokens_line_offset(cmon_tokens * _t, cmon_idx _idx);
 CMON_API cmon_bool cmon_tokens_follows_nl(cmon_tokens * _t, cmon_idx _idx);
 
-// implementation functions for variadic token check/accept macros below
-CMON_API cmon_bool cmon_tokens_is_impl_v(cmon_tokens * _t, cmon_idx _idx, va_list _args);
-CMON_API cmon_bool cmon_tokens_is_impl(cmon_tokens * _t, cmon_idx _idx, ...);
-CMON_API cmon_idx cmon_tokens_accept_impl_v(cmon_tokens * _t, va_list _args);
-CMON_API cmon_idx cmon_tokens_accept_impl(cmon_tokens * _t, ...);
+// check if a token is one of the kinds in a set, see CMON_TOKK_SET
+CMON_API cmon_bool cmon_tokens_is_in(cmon_tokens * _t, cmon_idx _idx, cmon_tokk_set _set);
+// advance and return the current token if it is one of the kinds in the set
+CMON_API cmon_idx cmon_tokens_accept_in(cmon_tokens * _t, cmon_tokk_set _set);
 
 //retrieve a view of a whole line
 CMON_API cmon_str_view cmon_tokens_line_str_view(cmon_tokens * _t, size_t _line);
@@ -131,16 +175,14 @@ CMON_API cmon_str_view cmon_tokens_line_str_view(cmon_tokens * _t, size_t _line)
 // token utility functions
 CMON_API const char * cmon_tokk_to_str(cmon_tokk _kind);
 
-// variadic macros to check for one or multiple token kinds
-#define cmon_tokens_is(_t, _idx, ...)                                                              \
-    cmon_tokens_is_impl((_t), _idx, _CMON_VARARG_APPEND_LAST(-1, __VA_ARGS__))
+// variadic macros to check for one or multiple token kinds. The kinds are turned into a constant
+// set at compile time, so checking is a single bit test no matter how many kinds are passed.
+#define cmon_tokens_is(_t, _idx, ...) cmon_tokens_is_in((_t), _idx, CMON_TOKK_SET(__VA_ARGS__))
 #define cmon_tokens_is_current(_t, ...)                                                            \
-    cmon_tokens_is_impl((_t), cmon_tokens_current((_t)), _CMON_VARARG_APPEND_LAST(-1, __VA_ARGS__))
+    cmon_tokens_is_in((_t), cmon_tokens_current((_t)), CMON_TOKK_SET(__VA_ARGS__))
 #define cmon_tokens_is_next(_t, ...)                                                               \
-    cmon_tokens_is_impl(                                                                           \
-        (_t), cmon_tokens_current((_t)) + 1, _CMON_VARARG_APPEND_LAST(-1, __VA_ARGS__))
-#define cmon_tokens_accept(_t, ...)                                                                \
-    cmon_tokens_accept_impl((_t), _CMON_VARARG_APPEND_LAST(-1, __VA_ARGS__))
+    cmon_tokens_is_in((_t), cmon_tokens_current((_t)) + 1, CMON_TOKK_SET(__VA_ARGS__))
+#define cmon_tokens_accept(_t, ...) cmon_tokens_accept_in((_t), CMON_TOKK_SET(__VA_ARGS__))
 
 // helper so we don't need to manually write out all binary expression tokens evey time we want to
 // check for that
@@ -0,0 +1,194 @@
+#include <cmon/cmon_dyn_arr.h>
+#include <cmon/cmon_str_builder.h>
+#include <cmon/cmon_trace.h>
+#include <cmon/cmon_util.h>
+#include <pthread.h>
+#include <time.h>
+
+#define _NAME_MAX 512
+
+typedef struct
+{
+    const char * cat;
+    size_t name_str_off;
+    size_t tid;
+    uint64_t begin;
+    uint64_t end;
+} _span;
+
+typedef struct cmon_trace
+{
+    cmon_allocator * alloc;
+    pthread_mutex_t mtx;
+    uint64_t start;
+    cmon_str_buf * str_buf;
+    cmon_dyn_arr(_span) spans;
+    // threads that recorded spans, the index is used as the thread id in the trace
+    cmon_dyn_arr(pthread_t) threads;
+} cmon_trace;
+
+// monotonic time in nanoseconds
+static inline uint64_t _now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+cmon_trace * cmon_trace_create(cmon_allocator * _alloc)
+{
+    cmon_trace * ret = CMON_CREATE(_alloc, cmon_trace);
+    ret->alloc = _alloc;
+    pthread_mutex_init(&ret->mtx, NULL);
+    ret->start = _now();
+    ret->str_buf = cmon_str_buf_create(_alloc, 4096);
+    cmon_dyn_arr_init(&ret->spans, _alloc, 256);
+    cmon_dyn_arr_init(&ret->threads, _alloc, 8);
+    return ret;
+}
+
+void cmon_trace_destroy(cmon_trace * _t)
+{
+    if (!_t)
+        return;
+
+    cmon_dyn_arr_dealloc(&_t->threads);
+    cmon_dyn_arr_dealloc(&_t->spans);
+    cmon_str_buf_destroy(_t->str_buf);
+    pthread_mutex_destroy(&_t->mtx);
+    CMON_DESTROY(_t->alloc, _t);
+}
+
+// needs to be called with the mutex locked
+static inline size_t _thread_id(cmon_trace * _t)
+{
+    size_t i;
+    pthread_t self = pthread_self();
+    for (i = 0; i < cmon_dyn_arr_count(&_t->threads); ++i)
+    {
+        if (pthread_equal(_t->threads[i], self))
+            return i;
+    }
+    cmon_dyn_arr_append(&_t->threads, self);
+    return cmon_dyn_arr_count(&_t->threads) - 1;
+}
+
+cmon_idx cmon_trace_begin(cmon_trace * _t, const char * _cat, const char * _fmt, ...)
+{
+    char name[_NAME_MAX];
+    va_list args;
+    _span s;
+
+    if (!_t)
+        return CMON_INVALID_IDX;
+
+    va_start(args, _fmt);
+    vsnprintf(name, sizeof(name), _fmt, args);
+    va_end(args);
+
+    s.cat = _cat;
+    s.end = 0;
+
+    pthread_mutex_lock(&_t->mtx);
+    s.name_str_off = cmon_str_buf_append(_t->str_buf, name);
+    s.tid = _thread_id(_t);
+    //@NOTE: taken last so formatting and locking are not part of the span
+    s.begin = _now();
+    cmon_dyn_arr_append(&_t->spans, s);
+    cmon_idx ret = cmon_dyn_arr_count(&_t->spans) - 1;
+    pthread_mutex_unlock(&_t->mtx);
+
+    return ret;
+}
+
+void cmon_trace_end(cmon_trace * _t, cmon_idx _span)
+{
+    uint64_t end;
+
+    if (!_t)
+        return;
+
+    end = _now();
+    pthread_mutex_lock(&_t->mtx);
+    assert(_span < cmon_dyn_arr_count(&_t->spans));
+    _t->spans[_span].end = end;
+    pthread_mutex_unlock(&_t->mtx);
+}
+
+size_t cmon_trace_span_count(cmon_trace * _t)
+{
+    size_t ret;
+
+    if (!_t)
+        return 0;
+
+    pthread_mutex_lock(&_t->mtx);
+    ret = cmon_dyn_arr_count(&_t->spans);
+    pthread_mutex_unlock(&_t->mtx);
+    return ret;
+}
+
+static inline void _write_json_str(FILE * _fp, const char * _str)
+{
+    fputc('"', _fp);
+    for (; *_str; ++_str)
+    {
+        if (*_str == '"' || *_str == '\\')
+            fprintf(_fp, "\\%c", *_str);
+        else if ((unsigned char)*_str < 0x20)
+            fprintf(_fp, "\\u%04x", (unsigned char)*_str);
+        else
+            fputc(*_str, _fp);
+    }
+    fputc('"', _fp);
+}
+
+cmon_bool cmon_trace_save(cmon_trace * _t, const char * _path)
+{
+    FILE * fp;
+    size_t i;
+    cmon_bool ret;
+
+    if (!_t)
+        return cmon_false;
+
+    fp = fopen(_path, "w");
+    if (!fp)
+        return cmon_true;
+
+    pthread_mutex_lock(&_t->mtx);
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (i = 0; i < cmon_dyn_arr_count(&_t->threads); ++i)
+    {
+        fprintf(fp,
+                "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{"
+                "\"name\":\"thread %lu\"}}",
+                i ? "," : "",
+                i,
+                i);
+    }
+
+    for (i = 0; i < cmon_dyn_arr_count(&_t->spans); ++i)
+    {
+        _span * s = &_t->spans[i];
+        // spans that were never ended (i.e. because the build bailed out) last until now
+        uint64_t end = s->end ? s->end : _now();
+
+        fprintf(fp, ",\n{\"name\":");
+        _write_json_str(fp, cmon_str_buf_get(_t->str_buf, s->name_str_off));
+        fprintf(fp, ",\"cat\":");
+        _write_json_str(fp, s->cat);
+        // chrome trace timestamps are in microseconds
+        fprintf(fp,
+                ",\"ph\":\"X\",\"pid\":1,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f}",
+                s->tid,
+                (double)(s->begin - _t->start) / 1000.0,
+                (double)(end - s->begin) / 1000.0);
+    }
+    fprintf(fp, "\n]}\n");
+    pthread_mutex_unlock(&_t->mtx);
+
+    ret = ferror(fp) != 0;
+    ret |= fclose(fp) != 0;
+    return ret;
+}
@@ -0,0 +1,20 @@
+#ifndef CMON_CMON_TRACE_H
+#define CMON_CMON_TRACE_H
+
+#include <cmon/cmon_allocator.h>
+
+// records timed spans (i.e. build phases, modules, files and c compiler invocations) and saves them
+// in the chrome trace event format, which can be inspected in chrome://tracing or ui.perfetto.dev.
+// Spans can be recorded from any thread. All functions are noops if the trace is NULL, so code can
+// be instrumented unconditionally.
+typedef struct cmon_trace cmon_trace;
+
+CMON_API cmon_trace * cmon_trace_create(cmon_allocator * _alloc);
+CMON_API void cmon_trace_destroy(cmon_trace * _t);
+// starts a span on the calling thread. _cat groups spans (i.e. "phase", "module", "file", "cc").
+CMON_API cmon_idx cmon_trace_begin(cmon_trace * _t, const char * _cat, const char * _fmt, ...);
+CMON_API void cmon_trace_end(cmon_trace * _t, cmon_idx _span);
+CMON_API size_t cmon_trace_span_count(cmon_trace * _t);
+CMON_API cmon_bool cmon_trace_save(cmon_trace * _t, const char * _path);
+
+#endif // CMON_CMON_TRACE_H
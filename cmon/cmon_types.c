@@ -1,9 +1,11 @@
+#include <cmon/cmon_blk_arr.h>
 #include <cmon/cmon_dyn_arr.h>
 #include <cmon/cmon_hashmap.h>
 #include <cmon/cmon_modules.h>
 #include <cmon/cmon_str_builder.h>
 #include <cmon/cmon_types.h>
 #include <cmon/cmon_util.h>
+#include <pthread.h>
 
 typedef struct
 {
@@ -41,6 +43,17 @@ typedef struct
     size_t count;
 } _array;
 
+// structural identity of an implicit type, used to hash-cons them
+typedef struct
+{
+    cmon_typek kind;
+    cmon_idx type;
+    // mutability for ptrs and views, the count for arrays and the param count for fns
+    size_t extra;
+    // only set for fns. Stored keys point at the params of the _fn_sig.
+    const cmon_idx * params;
+} _implicit_key;
+
 typedef struct
 {
     cmon_typek kind;
@@ -48,29 +61,49 @@ typedef struct
     cmon_idx mod_idx;
     cmon_idx src_file_idx;
     cmon_idx name_tok;
+    //@NOTE: the names of implicit types are only generated once they are asked for (see _name).
     const char * name_str;
     const char * full_name_str;
     const char * unique_name_str;
     // data idx for additional type information that gets interpreted based on kind.
     // i.e. for structs this is the index into the structs array.
     cmon_idx data_idx;
-    // array the size of all modules being compiled to indicate if the type is used by the module
-    cmon_dyn_arr(cmon_bool) mod_map;
 } _type;
 
+// the types a module uses. Modules usually only use a small fraction of all types, so this is kept
+// sparse rather than as a bit per type and module.
+typedef struct
+{
+    // in the order the module started using them
+    cmon_dyn_arr(cmon_idx) types;
+    // type idx -> index into types
+    cmon_hashmap(cmon_idx, cmon_idx) lookup;
+} _mod_usage;
+
 typedef struct cmon_types
 {
     cmon_allocator * alloc;
     cmon_modules * mods;
-    cmon_dyn_arr(_struct) structs;
-    cmon_dyn_arr(_fn_sig) fns;
-    cmon_dyn_arr(_ptr) ptrs;
-    cmon_dyn_arr(_view) views;
-    cmon_dyn_arr(_array) arrays;
-    cmon_dyn_arr(_type) types;
+    //@NOTE: the type storage lives in blocks that never move, so it can be read without locking
+    // while other threads add types.
+    cmon_blk_arr(_struct) structs;
+    cmon_blk_arr(_fn_sig) fns;
+    cmon_blk_arr(_ptr) ptrs;
+    cmon_blk_arr(_view) views;
+    cmon_blk_arr(_array) arrays;
+    cmon_blk_arr(_type) types;
+    //@NOTE: every module only ever writes its own entry, so this does not need to lock.
+    cmon_dyn_arr(_mod_usage) mod_usage;
+    // named types (builtins and structs) by unique name
     cmon_hashmap(const char *, cmon_idx) name_map;
+    // implicit types (ptrs, views, arrays and fns) by structure
+    cmon_hashmap(_implicit_key, cmon_idx) implicit_map;
     cmon_str_builder * str_builder;
-    cmon_dyn_arr(cmon_short_str) name_buf;
+    //@NOTE: names are allocated individually so that the pointers handed out by the name functions
+    // stay valid while the buffer grows (possibly on another thread).
+    cmon_dyn_arr(char *) name_buf;
+    // protects everything that creates types (and the shared str_builder)
+    pthread_mutex_t mtx;
 
     // builtin type indices
     cmon_dyn_arr(cmon_idx) builtins;
@@ -105,24 +138,105 @@ typedef struct cmon_types
 //                          (cmon_short_str_make(_t->alloc, _tmp_str(_t, _fmt, ##__VA_ARGS__)))),     \
 //      cmon_short_str_c_str(&cmon_dyn_arr_last(&_t->name_buf)))
 
-#define _get_type(_t, _idx) (assert(_idx < cmon_dyn_arr_count(&_t->types)), _t->types[_idx])
+#define _get_type(_t, _idx)                                                                        \
+    (assert(_idx < cmon_blk_arr_count(&_t->types)), cmon_blk_arr_get(&_t->types, _idx))
+// the kind specific data of a type, i.e. _type_data(_t, structs, _idx) for a struct
+#define _type_data(_t, _arr, _idx) cmon_blk_arr_get(&(_t)->_arr, _get_type(_t, _idx).data_idx)
 
-#define _return_if_found(_t, _name, _mod_idx)                                                      \
-    do                                                                                             \
-    {                                                                                              \
-        cmon_idx _idx;                                                                             \
-        if (cmon_is_valid_idx(_idx = cmon_types_find(_t, _name)))                                  \
-        {                                                                                          \
-            _t->types[_idx].mod_map[_mod_idx] = cmon_true;                                         \
-            return _idx;                                                                           \
-        }                                                                                          \
-    } while (0)
+typedef enum
+{
+    _name_kind_name,
+    _name_kind_unique,
+    _name_kind_full
+} _name_kind;
+
+static inline uint64_t _hash_mix(uint64_t _h, uint64_t _v)
+{
+    _h = (_h ^ _v) * 0x9E3779B97F4A7C15ULL;
+    return _h ^ (_h >> 32);
+}
+
+static uint64_t _implicit_key_hash(_implicit_key _key)
+{
+    size_t i;
+    uint64_t ret = _hash_mix(_hash_mix((uint64_t)_key.kind, _key.type), _key.extra);
+    if (_key.kind == cmon_typek_fn)
+    {
+        for (i = 0; i < _key.extra; ++i)
+        {
+            ret = _hash_mix(ret, _key.params[i]);
+        }
+    }
+    return ret;
+}
+
+static cmon_bool _implicit_key_cmp(const void * _a,
+                                   const void * _b,
+                                   size_t _byte_count,
+                                   void * _user_data)
+{
+    const _implicit_key * a = (const _implicit_key *)_a;
+    const _implicit_key * b = (const _implicit_key *)_b;
+    if (a->kind != b->kind || a->type != b->type || a->extra != b->extra)
+        return cmon_false;
+    return a->kind != cmon_typek_fn || !a->extra ||
+           memcmp(a->params, b->params, a->extra * sizeof(cmon_idx)) == 0;
+}
+
+static inline _implicit_key _implicit_key_make(cmon_typek _kind,
+                                               cmon_idx _type,
+                                               size_t _extra,
+                                               const cmon_idx * _params)
+{
+    _implicit_key ret;
+    ret.kind = _kind;
+    ret.type = _type;
+    ret.extra = _extra;
+    ret.params = _params;
+    return ret;
+}
+
+static inline void _set_used(cmon_types * _t, cmon_idx _idx, cmon_idx _mod_idx)
+{
+    _mod_usage * mu;
+    if (!cmon_is_valid_idx(_mod_idx))
+        return;
+
+    assert(_mod_idx < cmon_dyn_arr_count(&_t->mod_usage));
+    mu = &_t->mod_usage[_mod_idx];
+    if (cmon_hashmap_get(&mu->lookup, _idx))
+        return;
+
+    cmon_hashmap_set(&mu->lookup, _idx, cmon_dyn_arr_count(&mu->types));
+    cmon_dyn_arr_append(&mu->types, _idx);
+}
+
+// returns the implicit type matching _key and marks it as used by _mod_idx
+static inline cmon_idx _find_implicit(cmon_types * _t, _implicit_key _key, cmon_idx _mod_idx)
+{
+    cmon_idx * idx_ptr;
+    if ((idx_ptr = cmon_hashmap_get(&_t->implicit_map, _key)))
+    {
+        _set_used(_t, *idx_ptr, _mod_idx);
+        return *idx_ptr;
+    }
+    return CMON_INVALID_IDX;
+}
+
+static inline cmon_idx _find(cmon_types * _t, const char * _unique_name)
+{
+    cmon_idx * idx_ptr;
+    if ((idx_ptr = cmon_hashmap_get(&_t->name_map, _unique_name)))
+    {
+        return *idx_ptr;
+    }
+    return CMON_INVALID_IDX;
+}
 
 static inline const char * _intern_c_str(cmon_types * _t, const char * _c_str)
 {
-    cmon_dyn_arr_append(&_t->name_buf, cmon_short_str_make(_t->alloc, _c_str));
-    cmon_short_str str = cmon_dyn_arr_last(&_t->name_buf);
-    return cmon_short_str_c_str(&cmon_dyn_arr_last(&_t->name_buf));
+    cmon_dyn_arr_append(&_t->name_buf, cmon_c_str_copy(_t->alloc, _c_str));
+    return cmon_dyn_arr_last(&_t->name_buf);
 }
 
 static inline const char * _intern_str(cmon_types * _t, const char * _fmt, ...)
@@ -131,9 +245,9 @@ static inline const char * _intern_str(cmon_types * _t, const char * _fmt, ...)
     va_start(args, _fmt);
     cmon_dyn_arr_append(
         &_t->name_buf,
-        cmon_short_str_make(_t->alloc, cmon_str_builder_tmp_str_v(_t->str_builder, _fmt, args)));
+        cmon_c_str_copy(_t->alloc, cmon_str_builder_tmp_str_v(_t->str_builder, _fmt, args)));
     va_end(args);
-    return cmon_short_str_c_str(&cmon_dyn_arr_last(&_t->name_buf));
+    return cmon_dyn_arr_last(&_t->name_buf);
 }
 
 static inline cmon_idx _add_type(cmon_types * _t,
@@ -154,14 +268,6 @@ static inline cmon_idx _add_type(cmon_types * _t,
     t.unique_name_str = _unique;
     t.full_name_str = _full;
     t.data_idx = _extra_data;
-    assert(cmon_modules_count(_t->mods));
-    cmon_dyn_arr_init(&t.mod_map, _t->alloc, cmon_modules_count(_t->mods));
-    cmon_dyn_arr_resize(&t.mod_map, cmon_modules_count(_t->mods));
-    memset(&t.mod_map[0], cmon_false, cmon_dyn_arr_count(&t.mod_map) * sizeof(cmon_bool));
-    if(cmon_is_valid_idx(_mod_idx))
-    {
-        t.mod_map[_mod_idx] = cmon_true;
-    }
 
     //only user defined types can be defined in a module. struct is the only user type for now.
     if(_kind == cmon_typek_struct)
@@ -173,9 +279,32 @@ static inline cmon_idx _add_type(cmon_types * _t,
         t.mod_idx = CMON_INVALID_IDX;
     }
 
-    cmon_dyn_arr_append(&_t->types, t);
-    cmon_hashmap_set(&_t->name_map, _unique, cmon_dyn_arr_count(&_t->types) - 1);
-    return cmon_dyn_arr_count(&_t->types) - 1;
+    cmon_blk_arr_append(&_t->types, t);
+    _set_used(_t, cmon_blk_arr_count(&_t->types) - 1, _mod_idx);
+    if (_unique)
+    {
+        cmon_hashmap_set(&_t->name_map, _unique, cmon_blk_arr_count(&_t->types) - 1);
+    }
+    return cmon_blk_arr_count(&_t->types) - 1;
+}
+
+static inline cmon_idx _add_implicit(cmon_types * _t,
+                                     cmon_typek _kind,
+                                     _implicit_key _key,
+                                     cmon_idx _mod_idx,
+                                     cmon_idx _extra_data)
+{
+    cmon_idx ret = _add_type(_t,
+                             _kind,
+                             NULL,
+                             NULL,
+                             NULL,
+                             _mod_idx,
+                             CMON_INVALID_IDX,
+                             CMON_INVALID_IDX,
+                             _extra_data);
+    cmon_hashmap_set(&_t->implicit_map, _key, ret);
+    return ret;
 }
 
 static inline cmon_idx _add_builtin(cmon_types * _t,
@@ -195,19 +324,31 @@ static inline cmon_idx _add_builtin(cmon_types * _t,
 
 cmon_types * cmon_types_create(cmon_allocator * _alloc, cmon_modules * _mods)
 {
+    size_t i;
     cmon_types * ret = CMON_CREATE(_alloc, cmon_types);
     ret->alloc = _alloc;
     ret->mods = _mods;
-    cmon_dyn_arr_init(&ret->structs, _alloc, 32);
-    cmon_dyn_arr_init(&ret->fns, _alloc, 16);
-    cmon_dyn_arr_init(&ret->ptrs, _alloc, 16);
-    cmon_dyn_arr_init(&ret->views, _alloc, 16);
-    cmon_dyn_arr_init(&ret->arrays, _alloc, 16);
-    cmon_dyn_arr_init(&ret->types, _alloc, 64);
+    cmon_blk_arr_init(&ret->structs, _alloc);
+    cmon_blk_arr_init(&ret->fns, _alloc);
+    cmon_blk_arr_init(&ret->ptrs, _alloc);
+    cmon_blk_arr_init(&ret->views, _alloc);
+    cmon_blk_arr_init(&ret->arrays, _alloc);
+    cmon_blk_arr_init(&ret->types, _alloc);
+    assert(cmon_modules_count(_mods));
+    cmon_dyn_arr_init(&ret->mod_usage, _alloc, cmon_modules_count(_mods));
+    for (i = 0; i < cmon_modules_count(_mods); ++i)
+    {
+        _mod_usage mu;
+        cmon_dyn_arr_init(&mu.types, _alloc, 16);
+        cmon_hashmap_int_key_init(&mu.lookup, _alloc);
+        cmon_dyn_arr_append(&ret->mod_usage, mu);
+    }
     cmon_hashmap_str_key_init(&ret->name_map, _alloc);
+    cmon_hashmap_init(&ret->implicit_map, _alloc, _implicit_key_hash, _implicit_key_cmp, NULL);
     ret->str_builder = cmon_str_builder_create(_alloc, 256);
     cmon_dyn_arr_init(&ret->name_buf, _alloc, 64);
     cmon_dyn_arr_init(&ret->builtins, _alloc, 16);
+    pthread_mutex_init(&ret->mtx, NULL);
 
     ret->builtin_s8 = _add_builtin(ret, cmon_typek_s8, "s8", cmon_false);
     ret->builtin_s16 = _add_builtin(ret, cmon_typek_s16, "s16", cmon_false);
@@ -224,7 +365,7 @@ cmon_types * cmon_types_create(cmon_allocator * _alloc, cmon_modules * _mods)
     ret->builtin_modident = _add_builtin(ret, cmon_typek_modident, "__modident", cmon_true);
     ret->builtin_typeident = _add_builtin(ret, cmon_typek_typeident, "__typeident", cmon_true);
 
-    ret->builtins_end = cmon_dyn_arr_count(&ret->types);
+    ret->builtins_end = cmon_blk_arr_count(&ret->types);
 
     return ret;
 }
@@ -235,49 +376,58 @@ void cmon_types_destroy(cmon_types * _t)
         return;
 
     size_t i;
+    pthread_mutex_destroy(&_t->mtx);
     cmon_str_builder_destroy(_t->str_builder);
     for (i = 0; i < cmon_dyn_arr_count(&_t->name_buf); ++i)
     {
-        cmon_short_str_dealloc(&_t->name_buf[i]);
+        cmon_c_str_free(_t->alloc, _t->name_buf[i]);
     }
     cmon_dyn_arr_dealloc(&_t->name_buf);
     cmon_dyn_arr_dealloc(&_t->builtins);
+    cmon_hashmap_dealloc(&_t->implicit_map);
     cmon_hashmap_dealloc(&_t->name_map);
 
-    for (i = 0; i < cmon_dyn_arr_count(&_t->types); ++i)
+    for (i = 0; i < cmon_dyn_arr_count(&_t->mod_usage); ++i)
     {
-        cmon_dyn_arr_dealloc(&_t->types[i].mod_map);
+        cmon_hashmap_dealloc(&_t->mod_usage[i].lookup);
+        cmon_dyn_arr_dealloc(&_t->mod_usage[i].types);
     }
-
-    cmon_dyn_arr_dealloc(&_t->types);
-    cmon_dyn_arr_dealloc(&_t->arrays);
-    cmon_dyn_arr_dealloc(&_t->views);
-    cmon_dyn_arr_dealloc(&_t->ptrs);
-    for (i = 0; i < cmon_dyn_arr_count(&_t->fns); ++i)
+    cmon_dyn_arr_dealloc(&_t->mod_usage);
+    cmon_blk_arr_dealloc(&_t->types);
+    cmon_blk_arr_dealloc(&_t->arrays);
+    cmon_blk_arr_dealloc(&_t->views);
+    cmon_blk_arr_dealloc(&_t->ptrs);
+    for (i = 0; i < cmon_blk_arr_count(&_t->fns); ++i)
     {
-        cmon_dyn_arr_dealloc(&_t->fns[i].params);
+        cmon_dyn_arr_dealloc(&cmon_blk_arr_get(&_t->fns, i).params);
     }
-    cmon_dyn_arr_dealloc(&_t->fns);
-    for (i = 0; i < cmon_dyn_arr_count(&_t->structs); ++i)
+    cmon_blk_arr_dealloc(&_t->fns);
+    for (i = 0; i < cmon_blk_arr_count(&_t->structs); ++i)
     {
-        cmon_dyn_arr_dealloc(&_t->structs[i].fields);
+        cmon_dyn_arr_dealloc(&cmon_blk_arr_get(&_t->structs, i).fields);
     }
-    cmon_dyn_arr_dealloc(&_t->structs);
+    cmon_blk_arr_dealloc(&_t->structs);
     CMON_DESTROY(_t->alloc, _t);
 }
 
 size_t cmon_types_count(cmon_types * _t)
 {
-    return cmon_dyn_arr_count(&_t->types);
+    size_t ret;
+    pthread_mutex_lock(&_t->mtx);
+    ret = cmon_blk_arr_count(&_t->types);
+    pthread_mutex_unlock(&_t->mtx);
+    return ret;
 }
 
 cmon_idx cmon_types_add_struct(
     cmon_types * _t, cmon_idx _mod, cmon_str_view _name, cmon_idx _src_file_idx, cmon_idx _name_tok)
 {
+    cmon_idx ret;
     _struct strct;
+    pthread_mutex_lock(&_t->mtx);
     cmon_dyn_arr_init(&strct.fields, _t->alloc, 8);
-    cmon_dyn_arr_append(&_t->structs, strct);
-    return _add_type(
+    cmon_blk_arr_append(&_t->structs, strct);
+    ret = _add_type(
         _t,
         cmon_typek_struct,
         _intern_str(_t, "%.*s", _name.end - _name.begin, _name.begin),
@@ -291,7 +441,9 @@ cmon_idx cmon_types_add_struct(
         _mod,
         _src_file_idx,
         _name_tok,
-        cmon_dyn_arr_count(&_t->structs) - 1);
+        cmon_blk_arr_count(&_t->structs) - 1);
+    pthread_mutex_unlock(&_t->mtx);
+    return ret;
 }
 
 cmon_idx cmon_types_struct_add_field(cmon_types * _t,
@@ -300,160 +452,237 @@ cmon_idx cmon_types_struct_add_field(cmon_types * _t,
                                      cmon_idx _type,
                                      cmon_idx _def_expr_ast)
 {
-    cmon_dyn_arr_append(
-        &_t->structs[_get_type(_t, _struct).data_idx].fields,
-        ((_struct_field){
-            _intern_str(_t, "%.*s", _name.end - _name.begin, _name.begin), _type, _def_expr_ast }));
-    return cmon_dyn_arr_count(&_t->structs[_get_type(_t, _struct).data_idx].fields) - 1;
+    const char * name;
+    pthread_mutex_lock(&_t->mtx);
+    name = _intern_str(_t, "%.*s", _name.end - _name.begin, _name.begin);
+    pthread_mutex_unlock(&_t->mtx);
+
+    //@NOTE: fields are only ever added by the module owning the struct, no need to lock for this.
+    cmon_dyn_arr_append(&_type_data(_t, structs, _struct).fields,
+                        ((_struct_field){ name, _type, _def_expr_ast }));
+    return cmon_dyn_arr_count(&_type_data(_t, structs, _struct).fields) - 1;
 }
 
-cmon_idx cmon_types_find_ptr(cmon_types * _t, cmon_idx _type, cmon_bool _is_mut, cmon_idx _mod_idx)
+static cmon_idx _find_ptr(cmon_types * _t, cmon_idx _type, cmon_bool _is_mut, cmon_idx _mod_idx)
 {
     _ptr ptr;
-    const char * unique_name;
-    unique_name = cmon_str_builder_tmp_str(
-        _t->str_builder, "Ptr%s_%s", _is_mut ? "Mut" : "", cmon_types_unique_name(_t, _type));
-    _return_if_found(_t, unique_name, _mod_idx);
+    cmon_idx ret;
+    _implicit_key key = _implicit_key_make(cmon_typek_ptr, _type, _is_mut, NULL);
+    if (cmon_is_valid_idx(ret = _find_implicit(_t, key, _mod_idx)))
+        return ret;
 
     ptr.is_mut = _is_mut;
     ptr.type = _type;
-    cmon_dyn_arr_append(&_t->ptrs, ptr);
-
-    return _add_type(
-        _t,
-        cmon_typek_ptr,
-        _intern_str(_t, "*%s %s", _is_mut ? "mut" : "", cmon_types_name(_t, _type)),
-        _intern_c_str(_t, unique_name),
-        _intern_str(_t, "*%s %s", _is_mut ? "mut" : "", cmon_types_full_name(_t, _type)),
-        _mod_idx,
-        CMON_INVALID_IDX,
-        CMON_INVALID_IDX,
-        cmon_dyn_arr_count(&_t->ptrs) - 1);
+    cmon_blk_arr_append(&_t->ptrs, ptr);
+    return _add_implicit(_t, cmon_typek_ptr, key, _mod_idx, cmon_blk_arr_count(&_t->ptrs) - 1);
 }
 
-cmon_idx cmon_types_find_view(cmon_types * _t, cmon_idx _type, cmon_bool _is_mut, cmon_idx _mod_idx)
+static cmon_idx _find_view(cmon_types * _t, cmon_idx _type, cmon_bool _is_mut, cmon_idx _mod_idx)
 {
     _view view;
-    const char * unique_name;
-    unique_name = cmon_str_builder_tmp_str(
-        _t->str_builder, "View%s_%s", _is_mut ? "Mut" : "", cmon_types_unique_name(_t, _type));
-    _return_if_found(_t, unique_name, _mod_idx);
+    cmon_idx ret;
+    _implicit_key key = _implicit_key_make(cmon_typek_view, _type, _is_mut, NULL);
+    if (cmon_is_valid_idx(ret = _find_implicit(_t, key, _mod_idx)))
+        return ret;
 
     view.is_mut = _is_mut;
     view.type = _type;
-    cmon_dyn_arr_append(&_t->views, view);
-
-    unique_name = _intern_c_str(_t, unique_name);
-    return _add_type(
-        _t,
-        cmon_typek_view,
-        _intern_str(_t, "[]%s %s", _is_mut ? "mut" : "", cmon_types_name(_t, _type)),
-        unique_name,
-        _intern_str(_t, "[]%s %s", _is_mut ? "mut" : "", cmon_types_full_name(_t, _type)),
-        _mod_idx,
-        CMON_INVALID_IDX,
-        CMON_INVALID_IDX,
-        cmon_dyn_arr_count(&_t->views) - 1);
+    cmon_blk_arr_append(&_t->views, view);
+    return _add_implicit(_t, cmon_typek_view, key, _mod_idx, cmon_blk_arr_count(&_t->views) - 1);
 }
 
-cmon_idx cmon_types_find_array(cmon_types * _t, cmon_idx _type, size_t _size, cmon_idx _mod_idx)
+static cmon_idx _find_array(cmon_types * _t, cmon_idx _type, size_t _size, cmon_idx _mod_idx)
 {
     _array arr;
-    const char * unique_name;
-    unique_name = cmon_str_builder_tmp_str(
-        _t->str_builder, "Array%lu_%s", _size, cmon_types_unique_name(_t, _type));
-    _return_if_found(_t, unique_name, _mod_idx);
+    cmon_idx ret;
+    _implicit_key key = _implicit_key_make(cmon_typek_array, _type, _size, NULL);
+    if (cmon_is_valid_idx(ret = _find_implicit(_t, key, _mod_idx)))
+        return ret;
+
     arr.count = _size;
     arr.type = _type;
-    cmon_dyn_arr_append(&_t->arrays, arr);
-    unique_name = _intern_c_str(_t, unique_name);
-    return _add_type(_t,
-                     cmon_typek_array,
-                     _intern_str(_t, "[%lu]%s", _size, cmon_types_name(_t, _type)),
-                     unique_name,
-                     _intern_str(_t, "[%lu]%s", _size, cmon_types_full_name(_t, _type)),
-                     _mod_idx,
-                     CMON_INVALID_IDX,
-                     CMON_INVALID_IDX,
-                     cmon_dyn_arr_count(&_t->arrays) - 1);
-}
-
-static inline const char * _fn_name(cmon_types * _t,
-                                    cmon_idx _ret_type,
-                                    cmon_idx * _params,
-                                    size_t _param_count,
-                                    const char * (*_name_fn)(cmon_types *, cmon_idx))
+    cmon_blk_arr_append(&_t->arrays, arr);
+    return _add_implicit(_t, cmon_typek_array, key, _mod_idx, cmon_blk_arr_count(&_t->arrays) - 1);
+}
+
+static cmon_idx _find_fn(
+    cmon_types * _t, cmon_idx _ret_type, cmon_idx * _params, size_t _param_count, cmon_idx _mod_idx)
 {
+    _fn_sig sig;
+    cmon_idx ret;
     size_t i;
-    cmon_str_builder_clear(_t->str_builder);
-    cmon_str_builder_append(_t->str_builder, "fn(");
+    _implicit_key key = _implicit_key_make(cmon_typek_fn, _ret_type, _param_count, _params);
+    if (cmon_is_valid_idx(ret = _find_implicit(_t, key, _mod_idx)))
+        return ret;
+
+    cmon_dyn_arr_init(&sig.params, _t->alloc, _param_count);
     for (i = 0; i < _param_count; ++i)
     {
-        cmon_str_builder_append(_t->str_builder, _name_fn(_t, _params[i]));
-        if (i < _param_count - 1)
-            cmon_str_builder_append(_t->str_builder, ", ");
+        cmon_dyn_arr_append(&sig.params, _params[i]);
     }
-    cmon_str_builder_append_fmt(_t->str_builder, ")->%s", _name_fn(_t, _ret_type));
-    return cmon_str_builder_c_str(_t->str_builder);
+    sig.return_type = _ret_type;
+    cmon_blk_arr_append(&_t->fns, sig);
+
+    // the stored key must not point at the caller's params
+    key.params = sig.params;
+    return _add_implicit(_t, cmon_typek_fn, key, _mod_idx, cmon_blk_arr_count(&_t->fns) - 1);
+}
+
+cmon_idx cmon_types_find_ptr(cmon_types * _t, cmon_idx _type, cmon_bool _is_mut, cmon_idx _mod_idx)
+{
+    cmon_idx ret;
+    pthread_mutex_lock(&_t->mtx);
+    ret = _find_ptr(_t, _type, _is_mut, _mod_idx);
+    pthread_mutex_unlock(&_t->mtx);
+    return ret;
+}
+
+cmon_idx cmon_types_find_view(cmon_types * _t, cmon_idx _type, cmon_bool _is_mut, cmon_idx _mod_idx)
+{
+    cmon_idx ret;
+    pthread_mutex_lock(&_t->mtx);
+    ret = _find_view(_t, _type, _is_mut, _mod_idx);
+    pthread_mutex_unlock(&_t->mtx);
+    return ret;
+}
+
+cmon_idx cmon_types_find_array(cmon_types * _t, cmon_idx _type, size_t _size, cmon_idx _mod_idx)
+{
+    cmon_idx ret;
+    pthread_mutex_lock(&_t->mtx);
+    ret = _find_array(_t, _type, _size, _mod_idx);
+    pthread_mutex_unlock(&_t->mtx);
+    return ret;
 }
 
 cmon_idx cmon_types_find_fn(
     cmon_types * _t, cmon_idx _ret_type, cmon_idx * _params, size_t _param_count, cmon_idx _mod_idx)
 {
-    _fn_sig sig;
-    const char * unique_name;
+    cmon_idx ret;
+    pthread_mutex_lock(&_t->mtx);
+    ret = _find_fn(_t, _ret_type, _params, _param_count, _mod_idx);
+    pthread_mutex_unlock(&_t->mtx);
+    return ret;
+}
 
-    unique_name = _fn_name(_t, _ret_type, _params, _param_count, cmon_types_unique_name);
+cmon_idx cmon_types_find(cmon_types * _t, const char * _unique_name)
+{
+    cmon_idx ret;
+    pthread_mutex_lock(&_t->mtx);
+    ret = _find(_t, _unique_name);
+    pthread_mutex_unlock(&_t->mtx);
+    return ret;
+}
 
-    _return_if_found(_t, unique_name, _mod_idx);
+static inline const char ** _name_slot(cmon_types * _t, cmon_idx _type_idx, _name_kind _nk)
+{
+    assert(_type_idx < cmon_blk_arr_count(&_t->types));
+    if (_nk == _name_kind_unique)
+        return &cmon_blk_arr_get(&_t->types, _type_idx).unique_name_str;
+    if (_nk == _name_kind_full)
+        return &cmon_blk_arr_get(&_t->types, _type_idx).full_name_str;
+    return &cmon_blk_arr_get(&_t->types, _type_idx).name_str;
+}
 
-    cmon_dyn_arr_init(&sig.params, _t->alloc, _param_count);
+static const char * _gen_name(cmon_types * _t, cmon_idx _type_idx, _name_kind _nk);
 
+// generates the name of a fn type from the (already generated) names of its params and return type
+static inline const char * _gen_fn_name(cmon_types * _t, _fn_sig * _sig, _name_kind _nk)
+{
     size_t i;
-    for (i = 0; i < _param_count; ++i)
+    for (i = 0; i < cmon_dyn_arr_count(&_sig->params); ++i)
     {
-        cmon_dyn_arr_append(&sig.params, _params[i]);
+        _gen_name(_t, _sig->params[i], _nk);
     }
-    sig.return_type = _ret_type;
+    _gen_name(_t, _sig->return_type, _nk);
 
-    cmon_dyn_arr_append(&_t->fns, sig);
-
-    unique_name = _intern_c_str(_t, unique_name);
-    return _add_type(
-        _t,
-        cmon_typek_fn,
-        _intern_str(_t, _fn_name(_t, _ret_type, _params, _param_count, cmon_types_name)),
-        unique_name,
-        _intern_str(_t, _fn_name(_t, _ret_type, _params, _param_count, cmon_types_full_name)),
-        _mod_idx,
-        CMON_INVALID_IDX,
-        CMON_INVALID_IDX,
-        cmon_dyn_arr_count(&_t->fns) - 1);
+    cmon_str_builder_clear(_t->str_builder);
+    cmon_str_builder_append(_t->str_builder, "fn(");
+    for (i = 0; i < cmon_dyn_arr_count(&_sig->params); ++i)
+    {
+        cmon_str_builder_append(_t->str_builder, *_name_slot(_t, _sig->params[i], _nk));
+        if (i < cmon_dyn_arr_count(&_sig->params) - 1)
+            cmon_str_builder_append(_t->str_builder, ", ");
+    }
+    cmon_str_builder_append_fmt(
+        _t->str_builder, ")->%s", *_name_slot(_t, _sig->return_type, _nk));
+    return _intern_c_str(_t, cmon_str_builder_c_str(_t->str_builder));
 }
 
-cmon_idx cmon_types_find(cmon_types * _t, const char * _unique_name)
+// returns the name of a type, generating it first if needed. The element names of implicit types
+// are generated (and interned) before the shared str_builder is used for the type itself. Expects
+// the mutex to be locked.
+static const char * _gen_name(cmon_types * _t, cmon_idx _type_idx, _name_kind _nk)
 {
-    cmon_idx * idx_ptr;
-    if ((idx_ptr = cmon_hashmap_get(&_t->name_map, _unique_name)))
+    const char * ret;
+    const char * elem;
+    const char * mut;
+    size_t count;
+
+    if ((ret = *_name_slot(_t, _type_idx, _nk)))
+        return ret;
+
+    switch (_get_type(_t, _type_idx).kind)
     {
-        return *idx_ptr;
+    case cmon_typek_ptr:
+        elem = _gen_name(_t, _type_data(_t, ptrs, _type_idx).type, _nk);
+        mut = _type_data(_t, ptrs, _type_idx).is_mut ? (_nk == _name_kind_unique ? "Mut" : "mut")
+                                                     : "";
+        ret = _nk == _name_kind_unique ? _intern_str(_t, "Ptr%s_%s", mut, elem)
+                                       : _intern_str(_t, "*%s %s", mut, elem);
+        break;
+    case cmon_typek_view:
+        elem = _gen_name(_t, _type_data(_t, views, _type_idx).type, _nk);
+        mut = _type_data(_t, views, _type_idx).is_mut ? (_nk == _name_kind_unique ? "Mut" : "mut")
+                                                      : "";
+        ret = _nk == _name_kind_unique ? _intern_str(_t, "View%s_%s", mut, elem)
+                                       : _intern_str(_t, "[]%s %s", mut, elem);
+        break;
+    case cmon_typek_array:
+        elem = _gen_name(_t, _type_data(_t, arrays, _type_idx).type, _nk);
+        count = _type_data(_t, arrays, _type_idx).count;
+        ret = _nk == _name_kind_unique ? _intern_str(_t, "Array%lu_%s", count, elem)
+                                       : _intern_str(_t, "[%lu]%s", count, elem);
+        break;
+    case cmon_typek_fn:
+        ret = _gen_fn_name(_t, &_type_data(_t, fns, _type_idx), _nk);
+        break;
+    default:
+        assert(0);
+        return NULL;
     }
-    return CMON_INVALID_IDX;
+
+    //@NOTE: _name reads the slot without locking, so the name has to be published with release
+    // semantics.
+    __atomic_store_n(_name_slot(_t, _type_idx, _nk), ret, __ATOMIC_RELEASE);
+    return ret;
+}
+
+static inline const char * _name(cmon_types * _t, cmon_idx _type_idx, _name_kind _nk)
+{
+    const char * ret;
+    if ((ret = __atomic_load_n(_name_slot(_t, _type_idx, _nk), __ATOMIC_ACQUIRE)))
+        return ret;
+
+    pthread_mutex_lock(&_t->mtx);
+    ret = _gen_name(_t, _type_idx, _nk);
+    pthread_mutex_unlock(&_t->mtx);
+    return ret;
 }
 
 const char * cmon_types_unique_name(cmon_types * _t, cmon_idx _type_idx)
 {
-    return _get_type(_t, _type_idx).unique_name_str;
+    return _name(_t, _type_idx, _name_kind_unique);
 }
 
 const char * cmon_types_name(cmon_types * _t, cmon_idx _type_idx)
 {
-    return _get_type(_t, _type_idx).name_str;
+    return _name(_t, _type_idx, _name_kind_name);
 }
 
 const char * cmon_types_full_name(cmon_types * _t, cmon_idx _type_idx)
 {
-    return _get_type(_t, _type_idx).full_name_str;
+    return _name(_t, _type_idx, _name_kind_full);
 }
 
 cmon_typek cmon_types_kind(cmon_types * _t, cmon_idx _type_idx)
@@ -481,16 +710,16 @@ static inline _struct_field * _get_struct_field(cmon_types * _t,
                                                 cmon_idx _field_idx)
 {
     assert(_get_type(_t, _struct_idx).kind == cmon_typek_struct);
-    assert(_t->types[_struct_idx].data_idx < cmon_dyn_arr_count(&_t->structs));
-    assert(_field_idx < cmon_dyn_arr_count(&_t->structs[_t->types[_struct_idx].data_idx].fields));
-    return &_t->structs[_t->types[_struct_idx].data_idx].fields[_field_idx];
+    assert(_get_type(_t, _struct_idx).data_idx < cmon_blk_arr_count(&_t->structs));
+    assert(_field_idx < cmon_dyn_arr_count(&_type_data(_t, structs, _struct_idx).fields));
+    return &_type_data(_t, structs, _struct_idx).fields[_field_idx];
 }
 
 size_t cmon_types_struct_field_count(cmon_types * _t, cmon_idx _struct_idx)
 {
     assert(_get_type(_t, _struct_idx).kind == cmon_typek_struct);
-    assert(_t->types[_struct_idx].data_idx < cmon_dyn_arr_count(&_t->structs));
-    return cmon_dyn_arr_count(&_t->structs[_t->types[_struct_idx].data_idx].fields);
+    assert(_get_type(_t, _struct_idx).data_idx < cmon_blk_arr_count(&_t->structs));
+    return cmon_dyn_arr_count(&_type_data(_t, structs, _struct_idx).fields);
 }
 
 const char * cmon_types_struct_field_name(cmon_types * _t,
@@ -534,59 +763,59 @@ cmon_idx cmon_types_struct_findv_field(cmon_types * _t, cmon_idx _struct_idx, cm
 cmon_bool cmon_types_ptr_is_mut(cmon_types * _t, cmon_idx _ptr_idx)
 {
     assert(_get_type(_t, _ptr_idx).kind == cmon_typek_ptr);
-    return _t->ptrs[_t->types[_ptr_idx].data_idx].is_mut;
+    return _type_data(_t, ptrs, _ptr_idx).is_mut;
 }
 
 cmon_idx cmon_types_ptr_type(cmon_types * _t, cmon_idx _ptr_idx)
 {
     assert(_get_type(_t, _ptr_idx).kind == cmon_typek_ptr);
-    return _t->ptrs[_t->types[_ptr_idx].data_idx].type;
+    return _type_data(_t, ptrs, _ptr_idx).type;
 }
 
 cmon_bool cmon_types_view_is_mut(cmon_types * _t, cmon_idx _v_idx)
 {
     assert(_get_type(_t, _v_idx).kind == cmon_typek_view);
-    return _t->views[_t->types[_v_idx].data_idx].is_mut;
+    return _type_data(_t, views, _v_idx).is_mut;
 }
 
 cmon_idx cmon_types_view_type(cmon_types * _t, cmon_idx _v_idx)
 {
     assert(_get_type(_t, _v_idx).kind == cmon_typek_view);
-    return _t->views[_t->types[_v_idx].data_idx].type;
+    return _type_data(_t, views, _v_idx).type;
 }
 
 size_t cmon_types_array_count(cmon_types * _t, cmon_idx _arr_idx)
 {
     assert(_get_type(_t, _arr_idx).kind == cmon_typek_array);
-    return _t->arrays[_t->types[_arr_idx].data_idx].count;
+    return _type_data(_t, arrays, _arr_idx).count;
 }
 
 cmon_idx cmon_types_array_type(cmon_types * _t, cmon_idx _arr_idx)
 {
     assert(_get_type(_t, _arr_idx).kind == cmon_typek_array);
-    return _t->arrays[_t->types[_arr_idx].data_idx].type;
+    return _type_data(_t, arrays, _arr_idx).type;
 }
 
 cmon_idx cmon_types_fn_param_count(cmon_types * _t, cmon_idx _fn_idx)
 {
     assert(_get_type(_t, _fn_idx).kind == cmon_typek_fn);
-    assert(_t->types[_fn_idx].data_idx < cmon_dyn_arr_count(&_t->fns));
-    return cmon_dyn_arr_count(&_t->fns[_t->types[_fn_idx].data_idx].params);
+    assert(_get_type(_t, _fn_idx).data_idx < cmon_blk_arr_count(&_t->fns));
+    return cmon_dyn_arr_count(&_type_data(_t, fns, _fn_idx).params);
 }
 
 cmon_idx cmon_types_fn_param(cmon_types * _t, cmon_idx _fn_idx, cmon_idx _param_idx)
 {
     assert(_get_type(_t, _fn_idx).kind == cmon_typek_fn);
-    assert(_t->types[_fn_idx].data_idx < cmon_dyn_arr_count(&_t->fns));
-    assert(_param_idx < cmon_dyn_arr_count(&_t->fns[_t->types[_fn_idx].data_idx].params));
-    return _t->fns[_t->types[_fn_idx].data_idx].params[_param_idx];
+    assert(_get_type(_t, _fn_idx).data_idx < cmon_blk_arr_count(&_t->fns));
+    assert(_param_idx < cmon_dyn_arr_count(&_type_data(_t, fns, _fn_idx).params));
+    return _type_data(_t, fns, _fn_idx).params[_param_idx];
 }
 
 cmon_idx cmon_types_fn_return_type(cmon_types * _t, cmon_idx _fn_idx)
 {
     assert(_get_type(_t, _fn_idx).kind == cmon_typek_fn);
-    assert(_t->types[_fn_idx].data_idx < cmon_dyn_arr_count(&_t->fns));
-    return _t->fns[_t->types[_fn_idx].data_idx].return_type;
+    assert(_get_type(_t, _fn_idx).data_idx < cmon_blk_arr_count(&_t->fns));
+    return _type_data(_t, fns, _fn_idx).return_type;
 }
 
 cmon_idx cmon_types_builtin_s8(cmon_types * _t)
@@ -724,17 +953,30 @@ cmon_bool cmon_types_is_implicit(cmon_types * _t, cmon_idx _idx)
 }
 
 void cmon_types_set_used_in_module(cmon_types * _tr, cmon_idx _idx, cmon_idx _mod_idx)
-{   
-    _get_type(_tr, _idx).mod_map[_mod_idx] = cmon_true;
+{
+    assert(_idx < cmon_blk_arr_count(&_tr->types));
+    //@NOTE: the files of a module might be resolved concurrently
+    pthread_mutex_lock(&_tr->mtx);
+    _set_used(_tr, _idx, _mod_idx);
+    pthread_mutex_unlock(&_tr->mtx);
 }
 
 cmon_bool cmon_types_is_used_in_module(cmon_types * _tr, cmon_idx _idx, cmon_idx _mod_idx)
 {
-    for(size_t i = 0; i< cmon_modules_count(_tr->mods); ++i)
-    {
-        printf("%s %s\n", cmon_modules_name(_tr->mods, i), _get_type(_tr, _idx).mod_map[i] ? "true" : "false");
-    }
-    return _get_type(_tr, _idx).mod_map[_mod_idx];
+    assert(_mod_idx < cmon_dyn_arr_count(&_tr->mod_usage));
+    return cmon_hashmap_get(&_tr->mod_usage[_mod_idx].lookup, _idx) != NULL;
+}
+
+size_t cmon_types_used_in_module_count(cmon_types * _tr, cmon_idx _mod_idx)
+{
+    assert(_mod_idx < cmon_dyn_arr_count(&_tr->mod_usage));
+    return cmon_dyn_arr_count(&_tr->mod_usage[_mod_idx].types);
+}
+
+cmon_idx cmon_types_used_in_module_type(cmon_types * _tr, cmon_idx _mod_idx, size_t _idx)
+{
+    assert(_idx < cmon_types_used_in_module_count(_tr, _mod_idx));
+    return _tr->mod_usage[_mod_idx].types[_idx];
 }
 
 const char * cmon_typek_to_str(cmon_typek _kind)
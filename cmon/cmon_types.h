@@ -39,6 +39,8 @@ typedef struct cmon_types cmon_types;
 CMON_API cmon_types * cmon_types_create(cmon_allocator * _alloc, cmon_modules * _mods);
 CMON_API void cmon_types_destroy(cmon_types * _tr);
 CMON_API size_t cmon_types_count(cmon_types * _tr);
+// Creating types (i.e. the find_* functions below) is thread safe. Reading type information is lock
+// free, the type storage never moves while other threads add types.
 CMON_API cmon_idx cmon_types_add_struct(
     cmon_types * _tr, cmon_idx _mod, cmon_str_view _name, cmon_idx _src_idx, cmon_idx _name_tok);
 CMON_API cmon_idx cmon_types_struct_add_field(cmon_types * _tr,
@@ -47,7 +49,8 @@ CMON_API cmon_idx cmon_types_struct_add_field(cmon_types * _tr,
                                               cmon_idx _type,
                                               cmon_idx _def_expr_ast);
 
-//these will either find implicit types or create them if they don't exist yet
+//these will either find implicit types or create them if they don't exist yet. Implicit types are
+//looked up by their structure, their names are only generated once they are asked for.
 CMON_API cmon_idx cmon_types_find_ptr(cmon_types * _tr, cmon_idx _type, cmon_bool _is_mut, cmon_idx _mod_idx);
 CMON_API cmon_idx cmon_types_find_view(cmon_types * _tr, cmon_idx _type, cmon_bool _is_mut, cmon_idx _mod_idx);
 CMON_API cmon_idx cmon_types_find_array(cmon_types * _tr, cmon_idx _type, size_t _size, cmon_idx _mod_idx);
@@ -56,7 +59,7 @@ CMON_API cmon_idx cmon_types_find_fn(cmon_types * _tr,
                                      cmon_idx * _params,
                                      size_t _param_count, cmon_idx _mod_idx);
 
-//find a type by unique name
+//find a named type (builtin or struct) by unique name
 CMON_API cmon_idx cmon_types_find(cmon_types * _t, const char * _unique_name);
 
 //basic getters
@@ -134,6 +137,9 @@ CMON_API cmon_idx cmon_types_remove_ptr(cmon_types * _tr, cmon_idx _idx);
 CMON_API cmon_bool cmon_types_is_implicit(cmon_types * _tr, cmon_idx _idx);
 CMON_API void cmon_types_set_used_in_module(cmon_types * _tr, cmon_idx _idx, cmon_idx _mod_idx);
 CMON_API cmon_bool cmon_types_is_used_in_module(cmon_types * _tr, cmon_idx _idx, cmon_idx _mod_idx);
+// iterates the types used by a module in the order it started using them
+CMON_API size_t cmon_types_used_in_module_count(cmon_types * _tr, cmon_idx _mod_idx);
+CMON_API cmon_idx cmon_types_used_in_module_type(cmon_types * _tr, cmon_idx _mod_idx, size_t _idx);
 CMON_API const char * cmon_typek_to_str(cmon_typek _kind);
 
 #endif // CMON_CMON_TYPES_H
@@ -27,4 +27,50 @@ CMON_API void cmon_panic(const char * _fmt, ...);
 #define _CMON_VARARG_APPEND_LAST(last, ...) _CMON_VARARGS_COMBINE(__VA_ARGS__, last)
 // #define _CMON_VARARG_APPEND_LAST(last, ...) _CMON_VARARG_APPEND_LAST_IMPL(last, ##__VA_ARGS__)
 
+// helper macros to combine the results of applying _fn to each of up to 32 variadic arguments
+// with |, i.e. _CMON_MAP_OR(_fn, a, b) expands to (_fn(a) | _fn(b)).
+#define _CMON_NARGS(...)                                                                           \
+    _CMON_NARGS_IMPL(__VA_ARGS__, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17,  \
+                     16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1)
+#define _CMON_NARGS_IMPL(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16,    \
+                         _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30,     \
+                         _31, _32, _n, ...)                                                        \
+    _n
+#define _CMON_CONCAT(_a, _b) _CMON_CONCAT_IMPL(_a, _b)
+#define _CMON_CONCAT_IMPL(_a, _b) _a##_b
+#define _CMON_MAP_OR(_fn, ...)                                                                     \
+    (_CMON_CONCAT(_CMON_MAP_OR_, _CMON_NARGS(__VA_ARGS__))(_fn, __VA_ARGS__))
+#define _CMON_MAP_OR_1(_fn, _x) _fn(_x)
+#define _CMON_MAP_OR_2(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_1(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_3(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_2(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_4(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_3(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_5(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_4(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_6(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_5(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_7(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_6(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_8(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_7(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_9(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_8(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_10(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_9(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_11(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_10(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_12(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_11(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_13(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_12(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_14(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_13(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_15(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_14(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_16(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_15(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_17(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_16(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_18(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_17(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_19(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_18(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_20(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_19(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_21(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_20(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_22(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_21(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_23(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_22(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_24(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_23(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_25(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_24(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_26(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_25(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_27(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_26(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_28(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_27(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_29(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_28(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_30(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_29(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_31(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_30(_fn, __VA_ARGS__)
+#define _CMON_MAP_OR_32(_fn, _x, ...) _fn(_x) | _CMON_MAP_OR_31(_fn, __VA_ARGS__)
+
 #endif //CMON_CMON_UTIL_H
@@ -0,0 +1,573 @@
+#include <cmon/cmon_codegen_c.h>
+#include <cmon/cmon_dyn_arr.h>
+#include <cmon/cmon_fs.h>
+#include <cmon/cmon_hashmap.h>
+#include <cmon/cmon_interner.h>
+#include <cmon/cmon_mem_stats.h>
+#include <cmon/cmon_parser.h>
+#include <cmon/cmon_resolver.h>
+#include <cmon/cmon_src.h>
+#include <cmon/cmon_str_builder.h>
+#include <cmon/cmon_tokens.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// micro benchmarks for the core containers and the compiler stages, run via meson benchmark.
+// Usage: cmon_bench [function_count] [iterations] [json_output_path]
+// function_count scales the size of all synthetic inputs. The results are written as json to
+// json_output_path, or to stdout if it is omitted.
+
+#define _BENCH_BUILD_DIR "cmon_bench_build"
+
+static double _now_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1000000.0;
+}
+
+// keeps the compiler from optimizing away the work of the container benchmarks
+static volatile size_t _sink;
+
+typedef struct
+{
+    const char * name;
+    size_t items;
+    size_t bytes;
+    double best_ms;
+    double total_ms;
+    size_t runs;
+} _result;
+
+typedef cmon_dyn_arr(_result) _results;
+
+static _result _result_make(const char * _name, size_t _items, size_t _bytes)
+{
+    _result ret;
+    ret.name = _name;
+    ret.items = _items;
+    ret.bytes = _bytes;
+    ret.best_ms = 0;
+    ret.total_ms = 0;
+    ret.runs = 0;
+    return ret;
+}
+
+static void _result_add_run(_result * _r, double _ms)
+{
+    if (!_r->runs || _ms < _r->best_ms)
+        _r->best_ms = _ms;
+    _r->total_ms += _ms;
+    ++_r->runs;
+}
+
+// generates a source file with a typical mix of keywords, identifiers, literals and operators
+static void _gen_src(cmon_str_builder * _b, size_t _fn_count)
+{
+    size_t i;
+    cmon_str_builder_append(_b, "module bench\n\nimport foo\n\n");
+    for (i = 0; i < _fn_count; ++i)
+    {
+        cmon_str_builder_append_fmt(
+            _b,
+            "// function number %lu\n"
+            "pub fn compute_%lu(a : s32, b : s32, values : []f32) -> s32\n"
+            "{\n"
+            "    mut result := a + b * %lu;\n"
+            "    for i in 0..len(values) { result = result + values[i] as s32; }\n"
+            "    if result > 10 && !is_done { result -= 1; } else { result = 0; }\n"
+            "    scoped := foo.bar(result, 1.5, \"string literal\");\n"
+            "    return result;\n"
+            "}\n\n",
+            i,
+            i,
+            i);
+    }
+}
+
+// generates a source file that looks like generated code, i.e. an embedded data table with wide
+// alignment, long comments and long string literals
+static void _gen_table_src(cmon_str_builder * _b, size_t _row_count)
+{
+    size_t i;
+    cmon_str_builder_append(_b, "module bench\n\n");
+    cmon_str_builder_append(_b,
+                            "/*\n * This table was generated by a tool, do not edit it by hand.\n"
+                            " * Each row contains the name and the coefficients of one entry."
+                            "\n */\n");
+    cmon_str_builder_append(_b, "pub table := [\n");
+    for (i = 0; i < _row_count; ++i)
+    {
+        cmon_str_builder_append_fmt(
+            _b,
+            "                                        // entry %lu, see the generator for details "
+            "on how these values are computed\n"
+            "                                        (\"entry_name_number_%lu_with_a_long_"
+            "descriptive_suffix\",                        %lu,                %lu),\n",
+            i,
+            i,
+            i,
+            i * 7);
+    }
+    cmon_str_builder_append(_b, "];\n");
+}
+
+// generates a module that parses and resolves, i.e. for the ast size measurement
+static void _gen_module_src(cmon_str_builder * _b, size_t _fn_count)
+{
+    size_t i;
+    cmon_str_builder_append(_b, "module bench\n\nhelper := fn(a : s32) -> s32 {}\n\n");
+    for (i = 0; i < _fn_count; ++i)
+    {
+        cmon_str_builder_append_fmt(
+            _b,
+            "// function number %lu\n"
+            "pub struct Vec%lu\n"
+            "{\n"
+            "    x : s32\n"
+            "    y : s32 = 2\n"
+            "}\n\n"
+            "pub compute%lu := fn(a : s32, mut b : s32, v : Vec%lu) -> s32\n"
+            "{\n"
+            "    mut result := a + b * %lu\n"
+            "    result = result - (a * 3 + 1) / 2\n"
+            "    result = result + v.x * v.y\n"
+            "    tmp := Vec%lu{result, (a + 2) * 3}\n"
+            "    result = result + tmp.y - tmp.x\n"
+            "    result = helper(result) * 2\n"
+            "}\n\n",
+            i,
+            i,
+            i,
+            i,
+            i,
+            i);
+    }
+}
+
+typedef void (*_gen_fn)(cmon_str_builder *, size_t);
+
+static void _bench_dyn_arr(cmon_allocator * _alloc, _results * _res, size_t _count, size_t _iter)
+{
+    _result r = _result_make("dyn_arr_append_iterate", _count, _count * sizeof(size_t));
+    cmon_dyn_arr(size_t) arr;
+    size_t i, j, sum;
+    double start;
+
+    for (i = 0; i < _iter; ++i)
+    {
+        start = _now_ms();
+        cmon_dyn_arr_init(&arr, _alloc, 16);
+        for (j = 0; j < _count; ++j)
+        {
+            cmon_dyn_arr_append(&arr, j);
+        }
+        for (sum = 0, j = 0; j < cmon_dyn_arr_count(&arr); ++j)
+        {
+            sum += arr[j];
+        }
+        cmon_dyn_arr_dealloc(&arr);
+        _result_add_run(&r, _now_ms() - start);
+        _sink = sum;
+    }
+    cmon_dyn_arr_append(_res, r);
+}
+
+static void _bench_hashmap(cmon_allocator * _alloc, _results * _res, size_t _count, size_t _iter)
+{
+    _result insert = _result_make("hashmap_insert", _count, 0);
+    _result find = _result_make("hashmap_find", _count, 0);
+    cmon_hashmap(uint64_t, size_t) map;
+    size_t i, j, found;
+    double start;
+
+    for (i = 0; i < _iter; ++i)
+    {
+        cmon_hashmap_int_key_init(&map, _alloc);
+        start = _now_ms();
+        for (j = 0; j < _count; ++j)
+        {
+            cmon_hashmap_set(&map, (uint64_t)j * 7919, j);
+        }
+        _result_add_run(&insert, _now_ms() - start);
+
+        // every other lookup misses
+        start = _now_ms();
+        for (found = 0, j = 0; j < _count; ++j)
+        {
+            if (cmon_hashmap_get(&map, (uint64_t)j * 7919 + (j & 1)))
+                ++found;
+        }
+        _result_add_run(&find, _now_ms() - start);
+        _sink = found;
+        cmon_hashmap_dealloc(&map);
+    }
+    cmon_dyn_arr_append(_res, insert);
+    cmon_dyn_arr_append(_res, find);
+}
+
+static void _bench_str_builder(cmon_allocator * _alloc,
+                               _results * _res,
+                               size_t _count,
+                               size_t _iter)
+{
+    _result r = _result_make("str_builder_append", _count, 0);
+    cmon_str_builder * b;
+    size_t i, j;
+    double start;
+
+    for (i = 0; i < _iter; ++i)
+    {
+        start = _now_ms();
+        b = cmon_str_builder_create(_alloc, 64);
+        for (j = 0; j < _count; ++j)
+        {
+            cmon_str_builder_append(b, "    result = ");
+            cmon_str_builder_append_fmt(b, "value_%lu + %lu;\n", j, j * 3);
+        }
+        r.bytes = cmon_str_builder_count(b);
+        cmon_str_builder_destroy(b);
+        _result_add_run(&r, _now_ms() - start);
+    }
+    cmon_dyn_arr_append(_res, r);
+}
+
+static void _bench_tokenize(cmon_allocator * _alloc,
+                            _results * _res,
+                            const char * _name,
+                            _gen_fn _gen,
+                            size_t _count,
+                            size_t _iter)
+{
+    _result r = _result_make(_name, 0, 0);
+    cmon_str_builder * b;
+    cmon_src * src;
+    cmon_idx src_idx;
+    cmon_tokens * tokens;
+    cmon_err_report err;
+    size_t i;
+    double start;
+
+    b = cmon_str_builder_create(_alloc, 1024 * 1024);
+    _gen(b, _count);
+    r.bytes = cmon_str_builder_count(b);
+
+    src = cmon_src_create(_alloc);
+    src_idx = cmon_src_add(src, "bench.cmon", "bench.cmon");
+    cmon_src_set_code_ref(src, src_idx, cmon_str_builder_c_str(b));
+
+    for (i = 0; i < _iter; ++i)
+    {
+        start = _now_ms();
+        tokens = cmon_tokenize(_alloc, src, src_idx, &err);
+        _result_add_run(&r, _now_ms() - start);
+        r.items = cmon_tokens_count(tokens);
+        cmon_tokens_destroy(tokens);
+    }
+    cmon_dyn_arr_append(_res, r);
+
+    cmon_src_destroy(src);
+    cmon_str_builder_destroy(b);
+}
+
+// everything needed to compile the generated module in isolation
+typedef struct
+{
+    cmon_src * src;
+    cmon_modules * mods;
+    cmon_interner * interner;
+    cmon_symbols * symbols;
+    cmon_types * types;
+    cmon_tokens * tokens;
+    cmon_parser * parser;
+    cmon_resolver * resolver;
+    cmon_idx src_idx;
+    cmon_idx mod_idx;
+} _pipeline;
+
+static void _pipeline_init(_pipeline * _p, cmon_allocator * _alloc, const char * _code)
+{
+    cmon_err_report err;
+    _p->src = cmon_src_create(_alloc);
+    _p->src_idx = cmon_src_add(_p->src, "bench.cmon", "bench.cmon");
+    cmon_src_set_code_ref(_p->src, _p->src_idx, _code);
+    _p->mods = cmon_modules_create(_alloc, _p->src);
+    _p->mod_idx = cmon_modules_add(_p->mods, "bench", "bench");
+    cmon_modules_add_src_file(_p->mods, _p->mod_idx, _p->src_idx);
+    _p->interner = cmon_interner_create(_alloc);
+    _p->symbols = cmon_symbols_create(_alloc, _p->src, _p->mods, _p->interner);
+    _p->types = cmon_types_create(_alloc, _p->mods);
+    _p->tokens =
+        cmon_tokenize_with_interner(_alloc, _p->src, _p->interner, _p->src_idx, &err);
+    _p->parser = cmon_parser_create(_alloc);
+    _p->resolver = cmon_resolver_create(_alloc, 1);
+}
+
+static void _pipeline_dealloc(_pipeline * _p)
+{
+    cmon_resolver_destroy(_p->resolver);
+    cmon_parser_destroy(_p->parser);
+    cmon_tokens_destroy(_p->tokens);
+    cmon_types_destroy(_p->types);
+    cmon_symbols_destroy(_p->symbols);
+    cmon_interner_destroy(_p->interner);
+    cmon_modules_destroy(_p->mods);
+    cmon_src_destroy(_p->src);
+}
+
+static void _pipeline_fail(_pipeline * _p, const char * _stage)
+{
+    cmon_err_report * errs;
+    size_t count;
+    cmon_resolver_errors(_p->resolver, &errs, &count);
+    fprintf(stderr, "cmon_bench: %s failed: %s\n", _stage, count ? errs[0].msg : "");
+    exit(EXIT_FAILURE);
+}
+
+#define _TIME_PASS(_r, _p, _stage, _expr)                                                          \
+    do                                                                                             \
+    {                                                                                              \
+        double start = _now_ms();                                                                  \
+        if (_expr)                                                                                 \
+            _pipeline_fail((_p), (_stage));                                                        \
+        _result_add_run((_r), _now_ms() - start);                                                  \
+    } while (0)
+
+// times parsing, each resolver pass and the c code generation of the module workload. The c
+// compiler runs asynchronously, waiting for it is not part of the codegen timing.
+static void _bench_pipeline(cmon_allocator * _alloc, _results * _res, size_t _count, size_t _iter)
+{
+    _result parse, top_lvl, usertypes, globals, def_expr, main_pass, circ, ir, codegen;
+    cmon_str_builder * b;
+    cmon_codegen cgen;
+    cmon_idx session;
+    _pipeline p;
+    cmon_ir * ir_out;
+    size_t i, line_count, byte_count;
+    const char * c;
+
+    b = cmon_str_builder_create(_alloc, 1024 * 1024);
+    _gen_module_src(b, _count);
+    byte_count = cmon_str_builder_count(b);
+    for (line_count = 1, c = cmon_str_builder_c_str(b); *c; ++c)
+    {
+        if (*c == '\n')
+            ++line_count;
+    }
+
+    parse = _result_make("parse", line_count, byte_count);
+    top_lvl = _result_make("resolve_top_lvl", line_count, byte_count);
+    usertypes = _result_make("resolve_usertypes", line_count, byte_count);
+    globals = _result_make("resolve_globals", line_count, byte_count);
+    def_expr = _result_make("resolve_usertypes_def_expr", line_count, byte_count);
+    main_pass = _result_make("resolve_main", line_count, byte_count);
+    circ = _result_make("resolve_circ", line_count, byte_count);
+    ir = _result_make("resolve_finalize_ir", line_count, byte_count);
+    codegen = _result_make("codegen_c", line_count, byte_count);
+
+    if (!cmon_fs_exists(_BENCH_BUILD_DIR) && cmon_fs_mkdir(_BENCH_BUILD_DIR) == -1)
+    {
+        fprintf(stderr, "cmon_bench: could not create %s\n", _BENCH_BUILD_DIR);
+        exit(EXIT_FAILURE);
+    }
+    cgen = cmon_codegen_c_make(_alloc);
+
+    for (i = 0; i < _iter; ++i)
+    {
+        _pipeline_init(&p, _alloc, cmon_str_builder_c_str(b));
+
+        double start = _now_ms();
+        if (!cmon_parser_parse(p.parser, p.src, p.src_idx, p.tokens))
+        {
+            cmon_err_report err = cmon_parser_err(p.parser);
+            fprintf(stderr, "cmon_bench: parsing failed: %s\n", err.msg);
+            exit(EXIT_FAILURE);
+        }
+        _result_add_run(&parse, _now_ms() - start);
+
+        cmon_resolver_set_input(p.resolver, p.src, p.types, p.symbols, p.mods, p.mod_idx);
+        _TIME_PASS(&top_lvl,
+                   &p,
+                   "top level pass",
+                   cmon_resolver_top_lvl_pass(p.resolver, 0) ||
+                       cmon_resolver_finalize_top_lvl_names(p.resolver));
+        _TIME_PASS(
+            &usertypes, &p, "user type pass", cmon_resolver_usertypes_pass(p.resolver, 0));
+        _TIME_PASS(&globals, &p, "globals pass", cmon_resolver_globals_pass(p.resolver));
+        _TIME_PASS(&def_expr,
+                   &p,
+                   "user type default expression pass",
+                   cmon_resolver_usertypes_def_expr_pass(p.resolver, 0));
+        _TIME_PASS(&main_pass, &p, "main pass", cmon_resolver_main_pass(p.resolver, 0));
+        _TIME_PASS(&circ, &p, "dependency order pass", cmon_resolver_circ_pass(p.resolver));
+        _TIME_PASS(&ir, &p, "IR generation", !(ir_out = cmon_resolver_finalize(p.resolver)));
+
+        if (cmon_codegen_prepare(&cgen, p.mods, p.types, _BENCH_BUILD_DIR))
+        {
+            fprintf(stderr, "cmon_bench: codegen failed: %s\n", cmon_codegen_err_msg(&cgen));
+            exit(EXIT_FAILURE);
+        }
+        start = _now_ms();
+        session = cmon_codegen_begin_session(&cgen, p.mod_idx, ir_out);
+        if (cmon_codegen_gen(&cgen, session))
+        {
+            fprintf(stderr,
+                    "cmon_bench: codegen failed: %s\n",
+                    cmon_codegen_session_err_msg(&cgen, session));
+            exit(EXIT_FAILURE);
+        }
+        cmon_codegen_end_session(&cgen, session);
+        _result_add_run(&codegen, _now_ms() - start);
+        //@NOTE: the generated code is not the point here, c compiler errors are ignored.
+        cmon_codegen_finish(&cgen);
+
+        _pipeline_dealloc(&p);
+    }
+
+    cmon_dyn_arr_append(_res, parse);
+    cmon_dyn_arr_append(_res, top_lvl);
+    cmon_dyn_arr_append(_res, usertypes);
+    cmon_dyn_arr_append(_res, globals);
+    cmon_dyn_arr_append(_res, def_expr);
+    cmon_dyn_arr_append(_res, main_pass);
+    cmon_dyn_arr_append(_res, circ);
+    cmon_dyn_arr_append(_res, ir);
+    cmon_dyn_arr_append(_res, codegen);
+
+    cmon_codegen_dealloc(&cgen);
+    cmon_str_builder_destroy(b);
+}
+
+// measures how much memory the ast of the module workload takes per source line. The parser
+// allocates through a mem stats allocator so that the growth slack of the builder is included.
+static void _bench_ast_size(cmon_allocator * _alloc, cmon_str_builder * _json, size_t _count)
+{
+    cmon_str_builder * b;
+    cmon_src * src;
+    cmon_idx src_idx;
+    cmon_tokens * tokens;
+    cmon_parser * parser;
+    cmon_mem_stats * stats;
+    cmon_allocator parser_alloc;
+    cmon_ast * ast;
+    cmon_err_report err;
+    const char * code;
+    size_t line_count;
+
+    b = cmon_str_builder_create(_alloc, 1024 * 1024);
+    _gen_module_src(b, _count);
+    code = cmon_str_builder_c_str(b);
+    for (line_count = 1; *code; ++code)
+    {
+        if (*code == '\n')
+            ++line_count;
+    }
+
+    src = cmon_src_create(_alloc);
+    src_idx = cmon_src_add(src, "bench.cmon", "bench.cmon");
+    cmon_src_set_code_ref(src, src_idx, cmon_str_builder_c_str(b));
+    tokens = cmon_tokenize(_alloc, src, src_idx, &err);
+
+    stats = cmon_mem_stats_create(_alloc);
+    parser_alloc = cmon_mem_stats_allocator(stats, _alloc, "parser");
+    parser = cmon_parser_create(&parser_alloc);
+    ast = cmon_parser_parse(parser, src, src_idx, tokens);
+    if (ast)
+    {
+        cmon_str_builder_append_fmt(_json,
+                                    "  \"ast\": { \"lines\": %lu, \"nodes\": %lu, "
+                                    "\"bytes_per_line\": %.1f, \"allocated_bytes_per_line\": %.1f "
+                                    "},\n",
+                                    line_count,
+                                    cmon_ast_count(ast),
+                                    (double)cmon_ast_byte_count(ast) / (double)line_count,
+                                    (double)cmon_mem_stats_peak(stats) / (double)line_count);
+    }
+    else
+    {
+        err = cmon_parser_err(parser);
+        fprintf(stderr, "cmon_bench: failed to parse the generated code: %s\n", err.msg);
+        exit(EXIT_FAILURE);
+    }
+
+    cmon_parser_destroy(parser);
+    cmon_mem_stats_destroy(stats);
+    cmon_tokens_destroy(tokens);
+    cmon_src_destroy(src);
+    cmon_str_builder_destroy(b);
+}
+
+static void _write_results(cmon_str_builder * _json, _results * _res)
+{
+    size_t i;
+    cmon_str_builder_append(_json, "  \"results\": [\n");
+    for (i = 0; i < cmon_dyn_arr_count(_res); ++i)
+    {
+        _result * r = &(*_res)[i];
+        cmon_str_builder_append_fmt(
+            _json,
+            "    { \"name\": \"%s\", \"items\": %lu, \"bytes\": %lu, \"runs\": %lu, "
+            "\"best_ms\": %.4f, \"mean_ms\": %.4f, \"items_per_sec\": %.0f }%s\n",
+            r->name,
+            r->items,
+            r->bytes,
+            r->runs,
+            r->best_ms,
+            r->total_ms / (double)r->runs,
+            r->best_ms > 0 ? (double)r->items / r->best_ms * 1000.0 : 0.0,
+            i + 1 < cmon_dyn_arr_count(_res) ? "," : "");
+    }
+    cmon_str_builder_append(_json, "  ]\n");
+}
+
+int main(int _argc, const char * _args[])
+{
+    cmon_allocator alloc = cmon_mallocator_make();
+    size_t fn_count = _argc > 1 ? strtoul(_args[1], NULL, 10) : 2000;
+    size_t iterations = _argc > 2 ? strtoul(_args[2], NULL, 10) : 5;
+    const char * out_path = _argc > 3 ? _args[3] : NULL;
+    cmon_str_builder * json;
+    _results results;
+    int ret = EXIT_SUCCESS;
+
+    if (!fn_count || !iterations)
+    {
+        fprintf(stderr, "usage: cmon_bench [function_count] [iterations] [json_output_path]\n");
+        return EXIT_FAILURE;
+    }
+
+    json = cmon_str_builder_create(&alloc, 4096);
+    cmon_dyn_arr_init(&results, &alloc, 32);
+
+    _bench_dyn_arr(&alloc, &results, fn_count * 100, iterations);
+    _bench_hashmap(&alloc, &results, fn_count * 100, iterations);
+    _bench_str_builder(&alloc, &results, fn_count * 100, iterations);
+    _bench_tokenize(&alloc, &results, "tokenize_code", _gen_src, fn_count, iterations);
+    _bench_tokenize(&alloc, &results, "tokenize_table", _gen_table_src, fn_count * 4, iterations);
+    _bench_pipeline(&alloc, &results, fn_count, iterations);
+
+    cmon_str_builder_append_fmt(json,
+                                "{\n  \"function_count\": %lu,\n  \"iterations\": %lu,\n",
+                                fn_count,
+                                iterations);
+    _bench_ast_size(&alloc, json, fn_count);
+    _write_results(json, &results);
+    cmon_str_builder_append(json, "}\n");
+
+    if (!out_path)
+    {
+        fputs(cmon_str_builder_c_str(json), stdout);
+    }
+    else if (cmon_fs_write_txt_file(out_path, cmon_str_builder_c_str(json)) == -1)
+    {
+        fprintf(stderr, "cmon_bench: could not write %s\n", out_path);
+        ret = EXIT_FAILURE;
+    }
+
+    cmon_dyn_arr_dealloc(&results);
+    cmon_str_builder_destroy(json);
+    cmon_allocator_dealloc(&alloc);
+    return ret;
+}
@@ -1,15 +1,20 @@
 #include "utest.h"
 #include <cmon/cmon_argparse.h>
+#include <cmon/cmon_blk_arr.h>
+#include <cmon/cmon_builder_mt.h>
 #include <cmon/cmon_builder_st.h>
 #include <cmon/cmon_codegen_c.h>
 #include <cmon/cmon_dep_graph.h>
 #include <cmon/cmon_dyn_arr.h>
 #include <cmon/cmon_fs.h>
 #include <cmon/cmon_hashmap.h>
+#include <cmon/cmon_interner.h>
 #include <cmon/cmon_log.h>
+#include <cmon/cmon_mod_iface.h>
 #include <cmon/cmon_parser.h>
 #include <cmon/cmon_pm.h>
 #include <cmon/cmon_resolver.h>
+#include <cmon/cmon_scan.h>
 #include <cmon/cmon_symbols.h>
 #include <cmon/cmon_tini.h>
 #include <cmon/cmon_tokens.h>
@@ -61,6 +66,83 @@ UTEST(cmon, dyn_arr_tests)
     cmon_allocator_dealloc(&a);
 }
 
+UTEST(cmon, blk_arr_tests)
+{
+    cmon_allocator a = cmon_mallocator_make();
+
+    cmon_blk_arr(size_t) arr;
+    cmon_blk_arr_init(&arr, &a);
+    EXPECT_EQ(cmon_blk_arr_count(&arr), 0);
+
+    cmon_blk_arr_append(&arr, 0);
+    size_t * first = &cmon_blk_arr_get(&arr, 0);
+    for (size_t i = 1; i < 10000; ++i)
+    {
+        cmon_blk_arr_append(&arr, i);
+    }
+    EXPECT_EQ(cmon_blk_arr_count(&arr), 10000);
+    EXPECT_EQ(cmon_blk_arr_last(&arr), 9999);
+    for (size_t i = 0; i < cmon_blk_arr_count(&arr); ++i)
+    {
+        EXPECT_EQ(cmon_blk_arr_get(&arr, i), i);
+    }
+    // elements never move while the array grows
+    EXPECT_EQ(first, &cmon_blk_arr_get(&arr, 0));
+
+    cmon_blk_arr_dealloc(&arr);
+    cmon_allocator_dealloc(&a);
+}
+
+UTEST(cmon, arena_allocator_tests)
+{
+    cmon_allocator a = cmon_mallocator_make();
+    cmon_allocator arena = cmon_arena_allocator_make(&a, 64);
+
+    cmon_mem_blk blk = cmon_allocator_alloc(&arena, 3);
+    EXPECT_NE(NULL, blk.ptr);
+    EXPECT_EQ(0, (uintptr_t)blk.ptr % 16);
+    EXPECT_EQ(16, cmon_arena_allocator_byte_count(&arena));
+
+    // the most recent allocation grows in place
+    memcpy(blk.ptr, "ab", 3);
+    cmon_mem_blk blk2 = cmon_allocator_realloc(&arena, blk, 32);
+    EXPECT_EQ(blk.ptr, blk2.ptr);
+    EXPECT_EQ(32, cmon_arena_allocator_byte_count(&arena));
+
+    cmon_arena_mark mark = cmon_arena_allocator_mark(&arena);
+
+    // anything else gets copied
+    cmon_mem_blk other = cmon_allocator_alloc(&arena, 16);
+    cmon_mem_blk blk3 = cmon_allocator_realloc(&arena, blk2, 48);
+    EXPECT_NE(blk2.ptr, blk3.ptr);
+    EXPECT_STREQ("ab", (const char *)blk3.ptr);
+    cmon_allocator_free(&arena, other);
+
+    // bigger than the chunk size
+    cmon_mem_blk big = cmon_allocator_alloc(&arena, 1000);
+    EXPECT_NE(NULL, big.ptr);
+    memset(big.ptr, 1, 1000);
+
+    cmon_dyn_arr(int) vec;
+    cmon_dyn_arr_init(&vec, &arena, 2);
+    for (int i = 0; i < 100; ++i)
+    {
+        cmon_dyn_arr_append(&vec, i);
+    }
+    for (int i = 0; i < 100; ++i)
+    {
+        EXPECT_EQ(i, vec[i]);
+    }
+    cmon_dyn_arr_dealloc(&vec);
+
+    cmon_arena_allocator_reset(&arena, mark);
+    EXPECT_EQ(32, cmon_arena_allocator_byte_count(&arena));
+    EXPECT_STREQ("ab", (const char *)blk2.ptr);
+
+    cmon_allocator_dealloc(&arena);
+    cmon_allocator_dealloc(&a);
+}
+
 UTEST(cmon, hashmap_tests)
 {
     cmon_allocator a = cmon_mallocator_make();
@@ -115,6 +197,118 @@ UTEST(cmon, hashmap_tests)
     // EXPECT_NE(NULL, cmon_hashmap_get(&map3, &b));
     // cmon_hashmap_dealloc(&map3);
 
+    cmon_hashmap(uint64_t, int) map4;
+    cmon_hashmap_int_key_init(&map4, &a);
+    cmon_hashmap_reserve(&map4, 100);
+    EXPECT_GE(cmon_hashmap_bucket_count(&map4), 100);
+    for (int i = 0; i < 1000; ++i)
+    {
+        EXPECT_EQ(cmon_false, cmon_hashmap_set(&map4, i * 8, i));
+    }
+    EXPECT_EQ(1000, cmon_hashmap_count(&map4));
+
+    // iteration follows insertion order
+    int i = 0;
+    uint64_t * ikey_ref;
+    cmon_hashmap_iter_t it4 = cmon_hashmap_iter(&map4);
+    while ((ikey_ref = cmon_hashmap_next(&map4, &it4)))
+    {
+        EXPECT_EQ((uint64_t)i * 8, *ikey_ref);
+        EXPECT_EQ(i, cmon_hashmap_iter_value(&map4, &it4));
+        ++i;
+    }
+    EXPECT_EQ(1000, i);
+
+    for (i = 0; i < 1000; i += 2)
+    {
+        EXPECT_EQ(cmon_true, cmon_hashmap_remove(&map4, i * 8));
+    }
+    EXPECT_EQ(500, cmon_hashmap_count(&map4));
+    for (i = 0; i < 1000; ++i)
+    {
+        res = cmon_hashmap_get(&map4, i * 8);
+        if (i % 2)
+        {
+            EXPECT_NE(NULL, res);
+            EXPECT_EQ(i, *res);
+        }
+        else
+        {
+            EXPECT_EQ(NULL, res);
+        }
+    }
+
+    // the remaining entries keep their order
+    i = 1;
+    it4 = cmon_hashmap_iter(&map4);
+    while ((ikey_ref = cmon_hashmap_next(&map4, &it4)))
+    {
+        EXPECT_EQ((uint64_t)i * 8, *ikey_ref);
+        i += 2;
+    }
+    EXPECT_EQ(1001, i);
+
+    EXPECT_EQ(3, *cmon_hashmap_get_or_insert(&map4, 3 * 8, 99));
+    EXPECT_EQ(99, *cmon_hashmap_get_or_insert(&map4, 2 * 8, 99));
+    EXPECT_EQ(501, cmon_hashmap_count(&map4));
+
+    // new entries go to the end, after removing the first one
+    EXPECT_EQ(cmon_true, cmon_hashmap_remove(&map4, 1 * 8));
+    EXPECT_EQ(cmon_false, cmon_hashmap_set(&map4, 1 * 8, 1));
+    i = 0;
+    it4 = cmon_hashmap_iter(&map4);
+    while ((ikey_ref = cmon_hashmap_next(&map4, &it4)))
+    {
+        if (i == 0)
+        {
+            EXPECT_EQ((uint64_t)3 * 8, *ikey_ref);
+        }
+        else if (i == 499)
+        {
+            EXPECT_EQ((uint64_t)2 * 8, *ikey_ref);
+        }
+        else if (i == 500)
+        {
+            EXPECT_EQ((uint64_t)1 * 8, *ikey_ref);
+        }
+        EXPECT_EQ(cmon_hashmap_iter_value(&map4, &it4), *cmon_hashmap_get(&map4, *ikey_ref));
+        ++i;
+    }
+    EXPECT_EQ(501, i);
+    cmon_hashmap_dealloc(&map4);
+
+    cmon_allocator_dealloc(&a);
+}
+
+UTEST(cmon, interner_tests)
+{
+    cmon_allocator a = cmon_mallocator_make();
+    cmon_interner * i = cmon_interner_create(&a);
+    char buf[32];
+    size_t j;
+
+    const char * src = "foo bar foo";
+    cmon_idx foo = cmon_interner_intern(i, (cmon_str_view){ src, src + 3 });
+    cmon_idx bar = cmon_interner_intern(i, (cmon_str_view){ src + 4, src + 7 });
+    EXPECT_NE(foo, bar);
+    EXPECT_EQ(foo, cmon_interner_intern(i, (cmon_str_view){ src + 8, src + 11 }));
+    EXPECT_EQ(bar, cmon_interner_find(i, cmon_str_view_make("bar")));
+    EXPECT_EQ(CMON_INVALID_IDX, cmon_interner_find(i, cmon_str_view_make("baz")));
+    EXPECT_STREQ("foo", cmon_interner_c_str(i, foo));
+    EXPECT_EQ(3, cmon_str_view_len(cmon_interner_str_view(i, bar)));
+    EXPECT_EQ(2, cmon_interner_count(i));
+
+    // enough strings to span multiple id blocks, earlier strings must stay valid
+    for (j = 0; j < 10000; ++j)
+    {
+        snprintf(buf, sizeof(buf), "name%lu", j);
+        EXPECT_EQ(j + 2, cmon_interner_intern(i, cmon_str_view_make(buf)));
+    }
+    EXPECT_STREQ("foo", cmon_interner_c_str(i, foo));
+    EXPECT_STREQ("name9999", cmon_interner_c_str(i, 10001));
+    EXPECT_EQ(777 + 2, cmon_interner_find(i, cmon_str_view_make("name777")));
+
+    cmon_interner_destroy(i);
     cmon_allocator_dealloc(&a);
 }
 
@@ -186,6 +380,41 @@ UTEST(cmon, dep_graph_tests_success)
     cmon_allocator_dealloc(&alloc);
 }
 
+UTEST(cmon, dep_graph_tests_waves)
+{
+    cmon_allocator alloc = cmon_mallocator_make();
+
+    cmon_dep_graph * g = cmon_dep_graph_create(&alloc);
+
+    // a depends on b and c, b and c both depend on d, e depends on nothing
+    cmon_idx adeps[] = { 2, 3 };
+    cmon_idx bdeps[] = { 4 };
+    cmon_idx cdeps[] = { 4 };
+
+    cmon_dep_graph_add(g, 1, adeps, 2);
+    cmon_dep_graph_add(g, 2, bdeps, 1);
+    cmon_dep_graph_add(g, 3, cdeps, 1);
+    cmon_dep_graph_add(g, 4, NULL, 0);
+    cmon_dep_graph_add(g, 5, NULL, 0);
+
+    cmon_dep_graph_result res = cmon_dep_graph_resolve(g);
+    EXPECT_EQ(5, res.count);
+    EXPECT_EQ(3, cmon_dep_graph_wave_count(g));
+
+    cmon_dep_graph_result w0 = cmon_dep_graph_wave(g, 0);
+    cmon_dep_graph_result w1 = cmon_dep_graph_wave(g, 1);
+    cmon_dep_graph_result w2 = cmon_dep_graph_wave(g, 2);
+    EXPECT_EQ(2, w0.count);
+    EXPECT_TRUE((w0.array[0] == 4 && w0.array[1] == 5) || (w0.array[0] == 5 && w0.array[1] == 4));
+    EXPECT_EQ(2, w1.count);
+    EXPECT_TRUE((w1.array[0] == 2 && w1.array[1] == 3) || (w1.array[0] == 3 && w1.array[1] == 2));
+    EXPECT_EQ(1, w2.count);
+    EXPECT_EQ(1, w2.array[0]);
+
+    cmon_dep_graph_destroy(g);
+    cmon_allocator_dealloc(&alloc);
+}
+
 UTEST(cmon, dep_graph_tests_fail)
 {
     cmon_allocator alloc = cmon_mallocator_make();
@@ -231,6 +460,337 @@ UTEST(cmon, dep_graph_tests_fail)
     cmon_allocator_dealloc(&alloc);
 }
 
+UTEST(cmon, keyword_tokens_test)
+{
+    cmon_allocator alloc;
+    cmon_src * src;
+    cmon_idx src_idx;
+    cmon_tokens * tokens;
+    cmon_err_report err;
+    size_t i;
+
+    cmon_tokk expected[] = {
+        cmon_tokk_if,     cmon_tokk_in,         cmon_tokk_fn,       cmon_tokk_or,
+        cmon_tokk_as,     cmon_tokk_and,        cmon_tokk_mut,      cmon_tokk_pub,
+        cmon_tokk_for,    cmon_tokk_try,        cmon_tokk_else,     cmon_tokk_true,
+        cmon_tokk_type,   cmon_tokk_none,       cmon_tokk_self,     cmon_tokk_break,
+        cmon_tokk_false,  cmon_tokk_embed,      cmon_tokk_alias,    cmon_tokk_defer,
+        cmon_tokk_return, cmon_tokk_struct,     cmon_tokk_scoped,   cmon_tokk_module,
+        cmon_tokk_import, cmon_tokk_continue,   cmon_tokk_interface, cmon_tokk_scope_exit,
+        // identifiers that are close to keywords
+        cmon_tokk_ident,  cmon_tokk_ident,      cmon_tokk_ident,    cmon_tokk_ident,
+        cmon_tokk_ident,  cmon_tokk_ident,      cmon_tokk_eof
+    };
+
+    alloc = cmon_mallocator_make();
+    src = cmon_src_create(&alloc);
+    src_idx = cmon_src_add(src, "keyword_tokens_test.cmon", "keyword_tokens_test.cmon");
+    cmon_src_set_code(src,
+                      src_idx,
+                      "if in fn or as and mut pub for try else true type none self break false "
+                      "embed alias defer return struct scoped module import continue interface "
+                      "scope_exit i iff ifn types scope_exits _if");
+
+    tokens = cmon_tokenize(&alloc, src, src_idx, &err);
+    EXPECT_TRUE(cmon_err_report_is_empty(&err));
+    EXPECT_EQ(sizeof(expected) / sizeof(cmon_tokk), cmon_tokens_count(tokens));
+    for (i = 0; i < cmon_tokens_count(tokens); ++i)
+    {
+        EXPECT_EQ(expected[i], cmon_tokens_kind(tokens, i));
+    }
+
+    cmon_tokens_destroy(tokens);
+    cmon_src_destroy(src);
+    cmon_allocator_dealloc(&alloc);
+}
+
+UTEST(cmon, src_load_tests)
+{
+    cmon_allocator alloc = cmon_mallocator_make();
+    cmon_src * src = cmon_src_create(&alloc);
+    cmon_fs_txt_file f;
+    cmon_str_builder * b = cmon_str_builder_create(&alloc, 8192);
+    cmon_idx small_idx, page_idx, missing_idx;
+    size_t i;
+
+    // the second file has exactly the size of a page, so it can't be mapped with a nul terminator
+    // and has to be read instead
+    for (i = 0; i < (size_t)sysconf(_SC_PAGESIZE); ++i)
+        cmon_str_builder_append(b, i % 64 == 63 ? "\n" : "x");
+    ASSERT_EQ(0, cmon_fs_write_txt_file("src_load_small.cmon", "module foo\n"));
+    ASSERT_EQ(0, cmon_fs_write_txt_file("src_load_page.cmon", cmon_str_builder_c_str(b)));
+
+    ASSERT_EQ(0, cmon_fs_map_txt_file(&alloc, "src_load_small.cmon", &f));
+    EXPECT_TRUE(f.is_mapped);
+    EXPECT_EQ(11, f.byte_count);
+    EXPECT_STREQ("module foo\n", f.data);
+    cmon_fs_unmap_txt_file(&alloc, &f);
+
+    ASSERT_EQ(0, cmon_fs_map_txt_file(&alloc, "src_load_page.cmon", &f));
+    EXPECT_FALSE(f.is_mapped);
+    EXPECT_STREQ(cmon_str_builder_c_str(b), f.data);
+    cmon_fs_unmap_txt_file(&alloc, &f);
+
+    small_idx = cmon_src_add(src, "src_load_small.cmon", "src_load_small.cmon");
+    page_idx = cmon_src_add(src, "src_load_page.cmon", "src_load_page.cmon");
+    missing_idx = cmon_src_add(src, "src_load_missing.cmon", "src_load_missing.cmon");
+    EXPECT_FALSE(cmon_src_load_code(src, small_idx));
+    EXPECT_FALSE(cmon_src_load_code(src, page_idx));
+    EXPECT_TRUE(cmon_src_load_code(src, missing_idx));
+    EXPECT_STREQ("module foo\n", cmon_src_code(src, small_idx));
+    EXPECT_STREQ(cmon_str_builder_c_str(b), cmon_src_code(src, page_idx));
+
+    // released code can be loaded again
+    cmon_src_release_code(src, small_idx);
+    EXPECT_EQ(NULL, cmon_src_code(src, small_idx));
+    EXPECT_FALSE(cmon_src_load_code(src, small_idx));
+    EXPECT_STREQ("module foo\n", cmon_src_code(src, small_idx));
+
+    cmon_src_set_code_ref(src, missing_idx, "module bar");
+    EXPECT_STREQ("module bar", cmon_src_code(src, missing_idx));
+
+    cmon_fs_remove("src_load_small.cmon");
+    cmon_fs_remove("src_load_page.cmon");
+    cmon_str_builder_destroy(b);
+    cmon_src_destroy(src);
+    cmon_allocator_dealloc(&alloc);
+}
+
+UTEST(cmon, scanner_tests)
+{
+    const cmon_scanner * scalar = cmon_scanner_scalar();
+    const cmon_scanner * best = cmon_scanner_get();
+    const char alphabet[] = " \t\r\n\v\fazAZ09_*/\"'.{}\x80\xff";
+    char buf[256];
+    size_t i, j, off;
+
+    // the vectorized scanners have to agree with the scalar one for every offset and length
+    srand(1234);
+    for (i = 0; i < 200; ++i)
+    {
+        for (j = 0; j < sizeof(buf); ++j)
+        {
+            // long runs of one byte class so the vector loops actually get to skip something
+            buf[j] = j % 40 < 30 ? alphabet[i % (sizeof(alphabet) - 1)]
+                                 : alphabet[rand() % (sizeof(alphabet) - 1)];
+        }
+
+        for (off = 0; off < 64; off += 7)
+        {
+            const char * b = buf + off;
+            const char * e = buf + sizeof(buf) - (i % 37);
+            EXPECT_EQ(scalar->skip_blanks(b, e), best->skip_blanks(b, e));
+            EXPECT_EQ(scalar->ident_end(b, e), best->ident_end(b, e));
+            EXPECT_EQ(scalar->find_any3(b, e, '*', '/', '\n'), best->find_any3(b, e, '*', '/', '\n'));
+            EXPECT_EQ(scalar->find_any3(b, e, '"', '"', '"'), best->find_any3(b, e, '"', '"', '"'));
+        }
+    }
+
+    EXPECT_EQ(buf, scalar->ident_end(buf, buf));
+}
+
+UTEST(cmon, token_lines_test)
+{
+    cmon_allocator alloc;
+    cmon_src * src;
+    cmon_idx src_idx;
+    cmon_tokens * tokens;
+    cmon_err_report err;
+    cmon_str_view sv;
+
+    alloc = cmon_mallocator_make();
+    src = cmon_src_create(&alloc);
+    src_idx = cmon_src_add(src, "token_lines_test.cmon", "token_lines_test.cmon");
+    cmon_src_set_code(src, src_idx, "module foo\n/* a\nb */ x := \"c\nd\"\n\n  y := 1");
+
+    tokens = cmon_tokenize(&alloc, src, src_idx, &err);
+    EXPECT_TRUE(cmon_err_report_is_empty(&err));
+    ASSERT_EQ(12, cmon_tokens_count(tokens));
+
+    // module foo
+    EXPECT_EQ(1, cmon_tokens_line(tokens, 1));
+    EXPECT_EQ(8, cmon_tokens_line_offset(tokens, 1));
+    EXPECT_EQ(2, cmon_tokens_line_token_count(tokens, 1));
+
+    // the comment spans lines 2 and 3 and is part of both
+    EXPECT_EQ(cmon_tokk_comment, cmon_tokens_kind(tokens, 2));
+    EXPECT_TRUE(cmon_tokens_follows_nl(tokens, 2));
+    EXPECT_EQ(2, cmon_tokens_line(tokens, 2));
+    EXPECT_EQ(1, cmon_tokens_line_token_count(tokens, 2));
+    EXPECT_EQ(2, cmon_tokens_line_token(tokens, 2, 0));
+    EXPECT_EQ(5, cmon_tokens_line_token_count(tokens, 3));
+    EXPECT_EQ(2, cmon_tokens_line_token(tokens, 3, 0));
+
+    // x and the string literal that spans lines 3 and 4
+    EXPECT_FALSE(cmon_tokens_follows_nl(tokens, 3));
+    EXPECT_EQ(3, cmon_tokens_line(tokens, 3));
+    EXPECT_EQ(6, cmon_tokens_line_offset(tokens, 3));
+    sv = cmon_tokens_line_str_view(tokens, 3);
+    EXPECT_EQ(0, cmon_str_view_c_str_cmp(sv, "b */ x := \"c"));
+
+    // y is on line 6 after an empty line
+    EXPECT_EQ(cmon_tokk_ident, cmon_tokens_kind(tokens, 7));
+    EXPECT_TRUE(cmon_tokens_follows_nl(tokens, 7));
+    EXPECT_EQ(6, cmon_tokens_line(tokens, 7));
+    EXPECT_EQ(3, cmon_tokens_line_offset(tokens, 7));
+    EXPECT_EQ(0, cmon_tokens_line_token_count(tokens, 5));
+    EXPECT_EQ(0, cmon_str_view_len(cmon_tokens_line_str_view(tokens, 5)));
+    EXPECT_EQ(cmon_tokk_eof, cmon_tokens_kind(tokens, 11));
+    EXPECT_EQ(6, cmon_tokens_line(tokens, 11));
+
+    cmon_tokens_destroy(tokens);
+    cmon_src_destroy(src);
+    cmon_allocator_dealloc(&alloc);
+}
+
+// checks that incrementally updated tokens and ast match the ones of a fresh parse of the code
+static cmon_bool _matches_fresh_parse(cmon_tokens * _tokens, cmon_ast * _ast, const char * _code)
+{
+    cmon_allocator alloc;
+    cmon_src * src;
+    cmon_idx src_idx, i, a, b;
+    cmon_tokens * tokens;
+    cmon_parser * parser;
+    cmon_ast * ast;
+    cmon_err_report err;
+    cmon_bool ret;
+
+    alloc = cmon_mallocator_make();
+    src = cmon_src_create(&alloc);
+    src_idx = cmon_src_add(src, "fresh.cmon", "fresh.cmon");
+    cmon_src_set_code(src, src_idx, _code);
+    tokens = cmon_tokenize(&alloc, src, src_idx, &err);
+    parser = cmon_parser_create(&alloc);
+    ast = cmon_parser_parse(parser, src, src_idx, tokens);
+
+    ret = ast && cmon_tokens_count(tokens) == cmon_tokens_count(_tokens);
+    for (i = 0; ret && i < cmon_tokens_count(tokens); ++i)
+    {
+        ret = cmon_tokens_kind(tokens, i) == cmon_tokens_kind(_tokens, i) &&
+              cmon_tokens_follows_nl(tokens, i) == cmon_tokens_follows_nl(_tokens, i) &&
+              cmon_tokens_line(tokens, i) == cmon_tokens_line(_tokens, i) &&
+              cmon_tokens_line_offset(tokens, i) == cmon_tokens_line_offset(_tokens, i) &&
+              cmon_str_view_cmp(cmon_tokens_str_view(tokens, i),
+                                cmon_tokens_str_view(_tokens, i)) == 0;
+    }
+
+    a = ret ? cmon_ast_root_block(ast) : CMON_INVALID_IDX;
+    b = ret ? cmon_ast_root_block(_ast) : CMON_INVALID_IDX;
+    ret = ret && cmon_ast_block_child_count(ast, a) == cmon_ast_block_child_count(_ast, b);
+    for (i = 0; ret && i < cmon_ast_block_child_count(ast, a); ++i)
+    {
+        cmon_idx ca = cmon_ast_block_child(ast, a, i);
+        cmon_idx cb = cmon_ast_block_child(_ast, b, i);
+        ret = cmon_ast_kind(ast, ca) == cmon_ast_kind(_ast, cb) &&
+              cmon_ast_token(ast, ca) == cmon_ast_token(_ast, cb);
+    }
+
+    cmon_parser_destroy(parser);
+    cmon_tokens_destroy(tokens);
+    cmon_src_destroy(src);
+    cmon_allocator_dealloc(&alloc);
+    return ret;
+}
+
+UTEST(cmon, incremental_reparse_test)
+{
+    cmon_allocator alloc;
+    cmon_src * src;
+    cmon_idx src_idx;
+    cmon_tokens * tokens;
+    cmon_parser * parser;
+    cmon_ast * ast;
+    cmon_err_report err;
+    cmon_tokens_edit edit;
+    cmon_idx root, struct_node, add_node;
+    char code[512];
+
+    alloc = cmon_mallocator_make();
+    src = cmon_src_create(&alloc);
+    src_idx = cmon_src_add(src, "incr.cmon", "incr.cmon");
+    strcpy(code,
+           "module foo\n"
+           "pub fa : s32 = 1\n"
+           "pub struct Vec\n{\n    x : s32\n    y : s32\n}\n"
+           "pub add := fn(a : s32, mut b : s32) -> s32 {}\n"
+           "// some comment\n"
+           "hidden : s32 = 3\n");
+    cmon_src_set_code(src, src_idx, code);
+
+    tokens = cmon_tokenize(&alloc, src, src_idx, &err);
+    parser = cmon_parser_create(&alloc);
+    ast = cmon_parser_parse(parser, src, src_idx, tokens);
+    ASSERT_TRUE(ast != NULL);
+    root = cmon_ast_root_block(ast);
+    ASSERT_EQ(5, cmon_ast_block_child_count(ast, root));
+    struct_node = cmon_ast_block_child(ast, root, 2);
+    add_node = cmon_ast_block_child(ast, root, 3);
+
+// replaces _count bytes at the offset of _at in code and updates the tokens and ast
+#define _edit(_at, _count, _str)                                                                   \
+    do                                                                                             \
+    {                                                                                              \
+        size_t begin = strstr(code, _at) - code;                                                   \
+        memmove(code + begin + strlen(_str),                                                       \
+                code + begin + (_count),                                                           \
+                strlen(code + begin + (_count)) + 1);                                              \
+        memcpy(code + begin, _str, strlen(_str));                                                  \
+        cmon_src_set_code(src, src_idx, code);                                                     \
+        cmon_tokens_retokenize(                                                                    \
+            tokens, src, NULL, src_idx, begin, begin + (_count), strlen(_str), &edit, &err);       \
+        ast = cmon_parser_reparse(parser, &edit);                                                  \
+    } while (0)
+
+    // renaming only touches one token and one statement
+    _edit("fa :", 2, "fab");
+    EXPECT_TRUE(cmon_err_report_is_empty(&err));
+    EXPECT_EQ(edit.first + 1, edit.old_end);
+    EXPECT_EQ(edit.first + 1, edit.new_end);
+    ASSERT_TRUE(ast != NULL);
+    EXPECT_TRUE(_matches_fresh_parse(tokens, ast, code));
+    root = cmon_ast_root_block(ast);
+    EXPECT_EQ(struct_node, cmon_ast_block_child(ast, root, 2));
+    EXPECT_EQ(add_node, cmon_ast_block_child(ast, root, 3));
+
+    // adding a statement shifts the tokens of the following ones
+    _edit("pub fa", 0, "bar := 2\n");
+    ASSERT_TRUE(ast != NULL);
+    EXPECT_TRUE(_matches_fresh_parse(tokens, ast, code));
+    root = cmon_ast_root_block(ast);
+    EXPECT_EQ(6, cmon_ast_block_child_count(ast, root));
+    EXPECT_EQ(struct_node, cmon_ast_block_child(ast, root, 3));
+    EXPECT_EQ(add_node, cmon_ast_block_child(ast, root, 4));
+
+    // editing a function body, the statements around it are reused
+    _edit("{}", 2, "{ x := fab + 1 }");
+    ASSERT_TRUE(ast != NULL);
+    EXPECT_TRUE(_matches_fresh_parse(tokens, ast, code));
+    root = cmon_ast_root_block(ast);
+    EXPECT_EQ(struct_node, cmon_ast_block_child(ast, root, 3));
+    EXPECT_NE(add_node, cmon_ast_block_child(ast, root, 4));
+
+    // removing the closing bracket of the struct is an error, adding it back recovers
+    _edit("}\npub add", 1, "");
+    EXPECT_TRUE(ast == NULL);
+    _edit("pub add", 0, "}\n");
+    ASSERT_TRUE(ast != NULL);
+    EXPECT_TRUE(_matches_fresh_parse(tokens, ast, code));
+
+    // merging two tokens and changing a comment
+    _edit("fab + 1", 6, "fab+1");
+    _edit("some comment", 4, "other");
+    ASSERT_TRUE(ast != NULL);
+    EXPECT_TRUE(_matches_fresh_parse(tokens, ast, code));
+    EXPECT_EQ(6, cmon_ast_block_child_count(ast, cmon_ast_root_block(ast)));
+
+#undef _edit
+
+    cmon_parser_destroy(parser);
+    cmon_tokens_destroy(tokens);
+    cmon_src_destroy(src);
+    cmon_allocator_dealloc(&alloc);
+}
+
 UTEST(cmon, basic_tokens_test)
 {
     // cmon_allocator alloc;
@@ -737,6 +1297,12 @@ RESOLVE_TEST(resolve_many_lines,
              cmon_false);
 RESOLVE_TEST(resolve_many_lines02, "a : s32 = 1 +\n       true", cmon_false);
 RESOLVE_TEST(resolve_many_lines03, "a : s32 = 1 +   true //foo ", cmon_false);
+RESOLVE_TEST(resolve_const_fold01,
+             "a : u8 = 250 + 5\nb : [(1 + 1) * 2]s32 = [1, 2, 3, 4]\nc : f32 = -(1.0 / 4.0)",
+             cmon_true);
+RESOLVE_TEST(resolve_const_fold02, "a : u8 = 250 + 6", cmon_false);
+RESOLVE_TEST(resolve_const_fold03, "a : s32 = 1 / (2 - 2)", cmon_false);
+RESOLVE_TEST(resolve_const_fold04, "n := 4\nb : [n]s32 = [1, 2, 3, 4]", cmon_false);
 
 // void _module_selector_test_adder_fn(cmon_src * _src, cmon_modules * _mods)
 // {
@@ -779,6 +1345,720 @@ UTEST(cmon, resolve_module_circ_dep)
     EXPECT_EQ(cmon_true, _resolve_test_fn(_module_circ_dep_test_adder_fn));
 }
 
+void _builder_mt_test_adder_fn(cmon_src * _src, cmon_modules * _mods)
+{
+    cmon_idx src01_idx = cmon_src_add(_src, "foo/foo.cmon", "foo.cmon");
+    cmon_src_set_code(_src, src01_idx, "module foo; a : s32 = true");
+    cmon_idx src02_idx = cmon_src_add(_src, "foo/foo02.cmon", "foo02.cmon");
+    cmon_src_set_code(_src, src02_idx, "module foo; b : s32 = 1.5");
+    cmon_idx foo_mod = cmon_modules_add(_mods, "foo", "foo");
+    cmon_modules_add_src_file(_mods, foo_mod, src01_idx);
+    cmon_modules_add_src_file(_mods, foo_mod, src02_idx);
+    // baz does not depend on foo and is resolved concurrently with it
+    cmon_idx src04_idx = cmon_src_add(_src, "baz/baz.cmon", "baz.cmon");
+    cmon_src_set_code(_src, src04_idx, "module baz; d : s32 = 1; e := fn(a : *s32) -> s32 {}");
+    cmon_idx baz_mod = cmon_modules_add(_mods, "baz", "baz");
+    cmon_modules_add_src_file(_mods, baz_mod, src04_idx);
+    cmon_idx src03_idx = cmon_src_add(_src, "bar/bar.cmon", "bar.cmon");
+    cmon_src_set_code(_src, src03_idx, "module bar; import foo; import baz; c := 1");
+    cmon_idx bar_mod = cmon_modules_add(_mods, "bar", "bar");
+    cmon_modules_add_src_file(_mods, bar_mod, src03_idx);
+}
+
+// the main pass of these files runs concurrently in the multi threaded builder
+void _builder_mt_main_pass_test_adder_fn(cmon_src * _src, cmon_modules * _mods)
+{
+    cmon_idx src01_idx = cmon_src_add(_src, "foo/foo.cmon", "foo.cmon");
+    cmon_src_set_code(_src, src01_idx, "module foo; a := fn() -> s32 { x : s32 = true }");
+    cmon_idx src02_idx = cmon_src_add(_src, "foo/foo02.cmon", "foo02.cmon");
+    cmon_src_set_code(_src, src02_idx, "module foo; b := fn() -> s32 { y := a() }");
+    cmon_idx src03_idx = cmon_src_add(_src, "foo/foo03.cmon", "foo03.cmon");
+    cmon_src_set_code(_src, src03_idx, "module foo; c := fn() -> s32 { z : bool = b() }");
+    cmon_idx foo_mod = cmon_modules_add(_mods, "foo", "foo");
+    cmon_modules_add_src_file(_mods, foo_mod, src01_idx);
+    cmon_modules_add_src_file(_mods, foo_mod, src02_idx);
+    cmon_modules_add_src_file(_mods, foo_mod, src03_idx);
+}
+
+UTEST(cmon, builder_mt_matches_st)
+{
+    module_adder_fn adders[] = { _builder_mt_test_adder_fn, _builder_mt_main_pass_test_adder_fn };
+    size_t k;
+    for (k = 0; k < sizeof(adders) / sizeof(adders[0]); ++k)
+    {
+        cmon_allocator alloc = cmon_mallocator_make();
+        cmon_src * src_st = cmon_src_create(&alloc);
+        cmon_modules * mods_st = cmon_modules_create(&alloc, src_st);
+        cmon_src * src_mt = cmon_src_create(&alloc);
+        cmon_modules * mods_mt = cmon_modules_create(&alloc, src_mt);
+        cmon_log * log = cmon_log_create(&alloc, "build.log", "build", cmon_true);
+        cmon_codegen cg = _empty_codegen(&alloc);
+
+        adders[k](src_st, mods_st);
+        adders[k](src_mt, mods_mt);
+
+        cmon_builder_st * bst = cmon_builder_st_create(&alloc, 8, src_st, mods_st);
+        cmon_builder_mt * bmt = cmon_builder_mt_create(&alloc, 8, src_mt, mods_mt);
+        cmon_builder_mt_set_thread_count(bmt, 4);
+
+        EXPECT_EQ(cmon_true, cmon_builder_st_build(bst, &cg, "build", log));
+        EXPECT_EQ(cmon_true, cmon_builder_mt_build(bmt, &cg, "build", log));
+
+        cmon_err_report *errs_st, *errs_mt;
+        size_t count_st, count_mt, i;
+        cmon_builder_st_errors(bst, &errs_st, &count_st);
+        cmon_builder_mt_errors(bmt, &errs_mt, &count_mt);
+        EXPECT_EQ(count_st, count_mt);
+        // the errors of all files that failed the main pass are reported
+        if (adders[k] == _builder_mt_main_pass_test_adder_fn)
+            EXPECT_EQ((size_t)2, count_mt);
+        for (i = 0; i < count_st && i < count_mt; ++i)
+        {
+            EXPECT_EQ(errs_st[i].src_file_idx, errs_mt[i].src_file_idx);
+            EXPECT_EQ(errs_st[i].tok_of_interest, errs_mt[i].tok_of_interest);
+            EXPECT_STREQ(errs_st[i].msg, errs_mt[i].msg);
+        }
+
+        cmon_builder_mt_destroy(bmt);
+        cmon_builder_st_destroy(bst);
+        cmon_codegen_dealloc(&cg);
+        cmon_log_destroy(log);
+        cmon_modules_destroy(mods_mt);
+        cmon_src_destroy(src_mt);
+        cmon_modules_destroy(mods_st);
+        cmon_src_destroy(src_st);
+        cmon_allocator_dealloc(&alloc);
+    }
+}
+
+// a program that builds without errors, spread over multiple files and modules
+void _builder_mt_output_test_adder_fn(cmon_src * _src, cmon_modules * _mods)
+{
+    cmon_idx src01_idx = cmon_src_add(_src, "foo/foo.cmon", "foo.cmon");
+    cmon_src_set_code(_src,
+                      src01_idx,
+                      "module foo\npub struct Vec\n{\n    x : s32\n    y : s32\n}\n"
+                      "pub origin := Vec{0, 0}\n");
+    cmon_idx src02_idx = cmon_src_add(_src, "foo/foo02.cmon", "foo02.cmon");
+    cmon_src_set_code(_src,
+                      src02_idx,
+                      "module foo\npub add := fn(a : Vec, b : Vec) -> s32\n{\n"
+                      "    r := Vec{a.x + b.x, a.y + b.y}\n    mut s := r.x\n    p : *s32 = &s\n}\n");
+    cmon_idx foo_mod = cmon_modules_add(_mods, "foo", "foo");
+    cmon_modules_add_src_file(_mods, foo_mod, src01_idx);
+    cmon_modules_add_src_file(_mods, foo_mod, src02_idx);
+    // baz does not depend on foo and is resolved concurrently with it
+    cmon_idx src03_idx = cmon_src_add(_src, "baz/baz.cmon", "baz.cmon");
+    cmon_src_set_code(_src,
+                      src03_idx,
+                      "module baz\npub count : s32 = 4\n"
+                      "pub scale := fn(a : s32) -> s32\n{\n    q : [4]s32 = [1, 2, 3, 4]\n"
+                      "    mut r := a * count\n    r = r + 1\n}\n");
+    cmon_idx baz_mod = cmon_modules_add(_mods, "baz", "baz");
+    cmon_modules_add_src_file(_mods, baz_mod, src03_idx);
+    cmon_idx src04_idx = cmon_src_add(_src, "bar/bar.cmon", "bar.cmon");
+    cmon_src_set_code(_src,
+                      src04_idx,
+                      "module bar\nimport foo\nimport baz\n"
+                      "pub sum := fn(v : foo.Vec) -> s32\n{\n"
+                      "    s := foo.add(v, foo.origin)\n    t := baz.scale(v.x)\n}\n");
+    cmon_idx src05_idx = cmon_src_add(_src, "bar/bar02.cmon", "bar02.cmon");
+    cmon_src_set_code(_src,
+                      src05_idx,
+                      "module bar\nimport foo\nb := foo.Vec{1, 2}\n"
+                      "c := fn() -> s32\n{\n    d := sum(b)\n}\n");
+    cmon_idx bar_mod = cmon_modules_add(_mods, "bar", "bar");
+    cmon_modules_add_src_file(_mods, bar_mod, src04_idx);
+    cmon_modules_add_src_file(_mods, bar_mod, src05_idx);
+}
+
+static int _cmp_c_str_ptrs(const void * _a, const void * _b)
+{
+    return strcmp(*(const char **)_a, *(const char **)_b);
+}
+
+// the builders add to the symbols and types in a different order, so they are compared by name.
+static cmon_bool _symbols_differ(cmon_symbols * _a,
+                                 cmon_types * _ta,
+                                 cmon_idx _scope_a,
+                                 cmon_symbols * _b,
+                                 cmon_types * _tb,
+                                 cmon_idx _scope_b)
+{
+    size_t i;
+    if (cmon_symbols_scope_symbol_count(_a, _scope_a) !=
+            cmon_symbols_scope_symbol_count(_b, _scope_b) ||
+        cmon_symbols_scope_child_count(_a, _scope_a) != cmon_symbols_scope_child_count(_b, _scope_b))
+        return cmon_true;
+
+    for (i = 0; i < cmon_symbols_scope_symbol_count(_a, _scope_a); ++i)
+    {
+        cmon_idx sa = cmon_symbols_scope_symbol(_a, _scope_a, i);
+        cmon_idx sb = cmon_symbols_scope_symbol(_b, _scope_b, i);
+        if (cmon_symbols_kind(_a, sa) != cmon_symbols_kind(_b, sb) ||
+            cmon_symbols_module(_a, sa) != cmon_symbols_module(_b, sb) ||
+            cmon_symbols_is_pub(_a, sa) != cmon_symbols_is_pub(_b, sb) ||
+            strcmp(cmon_symbols_unique_name(_a, sa), cmon_symbols_unique_name(_b, sb)) != 0)
+            return cmon_true;
+
+        cmon_idx type_a = CMON_INVALID_IDX, type_b = CMON_INVALID_IDX;
+        if (cmon_symbols_kind(_a, sa) == cmon_symk_var)
+        {
+            type_a = cmon_symbols_var_type(_a, sa);
+            type_b = cmon_symbols_var_type(_b, sb);
+        }
+        else if (cmon_symbols_kind(_a, sa) != cmon_symk_import)
+        {
+            type_a = cmon_symbols_type(_a, sa);
+            type_b = cmon_symbols_type(_b, sb);
+        }
+        if (cmon_is_valid_idx(type_a) != cmon_is_valid_idx(type_b) ||
+            (cmon_is_valid_idx(type_a) && strcmp(cmon_types_unique_name(_ta, type_a),
+                                                 cmon_types_unique_name(_tb, type_b)) != 0))
+            return cmon_true;
+    }
+
+    for (i = 0; i < cmon_symbols_scope_child_count(_a, _scope_a); ++i)
+    {
+        if (_symbols_differ(_a,
+                            _ta,
+                            cmon_symbols_scope_child(_a, _scope_a, i),
+                            _b,
+                            _tb,
+                            cmon_symbols_scope_child(_b, _scope_b, i)))
+            return cmon_true;
+    }
+    return cmon_false;
+}
+
+UTEST(cmon, builder_mt_output_matches_st)
+{
+    cmon_allocator alloc = cmon_mallocator_make();
+    cmon_src * src_st = cmon_src_create(&alloc);
+    cmon_modules * mods_st = cmon_modules_create(&alloc, src_st);
+    cmon_src * src_mt = cmon_src_create(&alloc);
+    cmon_modules * mods_mt = cmon_modules_create(&alloc, src_mt);
+    cmon_log * log = cmon_log_create(&alloc, "build.log", "build", cmon_true);
+    cmon_codegen cg_st = cmon_codegen_c_make(&alloc);
+    cmon_codegen cg_mt = cmon_codegen_c_make(&alloc);
+
+    // fresh build directories, so no output of a previous run is reused
+    cmon_fs_remove_all("mt_output_st");
+    cmon_fs_remove_all("mt_output_mt");
+    cmon_fs_mkdir("mt_output_st");
+    cmon_fs_mkdir("mt_output_mt");
+
+    _builder_mt_output_test_adder_fn(src_st, mods_st);
+    _builder_mt_output_test_adder_fn(src_mt, mods_mt);
+
+    cmon_builder_st * bst = cmon_builder_st_create(&alloc, 8, src_st, mods_st);
+    cmon_builder_mt * bmt = cmon_builder_mt_create(&alloc, 8, src_mt, mods_mt);
+    cmon_builder_mt_set_thread_count(bmt, 4);
+
+    EXPECT_EQ(cmon_false, cmon_builder_st_build(bst, &cg_st, "mt_output_st", log));
+    EXPECT_EQ(cmon_false, cmon_builder_mt_build(bmt, &cg_mt, "mt_output_mt", log));
+
+    // same types
+    cmon_types * types_st = cmon_builder_st_types(bst);
+    cmon_types * types_mt = cmon_builder_mt_types(bmt);
+    size_t i;
+    ASSERT_EQ(cmon_types_count(types_st), cmon_types_count(types_mt));
+    cmon_dyn_arr(const char *) names_st;
+    cmon_dyn_arr(const char *) names_mt;
+    cmon_dyn_arr_init(&names_st, &alloc, cmon_types_count(types_st));
+    cmon_dyn_arr_init(&names_mt, &alloc, cmon_types_count(types_mt));
+    for (i = 0; i < cmon_types_count(types_st); ++i)
+    {
+        cmon_dyn_arr_append(&names_st, cmon_types_unique_name(types_st, i));
+        cmon_dyn_arr_append(&names_mt, cmon_types_unique_name(types_mt, i));
+    }
+    qsort(names_st, cmon_dyn_arr_count(&names_st), sizeof(const char *), _cmp_c_str_ptrs);
+    qsort(names_mt, cmon_dyn_arr_count(&names_mt), sizeof(const char *), _cmp_c_str_ptrs);
+    for (i = 0; i < cmon_types_count(types_st); ++i)
+    {
+        EXPECT_STREQ(names_st[i], names_mt[i]);
+    }
+    cmon_dyn_arr_dealloc(&names_mt);
+    cmon_dyn_arr_dealloc(&names_st);
+
+    // same symbols
+    cmon_symbols * syms_st = cmon_builder_st_symbols(bst);
+    cmon_symbols * syms_mt = cmon_builder_mt_symbols(bmt);
+    EXPECT_EQ(cmon_symbols_count(syms_st), cmon_symbols_count(syms_mt));
+    for (i = 0; i < cmon_modules_count(mods_st); ++i)
+    {
+        EXPECT_FALSE(_symbols_differ(syms_st,
+                                     types_st,
+                                     cmon_modules_global_scope(mods_st, i),
+                                     syms_mt,
+                                     types_mt,
+                                     cmon_modules_global_scope(mods_mt, i)));
+    }
+
+    // same IR, compared via the c code generated from it
+    const char * c_files[] = { "cgen/c/foo/foo.c", "cgen/c/baz/baz.c", "cgen/c/bar/bar.c" };
+    for (i = 0; i < sizeof(c_files) / sizeof(c_files[0]); ++i)
+    {
+        char path[CMON_PATH_MAX];
+        cmon_join_paths("mt_output_st", c_files[i], path, sizeof(path));
+        char * c_st = cmon_fs_load_txt_file(&alloc, path);
+        cmon_join_paths("mt_output_mt", c_files[i], path, sizeof(path));
+        char * c_mt = cmon_fs_load_txt_file(&alloc, path);
+        ASSERT_TRUE(c_st && c_mt);
+        EXPECT_STREQ(c_st, c_mt);
+        cmon_allocator_free(&alloc, (cmon_mem_blk){ c_st, strlen(c_st) + 1 });
+        cmon_allocator_free(&alloc, (cmon_mem_blk){ c_mt, strlen(c_mt) + 1 });
+    }
+
+    cmon_builder_mt_destroy(bmt);
+    cmon_builder_st_destroy(bst);
+    cmon_codegen_dealloc(&cg_mt);
+    cmon_codegen_dealloc(&cg_st);
+    cmon_log_destroy(log);
+    cmon_modules_destroy(mods_mt);
+    cmon_src_destroy(src_mt);
+    cmon_modules_destroy(mods_st);
+    cmon_src_destroy(src_st);
+    cmon_allocator_dealloc(&alloc);
+    cmon_fs_remove_all("mt_output_st");
+    cmon_fs_remove_all("mt_output_mt");
+}
+
+UTEST(cmon, builder_release_src)
+{
+    cmon_allocator alloc = cmon_mallocator_make();
+    cmon_src * src = cmon_src_create(&alloc);
+    cmon_modules * mods = cmon_modules_create(&alloc, src);
+    cmon_log * log = cmon_log_create(&alloc, "build.log", "build", cmon_true);
+    cmon_codegen cg = _empty_codegen(&alloc);
+
+    cmon_idx src01_idx = cmon_src_add(src, "foo/foo.cmon", "foo.cmon");
+    cmon_src_set_code(src, src01_idx, "module foo\npub a : s32 = 1");
+    cmon_idx foo_mod = cmon_modules_add(mods, "foo", "foo");
+    cmon_modules_add_src_file(mods, foo_mod, src01_idx);
+    cmon_idx src02_idx = cmon_src_add(src, "bar/bar.cmon", "bar.cmon");
+    cmon_src_set_code(src, src02_idx, "module bar\nimport foo\nb := foo.a + 1");
+    cmon_idx bar_mod = cmon_modules_add(mods, "bar", "bar");
+    cmon_modules_add_src_file(mods, bar_mod, src02_idx);
+
+    cmon_builder_st * b = cmon_builder_st_create(&alloc, 8, src, mods);
+    cmon_builder_st_set_release_src(b, cmon_true);
+    EXPECT_EQ(cmon_false, cmon_builder_st_build(b, &cg, "build", log));
+
+    // the asts are gone, the tokens are created again for diagnostics
+    EXPECT_TRUE(!cmon_src_ast(src, src01_idx));
+    EXPECT_TRUE(!cmon_src_ast(src, src02_idx));
+    cmon_str_view line = cmon_src_line(src, src01_idx, 2);
+    EXPECT_EQ(0, strncmp(line.begin, "pub a : s32 = 1", line.end - line.begin));
+
+    cmon_builder_st_destroy(b);
+    cmon_codegen_dealloc(&cg);
+    cmon_log_destroy(log);
+    cmon_modules_destroy(mods);
+    cmon_src_destroy(src);
+    cmon_allocator_dealloc(&alloc);
+}
+
+UTEST(cmon, builder_release_src_from_disk)
+{
+    cmon_allocator alloc = cmon_mallocator_make();
+    cmon_src * src = cmon_src_create(&alloc);
+    cmon_modules * mods = cmon_modules_create(&alloc, src);
+    cmon_log * log = cmon_log_create(&alloc, "build.log", "build", cmon_true);
+    cmon_codegen cg = _empty_codegen(&alloc);
+    char path[64];
+
+    // app only imports bar, so foo is released as soon as bar got its IR
+    cmon_fs_remove_all("release_src");
+    cmon_fs_mkdir("release_src");
+    cmon_fs_write_txt_file("release_src/foo.cmon",
+                           "module foo\npub struct Foo\n{\n    a : s32\n}\n");
+    cmon_fs_write_txt_file("release_src/bar.cmon",
+                           "module bar\nimport foo\npub v := foo.Foo{1}\n");
+    cmon_fs_write_txt_file("release_src/app.cmon", "module app\nimport bar\nx : s32 = bar.v\n");
+
+    const char * names[] = { "foo", "bar", "app" };
+    cmon_idx files[3];
+    for (size_t i = 0; i < 3; ++i)
+    {
+        // the module path is tokenized from a temporary on purpose
+        snprintf(path, sizeof(path), "release_src/%s.cmon", names[i]);
+        files[i] = cmon_src_add(src, path, names[i]);
+        snprintf(path, sizeof(path), "%s", names[i]);
+        cmon_idx mod = cmon_modules_add(mods, path, names[i]);
+        memset(path, 'x', sizeof(path) - 1);
+        cmon_modules_add_src_file(mods, mod, files[i]);
+    }
+    EXPECT_EQ(0, strncmp(cmon_modules_path_token(mods, 1, 0).begin, "bar", 3));
+
+    cmon_builder_st * b = cmon_builder_st_create(&alloc, 8, src, mods);
+    cmon_builder_st_set_release_src(b, cmon_true);
+    EXPECT_EQ(cmon_true, cmon_builder_st_build(b, &cg, "build", log));
+
+    // foo was unmapped before app failed, its code is loaded again from disk for diagnostics
+    EXPECT_TRUE(!cmon_src_ast(src, files[0]));
+    cmon_str_view line = cmon_src_line(src, files[0], 2);
+    EXPECT_EQ(0, strncmp(line.begin, "pub struct Foo", line.end - line.begin));
+
+    cmon_err_report * errs;
+    size_t count;
+    cmon_builder_st_errors(b, &errs, &count);
+    EXPECT_EQ((size_t)1, count);
+    if (count)
+    {
+        // the error mentions the type declared in the released module
+        EXPECT_EQ(files[2], errs[0].src_file_idx);
+        EXPECT_TRUE(strstr(errs[0].msg, "Foo") != NULL);
+        cmon_log_write_err_report(log, &errs[0], src);
+    }
+
+    cmon_builder_st_destroy(b);
+    cmon_codegen_dealloc(&cg);
+    cmon_log_destroy(log);
+    cmon_modules_destroy(mods);
+    cmon_src_destroy(src);
+    cmon_fs_remove_all("release_src");
+    cmon_allocator_dealloc(&alloc);
+}
+
+static const char * _incremental_mods[] = { "foo", "bar", "baz", "app" };
+#define _INCREMENTAL_MOD_COUNT (sizeof(_incremental_mods) / sizeof(_incremental_mods[0]))
+
+// builds the modules in incremental/src from scratch, like a new invocation of cmon build would.
+static cmon_bool _incremental_build(void)
+{
+    cmon_allocator alloc = cmon_mallocator_make();
+    cmon_src * src = cmon_src_create(&alloc);
+    cmon_modules * mods = cmon_modules_create(&alloc, src);
+    cmon_log * log = cmon_log_create(&alloc, "build.log", "build", cmon_true);
+    cmon_codegen cg = cmon_codegen_c_make(&alloc);
+    char path[CMON_PATH_MAX];
+    size_t i;
+
+    for (i = 0; i < _INCREMENTAL_MOD_COUNT; ++i)
+    {
+        snprintf(path, sizeof(path), "incremental/src/%s.cmon", _incremental_mods[i]);
+        cmon_idx file = cmon_src_add(src, path, _incremental_mods[i]);
+        cmon_idx mod = cmon_modules_add(mods, _incremental_mods[i], _incremental_mods[i]);
+        cmon_modules_add_src_file(mods, mod, file);
+    }
+
+    cmon_builder_st * b = cmon_builder_st_create(&alloc, 8, src, mods);
+    cmon_bool ret = cmon_builder_st_build(b, &cg, "incremental/build", log);
+
+    cmon_builder_st_destroy(b);
+    cmon_codegen_dealloc(&cg);
+    cmon_log_destroy(log);
+    cmon_modules_destroy(mods);
+    cmon_src_destroy(src);
+    cmon_allocator_dealloc(&alloc);
+    return ret;
+}
+
+static inline void _incremental_o_path(size_t _mod, char * _buf, size_t _buf_size)
+{
+    snprintf(_buf,
+             _buf_size,
+             "incremental/build/cgen/o/%s/%s.o",
+             _incremental_mods[_mod],
+             _incremental_mods[_mod]);
+}
+
+// replaces all object files with a marker. Objects that are reused keep it, the ones that are
+// compiled again are overwritten.
+static inline void _incremental_mark_objects(void)
+{
+    char path[CMON_PATH_MAX];
+    size_t i;
+    for (i = 0; i < _INCREMENTAL_MOD_COUNT; ++i)
+    {
+        _incremental_o_path(i, path, sizeof(path));
+        cmon_fs_write_txt_file(path, "reused");
+    }
+}
+
+// one char per module, 'r' if its object file was reused and 'c' if it was compiled again.
+static inline void _incremental_objects(char * _out)
+{
+    cmon_allocator alloc = cmon_mallocator_make();
+    char path[CMON_PATH_MAX];
+    size_t i;
+    for (i = 0; i < _INCREMENTAL_MOD_COUNT; ++i)
+    {
+        _incremental_o_path(i, path, sizeof(path));
+        _out[i] = '?';
+        cmon_fs_txt_file file;
+        if (cmon_fs_map_txt_file(&alloc, path, &file) == 0)
+        {
+            _out[i] = strcmp(file.data, "reused") == 0 ? 'r' : 'c';
+            cmon_fs_unmap_txt_file(&alloc, &file);
+        }
+    }
+    _out[i] = '\0';
+    cmon_allocator_dealloc(&alloc);
+}
+
+UTEST(cmon, builder_incremental)
+{
+    char objs[_INCREMENTAL_MOD_COUNT + 1];
+
+    // bar depends on foo, app depends on bar and baz is a leaf nothing depends on
+    cmon_fs_remove_all("incremental");
+    cmon_fs_mkdir("incremental");
+    cmon_fs_mkdir("incremental/src");
+    cmon_fs_mkdir("incremental/build");
+    cmon_fs_write_txt_file("incremental/src/foo.cmon",
+                           "module foo\npub struct Foo\n{\n    a : s32\n}\n");
+    cmon_fs_write_txt_file("incremental/src/bar.cmon",
+                           "module bar\nimport foo\npub v := foo.Foo{1}\n");
+    cmon_fs_write_txt_file("incremental/src/baz.cmon", "module baz\nb : s32 = 2\n");
+    cmon_fs_write_txt_file("incremental/src/app.cmon", "module app\nimport bar\nx : s32 = 3\n");
+
+    ASSERT_FALSE(_incremental_build());
+    _incremental_objects(objs);
+    EXPECT_STREQ("cccc", objs);
+
+    // nothing changed, everything is reused
+    _incremental_mark_objects();
+    ASSERT_FALSE(_incremental_build());
+    _incremental_objects(objs);
+    EXPECT_STREQ("rrrr", objs);
+
+    // edited leaf, only the leaf is compiled again
+    cmon_fs_write_txt_file("incremental/src/baz.cmon", "module baz\nb : s32 = 4\n");
+    _incremental_mark_objects();
+    ASSERT_FALSE(_incremental_build());
+    _incremental_objects(objs);
+    EXPECT_STREQ("rrcr", objs);
+
+    // edited dependency without changing its pub interface, the dependents are reused
+    cmon_fs_write_txt_file("incremental/src/foo.cmon",
+                           "module foo\npub struct Foo\n{\n    a : s32\n}\nf : s32 = 5\n");
+    _incremental_mark_objects();
+    ASSERT_FALSE(_incremental_build());
+    _incremental_objects(objs);
+    EXPECT_STREQ("crrr", objs);
+
+    // edited pub interface of a dependency, everything depending on it (transitively) is compiled
+    // again while the unrelated leaf is reused
+    cmon_fs_write_txt_file(
+        "incremental/src/foo.cmon",
+        "module foo\npub struct Foo\n{\n    a : s32\n}\nf : s32 = 5\npub g : s32 = 6\n");
+    _incremental_mark_objects();
+    ASSERT_FALSE(_incremental_build());
+    _incremental_objects(objs);
+    EXPECT_STREQ("ccrc", objs);
+
+    cmon_fs_remove_all("incremental");
+}
+
+// writes _size bytes of _data to _path, the interface files are binary.
+static inline void _write_bin_file(const char * _path, const void * _data, size_t _size)
+{
+    FILE * f = fopen(_path, "wb");
+    if (!f)
+        return;
+    fwrite(_data, 1, _size, f);
+    fclose(f);
+}
+
+// builds the modules foo and bar in iface_test/src, bar imports foo. Returns the builder, so the
+// result can be inspected.
+static cmon_builder_st * _iface_test_build(cmon_allocator * _alloc,
+                                           cmon_src * _src,
+                                           cmon_modules * _mods,
+                                           cmon_codegen * _cg,
+                                           cmon_log * _log)
+{
+    const char * names[] = { "foo", "bar" };
+    char path[CMON_PATH_MAX];
+    for (size_t i = 0; i < 2; ++i)
+    {
+        snprintf(path, sizeof(path), "iface_test/src/%s.cmon", names[i]);
+        cmon_idx file = cmon_src_add(_src, path, names[i]);
+        cmon_idx mod = cmon_modules_add(_mods, names[i], names[i]);
+        cmon_modules_add_src_file(_mods, mod, file);
+    }
+
+    cmon_builder_st * ret = cmon_builder_st_create(_alloc, 8, _src, _mods);
+    if (cmon_builder_st_build(ret, _cg, "iface_test/build", _log))
+    {
+        cmon_err_report * errs;
+        size_t count;
+        cmon_builder_st_errors(ret, &errs, &count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            cmon_log_write_err_report(_log, &errs[i], _src);
+        }
+        cmon_builder_st_destroy(ret);
+        return NULL;
+    }
+    return ret;
+}
+
+UTEST(cmon, mod_iface)
+{
+    cmon_allocator alloc = cmon_mallocator_make();
+    cmon_log * log = cmon_log_create(&alloc, "build.log", "build", cmon_true);
+
+    cmon_fs_remove_all("iface_test");
+    cmon_fs_mkdir("iface_test");
+    cmon_fs_mkdir("iface_test/src");
+    cmon_fs_mkdir("iface_test/build");
+    cmon_fs_write_txt_file("iface_test/src/foo.cmon",
+                           "module foo\n"
+                           "pub struct Vec\n{\n    x : s32\n    y : s32\n}\n"
+                           "pub origin := Vec{0, 0}\n"
+                           "pub mut count : s32 = 4\n"
+                           "hidden : s32 = 5\n"
+                           "pub add := fn(a : Vec, mut b : s32) -> s32\n{\n    b = b + a.x\n}\n");
+    cmon_fs_write_txt_file("iface_test/src/bar.cmon",
+                           "module bar\nimport foo\nc := fn() -> s32\n{\n"
+                           "    d := foo.add(foo.origin, foo.count)\n}\n");
+
+    // write the interface of foo
+    cmon_src * src = cmon_src_create(&alloc);
+    cmon_modules * mods = cmon_modules_create(&alloc, src);
+    cmon_codegen cg = cmon_codegen_c_make(&alloc);
+    cmon_builder_st * b = _iface_test_build(&alloc, src, mods, &cg, log);
+    ASSERT_TRUE(b != NULL);
+    cmon_types * types = cmon_builder_st_types(b);
+    cmon_idx vec_type = cmon_types_find(types, "foo_Vec");
+    ASSERT_TRUE(cmon_is_valid_idx(vec_type));
+    EXPECT_FALSE(cmon_mod_iface_write(&alloc,
+                                      "iface_test/foo.cmi",
+                                      src,
+                                      mods,
+                                      cmon_builder_st_symbols(b),
+                                      types,
+                                      0,
+                                      42));
+    cmon_builder_st_destroy(b);
+    cmon_codegen_dealloc(&cg);
+    cmon_modules_destroy(mods);
+    cmon_src_destroy(src);
+
+    cmon_mod_iface * iface = cmon_mod_iface_load(&alloc, "iface_test/foo.cmi");
+    ASSERT_TRUE(iface != NULL);
+    EXPECT_EQ((uint64_t)42, cmon_mod_iface_src_hash(iface));
+    EXPECT_EQ((size_t)0, cmon_mod_iface_dep_count(iface));
+
+    // import it into fresh symbols and types
+    src = cmon_src_create(&alloc);
+    mods = cmon_modules_create(&alloc, src);
+    cmon_idx foo = cmon_modules_add(mods, "foo", "foo");
+    types = cmon_types_create(&alloc, mods);
+    cmon_symbols * syms = cmon_symbols_create(&alloc, src, mods, NULL);
+    EXPECT_FALSE(cmon_mod_iface_import(iface, mods, syms, types, foo));
+
+    // only the pub symbols are imported
+    cmon_idx scope = cmon_modules_global_scope(mods, foo);
+    EXPECT_EQ((size_t)4, cmon_symbols_scope_symbol_count(syms, scope));
+    EXPECT_FALSE(cmon_is_valid_idx(cmon_symbols_find(syms, scope, cmon_str_view_make("hidden"))));
+
+    cmon_idx vec = cmon_symbols_find(syms, scope, cmon_str_view_make("Vec"));
+    ASSERT_TRUE(cmon_is_valid_idx(vec));
+    EXPECT_EQ(cmon_symk_type, cmon_symbols_kind(syms, vec));
+    vec_type = cmon_symbols_type(syms, vec);
+    EXPECT_EQ(vec_type, cmon_types_find(types, "foo_Vec"));
+    ASSERT_EQ((size_t)2, cmon_types_struct_field_count(types, vec_type));
+    EXPECT_STREQ("x", cmon_types_struct_field_name(types, vec_type, 0));
+    EXPECT_STREQ("y", cmon_types_struct_field_name(types, vec_type, 1));
+    EXPECT_EQ(cmon_types_builtin_s32(types), cmon_types_struct_field_type(types, vec_type, 1));
+
+    cmon_idx origin = cmon_symbols_find(syms, scope, cmon_str_view_make("origin"));
+    ASSERT_TRUE(cmon_is_valid_idx(origin));
+    EXPECT_EQ(vec_type, cmon_symbols_var_type(syms, origin));
+    EXPECT_FALSE(cmon_symbols_var_is_mut(syms, origin));
+    EXPECT_FALSE(cmon_mod_iface_sym_is_fn(iface, origin));
+
+    cmon_idx count = cmon_symbols_find(syms, scope, cmon_str_view_make("count"));
+    ASSERT_TRUE(cmon_is_valid_idx(count));
+    EXPECT_TRUE(cmon_symbols_var_is_mut(syms, count));
+
+    cmon_idx add = cmon_symbols_find(syms, scope, cmon_str_view_make("add"));
+    ASSERT_TRUE(cmon_is_valid_idx(add));
+    EXPECT_TRUE(cmon_mod_iface_sym_is_fn(iface, add));
+    ASSERT_EQ((size_t)2, cmon_mod_iface_fn_param_count(iface, add));
+    EXPECT_STREQ("a", cmon_mod_iface_fn_param_name(iface, add, 0));
+    EXPECT_STREQ("b", cmon_mod_iface_fn_param_name(iface, add, 1));
+    EXPECT_EQ(vec_type, cmon_mod_iface_fn_param_type(iface, add, 0));
+    EXPECT_EQ(cmon_types_builtin_s32(types), cmon_mod_iface_fn_param_type(iface, add, 1));
+    EXPECT_FALSE(cmon_mod_iface_fn_param_is_mut(iface, add, 0));
+    EXPECT_TRUE(cmon_mod_iface_fn_param_is_mut(iface, add, 1));
+    EXPECT_STREQ("fn(Vec, s32)->s32", cmon_types_name(types, cmon_symbols_var_type(syms, add)));
+
+    cmon_symbols_destroy(syms);
+    cmon_types_destroy(types);
+    cmon_modules_destroy(mods);
+    cmon_src_destroy(src);
+
+    // the build wrote the interface of foo, too. After editing bar, foo is imported from it and bar
+    // is resolved against the imported symbols.
+    cmon_fs_write_txt_file("iface_test/src/bar.cmon",
+                           "module bar\nimport foo\nc := fn() -> s32\n{\n"
+                           "    d := foo.add(foo.Vec{1, 2}, 3)\n}\n");
+    src = cmon_src_create(&alloc);
+    mods = cmon_modules_create(&alloc, src);
+    cg = cmon_codegen_c_make(&alloc);
+    b = _iface_test_build(&alloc, src, mods, &cg, log);
+    EXPECT_TRUE(b != NULL);
+    EXPECT_TRUE(cmon_modules_iface(mods, 0) != NULL);
+    EXPECT_TRUE(cmon_modules_iface(mods, 1) == NULL);
+    cmon_builder_st_destroy(b);
+    cmon_codegen_dealloc(&cg);
+    cmon_modules_destroy(mods);
+    cmon_src_destroy(src);
+    cmon_mod_iface_destroy(iface);
+
+    // invalid files are rejected when loading
+    char * data;
+    size_t size;
+    {
+        FILE * f = fopen("iface_test/foo.cmi", "rb");
+        ASSERT_TRUE(f != NULL);
+        fseek(f, 0, SEEK_END);
+        size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        data = cmon_allocator_alloc(&alloc, size).ptr;
+        EXPECT_EQ(size, fread(data, 1, size, f));
+        fclose(f);
+    }
+
+    // truncated
+    _write_bin_file("iface_test/bad.cmi", data, size - 1);
+    EXPECT_TRUE(cmon_mod_iface_load(&alloc, "iface_test/bad.cmi") == NULL);
+    _write_bin_file("iface_test/bad.cmi", data, 8);
+    EXPECT_TRUE(cmon_mod_iface_load(&alloc, "iface_test/bad.cmi") == NULL);
+
+    // wrong magic
+    data[0] = 'X';
+    _write_bin_file("iface_test/bad.cmi", data, size);
+    EXPECT_TRUE(cmon_mod_iface_load(&alloc, "iface_test/bad.cmi") == NULL);
+    data[0] = 'C';
+
+    // unterminated string table (overwriting the padding behind it, too)
+    size_t str_end = size;
+    while (!data[str_end - 1])
+    {
+        data[--str_end] = 'X';
+    }
+    _write_bin_file("iface_test/bad.cmi", data, size);
+    EXPECT_TRUE(cmon_mod_iface_load(&alloc, "iface_test/bad.cmi") == NULL);
+    memset(data + str_end, 0, size - str_end);
+
+    // out of range string offset in the first type record, which directly follows the 40 byte
+    // header as foo has no dependencies
+    memset(data + 40 + sizeof(uint32_t), 0xFF, sizeof(uint32_t));
+    _write_bin_file("iface_test/bad.cmi", data, size);
+    EXPECT_TRUE(cmon_mod_iface_load(&alloc, "iface_test/bad.cmi") == NULL);
+
+    cmon_allocator_free(&alloc, (cmon_mem_blk){ data, size });
+    cmon_log_destroy(log);
+    cmon_fs_remove_all("iface_test");
+    cmon_allocator_dealloc(&alloc);
+}
+
 // void _module_circ_dep_test_adder_fn02(cmon_src * _src, cmon_modules * _mods)
 // {
 //     cmon_idx src01_idx = cmon_src_add(_src, "foo/foo.cmon", "foo.cmon");